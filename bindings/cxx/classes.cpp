@@ -26,8 +26,11 @@
 #include <config.h>
 #include <libsigrokcxx/libsigrokcxx.hpp>
 
+#include <algorithm>
 #include <sstream>
+#include <cstring>
 #include <cmath>
+#include <chrono>
 
 namespace sigrok
 {
@@ -898,16 +901,140 @@ float TriggerMatch::value() const
 DatafeedCallbackData::DatafeedCallbackData(Session *session,
 		DatafeedCallbackFunction callback) :
 	_callback(move(callback)),
-	_session(session)
+	_session(session),
+	_last_sdi(nullptr)
 {
 }
 
+DatafeedCallbackData::DatafeedCallbackData(Session *session,
+		BatchedDatafeedCallbackFunction callback,
+		size_t max_bytes, unsigned int max_latency_ms) :
+	_session(session),
+	_last_sdi(nullptr),
+	_batched_callback(move(callback)),
+	_max_bytes(max_bytes),
+	_max_latency_us(max_latency_ms * G_GINT64_CONSTANT(1000)),
+	_batch_bytes(0),
+	_batch_start(0),
+	_logic_size(0),
+	_logic_length(0),
+	_logic_unitsize(0)
+{
+}
+
+shared_ptr<Device> DatafeedCallbackData::get_device(
+	const struct sr_dev_inst *sdi)
+{
+	if (sdi != _last_sdi || !_last_device) {
+		_last_device = _session->get_device(sdi);
+		_last_sdi = sdi;
+	}
+	return _last_device;
+}
+
 void DatafeedCallbackData::run(const struct sr_dev_inst *sdi,
 	const struct sr_datafeed_packet *pkt)
 {
-	auto device = _session->get_device(sdi);
-	shared_ptr<Packet> packet {new Packet{device, pkt}, default_delete<Packet>{}};
-	_callback(move(device), move(packet));
+	if (_batched_callback) {
+		batch(sdi, pkt);
+		return;
+	}
+
+	auto device = get_device(sdi);
+	shared_ptr<Packet> packet {new Packet{device, pkt, true}, default_delete<Packet>{}};
+	_callback(move(device), packet);
+	/* The packet's data is only valid during this call. */
+	if (packet.use_count() > 1)
+		packet->detach();
+}
+
+void DatafeedCallbackData::batch(const struct sr_dev_inst *sdi,
+	const struct sr_datafeed_packet *pkt)
+{
+	auto device = get_device(sdi);
+	if (device != _batch_device) {
+		flush();
+		_batch_device = device;
+	}
+
+	if (_batch.empty() && !_logic_length)
+		_batch_start = g_get_monotonic_time();
+
+	switch (pkt->type) {
+	case SR_DF_LOGIC:
+		batch_logic(static_cast<const struct sr_datafeed_logic *>(
+			pkt->payload));
+		break;
+	case SR_DF_ANALOG: {
+		end_logic_run();
+		shared_ptr<Packet> packet {new Packet{device, pkt, true},
+			default_delete<Packet>{}};
+		packet->detach();
+		auto analog = static_cast<const struct sr_datafeed_analog *>(
+			packet->_structure->payload);
+		_batch_bytes += (size_t)analog->num_samples *
+			analog->encoding->unitsize *
+			g_slist_length(analog->meaning->channels);
+		_batch.push_back(move(packet));
+		break;
+	}
+	default:
+		/* Packets without samples get delivered right away. */
+		end_logic_run();
+		shared_ptr<Packet> packet {new Packet{device, pkt, true},
+			default_delete<Packet>{}};
+		packet->detach();
+		_batch.push_back(move(packet));
+		flush();
+		return;
+	}
+
+	if (_batch_bytes >= _max_bytes ||
+			g_get_monotonic_time() - _batch_start >= _max_latency_us)
+		flush();
+}
+
+void DatafeedCallbackData::batch_logic(const struct sr_datafeed_logic *logic)
+{
+	if (logic->unitsize != _logic_unitsize ||
+			_logic_length + logic->length > _logic_size)
+		end_logic_run();
+
+	if (!_logic_data) {
+		_logic_size = max(_max_bytes, (size_t)logic->length);
+		_logic_data.reset(new uint8_t[_logic_size]);
+		_logic_unitsize = logic->unitsize;
+	}
+	memcpy(_logic_data.get() + _logic_length, logic->data, logic->length);
+	_logic_length += logic->length;
+	_batch_bytes += logic->length;
+}
+
+/* Hand the merged logic data over to a packet of its own. */
+void DatafeedCallbackData::end_logic_run()
+{
+	if (!_logic_data)
+		return;
+	if (_logic_length)
+		_batch.push_back(shared_ptr<Packet>{
+			new Packet{_batch_device, move(_logic_data),
+				_logic_length, _logic_unitsize},
+			default_delete<Packet>{}});
+	_logic_data.reset();
+	_logic_length = 0;
+}
+
+void DatafeedCallbackData::flush()
+{
+	end_logic_run();
+	if (_batch.empty())
+		return;
+
+	vector<shared_ptr<Packet>> batch;
+	batch.reserve(_batch.size());
+	batch.swap(_batch);
+	_batch_bytes = 0;
+	_batched_callback(_batch_device, move(batch));
 }
 
 SessionDevice::SessionDevice(struct sr_dev_inst *structure) :
@@ -926,7 +1053,8 @@ shared_ptr<Device> SessionDevice::get_shared_from_this()
 
 Session::Session(shared_ptr<Context> context) :
 	_structure(nullptr),
-	_context(move(context))
+	_context(move(context)),
+	_main_context(nullptr)
 {
 	check(sr_session_new(_context->_structure, &_structure));
 	_context->_session = this;
@@ -935,6 +1063,7 @@ Session::Session(shared_ptr<Context> context) :
 Session::Session(shared_ptr<Context> context, string filename) :
 	_structure(nullptr),
 	_context(move(context)),
+	_main_context(nullptr),
 	_filename(move(filename))
 {
 	check(sr_session_load(_context->_structure, _filename.c_str(), &_structure));
@@ -951,7 +1080,12 @@ Session::Session(shared_ptr<Context> context, string filename) :
 
 Session::~Session()
 {
+	for (const auto &weak_queue : _packet_queues)
+		if (auto queue = weak_queue.lock())
+			queue->session_destroyed();
 	check(sr_session_destroy(_structure));
+	if (_main_context)
+		g_main_context_unref(_main_context);
 }
 
 shared_ptr<Device> Session::get_device(const struct sr_dev_inst *sdi)
@@ -970,6 +1104,8 @@ void Session::add_device(shared_ptr<Device> device)
 	const auto dev_struct = device->_structure;
 	check(sr_session_dev_add(_structure, dev_struct));
 	_other_devices[dev_struct] = move(device);
+	for (const auto &cb_data : _datafeed_callbacks)
+		cb_data->_last_device.reset();
 }
 
 vector<shared_ptr<Device>> Session::devices()
@@ -989,11 +1125,26 @@ void Session::remove_devices()
 {
 	_other_devices.clear();
 	check(sr_session_dev_remove_all(_structure));
+	for (const auto &cb_data : _datafeed_callbacks) {
+		cb_data->_last_device.reset();
+		cb_data->_batch_device.reset();
+	}
 }
 
 void Session::start()
 {
-	check(sr_session_start(_structure));
+	if (!_main_context) {
+		check(sr_session_start(_structure));
+		return;
+	}
+	/*
+	 * Have the session's events dispatched in our own main context,
+	 * which packet queues can process from whichever thread pulls.
+	 */
+	g_main_context_push_thread_default(_main_context);
+	const int ret = sr_session_start(_structure);
+	g_main_context_pop_thread_default(_main_context);
+	check(ret);
 }
 
 void Session::run()
@@ -1014,23 +1165,37 @@ bool Session::is_running() const
 	return (ret != 0);
 }
 
-static void session_stopped_callback(void *data) noexcept
+void Session::stopped_callback(void *data) noexcept
 {
-	auto *const callback = static_cast<SessionStoppedCallback*>(data);
-	(*callback)();
+	auto *const session = static_cast<Session *>(data);
+	session->stopped();
 }
 
-void Session::set_stopped_callback(SessionStoppedCallback callback)
+void Session::stopped()
 {
-	_stopped_callback = move(callback);
+	for (const auto &weak_queue : _packet_queues)
+		if (auto queue = weak_queue.lock())
+			queue->stopped();
 	if (_stopped_callback)
+		_stopped_callback();
+}
+
+void Session::update_stopped_callback()
+{
+	if (_stopped_callback || !_packet_queues.empty())
 		check(sr_session_stopped_callback_set(_structure,
-				&session_stopped_callback, &_stopped_callback));
+				&Session::stopped_callback, this));
 	else
 		check(sr_session_stopped_callback_set(_structure,
 				nullptr, nullptr));
 }
 
+void Session::set_stopped_callback(SessionStoppedCallback callback)
+{
+	_stopped_callback = move(callback);
+	update_stopped_callback();
+}
+
 static void datafeed_callback(const struct sr_dev_inst *sdi,
 	const struct sr_datafeed_packet *pkt, void *cb_data) noexcept
 {
@@ -1047,12 +1212,292 @@ void Session::add_datafeed_callback(DatafeedCallbackFunction callback)
 	_datafeed_callbacks.push_back(move(cb_data));
 }
 
+void Session::add_batched_datafeed_callback(
+	BatchedDatafeedCallbackFunction callback,
+	size_t max_bytes, unsigned int max_latency_ms)
+{
+	unique_ptr<DatafeedCallbackData> cb_data
+		{new DatafeedCallbackData{this, move(callback),
+			max_bytes, max_latency_ms}};
+	check(sr_session_datafeed_callback_add(_structure,
+			&datafeed_callback, cb_data.get()));
+	_datafeed_callbacks.push_back(move(cb_data));
+}
+
 void Session::remove_datafeed_callbacks()
 {
 	check(sr_session_datafeed_callback_remove_all(_structure));
 	_datafeed_callbacks.clear();
 }
 
+/*
+ * Owns a packet queue for its consumers, and closes the queue when the
+ * last of them lets go. Otherwise the session thread could wait forever
+ * for room in a full queue which nobody takes packets from.
+ */
+struct PacketQueueConsumers
+{
+	shared_ptr<PacketQueue> queue;
+	~PacketQueueConsumers() { queue->close(); }
+};
+
+shared_ptr<PacketQueue> Session::create_packet_queue(size_t capacity,
+	PacketQueue::Overflow overflow)
+{
+	if (capacity == 0)
+		throw Error(SR_ERR_ARG);
+	if (is_running())
+		throw Error(SR_ERR_NA);
+	if (!_main_context)
+		_main_context = g_main_context_new();
+
+	auto consumers = make_shared<PacketQueueConsumers>();
+	consumers->queue.reset(
+		new PacketQueue{_structure, _main_context, capacity, overflow},
+		default_delete<PacketQueue>{});
+	weak_ptr<PacketQueue> weak_queue = consumers->queue;
+	add_datafeed_callback([weak_queue](shared_ptr<Device>,
+		shared_ptr<Packet> packet) {
+		if (auto queue = weak_queue.lock()) {
+			/*
+			 * Consumers may take the packet as soon as it is
+			 * queued, after the driver's buffer went away.
+			 */
+			packet->detach();
+			queue->push(move(packet));
+		}
+	});
+	_packet_queues.erase(remove_if(_packet_queues.begin(),
+		_packet_queues.end(), [](const weak_ptr<PacketQueue> &queue) {
+			return queue.expired();
+		}), _packet_queues.end());
+	_packet_queues.push_back(weak_queue);
+	update_stopped_callback();
+
+	return shared_ptr<PacketQueue>{consumers, consumers->queue.get()};
+}
+
+PacketQueue::PacketQueue(struct sr_session *session,
+		GMainContext *main_context, size_t capacity, Overflow overflow) :
+	_session(session),
+	_main_context(g_main_context_ref(main_context)),
+	_capacity(capacity),
+	_overflow(overflow),
+	_dropped(0),
+	_end_queued(false),
+	_finished(false),
+	_closed(false)
+{
+}
+
+PacketQueue::~PacketQueue()
+{
+	g_main_context_unref(_main_context);
+}
+
+void PacketQueue::push(shared_ptr<Packet> packet)
+{
+	std::function<void()> ready_callback;
+	{
+		unique_lock<mutex> lock(_mutex);
+		if (_closed)
+			return;
+		/*
+		 * Packets which arrive while this very thread pulls from the
+		 * queue cannot wait for the consumer, the queue grows then.
+		 */
+		const bool can_block = _overflow == BLOCK &&
+			_pumping_thread != this_thread::get_id();
+		while (_packets.size() >= _capacity && !_closed) {
+			if (can_block) {
+				_not_full.wait(lock);
+			} else if (_overflow == DROP_OLDEST) {
+				_packets.pop_front();
+				_dropped++;
+			} else if (_overflow == DROP_NEWEST &&
+					packet->type() != PacketType::END) {
+				_dropped++;
+				return;
+			} else {
+				break;
+			}
+		}
+		if (_closed)
+			return;
+		if (packet->type() == PacketType::END)
+			_end_queued = true;
+		_packets.push_back(move(packet));
+		ready_callback = _ready_callback;
+	}
+	_not_empty.notify_one();
+	if (ready_callback)
+		ready_callback();
+}
+
+void PacketQueue::stopped()
+{
+	{
+		lock_guard<mutex> lock(_mutex);
+		_end_queued = true;
+	}
+	_not_empty.notify_all();
+}
+
+void PacketQueue::session_destroyed()
+{
+	{
+		lock_guard<mutex> lock(_mutex);
+		_session = nullptr;
+		_end_queued = true;
+	}
+	_not_empty.notify_all();
+}
+
+static gboolean wakeup(void *) noexcept
+{
+	return G_SOURCE_REMOVE;
+}
+
+/* Process session events once, waiting no longer than the deadline. */
+void PacketQueue::run_session(gint64 deadline)
+{
+	GSource *timeout = nullptr;
+
+	if (deadline >= 0) {
+		const gint64 remaining = deadline - g_get_monotonic_time();
+		timeout = g_timeout_source_new(remaining > 0 ? remaining / 1000 : 0);
+		g_source_set_callback(timeout, &wakeup, nullptr, nullptr);
+		g_source_attach(timeout, _main_context);
+	}
+
+	g_main_context_iteration(_main_context, TRUE);
+
+	if (timeout) {
+		g_source_destroy(timeout);
+		g_source_unref(timeout);
+	}
+}
+
+shared_ptr<Packet> PacketQueue::next_packet(int timeout_ms)
+{
+	const gint64 deadline = (timeout_ms < 0) ? -1 :
+		g_get_monotonic_time() + timeout_ms * G_GINT64_CONSTANT(1000);
+
+	unique_lock<mutex> lock(_mutex);
+	while (_packets.empty() && !_end_queued && !_closed) {
+		if (deadline >= 0 && g_get_monotonic_time() >= deadline)
+			return nullptr;
+		if (g_main_context_acquire(_main_context)) {
+			/* Nobody runs the session, do it here. */
+			if (!_session || sr_session_is_running(_session) <= 0) {
+				/* No events would ever arrive. */
+				g_main_context_release(_main_context);
+				throw Error(SR_ERR_NA);
+			}
+			_pumping_thread = this_thread::get_id();
+			lock.unlock();
+			run_session(deadline);
+			lock.lock();
+			_pumping_thread = thread::id();
+			g_main_context_release(_main_context);
+		} else {
+			/*
+			 * Another thread runs the session. Check back now and
+			 * then, in case that thread stops doing so.
+			 */
+			gint64 wait_us = 50000;
+			if (deadline >= 0)
+				wait_us = min(wait_us, deadline - g_get_monotonic_time());
+			if (wait_us > 0)
+				_not_empty.wait_for(lock, chrono::microseconds(wait_us));
+		}
+	}
+
+	if (_packets.empty()) {
+		_finished = true;
+		return nullptr;
+	}
+	auto packet = move(_packets.front());
+	_packets.pop_front();
+	lock.unlock();
+	_not_full.notify_one();
+
+	return packet;
+}
+
+shared_ptr<Packet> PacketQueue::try_next_packet()
+{
+	unique_lock<mutex> lock(_mutex);
+	if (_packets.empty()) {
+		if (_end_queued || _closed)
+			_finished = true;
+		return nullptr;
+	}
+	auto packet = move(_packets.front());
+	_packets.pop_front();
+	lock.unlock();
+	_not_full.notify_one();
+
+	return packet;
+}
+
+bool PacketQueue::finished()
+{
+	lock_guard<mutex> lock(_mutex);
+	return _finished || (_packets.empty() && (_end_queued || _closed));
+}
+
+size_t PacketQueue::size()
+{
+	lock_guard<mutex> lock(_mutex);
+	return _packets.size();
+}
+
+uint64_t PacketQueue::dropped()
+{
+	lock_guard<mutex> lock(_mutex);
+	return _dropped;
+}
+
+void PacketQueue::set_ready_callback(std::function<void()> callback)
+{
+	lock_guard<mutex> lock(_mutex);
+	_ready_callback = move(callback);
+}
+
+void PacketQueue::close()
+{
+	{
+		lock_guard<mutex> lock(_mutex);
+		_closed = true;
+		_packets.clear();
+	}
+	_not_full.notify_all();
+	_not_empty.notify_all();
+}
+
+PacketQueue::iterator PacketQueue::begin()
+{
+	return iterator{this};
+}
+
+PacketQueue::iterator PacketQueue::end()
+{
+	return iterator{};
+}
+
+PacketQueue::iterator::iterator(PacketQueue *queue) :
+	_queue(queue),
+	_packet(queue->next_packet())
+{
+}
+
+PacketQueue::iterator &PacketQueue::iterator::operator++()
+{
+	_packet = _queue->next_packet();
+	return *this;
+}
+
 shared_ptr<Trigger> Session::trigger()
 {
 	return _trigger;
@@ -1079,9 +1524,10 @@ shared_ptr<Context> Session::context()
 }
 
 Packet::Packet(shared_ptr<Device> device,
-	const struct sr_datafeed_packet *structure) :
+	const struct sr_datafeed_packet *structure, bool borrowed) :
 	_structure(structure),
-	_device(move(device))
+	_device(move(device)),
+	_borrowed(borrowed)
 {
 	switch (structure->type)
 	{
@@ -1108,15 +1554,48 @@ Packet::Packet(shared_ptr<Device> device,
 	}
 }
 
+Packet::Packet(shared_ptr<Device> device,
+	unique_ptr<uint8_t[]> logic_data, size_t length,
+	unsigned int unit_size) :
+	_structure(&_owned_structure),
+	_device(move(device)),
+	_borrowed(false)
+{
+	auto logic = new Logic{nullptr};
+	logic->_owned_data = move(logic_data);
+	logic->_owned_structure.length = length;
+	logic->_owned_structure.unitsize = unit_size;
+	logic->_owned_structure.data = logic->_owned_data.get();
+	logic->_structure = &logic->_owned_structure;
+	_payload.reset(logic);
+	_owned_structure.type = SR_DF_LOGIC;
+	_owned_structure.payload = logic->_structure;
+}
+
 Packet::~Packet()
 {
 }
 
+void Packet::detach()
+{
+	if (!_borrowed)
+		return;
+	_owned_structure = *_structure;
+	_owned_structure.payload = _payload ? _payload->detach() : nullptr;
+	_structure = &_owned_structure;
+	_borrowed = false;
+}
+
 const PacketType *Packet::type() const
 {
 	return PacketType::get(_structure->type);
 }
 
+shared_ptr<Device> Packet::device()
+{
+	return _device;
+}
+
 shared_ptr<PacketPayload> Packet::payload()
 {
 	if (_payload)
@@ -1149,6 +1628,13 @@ shared_ptr<PacketPayload> Header::share_owned_by(shared_ptr<Packet> _parent)
 		ParentOwned::share_owned_by(_parent));
 }
 
+const void *Header::detach()
+{
+	_owned_structure = *_structure;
+	_structure = &_owned_structure;
+	return _structure;
+}
+
 int Header::feed_version() const
 {
 	return _structure->feed_version;
@@ -1163,12 +1649,21 @@ Glib::TimeVal Header::start_time() const
 
 Meta::Meta(const struct sr_datafeed_meta *structure) :
 	PacketPayload(),
-	_structure(structure)
+	_structure(structure),
+	_owned(false)
 {
 }
 
 Meta::~Meta()
 {
+	if (!_owned)
+		return;
+	for (auto l = _owned_structure.config; l; l = l->next) {
+		auto *const config = static_cast<struct sr_config *>(l->data);
+		g_variant_unref(config->data);
+		g_free(config);
+	}
+	g_slist_free(_owned_structure.config);
 }
 
 shared_ptr<PacketPayload> Meta::share_owned_by(shared_ptr<Packet> _parent)
@@ -1177,6 +1672,23 @@ shared_ptr<PacketPayload> Meta::share_owned_by(shared_ptr<Packet> _parent)
 		ParentOwned::share_owned_by(_parent));
 }
 
+const void *Meta::detach()
+{
+	_owned_structure.config = nullptr;
+	for (auto l = _structure->config; l; l = l->next) {
+		auto *const config = static_cast<struct sr_config *>(l->data);
+		auto *const copy = g_new(struct sr_config, 1);
+		copy->key = config->key;
+		copy->data = g_variant_ref(config->data);
+		_owned_structure.config = g_slist_prepend(
+			_owned_structure.config, copy);
+	}
+	_owned_structure.config = g_slist_reverse(_owned_structure.config);
+	_structure = &_owned_structure;
+	_owned = true;
+	return _structure;
+}
+
 map<const ConfigKey *, Glib::VariantBase> Meta::config() const
 {
 	map<const ConfigKey *, Glib::VariantBase> result;
@@ -1203,11 +1715,34 @@ shared_ptr<PacketPayload> Logic::share_owned_by(shared_ptr<Packet> _parent)
 		ParentOwned::share_owned_by(_parent));
 }
 
+const void *Logic::detach()
+{
+	_owned_structure = *_structure;
+	_owned_data.reset(new uint8_t[_structure->length]);
+	memcpy(_owned_data.get(), _structure->data, _structure->length);
+	_owned_structure.data = _owned_data.get();
+	_structure = &_owned_structure;
+	return _structure;
+}
+
 void *Logic::data_pointer()
 {
 	return _structure->data;
 }
 
+shared_ptr<void> Logic::data_buffer()
+{
+	if (!_parent) {
+		/* Not part of a packet, hand out a copy. */
+		shared_ptr<uint8_t> copy {new uint8_t[_structure->length],
+			default_delete<uint8_t[]>{}};
+		memcpy(copy.get(), _structure->data, _structure->length);
+		return copy;
+	}
+	_parent->detach();
+	return shared_ptr<void>{_parent, _structure->data};
+}
+
 size_t Logic::data_length() const
 {
 	return _structure->length;
@@ -1226,6 +1761,8 @@ Analog::Analog(const struct sr_datafeed_analog *structure) :
 
 Analog::~Analog()
 {
+	if (_structure == &_owned_structure)
+		g_slist_free(_owned_meaning.channels);
 }
 
 shared_ptr<PacketPayload> Analog::share_owned_by(shared_ptr<Packet> _parent)
@@ -1234,11 +1771,52 @@ shared_ptr<PacketPayload> Analog::share_owned_by(shared_ptr<Packet> _parent)
 		ParentOwned::share_owned_by(_parent));
 }
 
+/* Size of the sample data in bytes, for all channels. */
+static size_t analog_data_length(const struct sr_datafeed_analog *analog)
+{
+	return (size_t)analog->num_samples * analog->encoding->unitsize *
+		g_slist_length(analog->meaning->channels);
+}
+
+const void *Analog::detach()
+{
+	const size_t length = analog_data_length(_structure);
+
+	_owned_structure = *_structure;
+	_owned_encoding = *_structure->encoding;
+	_owned_meaning = *_structure->meaning;
+	_owned_meaning.channels = g_slist_copy(_structure->meaning->channels);
+	if (_structure->spec)
+		_owned_spec = *_structure->spec;
+	_owned_data.reset(new uint8_t[length]);
+	memcpy(_owned_data.get(), _structure->data, length);
+	_owned_structure.data = _owned_data.get();
+	_owned_structure.encoding = &_owned_encoding;
+	_owned_structure.meaning = &_owned_meaning;
+	if (_structure->spec)
+		_owned_structure.spec = &_owned_spec;
+	_structure = &_owned_structure;
+	return _structure;
+}
+
 void *Analog::data_pointer()
 {
 	return _structure->data;
 }
 
+shared_ptr<void> Analog::data_buffer()
+{
+	if (!_parent) {
+		const size_t length = analog_data_length(_structure);
+		shared_ptr<uint8_t> copy {new uint8_t[length],
+			default_delete<uint8_t[]>{}};
+		memcpy(copy.get(), _structure->data, length);
+		return copy;
+	}
+	_parent->detach();
+	return shared_ptr<void>{_parent, _structure->data};
+}
+
 void Analog::get_data_as_float(float *dest)
 {
 	check(sr_analog_to_float(_structure, dest));
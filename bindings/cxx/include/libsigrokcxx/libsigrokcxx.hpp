@@ -82,8 +82,13 @@ G_GNUC_END_IGNORE_DEPRECATIONS
 #include <stdexcept>
 #include <memory>
 #include <vector>
+#include <deque>
 #include <map>
 #include <set>
+#include <iterator>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 
 namespace sigrok
 {
@@ -109,6 +114,7 @@ class SR_API TriggerMatch;
 class SR_API TriggerMatchType;
 class SR_API ChannelType;
 class SR_API Packet;
+class SR_API PacketQueue;
 class SR_API PacketPayload;
 class SR_API PacketType;
 class SR_API Quantity;
@@ -578,6 +584,10 @@ typedef std::function<void()> SessionStoppedCallback;
 typedef std::function<void(std::shared_ptr<Device>, std::shared_ptr<Packet>)>
 	DatafeedCallbackFunction;
 
+/** Type of batched datafeed callback */
+typedef std::function<void(std::shared_ptr<Device>,
+	std::vector<std::shared_ptr<Packet> >)> BatchedDatafeedCallbackFunction;
+
 /* Data required for C callback function to call a C++ datafeed callback */
 class SR_PRIV DatafeedCallbackData
 {
@@ -588,7 +598,32 @@ private:
 	DatafeedCallbackFunction _callback;
 	DatafeedCallbackData(Session *session,
 		DatafeedCallbackFunction callback);
+	DatafeedCallbackData(Session *session,
+		BatchedDatafeedCallbackFunction callback,
+		size_t max_bytes, unsigned int max_latency_ms);
+	std::shared_ptr<Device> get_device(const struct sr_dev_inst *sdi);
+	void batch(const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *pkt);
+	void batch_logic(const struct sr_datafeed_logic *logic);
+	void end_logic_run();
+	void flush();
 	Session *_session;
+	/* Device of the previous packet, saves the lookup. */
+	const struct sr_dev_inst *_last_sdi;
+	std::shared_ptr<Device> _last_device;
+	/* Batched delivery. */
+	BatchedDatafeedCallbackFunction _batched_callback;
+	size_t _max_bytes;
+	gint64 _max_latency_us;
+	std::shared_ptr<Device> _batch_device;
+	std::vector<std::shared_ptr<Packet> > _batch;
+	size_t _batch_bytes;
+	gint64 _batch_start;
+	/* Consecutive logic packets are merged into one buffer. */
+	std::unique_ptr<uint8_t[]> _logic_data;
+	size_t _logic_size;
+	size_t _logic_length;
+	unsigned int _logic_unitsize;
 	friend class Session;
 };
 
@@ -606,6 +641,107 @@ private:
 	friend struct std::default_delete<SessionDevice>;
 };
 
+/**
+ * A queue of datafeed packets, for pulling packets from a session
+ * instead of having them pushed to a callback.
+ *
+ * When no other thread runs the session, taking packets from the queue
+ * processes the session's events in the calling thread, as far as the
+ * queue needs to be refilled. Otherwise the session thread fills the
+ * queue, and the overflow setting decides what happens while it is full.
+ *
+ * The queue gets closed when the last reference to it goes away.
+ */
+class SR_API PacketQueue : public UserOwned<PacketQueue>
+{
+public:
+	/** What to do with new packets while the queue is full. */
+	enum Overflow {
+		/** Wait for the consumer. Stalls the session's event processing. */
+		BLOCK,
+		/** Drop the oldest packet in the queue. */
+		DROP_OLDEST,
+		/** Drop the new packet. */
+		DROP_NEWEST,
+	};
+
+	/** Input iterator over the packets, until the end of the datafeed. */
+	class iterator
+	{
+	public:
+		typedef std::input_iterator_tag iterator_category;
+		typedef std::shared_ptr<Packet> value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const std::shared_ptr<Packet> *pointer;
+		typedef const std::shared_ptr<Packet> &reference;
+
+		iterator() : _queue(nullptr) {}
+		reference operator*() const { return _packet; }
+		pointer operator->() const { return &_packet; }
+		iterator &operator++();
+		bool operator==(const iterator &other) const
+			{ return _packet == other._packet; }
+		bool operator!=(const iterator &other) const
+			{ return !(*this == other); }
+	private:
+		explicit iterator(PacketQueue *queue);
+		PacketQueue *_queue;
+		std::shared_ptr<Packet> _packet;
+		friend class PacketQueue;
+	};
+
+	/** Take the next packet from the queue.
+	 * @param timeout_ms Time to wait for a packet, negative to wait
+	 * until one arrives or the datafeed ends.
+	 * @return The packet, or nullptr on timeout or after the end.
+	 * @throws Error SR_ERR_NA if the queue needs refilling and the
+	 * session is not running. */
+	std::shared_ptr<Packet> next_packet(int timeout_ms = -1);
+	/** Take the next packet if one is queued, without waiting. */
+	std::shared_ptr<Packet> try_next_packet();
+	/** Whether the datafeed ended and all packets were taken. */
+	bool finished();
+	/** Number of packets in the queue. */
+	size_t size();
+	/** Number of packets dropped because the queue was full. */
+	uint64_t dropped();
+	/** Set a function to be called when a packet was queued. It is
+	 * called from the thread which runs the session, and can be used
+	 * to resume consumers waiting in an event loop or coroutine. */
+	void set_ready_callback(std::function<void()> callback);
+	/** Discard queued packets and stop taking new ones. */
+	void close();
+	/** Iterate over the packets, blocking until each one arrives. */
+	iterator begin();
+	iterator end();
+private:
+	PacketQueue(struct sr_session *session, GMainContext *main_context,
+		size_t capacity, Overflow overflow);
+	~PacketQueue();
+	void push(std::shared_ptr<Packet> packet);
+	void stopped();
+	void session_destroyed();
+	void run_session(gint64 deadline);
+	struct sr_session *_session;
+	GMainContext *_main_context;
+	const size_t _capacity;
+	const Overflow _overflow;
+	std::mutex _mutex;
+	std::condition_variable _not_empty;
+	std::condition_variable _not_full;
+	std::deque<std::shared_ptr<Packet> > _packets;
+	std::function<void()> _ready_callback;
+	/* Thread which currently processes session events in next_packet(). */
+	std::thread::id _pumping_thread;
+	uint64_t _dropped;
+	bool _end_queued;
+	bool _finished;
+	bool _closed;
+
+	friend class Session;
+	friend struct std::default_delete<PacketQueue>;
+};
+
 /** A sigrok session */
 class SR_API Session : public UserOwned<Session>
 {
@@ -620,8 +756,27 @@ public:
 	/** Add a datafeed callback to this session.
 	 * @param callback Callback of the form callback(Device, Packet). */
 	void add_datafeed_callback(DatafeedCallbackFunction callback);
+	/** Add a datafeed callback which receives packets in batches.
+	 * Packets of a device are collected until their data exceeds
+	 * max_bytes, until max_latency_ms passed since the first one, or
+	 * until a packet without sample data arrives. Consecutive logic
+	 * packets are merged into one. The packets stay valid after the
+	 * callback returned.
+	 * @param callback Callback of the form callback(Device, [Packet]).
+	 * @param max_bytes Amount of sample data to collect.
+	 * @param max_latency_ms Time to collect sample data for, checked
+	 * when packets arrive. */
+	void add_batched_datafeed_callback(
+		BatchedDatafeedCallbackFunction callback,
+		size_t max_bytes, unsigned int max_latency_ms);
 	/** Remove all datafeed callbacks from this session. */
 	void remove_datafeed_callbacks();
+	/** Create a queue which receives the datafeed packets of this
+	 * session. Must be called before the session is started.
+	 * @param capacity Number of packets the queue holds.
+	 * @param overflow What to do with packets while the queue is full. */
+	std::shared_ptr<PacketQueue> create_packet_queue(size_t capacity = 64,
+		PacketQueue::Overflow overflow = PacketQueue::BLOCK);
 	/** Start the session. */
 	void start();
 	/** Run the session event loop. */
@@ -646,8 +801,14 @@ private:
 	Session(std::shared_ptr<Context> context, std::string filename);
 	~Session();
 	std::shared_ptr<Device> get_device(const struct sr_dev_inst *sdi);
+	void stopped();
+	void update_stopped_callback();
+	static SR_PRIV void stopped_callback(void *data) noexcept;
 	struct sr_session *_structure;
 	const std::shared_ptr<Context> _context;
+	/* Main context of the session's events, if packet queues are used. */
+	GMainContext *_main_context;
+	std::vector<std::weak_ptr<PacketQueue> > _packet_queues;
 	std::map<const struct sr_dev_inst *, std::unique_ptr<SessionDevice> > _owned_devices;
 	std::map<const struct sr_dev_inst *, std::shared_ptr<Device> > _other_devices;
 	std::vector<std::unique_ptr<DatafeedCallbackData> > _datafeed_callbacks;
@@ -667,15 +828,25 @@ class SR_API Packet : public UserOwned<Packet>
 public:
 	/** Type of this packet. */
 	const PacketType *type() const;
+	/** Device which sent this packet, if any. */
+	std::shared_ptr<Device> device();
 	/** Payload of this packet. */
 	std::shared_ptr<PacketPayload> payload();
 private:
 	Packet(std::shared_ptr<Device> device,
-		const struct sr_datafeed_packet *structure);
+		const struct sr_datafeed_packet *structure,
+		bool borrowed = false);
+	Packet(std::shared_ptr<Device> device,
+		std::unique_ptr<uint8_t[]> logic_data, size_t length,
+		unsigned int unit_size);
 	~Packet();
+	void detach();
 	const struct sr_datafeed_packet *_structure;
 	std::shared_ptr<Device> _device;
 	std::unique_ptr<PacketPayload> _payload;
+	/* Structure and data belong to the session's datafeed callback. */
+	bool _borrowed;
+	struct sr_datafeed_packet _owned_structure;
 
 	friend class Session;
 	friend class Output;
@@ -696,6 +867,8 @@ protected:
 	virtual ~PacketPayload() = 0;
 private:
 	virtual std::shared_ptr<PacketPayload> share_owned_by(std::shared_ptr<Packet> parent) = 0;
+	/* Take copies of borrowed structures and data, return the copy. */
+	virtual const void *detach() = 0;
 
 	friend class Packet;
 	friend class Output;
@@ -716,8 +889,10 @@ private:
 	explicit Header(const struct sr_datafeed_header *structure);
 	~Header();
 	std::shared_ptr<PacketPayload> share_owned_by(std::shared_ptr<Packet> parent);
+	const void *detach();
 
 	const struct sr_datafeed_header *_structure;
+	struct sr_datafeed_header _owned_structure;
 
 	friend class Packet;
 };
@@ -734,8 +909,11 @@ private:
 	explicit Meta(const struct sr_datafeed_meta *structure);
 	~Meta();
 	std::shared_ptr<PacketPayload> share_owned_by(std::shared_ptr<Packet> parent);
+	const void *detach();
 
 	const struct sr_datafeed_meta *_structure;
+	struct sr_datafeed_meta _owned_structure;
+	bool _owned;
 	std::map<const ConfigKey *, Glib::VariantBase> _config;
 
 	friend class Packet;
@@ -749,6 +927,12 @@ class SR_API Logic :
 public:
 	/* Pointer to data. */
 	void *data_pointer();
+	/**
+	 * Data which stays valid as long as the returned pointer is held,
+	 * also after the datafeed callback returned. Data which the packet
+	 * borrowed from the session gets copied once, other data is shared.
+	 */
+	std::shared_ptr<void> data_buffer();
 	/* Data length in bytes. */
 	size_t data_length() const;
 	/* Size of each sample in bytes. */
@@ -757,8 +941,11 @@ private:
 	explicit Logic(const struct sr_datafeed_logic *structure);
 	~Logic();
 	std::shared_ptr<PacketPayload> share_owned_by(std::shared_ptr<Packet> parent);
+	const void *detach();
 
 	const struct sr_datafeed_logic *_structure;
+	struct sr_datafeed_logic _owned_structure;
+	std::unique_ptr<uint8_t[]> _owned_data;
 
 	friend class Packet;
 	friend class Analog;
@@ -773,6 +960,12 @@ class SR_API Analog :
 public:
 	/** Pointer to data. */
 	void *data_pointer();
+	/**
+	 * Data which stays valid as long as the returned pointer is held,
+	 * also after the datafeed callback returned. Data which the packet
+	 * borrowed from the session gets copied once, other data is shared.
+	 */
+	std::shared_ptr<void> data_buffer();
 	/**
 	 * Fills dest pointer with the analog data converted to float.
 	 * The pointer must have space for num_samples() floats.
@@ -840,8 +1033,14 @@ private:
 	explicit Analog(const struct sr_datafeed_analog *structure);
 	~Analog();
 	std::shared_ptr<PacketPayload> share_owned_by(std::shared_ptr<Packet> parent);
+	const void *detach();
 
 	const struct sr_datafeed_analog *_structure;
+	struct sr_datafeed_analog _owned_structure;
+	struct sr_analog_encoding _owned_encoding;
+	struct sr_analog_meaning _owned_meaning;
+	struct sr_analog_spec _owned_spec;
+	std::unique_ptr<uint8_t[]> _owned_data;
 
 	friend class Packet;
 };
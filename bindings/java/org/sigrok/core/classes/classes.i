@@ -381,6 +381,7 @@ typedef jobject jdatafeedcallback;
 %ignore sigrok::Context::create_analog_packet;
 %ignore sigrok::Context::create_meta_packet;
 %ignore sigrok::Meta::config;
+%ignore sigrok::Session::add_batched_datafeed_callback;
 
 %include "bindings/swig/classes.i"
 
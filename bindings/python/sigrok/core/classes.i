@@ -71,6 +71,42 @@ typedef guint pyg_flags_type;
 #define string_to_python PyString_FromString
 #endif
 
+static void buffer_capsule_destroy(PyObject *capsule)
+{
+    delete static_cast<std::shared_ptr<void> *>(
+        PyCapsule_GetPointer(capsule, "sigrok.buffer"));
+}
+
+/*
+ * Wrap packet data in a NumPy array without copying it. The array's
+ * base object holds a reference to the data, which keeps it valid for
+ * as long as the array (or any view of it) exists. Steals descr.
+ */
+static PyObject *array_from_buffer(PyArray_Descr *descr, int nd,
+    npy_intp *dims, std::shared_ptr<void> buffer)
+{
+    void *data = buffer.get();
+    PyObject *capsule = PyCapsule_New(new std::shared_ptr<void>(std::move(buffer)),
+        "sigrok.buffer", buffer_capsule_destroy);
+    if (!capsule) {
+        Py_DECREF(descr);
+        return nullptr;
+    }
+
+    PyObject *array = PyArray_NewFromDescr(&PyArray_Type, descr, nd, dims,
+        nullptr, data, NPY_ARRAY_C_CONTIGUOUS | NPY_ARRAY_ALIGNED, nullptr);
+    if (!array) {
+        Py_DECREF(capsule);
+        return nullptr;
+    }
+    if (PyArray_SetBaseObject((PyArrayObject *)array, capsule) < 0) {
+        Py_DECREF(array);
+        return nullptr;
+    }
+
+    return array;
+}
+
 %}
 
 %init %{
@@ -252,6 +288,62 @@ typedef guint pyg_flags_type;
     Py_XINCREF($input);
 }
 
+/* Map from callable PyObject to BatchedDatafeedCallbackFunction */
+%typecheck(SWIG_TYPECHECK_POINTER) sigrok::BatchedDatafeedCallbackFunction {
+    $1 = PyCallable_Check($input);
+}
+
+%typemap(in) sigrok::BatchedDatafeedCallbackFunction {
+    if (!PyCallable_Check($input))
+        SWIG_exception(SWIG_TypeError, "Expected a callable Python object");
+
+    $1 = [=] (std::shared_ptr<sigrok::Device> device,
+            std::vector<std::shared_ptr<sigrok::Packet> > packets) {
+        auto gstate = PyGILState_Ensure();
+
+        auto device_obj = SWIG_NewPointerObj(
+            SWIG_as_voidptr(new std::shared_ptr<sigrok::Device>(device)),
+            SWIGTYPE_p_std__shared_ptrT_sigrok__Device_t, SWIG_POINTER_OWN);
+
+        auto packets_obj = PyList_New(packets.size());
+        for (size_t i = 0; i < packets.size(); i++)
+            PyList_SET_ITEM(packets_obj, i, SWIG_NewPointerObj(
+                SWIG_as_voidptr(new std::shared_ptr<sigrok::Packet>(packets[i])),
+                SWIGTYPE_p_std__shared_ptrT_sigrok__Packet_t, SWIG_POINTER_OWN));
+
+        auto arglist = Py_BuildValue("(OO)", device_obj, packets_obj);
+
+        auto result = PyEval_CallObject($input, arglist);
+
+        Py_XDECREF(arglist);
+        Py_XDECREF(device_obj);
+        Py_XDECREF(packets_obj);
+
+        bool completed = !PyErr_Occurred();
+
+        if (!completed)
+            PyErr_Print();
+
+        bool valid_result = (completed && result == Py_None);
+
+        Py_XDECREF(result);
+
+        if (completed && !valid_result)
+        {
+            PyErr_SetString(PyExc_TypeError,
+                "Datafeed callback did not return None");
+            PyErr_Print();
+        }
+
+        PyGILState_Release(gstate);
+
+        if (!valid_result)
+            throw sigrok::Error(SR_ERR);
+    };
+
+    Py_XINCREF($input);
+}
+
 /* Cast PacketPayload pointers to correct subclass type. */
 %ignore sigrok::Packet::payload;
 
@@ -401,6 +493,7 @@ std::map<std::string, Glib::VariantBase> dict_to_map_options(PyObject *dict,
 /* Ignore these methods, we will override them below. */
 %ignore sigrok::Analog::data;
 %ignore sigrok::Logic::data;
+%ignore sigrok::Analog::get_data_as_float;
 %ignore sigrok::Driver::scan;
 %ignore sigrok::InputFormat::create_input;
 %ignore sigrok::OutputFormat::create_output;
@@ -539,27 +632,113 @@ std::map<std::string, Glib::VariantBase> dict_to_map_options(PyObject *dict,
     }
 }
 
-/* Return NumPy array from Analog::data(). */
+/*
+ * Return NumPy array from Analog::data(), in the packet's sample
+ * encoding. The array remains valid after the datafeed callback.
+ */
 %extend sigrok::Analog
 {
     PyObject * _data()
     {
-        int nd = 2;
+        int typenum;
+        unsigned int unitsize = $self->unitsize();
+        if ($self->is_float()) {
+            switch (unitsize) {
+            case 4: typenum = NPY_FLOAT32; break;
+            case 8: typenum = NPY_FLOAT64; break;
+            default: typenum = NPY_NOTYPE; break;
+            }
+        } else {
+            bool is_signed = $self->is_signed();
+            switch (unitsize) {
+            case 1: typenum = is_signed ? NPY_INT8 : NPY_UINT8; break;
+            case 2: typenum = is_signed ? NPY_INT16 : NPY_UINT16; break;
+            case 4: typenum = is_signed ? NPY_INT32 : NPY_UINT32; break;
+            case 8: typenum = is_signed ? NPY_INT64 : NPY_UINT64; break;
+            default: typenum = NPY_NOTYPE; break;
+            }
+        }
+        if (typenum == NPY_NOTYPE) {
+            PyErr_SetString(PyExc_ValueError,
+                "Unsupported analog sample encoding.");
+            return nullptr;
+        }
+
+        PyArray_Descr *descr = PyArray_DescrFromType(typenum);
+        if (unitsize > 1) {
+            PyArray_Descr *swapped = PyArray_DescrNewByteorder(descr,
+                $self->is_bigendian() ? NPY_BIG : NPY_LITTLE);
+            Py_DECREF(descr);
+            if (!swapped)
+                return nullptr;
+            descr = swapped;
+        }
+
         npy_intp dims[2];
         dims[0] = $self->channels().size();
         dims[1] = $self->num_samples();
-        int typenum = NPY_FLOAT;
-        void *data = $self->data_pointer();
-        return PyArray_SimpleNewFromData(nd, dims, typenum, data);
+        return array_from_buffer(descr, 2, dims, $self->data_buffer());
+    }
+
+    /* Convert to float, into the given array if it is suitable. */
+    PyObject * _get_data_as_float(PyObject *out)
+    {
+        npy_intp count = (npy_intp)$self->channels().size() *
+            $self->num_samples();
+        PyArrayObject *array;
+
+        if (out == Py_None) {
+            npy_intp dims[2];
+            dims[0] = $self->channels().size();
+            dims[1] = $self->num_samples();
+            array = (PyArrayObject *)PyArray_SimpleNew(2, dims, NPY_FLOAT32);
+            if (!array)
+                return nullptr;
+        } else {
+            if (!PyArray_Check(out)) {
+                PyErr_SetString(PyExc_TypeError, "out must be a NumPy array.");
+                return nullptr;
+            }
+            array = (PyArrayObject *)out;
+            if (PyArray_TYPE(array) != NPY_FLOAT32 ||
+                    !PyArray_ISCARRAY(array) ||
+                    !PyArray_ISNOTSWAPPED(array)) {
+                PyErr_SetString(PyExc_ValueError,
+                    "out must be a writeable, C-contiguous float32 array.");
+                return nullptr;
+            }
+            if (PyArray_SIZE(array) < count) {
+                PyErr_SetString(PyExc_ValueError, "out is too small.");
+                return nullptr;
+            }
+            Py_INCREF(out);
+        }
+
+        try {
+            $self->get_data_as_float((float *)PyArray_DATA(array));
+        } catch (const sigrok::Error &e) {
+            Py_DECREF(array);
+            PyErr_SetString(PyExc_RuntimeError, e.what());
+            return nullptr;
+        }
+
+        return (PyObject *)array;
     }
 
 %pythoncode
 {
     data = property(_data)
+
+    def get_data_as_float(self, out=None):
+        """Sample values as float32, optionally into an existing array."""
+        return self._get_data_as_float(out)
 }
 }
 
-/* Return NumPy array from Logic::data(). */
+/*
+ * Return NumPy array from Logic::data(). The array remains valid after
+ * the datafeed callback.
+ */
 %extend sigrok::Logic
 {
     PyObject * _data()
@@ -567,9 +746,8 @@ std::map<std::string, Glib::VariantBase> dict_to_map_options(PyObject *dict,
         npy_intp dims[2];
         dims[0] = $self->data_length() / $self->unit_size();
         dims[1] = $self->unit_size();
-        int typenum = NPY_UINT8;
-        void *data = $self->data_pointer();
-        return PyArray_SimpleNewFromData(2, dims, typenum, data);
+        return array_from_buffer(PyArray_DescrFromType(NPY_UINT8), 2, dims,
+            $self->data_buffer());
     }
 
 %pythoncode
@@ -309,6 +309,7 @@ int convert_option_by_key(VALUE key, VALUE val, VALUE in) {
 
 /* Ignore these methods, we will override them below. */
 %ignore sigrok::Analog::data;
+%ignore sigrok::Session::add_batched_datafeed_callback;
 %ignore sigrok::Driver::scan;
 %ignore sigrok::Input::send;
 %ignore sigrok::InputFormat::create_input;
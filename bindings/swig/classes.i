@@ -80,6 +80,10 @@ template< class T > class enable_shared_from_this;
 #define SR_PRIV
 
 %ignore sigrok::DatafeedCallbackData;
+%ignore sigrok::Logic::data_buffer;
+%ignore sigrok::Analog::data_buffer;
+%ignore sigrok::PacketQueue;
+%ignore sigrok::Session::create_packet_queue;
 
 #ifndef SWIGJAVA
 
@@ -495,6 +495,20 @@ struct sr_datafeed_packet {
 	const void *payload;
 };
 
+/**
+ * Timestamp of a datafeed packet.
+ * @see sr_session_datafeed_callback_add_timed()
+ */
+struct sr_datafeed_timestamp {
+	/** Host time when the first sample got acquired, in microseconds
+	 *  (see g_get_monotonic_time()). */
+	int64_t time_us;
+	/** Index of the first sample, since the start of the acquisition. */
+	uint64_t sample;
+	/** Whether the driver synchronized the time with the hardware. */
+	gboolean hw_timed;
+};
+
 /** Header of a sigrok data feed. */
 struct sr_datafeed_header {
 	int feed_version;
@@ -1093,8 +1107,16 @@ enum sr_configkey {
 	/** The device supports specifying a capturefile to inject. */
 	SR_CONF_CAPTUREFILE,
 
+	/*
+	 * Newer keys which belong to the capturefile. The explicit values
+	 * keep the numbers of the keys below them.
+	 */
+
+	/** The device supports specifying the capturefile's frame index. */
+	SR_CONF_CAPTURE_FRAMEFILE = SR_CONF_SESSIONFILE + 7,
+
 	/** The device supports specifying the capturefile unit size. */
-	SR_CONF_CAPTURE_UNITSIZE,
+	SR_CONF_CAPTURE_UNITSIZE = SR_CONF_CAPTUREFILE + 1,
 
 	/** Power off the device. */
 	SR_CONF_POWER_OFF,
@@ -1119,6 +1141,22 @@ enum sr_configkey {
 	/** Number of powerline cycles for ADC integration time. */
 	SR_CONF_ADC_POWERLINE_CYCLES,
 
+	/** Number of frames in a segmented capture. */
+	SR_CONF_CAPTURE_FRAMES = SR_CONF_CAPTURE_FRAMEFILE + 1,
+
+	/**
+	 * The device supports starting the acquisition at a given frame
+	 * (0-based) of a segmented capture.
+	 */
+	SR_CONF_FIRST_FRAME,
+
+	/**
+	 * Acquisition metrics of the device, a dictionary (see
+	 * sr_session_stats_get()). Sent in SR_DF_META packets at the
+	 * interval set by sr_session_stats_interval_set().
+	 */
+	SR_CONF_SESSION_STATS,
+
 	/* Update sr_key_info_config[] (hwdriver.c) upon changes! */
 
 	/*--- Acquisition modes, sample limiting ----------------------------*/
@@ -1272,6 +1310,24 @@ struct sr_serial_port {
 	char *description;
 };
 
+/** Receive statistics of a serial port, see sr_serial_reactor_stats_get(). */
+struct sr_serial_reactor_stats {
+	/** Number of bytes read from the port. */
+	uint64_t rx_bytes;
+	/** Number of complete packets found in the RX data. */
+	uint64_t rx_packets;
+	/** Number of bytes skipped while re-synchronizing to packets. */
+	uint64_t dropped_bytes;
+	/** Number of packets dropped because the driver fell behind. */
+	uint64_t dropped_packets;
+	/** Sum of the latencies [us] between reception and fetch of packets. */
+	uint64_t latency_us_sum;
+	/** Maximum latency [us] between reception and fetch of a packet. */
+	uint64_t latency_us_max;
+	/** Number of fetched packets, the latency sum's divisor. */
+	uint64_t latency_count;
+};
+
 #include <libsigrok/proto.h>
 #include <libsigrok/version.h>
 
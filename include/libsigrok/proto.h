@@ -68,6 +68,13 @@ SR_API int sr_log_loglevel_get(void);
 SR_API int sr_log_callback_set(sr_log_callback cb, void *cb_data);
 SR_API int sr_log_callback_set_default(void);
 SR_API int sr_log_callback_get(sr_log_callback *cb, void **cb_data);
+SR_API int sr_log_callback_set_async(sr_log_callback cb, void *cb_data);
+SR_API int sr_log_async_rate_limit_set(unsigned int per_second);
+SR_API int sr_log_async_flush(void);
+SR_API int sr_log_async_stats_get(uint64_t *logged, uint64_t *dropped,
+		uint64_t *limited);
+SR_API int sr_log_filter_set(const char *prefix, int loglevel);
+SR_API int sr_log_filter_clear(const char *prefix);
 
 /*--- device.c --------------------------------------------------------------*/
 
@@ -105,6 +112,10 @@ SR_API int sr_driver_init(struct sr_context *ctx,
 		struct sr_dev_driver *driver);
 SR_API GArray *sr_driver_scan_options_list(const struct sr_dev_driver *driver);
 SR_API GSList *sr_driver_scan(struct sr_dev_driver *driver, GSList *options);
+typedef void (*sr_driver_scan_callback)(struct sr_dev_driver *driver,
+		GSList *devices, void *cb_data);
+SR_API GSList *sr_driver_scan_all(struct sr_dev_driver **drivers,
+		GSList *options, sr_driver_scan_callback cb, void *cb_data);
 SR_API int sr_config_get(const struct sr_dev_driver *driver,
 		const struct sr_dev_inst *sdi,
 		const struct sr_channel_group *cg,
@@ -117,6 +128,8 @@ SR_API int sr_config_list(const struct sr_dev_driver *driver,
 		const struct sr_dev_inst *sdi,
 		const struct sr_channel_group *cg,
 		uint32_t key, GVariant **data);
+SR_API int sr_config_cache_enable(struct sr_dev_inst *sdi, gboolean enable);
+SR_API int sr_config_cache_invalidate(const struct sr_dev_inst *sdi);
 SR_API const struct sr_key_info *sr_key_info_get(int keytype, uint32_t key);
 SR_API const struct sr_key_info *sr_key_info_name_get(int keytype, const char *keyid);
 
@@ -125,6 +138,9 @@ SR_API const struct sr_key_info *sr_key_info_name_get(int keytype, const char *k
 typedef void (*sr_session_stopped_callback)(void *data);
 typedef void (*sr_datafeed_callback)(const struct sr_dev_inst *sdi,
 		const struct sr_datafeed_packet *packet, void *cb_data);
+typedef void (*sr_datafeed_timed_callback)(const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *packet,
+		const struct sr_datafeed_timestamp *ts, void *cb_data);
 
 SR_API struct sr_trigger *sr_session_trigger_get(struct sr_session *session);
 
@@ -145,6 +161,12 @@ SR_API int sr_session_trigger_set(struct sr_session *session, struct sr_trigger
 SR_API int sr_session_datafeed_callback_remove_all(struct sr_session *session);
 SR_API int sr_session_datafeed_callback_add(struct sr_session *session,
 		sr_datafeed_callback cb, void *cb_data);
+SR_API int sr_session_datafeed_callback_add_concurrent(
+		struct sr_session *session, sr_datafeed_callback cb, void *cb_data);
+SR_API int sr_session_datafeed_callback_add_timed(struct sr_session *session,
+		sr_datafeed_timed_callback cb, void *cb_data);
+SR_API int sr_session_merge_set(struct sr_session *session,
+		uint64_t window_us);
 
 /* Session control */
 SR_API int sr_session_start(struct sr_session *session);
@@ -154,6 +176,17 @@ SR_API int sr_session_is_running(struct sr_session *session);
 SR_API int sr_session_stopped_callback_set(struct sr_session *session,
 		sr_session_stopped_callback cb, void *cb_data);
 
+/* Metrics */
+SR_API int sr_session_stats_get(struct sr_session *session, GVariant **stats);
+SR_API int sr_session_stats_interval_set(struct sr_session *session,
+		unsigned int interval_ms);
+SR_API int sr_session_stats_timing_set(struct sr_session *session,
+		gboolean enable);
+
+/* Dispatch threads */
+SR_API int sr_session_device_threads_set(struct sr_session *session,
+		gboolean enable);
+
 SR_API int sr_packet_copy(const struct sr_datafeed_packet *packet,
 		struct sr_datafeed_packet **copy);
 SR_API void sr_packet_free(struct sr_datafeed_packet *packet);
@@ -226,6 +259,11 @@ SR_API int sr_trigger_match_add(struct sr_trigger_stage *stage,
 SR_API GSList *sr_serial_list(const struct sr_dev_driver *driver);
 SR_API void sr_serial_free(struct sr_serial_port *serial);
 
+/*--- serial_reactor.c ------------------------------------------------------*/
+
+SR_API int sr_serial_reactor_stats_get(const struct sr_dev_inst *sdi,
+		struct sr_serial_reactor_stats *stats);
+
 /*--- resource.c ------------------------------------------------------------*/
 
 typedef int (*sr_resource_open_callback)(struct sr_resource *res,
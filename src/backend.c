@@ -538,11 +538,93 @@ static int sanity_check_all_transform_modules(void)
 	return ret;
 }
 
+/* Sanity-check all drivers and modules, see SIGROK_SANITY_CHECKS. */
+static int sanity_check_all(const struct sr_context *ctx)
+{
+	if (sanity_check_all_drivers(ctx) < 0) {
+		sr_err("Internal driver error(s), aborting.");
+		return SR_ERR;
+	}
+
+	if (sanity_check_all_input_modules() < 0) {
+		sr_err("Internal input module error(s), aborting.");
+		return SR_ERR;
+	}
+
+	if (sanity_check_all_output_modules() < 0) {
+		sr_err("Internal output module error(s), aborting.");
+		return SR_ERR;
+	}
+
+	if (sanity_check_all_transform_modules() < 0) {
+		sr_err("Internal transform module error(s), aborting.");
+		return SR_ERR;
+	}
+
+	return SR_OK;
+}
+
+/**
+ * Initialize the USB and HID transports, when the first driver gets
+ * initialized. Frontends which don't use hardware drivers (or only
+ * drivers without such devices) don't pay for their initialization.
+ *
+ * @param ctx Pointer to a libsigrok context struct. Must not be NULL.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR The initialization of a transport failed.
+ *
+ * @private
+ */
+SR_PRIV int sr_transports_init(struct sr_context *ctx)
+{
+#ifdef HAVE_LIBUSB_1_0
+	int ret;
+#endif
+
+	if (ctx->transports_ready)
+		return SR_OK;
+
+#ifdef HAVE_LIBUSB_1_0
+	ret = libusb_init(&ctx->libusb_ctx);
+	if (LIBUSB_SUCCESS != ret) {
+		sr_err("libusb_init() returned %s.", libusb_error_name(ret));
+		ctx->libusb_ctx = NULL;
+		return SR_ERR;
+	}
+#endif
+#ifdef HAVE_LIBHIDAPI
+	/*
+	 * According to <hidapi.h>, the hid_init() routine just returns
+	 * zero or non-zero, and hid_error() appears to relate to calls
+	 * for a specific device after hid_open(). Which means that there
+	 * is no more detailled information available beyond success/fail
+	 * at this point in time.
+	 */
+	if (hid_init() != 0) {
+		sr_err("HIDAPI hid_init() failed.");
+#ifdef HAVE_LIBUSB_1_0
+		libusb_exit(ctx->libusb_ctx);
+		ctx->libusb_ctx = NULL;
+#endif
+		return SR_ERR;
+	}
+#endif
+	ctx->transports_ready = TRUE;
+
+	return SR_OK;
+}
+
 /**
  * Initialize libsigrok.
  *
  * This function must be called before any other libsigrok function.
  *
+ * Initialization is kept cheap, transports get initialized along with
+ * the first hardware driver (see sr_driver_init()). The internal sanity
+ * checks of all drivers and modules only run when debug output is
+ * enabled, or when the SIGROK_SANITY_CHECKS environment variable is set.
+ *
  * @param ctx Pointer to a libsigrok context struct pointer. Must not be NULL.
  *            This will be a pointer to a newly allocated libsigrok context
  *            object upon success, and is undefined upon errors.
@@ -562,9 +644,11 @@ SR_API int sr_init(struct sr_context **ctx)
 	WSADATA wsadata;
 #endif
 
-	print_versions();
-
-	print_resourcepaths();
+	/* Only collect the information when it gets shown. */
+	if (sr_log_enabled(SR_LOG_DBG)) {
+		print_versions();
+		print_resourcepaths();
+	}
 
 	if (!ctx) {
 		sr_err("%s(): libsigrok context was NULL.", __func__);
@@ -575,24 +659,9 @@ SR_API int sr_init(struct sr_context **ctx)
 
 	sr_drivers_init(context);
 
-	if (sanity_check_all_drivers(context) < 0) {
-		sr_err("Internal driver error(s), aborting.");
-		goto done;
-	}
-
-	if (sanity_check_all_input_modules() < 0) {
-		sr_err("Internal input module error(s), aborting.");
-		goto done;
-	}
-
-	if (sanity_check_all_output_modules() < 0) {
-		sr_err("Internal output module error(s), aborting.");
-		goto done;
-	}
-
-	if (sanity_check_all_transform_modules() < 0) {
-		sr_err("Internal transform module error(s), aborting.");
-		goto done;
+	if (sr_log_enabled(SR_LOG_DBG) || g_getenv("SIGROK_SANITY_CHECKS")) {
+		if (sanity_check_all(context) < 0)
+			goto done;
 	}
 
 #ifdef _WIN32
@@ -611,28 +680,7 @@ SR_API int sr_init(struct sr_context **ctx)
 		goto done;
 	}
 
-#ifdef HAVE_LIBUSB_1_0
-	ret = libusb_init(&context->libusb_ctx);
-	if (LIBUSB_SUCCESS != ret) {
-		sr_err("libusb_init() returned %s.", libusb_error_name(ret));
-		ret = SR_ERR;
-		goto done;
-	}
-#endif
-#ifdef HAVE_LIBHIDAPI
-	/*
-	 * According to <hidapi.h>, the hid_init() routine just returns
-	 * zero or non-zero, and hid_error() appears to relate to calls
-	 * for a specific device after hid_open(). Which means that there
-	 * is no more detailled information available beyond success/fail
-	 * at this point in time.
-	 */
-	if (hid_init() != 0) {
-		sr_err("HIDAPI hid_init() failed.");
-		ret = SR_ERR;
-		goto done;
-	}
-#endif
+	sr_resource_cache_init(context);
 	sr_resource_set_hooks(context, NULL, NULL, NULL, NULL);
 
 	*ctx = context;
@@ -667,16 +715,21 @@ SR_API int sr_exit(struct sr_context *ctx)
 	WSACleanup();
 #endif
 
+	if (ctx->transports_ready) {
 #ifdef HAVE_LIBHIDAPI
-	hid_exit();
+		hid_exit();
 #endif
 #ifdef HAVE_LIBUSB_1_0
-	libusb_exit(ctx->libusb_ctx);
+		libusb_exit(ctx->libusb_ctx);
 #endif
+	}
 
+	sr_resource_cache_free(ctx);
 	g_free(sr_driver_list(ctx));
 	g_free(ctx);
 
+	sr_log_async_stop();
+
 	return SR_OK;
 }
 
@@ -472,6 +472,8 @@ SR_PRIV void sr_dev_inst_free(struct sr_dev_inst *sdi)
 	if (sdi->session)
 		sr_session_dev_remove(sdi->session, sdi);
 
+	sr_config_cache_free(sdi);
+
 	g_free(sdi->vendor);
 	g_free(sdi->model);
 	g_free(sdi->version);
@@ -568,6 +570,7 @@ SR_PRIV void sr_serial_dev_inst_free(struct sr_serial_dev_inst *serial)
 	if (!serial)
 		return;
 
+	serial_port_unlock(serial);
 	g_free(serial->port);
 	g_free(serial->serialcomm);
 	g_free(serial);
@@ -679,6 +682,8 @@ SR_API int sr_dev_open(struct sr_dev_inst *sdi)
 
 	sr_dbg("%s: Opening device instance.", sdi->driver->name);
 
+	sr_config_cache_invalidate(sdi);
+
 	ret = sdi->driver->dev_open(sdi);
 
 	if (ret == SR_OK)
@@ -719,6 +724,8 @@ SR_API int sr_dev_close(struct sr_dev_inst *sdi)
 
 	sdi->status = SR_ST_INACTIVE;
 
+	sr_config_cache_invalidate(sdi);
+
 	sr_dbg("%s: Closing device instance.", sdi->driver->name);
 
 	return sdi->driver->dev_close(sdi);
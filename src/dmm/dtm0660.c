@@ -39,50 +39,27 @@
 
 #define LOG_PREFIX "dtm0660"
 
-static int parse_digit(uint8_t b)
-{
-	switch (b) {
-	case 0xeb:
-		return 0;
-	case 0x0a:
-		return 1;
-	case 0xad:
-		return 2;
-	case 0x8f:
-		return 3;
-	case 0x4e:
-		return 4;
-	case 0xc7:
-		return 5;
-	case 0xe7:
-		return 6;
-	case 0x8a:
-		return 7;
-	case 0xef:
-		return 8;
-	case 0xcf:
-		return 9;
-	default:
-		sr_dbg("Invalid digit byte: 0x%02x.", b);
-		return -1;
-	}
-}
-
-static gboolean sync_nibbles_valid(const uint8_t *buf)
-{
-	int i;
-
-	/* Check the synchronization nibbles, and make sure they all match. */
-	for (i = 0; i < DTM0660_PACKET_SIZE; i++) {
-		if (((buf[i] >> 4) & 0x0f) != (i + 1)) {
-			sr_dbg("Sync nibble in byte %d (0x%02x) is invalid.",
-			       i, buf[i]);
-			return FALSE;
-		}
-	}
-
-	return TRUE;
-}
+static const struct sr_lcd_digits dtm0660_digits = {
+	/* Bit 4 in the byte is not part of the digit. */
+	.mask = 0xef,
+	.lut = SR_LCD_DIGIT_LUT(0xeb, 0x0a, 0xad, 0x8f, 0x4e,
+		0xc7, 0xe7, 0x8a, 0xef, 0xcf),
+};
+
+/* The upper nibble of each byte holds the byte's position (1-15). */
+static const uint8_t dtm0660_sync_mask[DTM0660_PACKET_SIZE] = {
+	0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0,
+	0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0,
+};
+static const uint8_t dtm0660_sync_value[DTM0660_PACKET_SIZE] = {
+	0x10, 0x20, 0x30, 0x40, 0x50, 0x60, 0x70, 0x80,
+	0x90, 0xa0, 0xb0, 0xc0, 0xd0, 0xe0, 0xf0,
+};
+SR_PRIV const struct sr_dmm_sync sr_dtm0660_sync = {
+	.length = DTM0660_PACKET_SIZE,
+	.mask = dtm0660_sync_mask,
+	.value = dtm0660_sync_value,
+};
 
 static gboolean flags_valid(const struct dtm0660_info *info)
 {
@@ -130,7 +107,7 @@ static gboolean flags_valid(const struct dtm0660_info *info)
 
 static int parse_value(const uint8_t *buf, float *result, int *exponent)
 {
-	int i, sign, intval = 0, digits[4];
+	int i, sign, intval;
 	uint8_t digit_bytes[4];
 	float floatval;
 
@@ -160,18 +137,17 @@ static int parse_value(const uint8_t *buf, float *result, int *exponent)
 		return SR_OK;
 	}
 
-	/* Parse the digits. */
-	for (i = 0; i < 4; i++)
-		digits[i] = parse_digit(digit_bytes[i]);
-	sr_spew("Digits: %02x %02x %02x %02x (%d%d%d%d).",
-		digit_bytes[0], digit_bytes[1], digit_bytes[2], digit_bytes[3],
-		digits[0], digits[1], digits[2], digits[3]);
-
-	/* Merge all digits into an integer value. */
-	for (i = 0; i < 4; i++) {
-		intval *= 10;
-		intval += digits[i];
+	/* Parse the digits, merge them into an integer value. */
+	if (sr_lcd_digits_decode(&dtm0660_digits, digit_bytes, 4,
+			&intval) != SR_OK) {
+		sr_dbg("Invalid digit bytes: %02x %02x %02x %02x.",
+			digit_bytes[0], digit_bytes[1],
+			digit_bytes[2], digit_bytes[3]);
+		return SR_ERR;
 	}
+	sr_spew("Digits: %02x %02x %02x %02x (%04d).",
+		digit_bytes[0], digit_bytes[1], digit_bytes[2], digit_bytes[3],
+		intval);
 
 	floatval = (float)intval;
 
@@ -349,9 +325,13 @@ SR_PRIV gboolean sr_dtm0660_packet_valid(const uint8_t *buf)
 {
 	struct dtm0660_info info;
 
+	/* Cheap rejection of misaligned data before the flags check. */
+	if (!sr_dmm_sync_match(&sr_dtm0660_sync, buf))
+		return FALSE;
+
 	parse_flags(buf, &info);
 
-	return (sync_nibbles_valid(buf) && flags_valid(&info));
+	return flags_valid(&info);
 }
 
 /**
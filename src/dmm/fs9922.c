@@ -320,6 +320,19 @@ static void handle_flags(struct sr_datafeed_analog *analog, float *floatval,
 
 }
 
+/* Bytes 12 and 13 always are carriage return and newline. */
+static const uint8_t fs9922_sync_mask[FS9922_PACKET_SIZE] = {
+	[12] = 0xff, [13] = 0xff,
+};
+static const uint8_t fs9922_sync_value[FS9922_PACKET_SIZE] = {
+	[12] = '\r', [13] = '\n',
+};
+SR_PRIV const struct sr_dmm_sync sr_fs9922_sync = {
+	.length = FS9922_PACKET_SIZE,
+	.mask = fs9922_sync_mask,
+	.value = fs9922_sync_value,
+};
+
 SR_PRIV gboolean sr_fs9922_packet_valid(const uint8_t *buf)
 {
 	struct fs9922_info info;
@@ -0,0 +1,181 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 libsigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Common support for DMM chipset parsers: Table driven decoding of LCD
+ * segment digits, and packet synchronization by means of fixed bits in
+ * the packets (sync nibbles, terminating characters).
+ *
+ * Digit decoding uses lookup tables which are set up at compile time
+ * (see SR_LCD_DIGIT_LUT()). Sync patterns are checked and searched for
+ * eight bytes at a time, which makes re-synchronization to the stream
+ * of RX data cheap when lots of garbage needs to get skipped.
+ */
+
+#include <config.h>
+#include <string.h>
+#include <glib.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+
+#define LOG_PREFIX "dmm-lcd"
+
+/**
+ * Decode a sequence of LCD segment digits to an integer value.
+ *
+ * @param[in] digits The chipset's digit lookup table.
+ * @param[in] codes The segment bit patterns, most significant digit first.
+ * @param[in] count The number of digits.
+ * @param[out] value The decoded value (no sign, no decimal point).
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_DATA At least one digit's segments are invalid.
+ */
+SR_PRIV int sr_lcd_digits_decode(const struct sr_lcd_digits *digits,
+	const uint8_t *codes, size_t count, int *value)
+{
+	int result, digit;
+	uint8_t invalid;
+
+	/*
+	 * Accumulate without branching on the individual digit's
+	 * validity, a zero table entry flags an invalid pattern.
+	 */
+	result = 0;
+	invalid = 0;
+	while (count--) {
+		digit = digits->lut[*codes++ & digits->mask];
+		invalid |= (digit == 0);
+		result = result * 10 + digit - 1;
+	}
+	if (invalid)
+		return SR_ERR_DATA;
+	*value = result;
+
+	return SR_OK;
+}
+
+#define BYTES_ONES	0x0101010101010101ULL
+#define BYTES_HIGHS	0x8080808080808080ULL
+#define HAS_ZERO_BYTE(x) \
+	(((x) - BYTES_ONES) & ~(x) & BYTES_HIGHS)
+
+static uint64_t load_word(const uint8_t *p)
+{
+	uint64_t w;
+
+	memcpy(&w, p, sizeof(w));
+
+	return w;
+}
+
+/**
+ * Check a packet's sync pattern.
+ *
+ * @param[in] sync The chipset's sync pattern.
+ * @param[in] buf The packet's data, at least the pattern's length.
+ *
+ * @return TRUE when all sync bits match, FALSE otherwise.
+ */
+SR_PRIV gboolean sr_dmm_sync_match(const struct sr_dmm_sync *sync,
+	const uint8_t *buf)
+{
+	size_t idx;
+	uint64_t diff;
+
+	for (idx = 0; idx + sizeof(diff) <= sync->length; idx += sizeof(diff)) {
+		diff = load_word(&buf[idx]) ^ load_word(&sync->value[idx]);
+		if (diff & load_word(&sync->mask[idx]))
+			return FALSE;
+	}
+	for (; idx < sync->length; idx++) {
+		if ((buf[idx] ^ sync->value[idx]) & sync->mask[idx])
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Search RX data for the next position where a packet's sync pattern
+ * matches.
+ *
+ * Only positions where a complete sync pattern is available are
+ * considered. The caller still needs to run the chipset's validity
+ * check on the returned position.
+ *
+ * @param[in] sync The chipset's sync pattern.
+ * @param[in] buf The RX data.
+ * @param[in] len The RX data's length.
+ *
+ * @return The offset of the first matching position. When no position
+ *   matches, the number of leading bytes which cannot start a packet.
+ */
+SR_PRIV size_t sr_dmm_sync_find(const struct sr_dmm_sync *sync,
+	const uint8_t *buf, size_t len)
+{
+	size_t anchor, last, pos;
+	uint8_t amask, avalue;
+	uint64_t wmask, wvalue;
+	const uint8_t *p;
+
+	if (len < sync->length)
+		return 0;
+	last = len - sync->length;
+
+	/* The first byte with sync bits serves as the search anchor. */
+	for (anchor = 0; anchor < sync->length; anchor++) {
+		if (sync->mask[anchor])
+			break;
+	}
+	if (anchor == sync->length)
+		return 0;
+	amask = sync->mask[anchor];
+	avalue = sync->value[anchor] & amask;
+	wmask = BYTES_ONES * amask;
+	wvalue = BYTES_ONES * avalue;
+
+	pos = 0;
+	while (pos <= last) {
+		if (amask == 0xff) {
+			p = memchr(&buf[pos + anchor], avalue, last - pos + 1);
+			if (!p)
+				break;
+			pos = p - &buf[anchor];
+		} else {
+			/* Skip eight candidates at once when none matches. */
+			while (pos + sizeof(wmask) <= last + 1) {
+				if (HAS_ZERO_BYTE((load_word(&buf[pos + anchor]) &
+						wmask) ^ wvalue))
+					break;
+				pos += sizeof(wmask);
+			}
+			while (pos <= last &&
+					((buf[pos + anchor] ^ avalue) & amask))
+				pos++;
+			if (pos > last)
+				break;
+		}
+		if (sr_dmm_sync_match(sync, &buf[pos]))
+			return pos;
+		pos++;
+	}
+
+	return last + 1;
+}
@@ -328,6 +328,19 @@ static gboolean flags_valid(const struct metex14_info *info)
 	return TRUE;
 }
 
+/* Byte 13 always is a carriage return. */
+static const uint8_t metex14_sync_mask[METEX14_PACKET_SIZE] = {
+	[13] = 0xff,
+};
+static const uint8_t metex14_sync_value[METEX14_PACKET_SIZE] = {
+	[13] = '\r',
+};
+SR_PRIV const struct sr_dmm_sync sr_metex14_sync = {
+	.length = METEX14_PACKET_SIZE,
+	.mask = metex14_sync_mask,
+	.value = metex14_sync_value,
+};
+
 #ifdef HAVE_SERIAL_COMM
 SR_PRIV int sr_metex14_packet_request(struct sr_serial_dev_inst *serial)
 {
@@ -352,15 +365,15 @@ SR_PRIV gboolean sr_metex14_packet_valid(const uint8_t *buf)
 {
 	struct metex14_info info;
 
+	if (buf[13] != '\r')
+		return FALSE;
+
 	memset(&info, 0x00, sizeof(struct metex14_info));
 	parse_flags((const char *)buf, &info);
 
 	if (!flags_valid(&info))
 		return FALSE;
 
-	if (buf[13] != '\r')
-		return FALSE;
-
 	return TRUE;
 }
 
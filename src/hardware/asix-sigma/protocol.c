@@ -1604,73 +1604,56 @@ SR_PRIV int sigma_convert_trigger(const struct sr_dev_inst *sdi)
 {
 	struct dev_context *devc;
 	struct sr_trigger *trigger;
-	struct sr_trigger_stage *stage;
-	struct sr_trigger_match *match;
-	const GSList *l, *m;
-	uint16_t channelbit;
-	size_t edge_count;
+	struct sr_trigger_compiled *tc;
+	const struct sr_trigger_masks *masks;
+	struct sigma_trigger *t;
+	size_t stage;
+	uint16_t edges;
+	int ret;
 
 	devc = sdi->priv;
-	memset(&devc->trigger, 0, sizeof(devc->trigger));
+	t = &devc->trigger;
+	memset(t, 0, sizeof(*t));
 	devc->use_triggers = FALSE;
 
 	/* TODO Consider additional SR_CONF_TRIGGER_PATTERN support. */
 	trigger = sr_session_trigger_get(sdi->session);
-	if (!trigger)
+	if (!trigger || !trigger->stages)
 		return SR_OK;
+	ret = sr_trigger_compile(trigger, sizeof(uint16_t), &tc);
+	if (ret != SR_OK)
+		return ret;
 
-	edge_count = 0;
-	for (l = trigger->stages; l; l = l->next) {
-		stage = l->data;
-		for (m = stage->matches; m; m = m->next) {
-			match = m->data;
-			/* Ignore disabled channels with a trigger. */
-			if (!match->channel->enabled)
-				continue;
-			channelbit = BIT(match->channel->index);
-			if (devc->clock.samplerate >= SR_MHZ(100)) {
-				/* Fast trigger support. */
-				if (edge_count > 0) {
-					sr_err("100/200MHz modes limited to single trigger pin.");
-					return SR_ERR;
-				}
-				if (match->match == SR_TRIGGER_FALLING) {
-					devc->trigger.fallingmask |= channelbit;
-				} else if (match->match == SR_TRIGGER_RISING) {
-					devc->trigger.risingmask |= channelbit;
-				} else {
-					sr_err("100/200MHz modes limited to edge trigger.");
-					return SR_ERR;
-				}
-
-				edge_count++;
-			} else {
-				/* Simple trigger support (event). */
-				if (match->match == SR_TRIGGER_ONE) {
-					devc->trigger.simplevalue |= channelbit;
-					devc->trigger.simplemask |= channelbit;
-				} else if (match->match == SR_TRIGGER_ZERO) {
-					devc->trigger.simplevalue &= ~channelbit;
-					devc->trigger.simplemask |= channelbit;
-				} else if (match->match == SR_TRIGGER_FALLING) {
-					devc->trigger.fallingmask |= channelbit;
-					edge_count++;
-				} else if (match->match == SR_TRIGGER_RISING) {
-					devc->trigger.risingmask |= channelbit;
-					edge_count++;
-				}
-
-				/*
-				 * Actually, Sigma supports 2 rising/falling triggers,
-				 * but they are ORed and the current trigger syntax
-				 * does not permit ORed triggers.
-				 */
-				if (edge_count > 1) {
-					sr_err("Limited to 1 edge trigger.");
-					return SR_ERR;
-				}
-			}
+	/* All stages' conditions apply at the same time. */
+	for (stage = 0; stage < tc->num_stages; stage++) {
+		masks = &tc->masks[stage];
+		t->simplevalue = (t->simplevalue & ~masks->zeros) | masks->ones;
+		t->simplemask |= masks->ones | masks->zeros;
+		t->risingmask |= masks->rising;
+		t->fallingmask |= masks->falling;
+	}
+	sr_trigger_compiled_free(tc);
+
+	edges = t->risingmask | t->fallingmask;
+	if (devc->clock.samplerate >= SR_MHZ(100)) {
+		/* Fast trigger support. */
+		if (edges & (edges - 1)) {
+			sr_err("100/200MHz modes limited to single trigger pin.");
+			return SR_ERR;
 		}
+		if (t->simplemask || !edges) {
+			sr_err("100/200MHz modes limited to edge trigger.");
+			return SR_ERR;
+		}
+		t->simplevalue = t->simplemask = 0;
+	} else if (edges & (edges - 1)) {
+		/*
+		 * Actually, Sigma supports 2 rising/falling triggers,
+		 * but they are ORed and the current trigger syntax
+		 * does not permit ORed triggers.
+		 */
+		sr_err("Limited to 1 edge trigger.");
+		return SR_ERR;
 	}
 
 	/* Keep track whether triggers are involved during acquisition. */
@@ -1684,8 +1667,7 @@ static gboolean sample_matches_trigger(struct dev_context *devc, uint16_t sample
 	struct sigma_sample_interp *interp;
 	uint16_t last_sample;
 	struct sigma_trigger *t;
-	gboolean simple_match, rising_match, falling_match;
-	gboolean matched;
+	uint16_t mismatch;
 
 	/*
 	 * This logic is about improving the precision of the hardware
@@ -1703,20 +1685,17 @@ static gboolean sample_matches_trigger(struct dev_context *devc, uint16_t sample
 
 	/*
 	 * Check if the current sample and its most recent transition
-	 * match the initially provided trigger condition. The data
-	 * must not fail either of the individual checks. Unused
-	 * trigger features remain neutral in the summary expression.
+	 * match the initially provided trigger condition. Collect the
+	 * bits which fail either of the individual checks, unused
+	 * trigger features have empty masks and remain neutral.
 	 */
 	last_sample = interp->last.sample;
 	t = &devc->trigger;
-	simple_match = (sample & t->simplemask) == t->simplevalue;
-	rising_match = ((last_sample & t->risingmask) == 0) &&
-			((sample & t->risingmask) == t->risingmask);
-	falling_match = ((last_sample & t->fallingmask) == t->fallingmask) &&
-			((sample & t->fallingmask) == 0);
-	matched = simple_match && rising_match && falling_match;
-
-	return matched;
+	mismatch = ((sample ^ t->simplevalue) & t->simplemask) |
+		((last_sample | ~sample) & t->risingmask) |
+		((~last_sample | sample) & t->fallingmask);
+
+	return mismatch == 0;
 }
 
 static int send_trigger_marker(struct dev_context *devc)
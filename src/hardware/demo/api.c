@@ -47,6 +47,11 @@ static const char *logic_pattern_str[] = {
 	"graycode",
 };
 
+static const char *device_mode_str[] = {
+	"realtime",
+	"max-throughput",
+};
+
 static const uint32_t scanopts[] = {
 	SR_CONF_NUM_LOGIC_CHANNELS,
 	SR_CONF_NUM_ANALOG_CHANNELS,
@@ -69,6 +74,8 @@ static const uint32_t devopts[] = {
 	SR_CONF_AVG_SAMPLES | SR_CONF_GET | SR_CONF_SET,
 	SR_CONF_TRIGGER_MATCH | SR_CONF_LIST,
 	SR_CONF_CAPTURE_RATIO | SR_CONF_GET | SR_CONF_SET,
+	SR_CONF_DEVICE_MODE | SR_CONF_GET | SR_CONF_SET | SR_CONF_LIST,
+	SR_CONF_BUFFERSIZE | SR_CONF_GET | SR_CONF_SET,
 };
 
 static const uint32_t devopts_cg_logic[] = {
@@ -148,6 +155,8 @@ static GSList *scan(struct sr_dev_driver *di, GSList *options)
 	devc->limit_frames = limit_frames;
 	devc->capture_ratio = 20;
 	devc->stl = NULL;
+	devc->mode = MODE_REALTIME;
+	devc->packet_samples = DEFAULT_PACKET_SAMPLES;
 
 	if (num_logic_channels > 0) {
 		/* Logic channels, all in one channel group. */
@@ -271,6 +280,12 @@ static int config_get(uint32_t key, GVariant **data,
 	case SR_CONF_AVG_SAMPLES:
 		*data = g_variant_new_uint64(devc->avg_samples);
 		break;
+	case SR_CONF_DEVICE_MODE:
+		*data = g_variant_new_string(device_mode_str[devc->mode]);
+		break;
+	case SR_CONF_BUFFERSIZE:
+		*data = g_variant_new_uint64(devc->packet_samples);
+		break;
 	case SR_CONF_MEASURED_QUANTITY:
 		if (!cg)
 			return SR_ERR_CHANNEL_GROUP;
@@ -336,7 +351,8 @@ static int config_set(uint32_t key, GVariant *data,
 	struct sr_channel *ch;
 	GVariant *mq_tuple_child;
 	GSList *l;
-	int logic_pattern, analog_pattern;
+	int logic_pattern, analog_pattern, mode;
+	uint64_t packet_samples;
 
 	devc = sdi->priv;
 
@@ -434,6 +450,18 @@ static int config_set(uint32_t key, GVariant *data,
 	case SR_CONF_CAPTURE_RATIO:
 		devc->capture_ratio = g_variant_get_uint64(data);
 		break;
+	case SR_CONF_DEVICE_MODE:
+		mode = std_str_idx(data, ARRAY_AND_SIZE(device_mode_str));
+		if (mode < 0)
+			return SR_ERR_ARG;
+		devc->mode = mode;
+		break;
+	case SR_CONF_BUFFERSIZE:
+		packet_samples = g_variant_get_uint64(data);
+		if (!packet_samples)
+			return SR_ERR_ARG;
+		devc->packet_samples = packet_samples;
+		break;
 	default:
 		return SR_ERR_NA;
 	}
@@ -457,6 +485,9 @@ static int config_list(uint32_t key, GVariant **data,
 		case SR_CONF_TRIGGER_MATCH:
 			*data = std_gvar_array_i32(ARRAY_AND_SIZE(trigger_matches));
 			break;
+		case SR_CONF_DEVICE_MODE:
+			*data = g_variant_new_strv(ARRAY_AND_SIZE(device_mode_str));
+			break;
 		default:
 			return SR_ERR_NA;
 		}
@@ -509,7 +540,12 @@ static int dev_acquisition_start(const struct sr_dev_inst *sdi)
 	devc->sent_frame_samples = 0;
 
 	/* Setup triggers */
-	if ((trigger = sr_session_trigger_get(sdi->session))) {
+	trigger = sr_session_trigger_get(sdi->session);
+	if (trigger && devc->mode == MODE_MAX_THROUGHPUT) {
+		sr_warn("Triggers are not supported in max throughput mode.");
+		trigger = NULL;
+	}
+	if (trigger) {
 		int pre_trigger_samples = 0;
 		if (devc->limit_samples > 0)
 			pre_trigger_samples = (devc->capture_ratio * devc->limit_samples) / 100;
@@ -567,18 +603,25 @@ static int dev_acquisition_start(const struct sr_dev_inst *sdi)
 		devc->first_partial_logic_index,
 		devc->first_partial_logic_mask);
 
-	sr_session_source_add(sdi->session, -1, 0, 100,
-			demo_prepare_data, (struct sr_dev_inst *)sdi);
+	devc->step = 0;
+	if (devc->mode == MODE_MAX_THROUGHPUT) {
+		/* Frames and averaging don't apply, packets get reused. */
+		demo_prepare_packets((struct sr_dev_inst *)sdi);
+		sr_session_source_add(sdi->session, -1, 0, 0,
+				demo_send_packets, (struct sr_dev_inst *)sdi);
+	} else {
+		sr_session_source_add(sdi->session, -1, 0, 100,
+				demo_prepare_data, (struct sr_dev_inst *)sdi);
+	}
 
 	std_session_send_df_header(sdi);
 
-	if (devc->limit_frames > 0)
+	if (devc->limit_frames > 0 && devc->mode == MODE_REALTIME)
 		std_session_send_df_frame_begin(sdi);
 
 	/* We use this timestamp to decide how many more samples to send. */
 	devc->start_us = g_get_monotonic_time();
 	devc->spent_us = 0;
-	devc->step = 0;
 
 	return SR_OK;
 }
@@ -586,12 +629,22 @@ static int dev_acquisition_start(const struct sr_dev_inst *sdi)
 static int dev_acquisition_stop(struct sr_dev_inst *sdi)
 {
 	struct dev_context *devc;
+	int64_t elapsed_us;
 
 	sr_session_source_remove(sdi->session, -1);
 
 	devc = sdi->priv;
-	if (devc->limit_frames > 0)
+	if (devc->mode == MODE_MAX_THROUGHPUT) {
+		elapsed_us = MAX(1, g_get_monotonic_time() - devc->start_us);
+		sr_info("Sent %" PRIu64 " samples in %" PRIu64 " packets "
+			"within %" PRIi64 " ms, %.0f samples/s.",
+			devc->sent_samples, devc->sent_packets,
+			elapsed_us / 1000, (double)devc->sent_samples *
+			G_USEC_PER_SEC / elapsed_us);
+		demo_free_packets(devc);
+	} else if (devc->limit_frames > 0) {
 		std_session_send_df_frame_end(sdi);
+	}
 
 	std_session_send_df_end(sdi);
 
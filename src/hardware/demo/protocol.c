@@ -399,6 +399,79 @@ static void logic_fixup_feed(struct dev_context *devc,
 	}
 }
 
+/* The unit for a measured quantity. */
+static enum sr_unit mq_unit(enum sr_mq mq)
+{
+	if (mq == SR_MQ_VOLTAGE)
+		return SR_UNIT_VOLT;
+	else if (mq == SR_MQ_CURRENT)
+		return SR_UNIT_AMPERE;
+	else if (mq == SR_MQ_RESISTANCE)
+		return SR_UNIT_OHM;
+	else if (mq == SR_MQ_CAPACITANCE)
+		return SR_UNIT_FARAD;
+	else if (mq == SR_MQ_TEMPERATURE)
+		return SR_UNIT_CELSIUS;
+	else if (mq == SR_MQ_FREQUENCY)
+		return SR_UNIT_HERTZ;
+	else if (mq == SR_MQ_DUTY_CYCLE)
+		return SR_UNIT_PERCENTAGE;
+	else if (mq == SR_MQ_CONTINUITY)
+		return SR_UNIT_OHM;
+	else if (mq == SR_MQ_PULSE_WIDTH)
+		return SR_UNIT_PERCENTAGE;
+	else if (mq == SR_MQ_CONDUCTANCE)
+		return SR_UNIT_SIEMENS;
+	else if (mq == SR_MQ_POWER)
+		return SR_UNIT_WATT;
+	else if (mq == SR_MQ_GAIN)
+		return SR_UNIT_UNITLESS;
+	else if (mq == SR_MQ_SOUND_PRESSURE_LEVEL)
+		return SR_UNIT_DECIBEL_SPL;
+	else if (mq == SR_MQ_CARBON_MONOXIDE)
+		return SR_UNIT_CONCENTRATION;
+	else if (mq == SR_MQ_RELATIVE_HUMIDITY)
+		return SR_UNIT_HUMIDITY_293K;
+	else if (mq == SR_MQ_TIME)
+		return SR_UNIT_SECOND;
+	else if (mq == SR_MQ_WIND_SPEED)
+		return SR_UNIT_METER_SECOND;
+	else if (mq == SR_MQ_PRESSURE)
+		return SR_UNIT_HECTOPASCAL;
+	else if (mq == SR_MQ_PARALLEL_INDUCTANCE)
+		return SR_UNIT_HENRY;
+	else if (mq == SR_MQ_PARALLEL_CAPACITANCE)
+		return SR_UNIT_FARAD;
+	else if (mq == SR_MQ_PARALLEL_RESISTANCE)
+		return SR_UNIT_OHM;
+	else if (mq == SR_MQ_SERIES_INDUCTANCE)
+		return SR_UNIT_HENRY;
+	else if (mq == SR_MQ_SERIES_CAPACITANCE)
+		return SR_UNIT_FARAD;
+	else if (mq == SR_MQ_SERIES_RESISTANCE)
+		return SR_UNIT_OHM;
+	else if (mq == SR_MQ_DISSIPATION_FACTOR)
+		return SR_UNIT_UNITLESS;
+	else if (mq == SR_MQ_QUALITY_FACTOR)
+		return SR_UNIT_UNITLESS;
+	else if (mq == SR_MQ_PHASE_ANGLE)
+		return SR_UNIT_DEGREE;
+	else if (mq == SR_MQ_DIFFERENCE)
+		return SR_UNIT_UNITLESS;
+	else if (mq == SR_MQ_COUNT)
+		return SR_UNIT_PIECE;
+	else if (mq == SR_MQ_POWER_FACTOR)
+		return SR_UNIT_UNITLESS;
+	else if (mq == SR_MQ_APPARENT_POWER)
+		return SR_UNIT_VOLT_AMPERE;
+	else if (mq == SR_MQ_MASS)
+		return SR_UNIT_GRAM;
+	else if (mq == SR_MQ_HARMONIC_RATIO)
+		return SR_UNIT_UNITLESS;
+	else
+		return SR_UNIT_UNITLESS;
+}
+
 static void send_analog_packet(struct analog_gen *ag,
 		struct sr_dev_inst *sdi, uint64_t *analog_sent,
 		uint64_t analog_pos, uint64_t analog_todo)
@@ -426,74 +499,7 @@ static void send_analog_packet(struct analog_gen *ag,
 	ag->packet.meaning->mqflags = ag->mq_flags;
 
 	/* Set a unit for the given quantity. */
-	if (ag->mq == SR_MQ_VOLTAGE)
-		ag->packet.meaning->unit = SR_UNIT_VOLT;
-	else if (ag->mq == SR_MQ_CURRENT)
-		ag->packet.meaning->unit = SR_UNIT_AMPERE;
-	else if (ag->mq == SR_MQ_RESISTANCE)
-		ag->packet.meaning->unit = SR_UNIT_OHM;
-	else if (ag->mq == SR_MQ_CAPACITANCE)
-		ag->packet.meaning->unit = SR_UNIT_FARAD;
-	else if (ag->mq == SR_MQ_TEMPERATURE)
-		ag->packet.meaning->unit = SR_UNIT_CELSIUS;
-	else if (ag->mq == SR_MQ_FREQUENCY)
-		ag->packet.meaning->unit = SR_UNIT_HERTZ;
-	else if (ag->mq == SR_MQ_DUTY_CYCLE)
-		ag->packet.meaning->unit = SR_UNIT_PERCENTAGE;
-	else if (ag->mq == SR_MQ_CONTINUITY)
-		ag->packet.meaning->unit = SR_UNIT_OHM;
-	else if (ag->mq == SR_MQ_PULSE_WIDTH)
-		ag->packet.meaning->unit = SR_UNIT_PERCENTAGE;
-	else if (ag->mq == SR_MQ_CONDUCTANCE)
-		ag->packet.meaning->unit = SR_UNIT_SIEMENS;
-	else if (ag->mq == SR_MQ_POWER)
-		ag->packet.meaning->unit = SR_UNIT_WATT;
-	else if (ag->mq == SR_MQ_GAIN)
-		ag->packet.meaning->unit = SR_UNIT_UNITLESS;
-	else if (ag->mq == SR_MQ_SOUND_PRESSURE_LEVEL)
-		ag->packet.meaning->unit = SR_UNIT_DECIBEL_SPL;
-	else if (ag->mq == SR_MQ_CARBON_MONOXIDE)
-		ag->packet.meaning->unit = SR_UNIT_CONCENTRATION;
-	else if (ag->mq == SR_MQ_RELATIVE_HUMIDITY)
-		ag->packet.meaning->unit = SR_UNIT_HUMIDITY_293K;
-	else if (ag->mq == SR_MQ_TIME)
-		ag->packet.meaning->unit = SR_UNIT_SECOND;
-	else if (ag->mq == SR_MQ_WIND_SPEED)
-		ag->packet.meaning->unit = SR_UNIT_METER_SECOND;
-	else if (ag->mq == SR_MQ_PRESSURE)
-		ag->packet.meaning->unit = SR_UNIT_HECTOPASCAL;
-	else if (ag->mq == SR_MQ_PARALLEL_INDUCTANCE)
-		ag->packet.meaning->unit = SR_UNIT_HENRY;
-	else if (ag->mq == SR_MQ_PARALLEL_CAPACITANCE)
-		ag->packet.meaning->unit = SR_UNIT_FARAD;
-	else if (ag->mq == SR_MQ_PARALLEL_RESISTANCE)
-		ag->packet.meaning->unit = SR_UNIT_OHM;
-	else if (ag->mq == SR_MQ_SERIES_INDUCTANCE)
-		ag->packet.meaning->unit = SR_UNIT_HENRY;
-	else if (ag->mq == SR_MQ_SERIES_CAPACITANCE)
-		ag->packet.meaning->unit = SR_UNIT_FARAD;
-	else if (ag->mq == SR_MQ_SERIES_RESISTANCE)
-		ag->packet.meaning->unit = SR_UNIT_OHM;
-	else if (ag->mq == SR_MQ_DISSIPATION_FACTOR)
-		ag->packet.meaning->unit = SR_UNIT_UNITLESS;
-	else if (ag->mq == SR_MQ_QUALITY_FACTOR)
-		ag->packet.meaning->unit = SR_UNIT_UNITLESS;
-	else if (ag->mq == SR_MQ_PHASE_ANGLE)
-		ag->packet.meaning->unit = SR_UNIT_DEGREE;
-	else if (ag->mq == SR_MQ_DIFFERENCE)
-		ag->packet.meaning->unit = SR_UNIT_UNITLESS;
-	else if (ag->mq == SR_MQ_COUNT)
-		ag->packet.meaning->unit = SR_UNIT_PIECE;
-	else if (ag->mq == SR_MQ_POWER_FACTOR)
-		ag->packet.meaning->unit = SR_UNIT_UNITLESS;
-	else if (ag->mq == SR_MQ_APPARENT_POWER)
-		ag->packet.meaning->unit = SR_UNIT_VOLT_AMPERE;
-	else if (ag->mq == SR_MQ_MASS)
-		ag->packet.meaning->unit = SR_UNIT_GRAM;
-	else if (ag->mq == SR_MQ_HARMONIC_RATIO)
-		ag->packet.meaning->unit = SR_UNIT_UNITLESS;
-	else
-		ag->packet.meaning->unit = SR_UNIT_UNITLESS;
+	ag->packet.meaning->unit = mq_unit(ag->mq);
 
 	if (!devc->avg) {
 		ag_pattern_pos = analog_pos % pattern->num_samples;
@@ -747,3 +753,152 @@ SR_PRIV int demo_prepare_data(int fd, int revents, void *cb_data)
 
 	return G_SOURCE_CONTINUE;
 }
+
+/*
+ * Max throughput mode: One packet's worth of logic data, and of every
+ * enabled analog channel's data gets generated before the acquisition.
+ * These packets are sent over and over, so that the cost of generating
+ * samples doesn't limit the throughput of the session's datafeed.
+ */
+SR_PRIV void demo_prepare_packets(struct sr_dev_inst *sdi)
+{
+	struct dev_context *devc;
+	struct sr_datafeed_logic logic;
+	struct analog_gen *ag;
+	struct analog_pattern *pattern;
+	GHashTableIter iter;
+	void *value;
+	size_t size, off, chunk;
+	uint64_t i;
+	float amplitude, offset;
+
+	devc = sdi->priv;
+
+	if (devc->enabled_logic_channels) {
+		size = devc->packet_samples * devc->logic_unitsize;
+		devc->packet_logic = g_malloc(size);
+		chunk = LOGIC_BUFSIZE / devc->logic_unitsize * devc->logic_unitsize;
+		for (off = 0; off < size; off += chunk) {
+			chunk = MIN(chunk, size - off);
+			logic_generator(sdi, chunk);
+			memcpy(devc->packet_logic + off, devc->logic_data, chunk);
+		}
+		logic.data = devc->packet_logic;
+		logic.length = size;
+		logic.unitsize = devc->logic_unitsize;
+		logic_fixup_feed(devc, &logic);
+	}
+
+	g_hash_table_iter_init(&iter, devc->ch_ag);
+	while (g_hash_table_iter_next(&iter, NULL, &value)) {
+		ag = value;
+		if (!ag->ch || !ag->ch->enabled)
+			continue;
+		pattern = devc->analog_patterns[ag->pattern];
+		if (ag->pattern == PATTERN_ANALOG_RANDOM) {
+			amplitude = ag->amplitude / 500.0;
+			offset = ag->offset - DEFAULT_ANALOG_OFFSET - ag->amplitude;
+		} else {
+			amplitude = ag->amplitude / DEFAULT_ANALOG_AMPLITUDE;
+			offset = ag->offset - DEFAULT_ANALOG_OFFSET;
+		}
+		ag->packet_data = g_malloc(devc->packet_samples * sizeof(float));
+		for (i = 0; i < devc->packet_samples; i++) {
+			if (ag->pattern == PATTERN_ANALOG_RANDOM)
+				ag->packet_data[i] = (rand() % 1000) * amplitude + offset;
+			else
+				ag->packet_data[i] = pattern->data[i % pattern->num_samples]
+					* amplitude + offset;
+		}
+		ag->packet_channels = g_slist_append(NULL, ag->ch);
+		ag->packet.meaning->channels = ag->packet_channels;
+		ag->packet.meaning->mq = ag->mq;
+		ag->packet.meaning->mqflags = ag->mq_flags;
+		ag->packet.meaning->unit = mq_unit(ag->mq);
+		ag->packet.data = ag->packet_data;
+	}
+
+	devc->sent_packets = 0;
+}
+
+SR_PRIV void demo_free_packets(struct dev_context *devc)
+{
+	struct analog_gen *ag;
+	GHashTableIter iter;
+	void *value;
+
+	g_free(devc->packet_logic);
+	devc->packet_logic = NULL;
+
+	g_hash_table_iter_init(&iter, devc->ch_ag);
+	while (g_hash_table_iter_next(&iter, NULL, &value)) {
+		ag = value;
+		g_free(ag->packet_data);
+		ag->packet_data = NULL;
+		g_slist_free(ag->packet_channels);
+		ag->packet_channels = NULL;
+		ag->packet.meaning->channels = NULL;
+	}
+}
+
+/* Callback sending the precomputed packets, not throttled. */
+SR_PRIV int demo_send_packets(int fd, int revents, void *cb_data)
+{
+	struct sr_dev_inst *sdi;
+	struct dev_context *devc;
+	struct sr_datafeed_packet packet;
+	struct sr_datafeed_logic logic;
+	struct analog_gen *ag;
+	GHashTableIter iter;
+	void *value;
+	uint64_t count;
+	int64_t now, slice_end;
+
+	(void)fd;
+	(void)revents;
+
+	sdi = cb_data;
+	devc = sdi->priv;
+
+	now = g_get_monotonic_time();
+	slice_end = now + MAX_THROUGHPUT_SLICE_US;
+	do {
+		count = devc->packet_samples;
+		if (devc->limit_samples > 0)
+			count = MIN(count, devc->limit_samples - devc->sent_samples);
+		if (devc->limit_msec > 0 &&
+				now - devc->start_us >= (int64_t)devc->limit_msec * 1000)
+			count = 0;
+		if (!count) {
+			sr_dbg("Requested number of samples reached.");
+			sr_dev_acquisition_stop(sdi);
+			break;
+		}
+
+		if (devc->packet_logic) {
+			packet.type = SR_DF_LOGIC;
+			packet.payload = &logic;
+			logic.length = count * devc->logic_unitsize;
+			logic.unitsize = devc->logic_unitsize;
+			logic.data = devc->packet_logic;
+			sr_session_send(sdi, &packet);
+		}
+
+		g_hash_table_iter_init(&iter, devc->ch_ag);
+		while (g_hash_table_iter_next(&iter, NULL, &value)) {
+			ag = value;
+			if (!ag->packet_data)
+				continue;
+			packet.type = SR_DF_ANALOG;
+			packet.payload = &ag->packet;
+			ag->packet.num_samples = count;
+			sr_session_send(sdi, &packet);
+		}
+
+		devc->sent_samples += count;
+		devc->sent_packets++;
+		now = g_get_monotonic_time();
+	} while (now < slice_end);
+
+	return G_SOURCE_CONTINUE;
+}
@@ -37,6 +37,10 @@
 /* This is a development feature: it starts a new frame every n samples. */
 #define SAMPLES_PER_FRAME		1000UL
 #define DEFAULT_LIMIT_FRAMES		0
+/* Samples per packet in max throughput mode. */
+#define DEFAULT_PACKET_SAMPLES		(64 * 1024)
+/* Max throughput mode returns to the main loop this often (in us). */
+#define MAX_THROUGHPUT_SLICE_US		10000
 
 #define DEFAULT_ANALOG_ENCODING_DIGITS	4
 #define DEFAULT_ANALOG_SPEC_DIGITS		4
@@ -106,6 +110,13 @@ static const char *analog_pattern_str[] = {
 	"random",
 };
 
+enum device_mode {
+	/* Samples get sent at the rate of the configured samplerate. */
+	MODE_REALTIME,
+	/* The same precomputed packets get sent as fast as possible. */
+	MODE_MAX_THROUGHPUT,
+};
+
 struct analog_pattern {
 	float data[ANALOG_BUFSIZE];
 	unsigned int num_samples;
@@ -142,6 +153,11 @@ struct dev_context {
 	uint64_t capture_ratio;
 	gboolean trigger_fired;
 	struct soft_trigger_logic *stl;
+	/* Max throughput mode */
+	enum device_mode mode;
+	uint64_t packet_samples;
+	uint8_t *packet_logic;
+	uint64_t sent_packets;
 };
 
 struct analog_gen {
@@ -158,10 +174,16 @@ struct analog_gen {
 	struct sr_analog_spec spec;
 	float avg_val; /* Average value */
 	unsigned int num_avgs; /* Number of samples averaged */
+	/* Max throughput mode */
+	float *packet_data;
+	GSList *packet_channels;
 };
 
 SR_PRIV void demo_generate_analog_pattern(struct dev_context *devc);
 SR_PRIV void demo_free_analog_pattern(struct dev_context *devc);
 SR_PRIV int demo_prepare_data(int fd, int revents, void *cb_data);
+SR_PRIV void demo_prepare_packets(struct sr_dev_inst *sdi);
+SR_PRIV void demo_free_packets(struct dev_context *devc);
+SR_PRIV int demo_send_packets(int fd, int revents, void *cb_data);
 
 #endif
@@ -39,6 +39,8 @@
 #define DS_CMD_RD_NVM_PRE		0xbb
 #define DS_CMD_GET_HW_INFO		0xbc
 
+#define DS_HW_INFO_FPGA_DONE		(1 << 6)
+
 #define DS_START_FLAGS_STOP		(1 << 7)
 #define DS_START_FLAGS_CLK_48MHZ	(1 << 6)
 #define DS_START_FLAGS_SAMPLE_WIDE	(1 << 5)
@@ -138,6 +140,8 @@ struct fpga_config {
  */
 #define FW_BUFSIZE (1024 * 1024)
 
+#define FPGA_FIRMWARE_MAX_SIZE (4 * 1024 * 1024)
+
 #define FPGA_UPLOAD_DELAY (10 * 1000)
 
 #define USB_TIMEOUT (3 * 1000)
@@ -178,6 +182,24 @@ static int command_get_revid_version(struct sr_dev_inst *sdi, uint8_t *revid)
 	return SR_OK;
 }
 
+static int command_get_hw_info(const struct sr_dev_inst *sdi, uint8_t *info)
+{
+	struct sr_usb_dev_inst *usb = sdi->conn;
+	int ret;
+
+	ret = libusb_control_transfer(usb->devhdl, LIBUSB_REQUEST_TYPE_VENDOR |
+		LIBUSB_ENDPOINT_IN, DS_CMD_GET_HW_INFO, 0x0000, 0x0000,
+		info, 1, USB_TIMEOUT);
+
+	if (ret != 1) {
+		sr_dbg("Unable to get hardware info: %s.",
+		       ret < 0 ? libusb_error_name(ret) : "short read");
+		return SR_ERR;
+	}
+
+	return SR_OK;
+}
+
 static int command_start_acquisition(const struct sr_dev_inst *sdi)
 {
 	struct sr_usb_dev_inst *usb;
@@ -220,55 +242,25 @@ static int command_stop_acquisition(const struct sr_dev_inst *sdi)
 	return SR_OK;
 }
 
-SR_PRIV int dslogic_fpga_firmware_upload(const struct sr_dev_inst *sdi)
+static int send_fpga_firmware(const struct sr_dev_inst *sdi,
+	const struct sr_resource_image *bitstream)
 {
-	const char *name = NULL;
-	uint64_t sum;
-	struct sr_resource bitstream;
-	struct drv_context *drvc;
-	struct dev_context *devc;
 	struct sr_usb_dev_inst *usb;
 	unsigned char *buf;
-	ssize_t chunksize;
+	size_t chunksize, sum;
 	int transferred;
 	int result, ret;
 	const uint8_t cmd[3] = {0, 0, 0};
 
-	drvc = sdi->driver->context;
-	devc = sdi->priv;
 	usb = sdi->conn;
 
-	if (!strcmp(devc->profile->model, "DSLogic")) {
-		if (devc->cur_threshold < 1.40)
-			name = DSLOGIC_FPGA_FIRMWARE_3V3;
-		else
-			name = DSLOGIC_FPGA_FIRMWARE_5V;
-	} else if (!strcmp(devc->profile->model, "DSLogic Pro")){
-		name = DSLOGIC_PRO_FPGA_FIRMWARE;
-	} else if (!strcmp(devc->profile->model, "DSLogic Plus")){
-		name = DSLOGIC_PLUS_FPGA_FIRMWARE;
-	} else if (!strcmp(devc->profile->model, "DSLogic Basic")){
-		name = DSLOGIC_BASIC_FPGA_FIRMWARE;
-	} else if (!strcmp(devc->profile->model, "DSCope")) {
-		name = DSCOPE_FPGA_FIRMWARE;
-	} else {
-		sr_err("Failed to select FPGA firmware.");
-		return SR_ERR;
-	}
-
-	sr_dbg("Uploading FPGA firmware '%s'.", name);
-
-	result = sr_resource_open(drvc->sr_ctx, &bitstream,
-			SR_RESOURCE_FIRMWARE, name);
-	if (result != SR_OK)
-		return result;
+	sr_dbg("Uploading FPGA firmware '%s'.", bitstream->name);
 
 	/* Tell the device firmware is coming. */
 	if ((ret = libusb_control_transfer(usb->devhdl, LIBUSB_REQUEST_TYPE_VENDOR |
 			LIBUSB_ENDPOINT_OUT, DS_CMD_CONFIG, 0x0000, 0x0000,
 			(unsigned char *)&cmd, sizeof(cmd), USB_TIMEOUT)) < 0) {
 		sr_err("Failed to upload FPGA firmware: %s.", libusb_error_name(ret));
-		sr_resource_close(drvc->sr_ctx, &bitstream);
 		return SR_ERR;
 	}
 
@@ -276,15 +268,10 @@ SR_PRIV int dslogic_fpga_firmware_upload(const struct sr_dev_inst *sdi)
 	g_usleep(FPGA_UPLOAD_DELAY);
 
 	buf = g_malloc(FW_BUFSIZE);
-	sum = 0;
 	result = SR_OK;
-	while (1) {
-		chunksize = sr_resource_read(drvc->sr_ctx, &bitstream,
-				buf, FW_BUFSIZE);
-		if (chunksize < 0)
-			result = SR_ERR;
-		if (chunksize <= 0)
-			break;
+	for (sum = 0; sum < bitstream->size; sum += transferred) {
+		chunksize = MIN(bitstream->size - sum, FW_BUFSIZE);
+		memcpy(buf, &bitstream->data[sum], chunksize);
 
 		if ((ret = libusb_bulk_transfer(usb->devhdl, 2 | LIBUSB_ENDPOINT_OUT,
 				buf, chunksize, &transferred, USB_TIMEOUT)) < 0) {
@@ -293,18 +280,16 @@ SR_PRIV int dslogic_fpga_firmware_upload(const struct sr_dev_inst *sdi)
 			result = SR_ERR;
 			break;
 		}
-		sum += transferred;
-		sr_spew("Uploaded %" PRIu64 "/%" PRIu64 " bytes.",
-			sum, bitstream.size);
+		sr_spew("Uploaded %zu/%zu bytes.",
+			sum + transferred, bitstream->size);
 
-		if (transferred != chunksize) {
+		if ((size_t)transferred != chunksize) {
 			sr_err("Short transfer while uploading FPGA firmware.");
 			result = SR_ERR;
 			break;
 		}
 	}
 	g_free(buf);
-	sr_resource_close(drvc->sr_ctx, &bitstream);
 
 	if (result == SR_OK)
 		sr_dbg("FPGA firmware upload done.");
@@ -312,6 +297,89 @@ SR_PRIV int dslogic_fpga_firmware_upload(const struct sr_dev_inst *sdi)
 	return result;
 }
 
+/*
+ * Check whether the FPGA still runs a bitstream which was uploaded
+ * before (when the device was opened last). The FX2 firmware reports
+ * whether the FPGA is configured (its DONE pin), which it no longer is
+ * after the device lost power.
+ */
+static gboolean fpga_firmware_loaded(const struct sr_dev_inst *sdi,
+	const struct sr_resource_image *bitstream, const char *location)
+{
+	struct drv_context *drvc;
+	uint8_t hw_info;
+
+	drvc = sdi->driver->context;
+
+	if (!sr_resource_image_loaded(drvc->sr_ctx, location, bitstream))
+		return FALSE;
+
+	if (command_get_hw_info(sdi, &hw_info) != SR_OK ||
+			!(hw_info & DS_HW_INFO_FPGA_DONE)) {
+		sr_info("FPGA is not configured, uploading the firmware again.");
+		sr_resource_image_set_loaded(drvc->sr_ctx, location, NULL);
+		return FALSE;
+	}
+	sr_info("FPGA firmware '%s' is loaded already.", bitstream->name);
+
+	return TRUE;
+}
+
+SR_PRIV int dslogic_fpga_firmware_upload(const struct sr_dev_inst *sdi)
+{
+	const char *name = NULL;
+	struct sr_resource_image *bitstream;
+	struct drv_context *drvc;
+	struct dev_context *devc;
+	char *location;
+	int result;
+
+	drvc = sdi->driver->context;
+	devc = sdi->priv;
+
+	if (!strcmp(devc->profile->model, "DSLogic")) {
+		if (devc->cur_threshold < 1.40)
+			name = DSLOGIC_FPGA_FIRMWARE_3V3;
+		else
+			name = DSLOGIC_FPGA_FIRMWARE_5V;
+	} else if (!strcmp(devc->profile->model, "DSLogic Pro")){
+		name = DSLOGIC_PRO_FPGA_FIRMWARE;
+	} else if (!strcmp(devc->profile->model, "DSLogic Plus")){
+		name = DSLOGIC_PLUS_FPGA_FIRMWARE;
+	} else if (!strcmp(devc->profile->model, "DSLogic Basic")){
+		name = DSLOGIC_BASIC_FPGA_FIRMWARE;
+	} else if (!strcmp(devc->profile->model, "DSCope")) {
+		name = DSCOPE_FPGA_FIRMWARE;
+	} else {
+		sr_err("Failed to select FPGA firmware.");
+		return SR_ERR;
+	}
+
+	bitstream = sr_resource_image_get(drvc->sr_ctx, SR_RESOURCE_FIRMWARE,
+			name, FPGA_FIRMWARE_MAX_SIZE);
+	if (!bitstream)
+		return SR_ERR;
+
+	/*
+	 * The FPGA keeps its configuration while the device stays on the
+	 * bus. Skip the upload when it still runs this firmware.
+	 */
+	location = sr_usb_location(sdi);
+	if (fpga_firmware_loaded(sdi, bitstream, location)) {
+		result = SR_OK;
+	} else {
+		sr_resource_image_set_loaded(drvc->sr_ctx, location, NULL);
+		result = send_fpga_firmware(sdi, bitstream);
+		if (result == SR_OK)
+			sr_resource_image_set_loaded(drvc->sr_ctx, location,
+				bitstream);
+	}
+	g_free(location);
+	sr_resource_image_unref(bitstream);
+
+	return result;
+}
+
 static unsigned int enabled_channel_count(const struct sr_dev_inst *sdi)
 {
 	unsigned int count = 0;
@@ -662,19 +730,17 @@ SR_PRIV struct dev_context *dslogic_dev_new(void)
 
 static void abort_acquisition(struct dev_context *devc)
 {
-	int i;
-
 	devc->acq_aborted = TRUE;
 
-	for (i = devc->num_transfers - 1; i >= 0; i--) {
-		if (devc->transfers[i])
-			libusb_cancel_transfer(devc->transfers[i]);
-	}
+	if (devc->trigger_transfer)
+		libusb_cancel_transfer(devc->trigger_transfer);
+	sr_usb_stream_cancel(devc->stream);
 }
 
 static void finish_acquisition(struct sr_dev_inst *sdi)
 {
 	struct dev_context *devc;
+	struct sr_usb_stream_stats stats;
 
 	devc = sdi->priv;
 
@@ -682,46 +748,40 @@ static void finish_acquisition(struct sr_dev_inst *sdi)
 
 	usb_source_remove(sdi->session, devc->ctx);
 
-	devc->num_transfers = 0;
-	g_free(devc->transfers);
+	sr_usb_stream_get_stats(devc->stream, &stats);
+	sr_dbg("%" PRIu64 " transfers (%" PRIu64 " empty), %" PRIu64
+		" times starved, latency %" PRIu64 "-%" PRIu64 "us, "
+		"%u transfers of %zu bytes at the end.",
+		stats.transfers, stats.empty_transfers, stats.starved,
+		stats.latency_min_us, stats.latency_max_us,
+		stats.transfers_in_flight, stats.transfer_size);
+
 	g_free(devc->deinterleave_buffer);
+	devc->deinterleave_buffer = NULL;
 }
 
-static void free_transfer(struct libusb_transfer *transfer)
+static void free_transfer(struct sr_dev_inst *sdi,
+	struct libusb_transfer *transfer)
 {
-	struct sr_dev_inst *sdi;
 	struct dev_context *devc;
-	unsigned int i;
 
-	sdi = transfer->user_data;
 	devc = sdi->priv;
 
-	g_free(transfer->buffer);
-	transfer->buffer = NULL;
-	libusb_free_transfer(transfer);
-
-	for (i = 0; i < devc->num_transfers; i++) {
-		if (devc->transfers[i] == transfer) {
-			devc->transfers[i] = NULL;
-			break;
-		}
-	}
-
-	devc->submitted_transfers--;
-	if (devc->submitted_transfers == 0)
+	if (sr_usb_stream_release(devc->stream, transfer) == 0)
 		finish_acquisition(sdi);
 }
 
-static void resubmit_transfer(struct libusb_transfer *transfer)
+static void resubmit_transfer(struct sr_dev_inst *sdi,
+	struct libusb_transfer *transfer)
 {
-	int ret;
+	struct dev_context *devc;
 
-	if ((ret = libusb_submit_transfer(transfer)) == LIBUSB_SUCCESS)
-		return;
+	devc = sdi->priv;
 
-	sr_err("%s: %s", __func__, libusb_error_name(ret));
-	free_transfer(transfer);
+	if (sr_usb_stream_resubmit(devc->stream, transfer) == SR_OK)
+		return;
 
+	free_transfer(sdi, transfer);
 }
 
 static void deinterleave_buffer(const uint8_t *src, size_t length,
@@ -765,9 +825,10 @@ static void send_data(struct sr_dev_inst *sdi,
 	sr_session_send(sdi, &packet);
 }
 
-static void LIBUSB_CALL receive_transfer(struct libusb_transfer *transfer)
+static void receive_transfer(struct sr_usb_stream *stream,
+	struct libusb_transfer *transfer, void *cb_data)
 {
-	struct sr_dev_inst *const sdi = transfer->user_data;
+	struct sr_dev_inst *const sdi = cb_data;
 	struct dev_context *const devc = sdi->priv;
 	const size_t channel_count = enabled_channel_count(sdi);
 	const uint16_t channel_mask = enabled_channel_mask(sdi);
@@ -779,12 +840,14 @@ static void LIBUSB_CALL receive_transfer(struct libusb_transfer *transfer)
 	unsigned int num_samples;
 	int trigger_offset;
 
+	(void)stream;
+
 	/*
 	 * If acquisition has already ended, just free any queued up
 	 * transfer that come in.
 	 */
 	if (devc->acq_aborted) {
-		free_transfer(transfer);
+		free_transfer(sdi, transfer);
 		return;
 	}
 
@@ -796,7 +859,7 @@ static void LIBUSB_CALL receive_transfer(struct libusb_transfer *transfer)
 	switch (transfer->status) {
 	case LIBUSB_TRANSFER_NO_DEVICE:
 		abort_acquisition(devc);
-		free_transfer(transfer);
+		free_transfer(sdi, transfer);
 		return;
 	case LIBUSB_TRANSFER_COMPLETED:
 	case LIBUSB_TRANSFER_TIMED_OUT: /* We may have received some data though. */
@@ -808,15 +871,16 @@ static void LIBUSB_CALL receive_transfer(struct libusb_transfer *transfer)
 
 	if (transfer->actual_length == 0 || packet_has_error) {
 		devc->empty_transfer_count++;
-		if (devc->empty_transfer_count > MAX_EMPTY_TRANSFERS) {
+		if (devc->empty_transfer_count >
+				MAX_EMPTY_TRANSFERS(devc->stream)) {
 			/*
 			 * The FX2 gave up. End the acquisition, the frontend
 			 * will work out that the samplecount is short.
 			 */
 			abort_acquisition(devc);
-			free_transfer(transfer);
+			free_transfer(sdi, transfer);
 		} else {
-			resubmit_transfer(transfer);
+			resubmit_transfer(sdi, transfer);
 		}
 		return;
 	} else {
@@ -869,9 +933,9 @@ static void LIBUSB_CALL receive_transfer(struct libusb_transfer *transfer)
 
 	if (devc->limit_samples && devc->sent_samples >= devc->limit_samples) {
 		abort_acquisition(devc);
-		free_transfer(transfer);
+		free_transfer(sdi, transfer);
 	} else
-		resubmit_transfer(transfer);
+		resubmit_transfer(sdi, transfer);
 }
 
 static int receive_data(int fd, int revents, void *cb_data)
@@ -934,19 +998,31 @@ static unsigned int get_timeout(const struct sr_dev_inst *sdi)
 	return timeout + timeout / 4; /* Leave a headroom of 25% percent. */
 }
 
+static void get_stream_params(const struct sr_dev_inst *sdi,
+	struct sr_usb_stream_params *params)
+{
+	memset(params, 0, sizeof(*params));
+	params->endpoint = 6 | LIBUSB_ENDPOINT_IN;
+	params->bytes_per_ms = to_bytes_per_ms(sdi);
+	params->align = MAX(enabled_channel_count(sdi) * 512, 1);
+	params->transfer_ms = 10;
+	params->max_size_factor = MAX_TRANSFER_GROWTH;
+	params->total_ms = 100;
+	params->max_transfers = get_number_of_transfers(sdi);
+	params->limit_transfers = MAX_SIMUL_TRANSFERS;
+	params->dev_mem = TRUE;
+}
+
 static int start_transfers(const struct sr_dev_inst *sdi)
 {
 	const size_t channel_count = enabled_channel_count(sdi);
-	const size_t size = get_buffer_size(sdi);
-	const unsigned int num_transfers = get_number_of_transfers(sdi);
-	const unsigned int timeout = get_timeout(sdi);
+	/* Transfers may grow up to this size. */
+	const size_t size = get_buffer_size(sdi) * MAX_TRANSFER_GROWTH;
 
 	struct dev_context *devc;
 	struct sr_usb_dev_inst *usb;
-	struct libusb_transfer *transfer;
-	unsigned int i;
+	struct sr_usb_stream_params params;
 	int ret;
-	unsigned char *buf;
 
 	devc = sdi->priv;
 	usb = sdi->conn;
@@ -954,14 +1030,6 @@ static int start_transfers(const struct sr_dev_inst *sdi)
 	devc->sent_samples = 0;
 	devc->acq_aborted = FALSE;
 	devc->empty_transfer_count = 0;
-	devc->submitted_transfers = 0;
-
-	g_free(devc->transfers);
-	devc->transfers = g_try_malloc0(sizeof(*devc->transfers) * num_transfers);
-	if (!devc->transfers) {
-		sr_err("USB transfers malloc failed.");
-		return SR_ERR_MALLOC;
-	}
 
 	devc->deinterleave_buffer = g_try_malloc(DSLOGIC_ATOMIC_SAMPLES *
 		(size / (channel_count * DSLOGIC_ATOMIC_BYTES)) * sizeof(uint16_t));
@@ -971,27 +1039,15 @@ static int start_transfers(const struct sr_dev_inst *sdi)
 		return SR_ERR_MALLOC;
 	}
 
-	devc->num_transfers = num_transfers;
-	for (i = 0; i < num_transfers; i++) {
-		if (!(buf = g_try_malloc(size))) {
-			sr_err("USB transfer buffer malloc failed.");
-			return SR_ERR_MALLOC;
-		}
-		transfer = libusb_alloc_transfer(0);
-		libusb_fill_bulk_transfer(transfer, usb->devhdl,
-				6 | LIBUSB_ENDPOINT_IN, buf, size,
-				receive_transfer, (void *)sdi, timeout);
-		sr_info("submitting transfer: %d", i);
-		if ((ret = libusb_submit_transfer(transfer)) != 0) {
-			sr_err("Failed to submit transfer: %s.",
-			       libusb_error_name(ret));
-			libusb_free_transfer(transfer);
-			g_free(buf);
-			abort_acquisition(devc);
-			return SR_ERR;
-		}
-		devc->transfers[i] = transfer;
-		devc->submitted_transfers++;
+	/* The stream's pool of transfers is kept across acquisitions. */
+	if (!devc->stream)
+		devc->stream = sr_usb_stream_new(usb);
+	get_stream_params(sdi, &params);
+	params.metrics = SR_DEV_METRICS(sdi);
+	if ((ret = sr_usb_stream_start(devc->stream, &params,
+			receive_transfer, (void *)sdi)) != SR_OK) {
+		abort_acquisition(devc);
+		return ret;
 	}
 
 	std_session_send_df_header(sdi);
@@ -1007,13 +1063,12 @@ static void LIBUSB_CALL trigger_receive(struct libusb_transfer *transfer)
 
 	sdi = transfer->user_data;
 	devc = sdi->priv;
+	devc->trigger_transfer = NULL;
 	if (transfer->status == LIBUSB_TRANSFER_CANCELLED) {
 		sr_dbg("Trigger transfer canceled.");
 		/* Terminate session. */
 		std_session_send_df_end(sdi);
 		usb_source_remove(sdi->session, devc->ctx);
-		devc->num_transfers = 0;
-		g_free(devc->transfers);
 	} else if (transfer->status == LIBUSB_TRANSFER_COMPLETED
 			&& transfer->actual_length == sizeof(struct dslogic_trigger_pos)) {
 		tpos = (struct dslogic_trigger_pos *)transfer->buffer;
@@ -1072,14 +1127,7 @@ SR_PRIV int dslogic_acquisition_start(const struct sr_dev_inst *sdi)
 		return SR_ERR;
 	}
 
-	devc->transfers = g_try_malloc0(sizeof(*devc->transfers));
-	if (!devc->transfers) {
-		sr_err("USB trigger_pos transfer malloc failed.");
-		return SR_ERR_MALLOC;
-	}
-	devc->num_transfers = 1;
-	devc->submitted_transfers++;
-	devc->transfers[0] = transfer;
+	devc->trigger_transfer = transfer;
 
 	return ret;
 }
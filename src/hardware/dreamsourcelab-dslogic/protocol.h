@@ -36,7 +36,10 @@
 
 #define MAX_RENUM_DELAY_MS	3000
 #define NUM_SIMUL_TRANSFERS	32
-#define MAX_EMPTY_TRANSFERS	(NUM_SIMUL_TRANSFERS * 2)
+#define MAX_SIMUL_TRANSFERS	64
+#define MAX_TRANSFER_GROWTH	4
+/* Give up when twice the transfers in flight came back empty. */
+#define MAX_EMPTY_TRANSFERS(stream)	(sr_usb_stream_depth(stream) * 2)
 
 #define NUM_CHANNELS		16
 #define NUM_TRIGGER_STAGES	16
@@ -125,11 +128,10 @@ struct dev_context {
 	gboolean acq_aborted;
 
 	unsigned int sent_samples;
-	int submitted_transfers;
-	int empty_transfer_count;
+	unsigned int empty_transfer_count;
 
-	unsigned int num_transfers;
-	struct libusb_transfer **transfers;
+	struct libusb_transfer *trigger_transfer;
+	struct sr_usb_stream *stream;
 	struct sr_context *ctx;
 
 	uint16_t *deinterleave_buffer;
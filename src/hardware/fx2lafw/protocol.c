@@ -269,19 +269,18 @@ SR_PRIV struct dev_context *fx2lafw_dev_new(void)
 
 SR_PRIV void fx2lafw_abort_acquisition(struct dev_context *devc)
 {
-	int i;
-
 	devc->acq_aborted = TRUE;
 
-	for (i = devc->num_transfers - 1; i >= 0; i--) {
-		if (devc->transfers[i])
-			libusb_cancel_transfer(devc->transfers[i]);
-	}
+	sr_usb_stream_cancel(devc->stream);
+	/* Transfers kept for pre-trigger data are not in flight. */
+	if (devc->stl)
+		soft_trigger_logic_release_buffers(devc->stl);
 }
 
 static void finish_acquisition(struct sr_dev_inst *sdi)
 {
 	struct dev_context *devc;
+	struct sr_usb_stream_stats stats;
 
 	devc = sdi->priv;
 
@@ -289,8 +288,13 @@ static void finish_acquisition(struct sr_dev_inst *sdi)
 
 	usb_source_remove(sdi->session, devc->ctx);
 
-	devc->num_transfers = 0;
-	g_free(devc->transfers);
+	sr_usb_stream_get_stats(devc->stream, &stats);
+	sr_dbg("%" PRIu64 " transfers (%" PRIu64 " empty), %" PRIu64
+		" times starved, latency %" PRIu64 "-%" PRIu64 "us, "
+		"%u transfers of %zu bytes at the end.",
+		stats.transfers, stats.empty_transfers, stats.starved,
+		stats.latency_min_us, stats.latency_max_us,
+		stats.transfers_in_flight, stats.transfer_size);
 
 	/* Free the deinterlace buffers if we had them. */
 	if (g_slist_length(devc->enabled_analog_channels) > 0) {
@@ -304,41 +308,43 @@ static void finish_acquisition(struct sr_dev_inst *sdi)
 	}
 }
 
-static void free_transfer(struct libusb_transfer *transfer)
+static void free_transfer(struct sr_dev_inst *sdi,
+	struct libusb_transfer *transfer)
 {
-	struct sr_dev_inst *sdi;
 	struct dev_context *devc;
-	unsigned int i;
 
-	sdi = transfer->user_data;
 	devc = sdi->priv;
 
-	g_free(transfer->buffer);
-	transfer->buffer = NULL;
-	libusb_free_transfer(transfer);
-
-	for (i = 0; i < devc->num_transfers; i++) {
-		if (devc->transfers[i] == transfer) {
-			devc->transfers[i] = NULL;
-			break;
-		}
-	}
-
-	devc->submitted_transfers--;
-	if (devc->submitted_transfers == 0)
+	if (sr_usb_stream_release(devc->stream, transfer) == 0)
 		finish_acquisition(sdi);
 }
 
-static void resubmit_transfer(struct libusb_transfer *transfer)
+static void resubmit_transfer(struct sr_dev_inst *sdi,
+	struct libusb_transfer *transfer)
 {
-	int ret;
+	struct dev_context *devc;
+
+	devc = sdi->priv;
 
-	if ((ret = libusb_submit_transfer(transfer)) == LIBUSB_SUCCESS)
+	if (sr_usb_stream_resubmit(devc->stream, transfer) == SR_OK)
 		return;
 
-	sr_err("%s: %s", __func__, libusb_error_name(ret));
-	free_transfer(transfer);
+	free_transfer(sdi, transfer);
+}
+
+/* The soft trigger no longer needs a transfer's pre-trigger data. */
+static void release_transfer(void *handle, void *cb_data)
+{
+	struct sr_dev_inst *sdi;
+	struct dev_context *devc;
+
+	sdi = cb_data;
+	devc = sdi->priv;
 
+	if (devc->acq_aborted)
+		free_transfer(sdi, handle);
+	else
+		resubmit_transfer(sdi, handle);
 }
 
 static void mso_send_data_proc(struct sr_dev_inst *sdi,
@@ -410,7 +416,8 @@ static void la_send_data_proc(struct sr_dev_inst *sdi,
 	sr_session_send(sdi, &packet);
 }
 
-static void LIBUSB_CALL receive_transfer(struct libusb_transfer *transfer)
+static void receive_transfer(struct sr_usb_stream *stream,
+	struct libusb_transfer *transfer, void *cb_data)
 {
 	struct sr_dev_inst *sdi;
 	struct dev_context *devc;
@@ -418,8 +425,14 @@ static void LIBUSB_CALL receive_transfer(struct libusb_transfer *transfer)
 	unsigned int num_samples;
 	int trigger_offset, cur_sample_count, unitsize, processed_samples;
 	int pre_trigger_samples;
+	gboolean retained;
+	int64_t completed_us;
+
+	(void)stream;
 
-	sdi = transfer->user_data;
+	/* The transfer's last sample got acquired about now. */
+	completed_us = g_get_monotonic_time();
+	sdi = cb_data;
 	devc = sdi->priv;
 
 	/*
@@ -427,7 +440,7 @@ static void LIBUSB_CALL receive_transfer(struct libusb_transfer *transfer)
 	 * transfer that come in.
 	 */
 	if (devc->acq_aborted) {
-		free_transfer(transfer);
+		free_transfer(sdi, transfer);
 		return;
 	}
 
@@ -438,11 +451,12 @@ static void LIBUSB_CALL receive_transfer(struct libusb_transfer *transfer)
 	unitsize = devc->sample_wide ? 2 : 1;
 	cur_sample_count = transfer->actual_length / unitsize;
 	processed_samples = 0;
+	retained = FALSE;
 
 	switch (transfer->status) {
 	case LIBUSB_TRANSFER_NO_DEVICE:
 		fx2lafw_abort_acquisition(devc);
-		free_transfer(transfer);
+		free_transfer(sdi, transfer);
 		return;
 	case LIBUSB_TRANSFER_COMPLETED:
 	case LIBUSB_TRANSFER_TIMED_OUT: /* We may have received some data though. */
@@ -454,15 +468,16 @@ static void LIBUSB_CALL receive_transfer(struct libusb_transfer *transfer)
 
 	if (transfer->actual_length == 0 || packet_has_error) {
 		devc->empty_transfer_count++;
-		if (devc->empty_transfer_count > MAX_EMPTY_TRANSFERS) {
+		if (devc->empty_transfer_count >
+				MAX_EMPTY_TRANSFERS(devc->stream)) {
 			/*
 			 * The FX2 gave up. End the acquisition, the frontend
 			 * will work out that the samplecount is short.
 			 */
 			fx2lafw_abort_acquisition(devc);
-			free_transfer(transfer);
+			free_transfer(sdi, transfer);
 		} else {
-			resubmit_transfer(transfer);
+			resubmit_transfer(sdi, transfer);
 		}
 		return;
 	} else {
@@ -483,10 +498,10 @@ check_trigger:
 			processed_samples += num_samples;
 		}
 	} else {
-		trigger_offset = soft_trigger_logic_check(devc->stl,
+		trigger_offset = soft_trigger_logic_check_buffer(devc->stl,
 			transfer->buffer + processed_samples * unitsize,
 			transfer->actual_length - processed_samples * unitsize,
-			&pre_trigger_samples);
+			&pre_trigger_samples, transfer, &retained);
 		if (trigger_offset > -1) {
 			std_session_send_df_frame_begin(sdi);
 			devc->sent_samples += pre_trigger_samples;
@@ -506,6 +521,9 @@ check_trigger:
 		}
 	}
 
+	if (devc->trigger_fired && processed_samples == cur_sample_count)
+		sr_dev_timing_sync(sdi, completed_us);
+
 	const int frame_ended = devc->limit_samples && (devc->sent_samples >= devc->limit_samples);
 	const int final_frame = devc->limit_frames && (devc->num_frames >= (devc->limit_frames - 1));
 
@@ -530,9 +548,13 @@ check_trigger:
 	}
 	if (frame_ended && final_frame) {
 		fx2lafw_abort_acquisition(devc);
-		free_transfer(transfer);
-	} else
-		resubmit_transfer(transfer);
+		free_transfer(sdi, transfer);
+	} else if (!retained) {
+		resubmit_transfer(sdi, transfer);
+	} else {
+		/* Keep the stream going while the soft trigger has it. */
+		sr_usb_stream_hold(devc->stream, transfer);
+	}
 }
 
 static int configure_channels(const struct sr_dev_inst *sdi)
@@ -574,41 +596,35 @@ static unsigned int to_bytes_per_ms(unsigned int samplerate)
 	return samplerate / 1000;
 }
 
-static size_t get_buffer_size(struct dev_context *devc)
+static void get_stream_params(struct dev_context *devc,
+	struct sr_usb_stream_params *params)
 {
-	size_t s;
-
+	memset(params, 0, sizeof(*params));
+	params->endpoint = 2 | LIBUSB_ENDPOINT_IN;
+	params->bytes_per_ms = to_bytes_per_ms(devc->cur_samplerate);
 	/*
-	 * The buffer should be large enough to hold 10ms of data and
-	 * a multiple of 512.
+	 * Transfers should be large enough to hold 10ms of data and
+	 * a multiple of 512. Total buffer size should be able to hold
+	 * about 500ms of data.
 	 */
-	s = 10 * to_bytes_per_ms(devc->cur_samplerate);
-	return (s + 511) & ~511;
+	params->align = 512;
+	params->transfer_ms = 10;
+	params->max_size_factor = MAX_TRANSFER_GROWTH;
+	params->total_ms = 500;
+	params->max_transfers = NUM_SIMUL_TRANSFERS;
+	params->limit_transfers = MAX_SIMUL_TRANSFERS;
+	params->dev_mem = TRUE;
 }
 
-static unsigned int get_number_of_transfers(struct dev_context *devc)
+/* The largest transfer which the stream may grow to. */
+static size_t get_max_buffer_size(struct dev_context *devc)
 {
-	unsigned int n;
-
-	/* Total buffer size should be able to hold about 500ms of data. */
-	n = (500 * to_bytes_per_ms(devc->cur_samplerate) /
-		get_buffer_size(devc));
-
-	if (n > NUM_SIMUL_TRANSFERS)
-		return NUM_SIMUL_TRANSFERS;
-
-	return n;
-}
+	size_t s;
 
-static unsigned int get_timeout(struct dev_context *devc)
-{
-	size_t total_size;
-	unsigned int timeout;
+	s = 10 * to_bytes_per_ms(devc->cur_samplerate);
+	s = (s + 511) & ~511;
 
-	total_size = get_buffer_size(devc) *
-			get_number_of_transfers(devc);
-	timeout = total_size / to_bytes_per_ms(devc->cur_samplerate);
-	return timeout + timeout / 4; /* Leave a headroom of 25% percent. */
+	return s * MAX_TRANSFER_GROWTH;
 }
 
 static int receive_data(int fd, int revents, void *cb_data)
@@ -632,11 +648,8 @@ static int start_transfers(const struct sr_dev_inst *sdi)
 	struct dev_context *devc;
 	struct sr_usb_dev_inst *usb;
 	struct sr_trigger *trigger;
-	struct libusb_transfer *transfer;
-	unsigned int i, num_transfers;
-	int timeout, ret;
-	unsigned char *buf;
-	size_t size;
+	struct sr_usb_stream_params params;
+	int ret;
 
 	devc = sdi->priv;
 	usb = sdi->conn;
@@ -652,45 +665,24 @@ static int start_transfers(const struct sr_dev_inst *sdi)
 		devc->stl = soft_trigger_logic_new(sdi, trigger, pre_trigger_samples);
 		if (!devc->stl)
 			return SR_ERR_MALLOC;
+		/* Keep pre-trigger data in transfers, instead of copying it. */
+		soft_trigger_logic_retain_buffers(devc->stl,
+			NUM_SIMUL_TRANSFERS / 2, release_transfer, (void *)sdi);
 		devc->trigger_fired = FALSE;
 	} else {
 		std_session_send_df_frame_begin(sdi);
 		devc->trigger_fired = TRUE;
 	}
 
-	num_transfers = get_number_of_transfers(devc);
-
-	size = get_buffer_size(devc);
-	devc->submitted_transfers = 0;
-
-	devc->transfers = g_try_malloc0(sizeof(*devc->transfers) * num_transfers);
-	if (!devc->transfers) {
-		sr_err("USB transfers malloc failed.");
-		return SR_ERR_MALLOC;
-	}
-
-	timeout = get_timeout(devc);
-	devc->num_transfers = num_transfers;
-	for (i = 0; i < num_transfers; i++) {
-		if (!(buf = g_try_malloc(size))) {
-			sr_err("USB transfer buffer malloc failed.");
-			return SR_ERR_MALLOC;
-		}
-		transfer = libusb_alloc_transfer(0);
-		libusb_fill_bulk_transfer(transfer, usb->devhdl,
-				2 | LIBUSB_ENDPOINT_IN, buf, size,
-				receive_transfer, (void *)sdi, timeout);
-		sr_info("submitting transfer: %d", i);
-		if ((ret = libusb_submit_transfer(transfer)) != 0) {
-			sr_err("Failed to submit transfer: %s.",
-			       libusb_error_name(ret));
-			libusb_free_transfer(transfer);
-			g_free(buf);
-			fx2lafw_abort_acquisition(devc);
-			return SR_ERR;
-		}
-		devc->transfers[i] = transfer;
-		devc->submitted_transfers++;
+	/* The stream's pool of transfers is kept across acquisitions. */
+	if (!devc->stream)
+		devc->stream = sr_usb_stream_new(usb);
+	get_stream_params(devc, &params);
+	params.metrics = SR_DEV_METRICS(sdi);
+	if ((ret = sr_usb_stream_start(devc->stream, &params,
+			receive_transfer, (void *)sdi)) != SR_OK) {
+		fx2lafw_abort_acquisition(devc);
+		return ret;
 	}
 
 	/*
@@ -715,6 +707,7 @@ SR_PRIV int fx2lafw_start_acquisition(const struct sr_dev_inst *sdi)
 	struct dev_context *devc;
 	int timeout, ret;
 	size_t size;
+	struct sr_usb_stream_params params;
 
 	di = sdi->driver;
 	drvc = di->context;
@@ -731,13 +724,16 @@ SR_PRIV int fx2lafw_start_acquisition(const struct sr_dev_inst *sdi)
 		return SR_ERR;
 	}
 
-	timeout = get_timeout(devc);
+	/* Use the time to fill the stream's initial set of transfers. */
+	get_stream_params(devc, &params);
+	timeout = MIN(params.total_ms, params.max_transfers * params.transfer_ms);
+	timeout += timeout / 4; /* Leave a headroom of 25% percent. */
 	usb_source_add(sdi->session, devc->ctx, timeout, receive_data, drvc);
 
-	size = get_buffer_size(devc);
+	size = get_max_buffer_size(devc);
 	/* Prepare for analog sampling. */
 	if (g_slist_length(devc->enabled_analog_channels) > 0) {
-		/* We need a buffer half the size of a transfer. */
+		/* We need a buffer half the size of the largest transfer. */
 		devc->logic_buffer = g_try_malloc(size / 2);
 		devc->analog_buffer = g_try_malloc(
 			sizeof(float) * size / 2);
@@ -37,7 +37,10 @@
 
 #define MAX_RENUM_DELAY_MS	3000
 #define NUM_SIMUL_TRANSFERS	32
-#define MAX_EMPTY_TRANSFERS	(NUM_SIMUL_TRANSFERS * 2)
+#define MAX_SIMUL_TRANSFERS	64
+#define MAX_TRANSFER_GROWTH	4
+/* Give up when twice the transfers in flight came back empty. */
+#define MAX_EMPTY_TRANSFERS(stream)	(sr_usb_stream_depth(stream) * 2)
 
 #define NUM_CHANNELS		16
 
@@ -113,11 +116,9 @@ struct dev_context {
 
 	uint64_t num_frames;
 	uint64_t sent_samples;
-	int submitted_transfers;
-	int empty_transfer_count;
+	unsigned int empty_transfer_count;
 
-	unsigned int num_transfers;
-	struct libusb_transfer **transfers;
+	struct sr_usb_stream *stream;
 	struct sr_context *ctx;
 	void (*send_data_proc)(struct sr_dev_inst *sdi,
 		uint8_t *data, size_t length, size_t sample_width);
@@ -213,9 +213,12 @@ SR_PRIV int ipdbg_la_convert_trigger(const struct sr_dev_inst *sdi)
 {
 	struct dev_context *devc;
 	struct sr_trigger *trigger;
-	struct sr_trigger_stage *stage;
-	struct sr_trigger_match *match;
-	const GSList *l, *m;
+	struct sr_trigger_compiled *tc;
+	const struct sr_trigger_masks *masks;
+	struct sr_trigger_masks all;
+	size_t stage;
+	uint64_t i;
+	int shift, ret;
 
 	devc = sdi->priv;
 
@@ -223,7 +226,7 @@ SR_PRIV int ipdbg_la_convert_trigger(const struct sr_dev_inst *sdi)
 	devc->num_transfers = 0;
 	devc->raw_sample_buf = NULL;
 
-	for (uint64_t i = 0; i < devc->data_width_bytes; i++) {
+	for (i = 0; i < devc->data_width_bytes; i++) {
 		devc->trigger_mask[i] = 0;
 		devc->trigger_value[i] = 0;
 		devc->trigger_mask_last[i] = 0;
@@ -231,50 +234,37 @@ SR_PRIV int ipdbg_la_convert_trigger(const struct sr_dev_inst *sdi)
 		devc->trigger_edge_mask[i] = 0;
 	}
 
-	if (!(trigger = sr_session_trigger_get(sdi->session)))
+	if (!(trigger = sr_session_trigger_get(sdi->session)) || !trigger->stages)
 		return SR_OK;
 
-	for (l = trigger->stages; l; l = l->next) {
-		stage = l->data;
-		for (m = stage->matches; m; m = m->next) {
-			match = m->data;
-			int byte_idx = match->channel->index / 8;
-			uint8_t match_bit = 1 << (match->channel->index % 8);
-
-			if (!match->channel->enabled)
-				/* Ignore disabled channels with a trigger. */
-				continue;
-
-			if (match->match == SR_TRIGGER_ONE) {
-				devc->trigger_value[byte_idx] |= match_bit;
-				devc->trigger_mask[byte_idx] |= match_bit;
-				devc->trigger_mask_last[byte_idx] &= ~match_bit;
-				devc->trigger_edge_mask[byte_idx] &= ~match_bit;
-			} else if (match->match == SR_TRIGGER_ZERO) {
-				devc->trigger_value[byte_idx] &= ~match_bit;
-				devc->trigger_mask[byte_idx] |= match_bit;
-				devc->trigger_mask_last[byte_idx] &= ~match_bit;
-				devc->trigger_edge_mask[byte_idx] &= ~match_bit;
-			} else if (match->match == SR_TRIGGER_RISING) {
-				devc->trigger_value[byte_idx] |= match_bit;
-				devc->trigger_value_last[byte_idx] &=
-				    ~match_bit;
-				devc->trigger_mask[byte_idx] |= match_bit;
-				devc->trigger_mask_last[byte_idx] |= match_bit;
-				devc->trigger_edge_mask[byte_idx] &= ~match_bit;
-			} else if (match->match == SR_TRIGGER_FALLING) {
-				devc->trigger_value[byte_idx] &= ~match_bit;
-				devc->trigger_value_last[byte_idx] |= match_bit;
-				devc->trigger_mask[byte_idx] |= match_bit;
-				devc->trigger_mask_last[byte_idx] |= match_bit;
-				devc->trigger_edge_mask[byte_idx] &= ~match_bit;
-			} else if (match->match == SR_TRIGGER_EDGE) {
-				devc->trigger_mask[byte_idx] &= ~match_bit;
-				devc->trigger_mask_last[byte_idx] &= ~match_bit;
-				devc->trigger_edge_mask[byte_idx] |= match_bit;
-			}
+	ret = sr_trigger_compile(trigger, devc->data_width_bytes, &tc);
+	if (ret != SR_OK)
+		return ret;
+
+	/*
+	 * The device checks a single condition, which all stages'
+	 * matches contribute to. Translate the masks of each 64-bit
+	 * word to the device's per-byte registers.
+	 */
+	for (i = 0; i < devc->data_width_bytes; i++) {
+		memset(&all, 0, sizeof(all));
+		for (stage = 0; stage < tc->num_stages; stage++) {
+			masks = &tc->masks[stage * tc->num_words + i / 8];
+			all.ones |= masks->ones;
+			all.zeros |= masks->zeros;
+			all.rising |= masks->rising;
+			all.falling |= masks->falling;
+			all.edges |= masks->edges;
 		}
+		shift = 8 * (i % 8);
+		devc->trigger_value[i] = (all.ones | all.rising) >> shift;
+		devc->trigger_mask[i] = (all.ones | all.zeros |
+			all.rising | all.falling) >> shift;
+		devc->trigger_value_last[i] = all.falling >> shift;
+		devc->trigger_mask_last[i] = (all.rising | all.falling) >> shift;
+		devc->trigger_edge_mask[i] = all.edges >> shift;
 	}
+	sr_trigger_compiled_free(tc);
 
 	return SR_OK;
 }
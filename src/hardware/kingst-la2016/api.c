@@ -540,28 +540,68 @@ static int config_list(uint32_t key, GVariant **data,
 	return SR_OK;
 }
 
-static void send_chunk(struct sr_dev_inst *sdi,
-	const uint8_t *packets, unsigned int num_tfers)
+/* The most samples which one transfer packet can expand to. */
+#define MAX_SAMPLES_PER_TFER_PACKET	(NUM_PACKETS_IN_CHUNK * 255)
+/* Run expansion writes whole groups of eight samples. */
+#define EXPAND_SLACK	8
+
+/*
+ * Expand a run of samples. The sample gets broadcast to a 64-bit word,
+ * which gets stored repeatedly. This writes up to seven samples beyond
+ * the end of the run, the caller must provide the room.
+ */
+static inline uint16_t *expand_run(uint16_t *wp, uint16_t state,
+	unsigned int count)
+{
+	uint64_t pattern;
+	uint16_t *end;
+
+	pattern = state * 0x0001000100010001ULL;
+	end = wp + count;
+	while (wp < end) {
+		memcpy(&wp[0], &pattern, sizeof(pattern));
+		memcpy(&wp[4], &pattern, sizeof(pattern));
+		wp += 8;
+	}
+
+	return end;
+}
+
+static void send_samples(struct sr_dev_inst *sdi, unsigned int n_samples)
 {
 	struct dev_context *devc;
 	struct sr_datafeed_logic logic;
 	struct sr_datafeed_packet sr_packet;
-	unsigned int max_samples, n_samples, total_samples, free_n_samples;
-	unsigned int i, j, k;
-	int do_signal_trigger;
-	uint16_t *wp;
-	const uint8_t *rp;
-	uint16_t state;
-	uint8_t repetitions;
+
+	if (!n_samples)
+		return;
 
 	devc = sdi->priv;
 
 	logic.unitsize = 2;
 	logic.data = devc->convbuffer;
+	logic.length = n_samples * 2;
 
 	sr_packet.type = SR_DF_LOGIC;
 	sr_packet.payload = &logic;
 
+	sr_session_send(sdi, &sr_packet);
+}
+
+static void send_chunk(struct sr_dev_inst *sdi,
+	const uint8_t *packets, unsigned int num_tfers)
+{
+	struct dev_context *devc;
+	unsigned int max_samples, n_samples, total_samples;
+	unsigned int i, k;
+	int do_signal_trigger;
+	uint16_t *wp;
+	const uint8_t *rp;
+	uint16_t state;
+	uint8_t repetitions;
+
+	devc = sdi->priv;
+
 	max_samples = devc->convbuffer_size / 2;
 	n_samples = 0;
 	wp = (uint16_t *)devc->convbuffer;
@@ -575,47 +615,65 @@ static void send_chunk(struct sr_dev_inst *sdi,
 
 	rp = packets;
 	for (i = 0; i < num_tfers; i++) {
+		if (max_samples - n_samples < MAX_SAMPLES_PER_TFER_PACKET + EXPAND_SLACK ||
+				do_signal_trigger) {
+			send_samples(sdi, n_samples);
+			total_samples += n_samples;
+			n_samples = 0;
+			wp = (uint16_t *)devc->convbuffer;
+			if (do_signal_trigger) {
+				std_session_send_df_trigger(sdi);
+				do_signal_trigger = 0;
+			}
+		}
+
+		if (devc->reading_behind_trigger) {
+			/* No trigger position to look for, just expand. */
+			for (k = 0; k < NUM_PACKETS_IN_CHUNK; k++) {
+				state = read_u16le_inc(&rp);
+				repetitions = read_u8_inc(&rp);
+				wp = expand_run(wp, state, repetitions);
+				n_samples += repetitions;
+			}
+			(void)read_u8_inc(&rp); /* Skip sequence number. */
+			continue;
+		}
+
 		for (k = 0; k < NUM_PACKETS_IN_CHUNK; k++) {
-			free_n_samples = max_samples - n_samples;
-			if (free_n_samples < 256 || do_signal_trigger) {
-				logic.length = n_samples * 2;
-				sr_session_send(sdi, &sr_packet);
+			if (do_signal_trigger) {
+				send_samples(sdi, n_samples);
+				total_samples += n_samples;
 				n_samples = 0;
 				wp = (uint16_t *)devc->convbuffer;
-				if (do_signal_trigger) {
-					std_session_send_df_trigger(sdi);
-					do_signal_trigger = 0;
-				}
+				std_session_send_df_trigger(sdi);
+				do_signal_trigger = 0;
 			}
 
 			state = read_u16le_inc(&rp);
 			repetitions = read_u8_inc(&rp);
-			for (j = 0; j < repetitions; j++)
-				*wp++ = state;
-
+			wp = expand_run(wp, state, repetitions);
 			n_samples += repetitions;
-			total_samples += repetitions;
-			devc->total_samples += repetitions;
+
 			if (!devc->reading_behind_trigger) {
 				devc->n_reps_until_trigger--;
 				if (devc->n_reps_until_trigger == 0) {
 					devc->reading_behind_trigger = 1;
 					do_signal_trigger = 1;
 					sr_dbg("  here is trigger position after %" PRIu64 " samples, %.6fms",
-					       devc->total_samples,
-					       (double)devc->total_samples / devc->cur_samplerate * 1e3);
+					       devc->total_samples + total_samples + n_samples,
+					       (double)(devc->total_samples + total_samples + n_samples) / devc->cur_samplerate * 1e3);
 				}
 			}
 		}
 		(void)read_u8_inc(&rp); /* Skip sequence number. */
 	}
 	if (n_samples) {
-		logic.length = n_samples * 2;
-		sr_session_send(sdi, &sr_packet);
-		if (do_signal_trigger) {
-			std_session_send_df_trigger(sdi);
-		}
+		send_samples(sdi, n_samples);
+		total_samples += n_samples;
 	}
+	if (do_signal_trigger)
+		std_session_send_df_trigger(sdi);
+	devc->total_samples += total_samples;
 	sr_dbg("send_chunk done after %d samples", total_samples);
 }
 
@@ -623,43 +681,41 @@ static void LIBUSB_CALL receive_transfer(struct libusb_transfer *transfer)
 {
 	struct sr_dev_inst *sdi;
 	struct dev_context *devc;
-	struct sr_usb_dev_inst *usb;
-	int ret;
+	unsigned int i;
 
 	sdi = transfer->user_data;
 	devc = sdi->priv;
-	usb = sdi->conn;
 
 	sr_dbg("receive_transfer(): status %s received %d bytes.",
 	       libusb_error_name(transfer->status), transfer->actual_length);
 
-	if (transfer->status == LIBUSB_TRANSFER_TIMED_OUT) {
+	if (transfer->status == LIBUSB_TRANSFER_TIMED_OUT)
 		sr_err("bulk transfer timeout!");
-		devc->transfer_finished = 1;
-	}
-	send_chunk(sdi, transfer->buffer, transfer->actual_length / TRANSFER_PACKET_LENGTH);
-
-	devc->n_bytes_to_read -= transfer->actual_length;
-	if (devc->n_bytes_to_read) {
-		uint32_t to_read = devc->n_bytes_to_read;
-		/* determine read size for the next usb transfer */
-		if (to_read >= LA2016_USB_BUFSZ)
-			to_read = LA2016_USB_BUFSZ;
-		else /* last transfer, make read size some multiple of LA2016_EP6_PKTSZ */
-			to_read = (to_read + (LA2016_EP6_PKTSZ-1)) & ~(LA2016_EP6_PKTSZ-1);
-		libusb_fill_bulk_transfer(
-			transfer, usb->devhdl,
-			0x86, transfer->buffer, to_read,
-			receive_transfer, (void *)sdi, DEFAULT_TIMEOUT_MS);
-
-		if ((ret = libusb_submit_transfer(transfer)) == 0)
+	if (transfer->status != LIBUSB_TRANSFER_CANCELLED)
+		send_chunk(sdi, transfer->buffer, transfer->actual_length / TRANSFER_PACKET_LENGTH);
+
+	/* Stop requesting more data after errors. */
+	if (transfer->status != LIBUSB_TRANSFER_COMPLETED)
+		devc->n_bytes_to_submit = 0;
+
+	devc->n_bytes_to_read -= MIN((unsigned int)transfer->actual_length, devc->n_bytes_to_read);
+	if (devc->n_bytes_to_read && devc->n_bytes_to_submit) {
+		/*
+		 * The other transfers still are in flight, this one
+		 * requests the next piece of data behind them.
+		 */
+		if (la2016_submit_transfer(sdi, transfer) == SR_OK)
 			return;
-		sr_err("Failed to submit further transfer: %s.", libusb_error_name(ret));
 	}
 
+	for (i = 0; i < LA2016_USB_NUM_XFERS; i++) {
+		if (devc->transfers[i] == transfer)
+			devc->transfers[i] = NULL;
+	}
 	g_free(transfer->buffer);
 	libusb_free_transfer(transfer);
-	devc->transfer_finished = 1;
+	if (--devc->n_transfers_active == 0)
+		devc->transfer_finished = 1;
 }
 
 static int handle_event(int fd, int revents, void *cb_data)
@@ -711,8 +767,6 @@ static int handle_event(int fd, int revents, void *cb_data)
 		g_free(devc->convbuffer);
 		devc->convbuffer = NULL;
 
-		devc->transfer = NULL;
-
 		sr_dbg("transfer is now finished");
 	}
 
@@ -721,8 +775,12 @@ static int handle_event(int fd, int revents, void *cb_data)
 
 static void abort_acquisition(struct dev_context *devc)
 {
-	if (devc->transfer)
-		libusb_cancel_transfer(devc->transfer);
+	unsigned int i;
+
+	for (i = 0; i < LA2016_USB_NUM_XFERS; i++) {
+		if (devc->transfers[i])
+			libusb_cancel_transfer(devc->transfers[i]);
+	}
 }
 
 static int configure_channels(const struct sr_dev_inst *sdi)
@@ -681,18 +681,57 @@ SR_PRIV int la2016_has_triggered(const struct sr_dev_inst *sdi)
 	return (state & 0x3) == 1;
 }
 
-SR_PRIV int la2016_start_retrieval(const struct sr_dev_inst *sdi, libusb_transfer_cb_fn cb)
+/* Size of the next bulk transfer, a multiple of the endpoint's packet size. */
+static uint32_t next_read_size(const struct dev_context *devc)
+{
+	uint32_t to_read;
+
+	to_read = devc->n_bytes_to_submit;
+	if (to_read >= LA2016_USB_BUFSZ)
+		to_read = LA2016_USB_BUFSZ;
+	else
+		to_read = (to_read + (LA2016_EP6_PKTSZ-1)) & ~(LA2016_EP6_PKTSZ-1);
+
+	return to_read;
+}
+
+/* Request the next piece of capture data, the transfer's buffer gets reused. */
+SR_PRIV int la2016_submit_transfer(const struct sr_dev_inst *sdi, struct libusb_transfer *transfer)
 {
 	struct dev_context *devc;
 	struct sr_usb_dev_inst *usb;
+	uint32_t to_read;
+	int ret;
+
+	devc = sdi->priv;
+	usb = sdi->conn;
+
+	to_read = next_read_size(devc);
+	libusb_fill_bulk_transfer(
+		transfer, usb->devhdl,
+		0x86, transfer->buffer, to_read,
+		devc->transfer_cb, (void *)sdi, DEFAULT_TIMEOUT_MS);
+
+	if ((ret = libusb_submit_transfer(transfer)) != 0) {
+		sr_err("Failed to submit transfer: %s.", libusb_error_name(ret));
+		return SR_ERR;
+	}
+	devc->n_bytes_to_submit -= MIN(to_read, devc->n_bytes_to_submit);
+
+	return SR_OK;
+}
+
+SR_PRIV int la2016_start_retrieval(const struct sr_dev_inst *sdi, libusb_transfer_cb_fn cb)
+{
+	struct dev_context *devc;
+	struct libusb_transfer *transfer;
 	int ret;
 	uint8_t wrbuf[2 * sizeof(uint32_t)];
 	uint8_t *wrptr;
 	uint32_t to_read;
-	uint8_t *buffer;
+	unsigned int i;
 
 	devc = sdi->priv;
-	usb = sdi->conn;
 
 	if ((ret = get_capture_info(sdi)) != SR_OK)
 		return ret;
@@ -722,31 +761,36 @@ SR_PRIV int la2016_start_retrieval(const struct sr_dev_inst *sdi, libusb_transfe
 		return ret;
 	}
 
-	to_read = devc->n_bytes_to_read;
+	/*
+	 * Keep several transfers in flight, so that the device can send
+	 * more data while the host expands the previous transfer's data.
+	 * Transfers on the same endpoint complete in the order of their
+	 * submission. Each transfer gets resubmitted by the callback until
+	 * all data was requested.
+	 */
+	devc->n_bytes_to_submit = devc->n_bytes_to_read;
+	devc->n_transfers_active = 0;
+	devc->transfer_cb = cb;
 	/* choose a buffer size for all of the usb transfers */
-	if (to_read >= LA2016_USB_BUFSZ)
-		to_read = LA2016_USB_BUFSZ; /* multiple transfers */
-	else /* one transfer, make buffer size some multiple of LA2016_EP6_PKTSZ */
-		to_read = (to_read + (LA2016_EP6_PKTSZ-1)) & ~(LA2016_EP6_PKTSZ-1);
-	buffer = g_try_malloc(to_read);
-	if (!buffer) {
-		sr_err("Failed to allocate %d bytes for bulk transfer", to_read);
-		return SR_ERR_MALLOC;
+	to_read = next_read_size(devc);
+	for (i = 0; i < LA2016_USB_NUM_XFERS && devc->n_bytes_to_submit; i++) {
+		transfer = libusb_alloc_transfer(0);
+		transfer->buffer = g_try_malloc(to_read);
+		if (!transfer->buffer) {
+			sr_err("Failed to allocate %d bytes for bulk transfer", to_read);
+			libusb_free_transfer(transfer);
+			break;
+		}
+		if (la2016_submit_transfer(sdi, transfer) != SR_OK) {
+			g_free(transfer->buffer);
+			libusb_free_transfer(transfer);
+			break;
+		}
+		devc->transfers[i] = transfer;
+		devc->n_transfers_active++;
 	}
-
-	devc->transfer = libusb_alloc_transfer(0);
-	libusb_fill_bulk_transfer(
-		devc->transfer, usb->devhdl,
-		0x86, buffer, to_read,
-		cb, (void *)sdi, DEFAULT_TIMEOUT_MS);
-
-	if ((ret = libusb_submit_transfer(devc->transfer)) != 0) {
-		sr_err("Failed to submit transfer: %s.", libusb_error_name(ret));
-		libusb_free_transfer(devc->transfer);
-		devc->transfer = NULL;
-		g_free(buffer);
+	if (!devc->n_transfers_active)
 		return SR_ERR;
-	}
 
 	return SR_OK;
 }
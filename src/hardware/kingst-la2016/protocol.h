@@ -46,6 +46,7 @@
  */
 #define LA2016_EP6_PKTSZ	512 /* endpoint 6 max packet size */
 #define LA2016_USB_BUFSZ	(256 * 2 * LA2016_EP6_PKTSZ) /* 256KB buffer */
+#define LA2016_USB_NUM_XFERS	4 /* transfers in flight during retrieval */
 
 #define MAX_RENUM_DELAY_MS	3000
 #define DEFAULT_TIMEOUT_MS      200
@@ -109,6 +110,7 @@ struct dev_context {
 	capture_info_t info;
 	unsigned int n_transfer_packets_to_read; /* each with 5 acq packets */
 	unsigned int n_bytes_to_read;
+	unsigned int n_bytes_to_submit;
 	unsigned int n_reps_until_trigger;
 	unsigned int reading_behind_trigger;
 	uint64_t total_samples;
@@ -116,7 +118,9 @@ struct dev_context {
 
 	unsigned int convbuffer_size;
 	uint8_t *convbuffer;
-	struct libusb_transfer *transfer;
+	struct libusb_transfer *transfers[LA2016_USB_NUM_XFERS];
+	unsigned int n_transfers_active;
+	libusb_transfer_cb_fn transfer_cb;
 };
 
 SR_PRIV int la2016_upload_firmware(struct sr_context *sr_ctx, libusb_device *dev, uint16_t product_id);
@@ -126,6 +130,7 @@ SR_PRIV int la2016_stop_acquisition(const struct sr_dev_inst *sdi);
 SR_PRIV int la2016_abort_acquisition(const struct sr_dev_inst *sdi);
 SR_PRIV int la2016_has_triggered(const struct sr_dev_inst *sdi);
 SR_PRIV int la2016_start_retrieval(const struct sr_dev_inst *sdi, libusb_transfer_cb_fn cb);
+SR_PRIV int la2016_submit_transfer(const struct sr_dev_inst *sdi, struct libusb_transfer *transfer);
 SR_PRIV int la2016_init_device(const struct sr_dev_inst *sdi);
 SR_PRIV int la2016_deinit_device(const struct sr_dev_inst *sdi);
 
@@ -118,6 +118,70 @@ static int rdtech_dps_read_holding_registers(struct sr_modbus_dev_inst *modbus,
 	return ret;
 }
 
+/*
+ * Retries failed batch read attempts for improved reliability. When
+ * the device keeps rejecting the single request which spans the gap
+ * between the batch's ranges, the ranges get read separately.
+ */
+static int rdtech_dps_read_batch(struct dev_context *devc,
+	struct sr_modbus_dev_inst *modbus, struct sr_modbus_batch *batch)
+{
+	size_t retries;
+	int ret;
+
+	while (TRUE) {
+		retries = 3;
+		while (retries--) {
+			ret = sr_modbus_batch_read(modbus, batch);
+			if (ret == SR_OK)
+				return ret;
+		}
+		if (ret != SR_ERR_DATA || devc->state_batch_split)
+			return ret;
+		sr_warn("Device rejects merged reads, reading ranges separately.");
+		sr_modbus_batch_set_max_gap(batch, 0);
+		devc->state_batch_split = TRUE;
+	}
+}
+
+/*
+ * The registers which get read to determine the device's state. The
+ * protection thresholds can get changed at the device's front panel,
+ * so they are read in every poll like the measurements. Both ranges
+ * get read in a single request, which includes the registers between
+ * them, to save a round trip per poll.
+ */
+static struct sr_modbus_batch *rdtech_dps_state_batch(struct dev_context *devc)
+{
+	struct sr_modbus_batch *batch;
+	int gap;
+
+	if (devc->state_batch)
+		return devc->state_batch;
+
+	gap = 0;
+	batch = sr_modbus_batch_new();
+	switch (devc->model->model_type) {
+	case MODEL_DPS:
+		sr_modbus_batch_add(batch, REG_DPS_USET, 10, FALSE);
+		sr_modbus_batch_add(batch, PRE_DPS_OVPSET, 2, FALSE);
+		gap = PRE_DPS_OVPSET - (REG_DPS_USET + 10);
+		break;
+	case MODEL_RD:
+		sr_modbus_batch_add(batch, REG_RD_VOLT_TGT, 11, FALSE);
+		sr_modbus_batch_add(batch, REG_RD_OVP_THR, 2, FALSE);
+		gap = REG_RD_OVP_THR - (REG_RD_VOLT_TGT + 11);
+		break;
+	default:
+		break;
+	}
+	if (!devc->state_batch_split)
+		sr_modbus_batch_set_max_gap(batch, gap);
+	devc->state_batch = batch;
+
+	return batch;
+}
+
 /* Set one 16bit register. LE format for DPS devices. */
 static int rdtech_dps_set_reg(const struct sr_dev_inst *sdi,
 	uint16_t address, uint16_t value)
@@ -258,6 +322,7 @@ SR_PRIV int rdtech_dps_get_state(const struct sr_dev_inst *sdi,
 {
 	struct dev_context *devc;
 	struct sr_modbus_dev_inst *modbus;
+	struct sr_modbus_batch *batch;
 	gboolean get_config, get_init_state, get_curr_meas;
 	uint16_t registers[12];
 	int ret;
@@ -308,20 +373,23 @@ SR_PRIV int rdtech_dps_get_state(const struct sr_dev_inst *sdi,
 	(void)get_init_state;
 	(void)get_curr_meas;
 
+	/*
+	 * Transfer all chunks of registers. It's unfortunate that the
+	 * model dependency and the sparse register map force us to
+	 * open code addresses, sizes, and the sequence of the registers
+	 * and how to interpret their bit fields. But then this is not
+	 * too unusual for a hardware specific device driver ...
+	 */
+	g_mutex_lock(&devc->rw_mutex);
+	batch = rdtech_dps_state_batch(devc);
+	ret = rdtech_dps_read_batch(devc, modbus, batch);
+	g_mutex_unlock(&devc->rw_mutex);
+	if (ret != SR_OK)
+		return ret;
+
 	switch (devc->model->model_type) {
 	case MODEL_DPS:
-		/*
-		 * Transfer a chunk of registers in a single call. It's
-		 * unfortunate that the model dependency and the sparse
-		 * register map force us to open code addresses, sizes,
-		 * and the sequence of the registers and how to interpret
-		 * their bit fields. But then this is not too unusual for
-		 * a hardware specific device driver ...
-		 */
-		g_mutex_lock(&devc->rw_mutex);
-		ret = rdtech_dps_read_holding_registers(modbus,
-			REG_DPS_USET, 10, registers);
-		g_mutex_unlock(&devc->rw_mutex);
+		ret = sr_modbus_batch_get(batch, REG_DPS_USET, 10, registers);
 		if (ret != SR_OK)
 			return ret;
 
@@ -348,11 +416,8 @@ SR_PRIV int rdtech_dps_get_state(const struct sr_dev_inst *sdi,
 		out_state = read_u16be_inc(&rdptr); /* ENABLE */
 		is_out_enabled = out_state != 0;
 
-		/* Transfer another chunk of registers in a single call. */
-		g_mutex_lock(&devc->rw_mutex);
-		ret = rdtech_dps_read_holding_registers(modbus,
-			PRE_DPS_OVPSET, 2, registers);
-		g_mutex_unlock(&devc->rw_mutex);
+		/* Get another chunk of registers. */
+		ret = sr_modbus_batch_get(batch, PRE_DPS_OVPSET, 2, registers);
 		if (ret != SR_OK)
 			return ret;
 
@@ -366,11 +431,8 @@ SR_PRIV int rdtech_dps_get_state(const struct sr_dev_inst *sdi,
 		break;
 
 	case MODEL_RD:
-		/* Retrieve a set of adjacent registers. */
-		g_mutex_lock(&devc->rw_mutex);
-		ret = rdtech_dps_read_holding_registers(modbus,
-			REG_RD_VOLT_TGT, 11, registers);
-		g_mutex_unlock(&devc->rw_mutex);
+		/* Get a set of adjacent registers. */
+		ret = sr_modbus_batch_get(batch, REG_RD_VOLT_TGT, 11, registers);
 		if (ret != SR_OK)
 			return ret;
 
@@ -397,11 +459,8 @@ SR_PRIV int rdtech_dps_get_state(const struct sr_dev_inst *sdi,
 		out_state = read_u16be_inc(&rdptr); /* ENABLE */
 		is_out_enabled = out_state != 0;
 
-		/* Retrieve a set of adjacent registers. */
-		g_mutex_lock(&devc->rw_mutex);
-		ret = rdtech_dps_read_holding_registers(modbus,
-			REG_RD_OVP_THR, 2, registers);
-		g_mutex_unlock(&devc->rw_mutex);
+		/* Get a set of adjacent registers. */
+		ret = sr_modbus_batch_get(batch, REG_RD_OVP_THR, 2, registers);
 		if (ret != SR_OK)
 			return ret;
 
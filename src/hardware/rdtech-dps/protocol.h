@@ -55,6 +55,8 @@ struct dev_context {
 	double voltage_multiplier;
 	struct sr_sw_limits limits;
 	GMutex rw_mutex;
+	struct sr_modbus_batch *state_batch;
+	gboolean state_batch_split;
 	gboolean curr_ovp_state;
 	gboolean curr_ocp_state;
 	gboolean curr_cc_state;
@@ -0,0 +1,199 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 libsigrok contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Conversion of the device's sample data to the sigrok logic format.
+ *
+ * One batch from the device consists of 32 samples per active digital
+ * channel, with one 32-bit word per channel (first sample in the MSB).
+ * Converting a batch to 32 samples of 16 bits each is a transposition
+ * of a (up to) 16x32 bit matrix. Whole batches get transposed at once,
+ * eight samples per step. Only batches which cross USB packets are
+ * converted word by word.
+ */
+
+#include <config.h>
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "protocol.h"
+
+#define SAMPLES_PER_BATCH	32
+
+#define BYTES_ONES	0x0101010101010101ULL
+#define BYTES_LOWS	0x7f7f7f7f7f7f7f7fULL
+#define BYTES_HIGHS	0x8080808080808080ULL
+/* Selects bit 7 in byte 0, bit 6 in byte 1, ..., bit 0 in byte 7. */
+#define BYTES_SELECT	0x0102040810204080ULL
+
+/*
+ * Spread the bits of a byte to the bytes of a word, MSB first: Byte 0
+ * of the result (least significant) is 1 when bit 7 is set, byte 7 is
+ * 1 when bit 0 is set.
+ */
+static inline uint64_t spread_bits(uint8_t bits)
+{
+	uint64_t w;
+
+	w = (bits * BYTES_ONES) & BYTES_SELECT;
+	w = ((w + BYTES_LOWS) & BYTES_HIGHS) >> 7;
+
+	return w;
+}
+
+/* OR one channel's word into a batch of samples. */
+static void convert_word(uint16_t *dst, uint32_t samples, unsigned int bit)
+{
+	unsigned int group, k;
+	uint64_t w;
+
+	for (group = 0; group < 4; group++) {
+		w = spread_bits(samples >> (24 - 8 * group)) << bit % 8;
+		for (k = 0; k < 8; k++)
+			dst[8 * group + k] |= ((w >> (8 * k)) & 0xff) << (bit & 8);
+	}
+}
+
+#if defined(__SSE2__)
+
+static inline __m128i gather_bytes(const __m128i *words, int shift)
+{
+	const __m128i mask = _mm_set1_epi32(0xff);
+	__m128i lo, hi;
+
+	lo = _mm_packs_epi32(
+		_mm_and_si128(_mm_srli_epi32(words[0], shift), mask),
+		_mm_and_si128(_mm_srli_epi32(words[1], shift), mask));
+	hi = _mm_packs_epi32(
+		_mm_and_si128(_mm_srli_epi32(words[2], shift), mask),
+		_mm_and_si128(_mm_srli_epi32(words[3], shift), mask));
+
+	return _mm_packus_epi16(lo, hi);
+}
+
+/*
+ * Transpose a whole batch. The words get placed in the byte lane of
+ * their channel, then each movemask collects one bit of all channels,
+ * which is one sample.
+ */
+static void convert_batch(uint16_t *dst, const uint32_t *src,
+	const uint8_t *bits, unsigned int cnt)
+{
+	uint32_t lanes[16];
+	__m128i words[4], v;
+	unsigned int i, group, k;
+
+	memset(lanes, 0, sizeof(lanes));
+	for (i = 0; i < cnt; i++)
+		lanes[bits[i]] = src[i];
+	for (i = 0; i < 4; i++)
+		words[i] = _mm_loadu_si128((const __m128i *)&lanes[4 * i]);
+
+	for (group = 0; group < 4; group++) {
+		v = gather_bytes(words, 24 - 8 * group);
+		for (k = 0; k < 8; k++) {
+			*dst++ = _mm_movemask_epi8(v);
+			v = _mm_add_epi8(v, v);
+		}
+	}
+}
+
+#else
+
+/*
+ * Transpose a whole batch. Eight samples of all channels get collected
+ * in two words (channels 0-7 and 8-15), one byte per sample.
+ */
+static void convert_batch(uint16_t *dst, const uint32_t *src,
+	const uint8_t *bits, unsigned int cnt)
+{
+	uint64_t acc[2];
+	unsigned int i, group, k;
+	int shift;
+
+	for (group = 0; group < 4; group++) {
+		shift = 24 - 8 * group;
+		acc[0] = acc[1] = 0;
+		for (i = 0; i < cnt; i++)
+			acc[bits[i] / 8] |= spread_bits(src[i] >> shift) << bits[i] % 8;
+		for (k = 0; k < 8; k++) {
+			*dst++ = ((acc[0] >> (8 * k)) & 0xff) |
+				((acc[1] >> (8 * k)) & 0xff) << 8;
+		}
+	}
+}
+
+#endif
+
+/*
+ * Convert the words of one USB packet. A batch which is not complete at
+ * the end of the previous packet is moved to the start of the conversion
+ * buffer, and gets completed first. devc->conv_size receives the size of
+ * the completed batches.
+ */
+SR_PRIV void saleae_logic_pro_convert_data(struct dev_context *devc,
+	const uint32_t *src, size_t srccnt)
+{
+	uint16_t *dst;
+	unsigned int cnt, batch_index;
+
+	dst = (uint16_t *)devc->conv_buffer;
+	cnt = devc->dig_channel_cnt;
+	batch_index = devc->batch_index;
+
+	/* Copy partial batch to the beginning. */
+	if (devc->conv_size)
+		memcpy(dst, devc->conv_buffer + devc->conv_size, CONV_BATCH_SIZE);
+	/* Reset converted size. */
+	devc->conv_size = 0;
+	if (!cnt)
+		return;
+
+	/* Complete the partial batch. */
+	while (batch_index && srccnt) {
+		convert_word(dst, *src++, devc->dig_channel_bits[batch_index]);
+		srccnt--;
+		if (++batch_index == cnt) {
+			devc->conv_size += CONV_BATCH_SIZE;
+			batch_index = 0;
+			dst += SAMPLES_PER_BATCH;
+		}
+	}
+
+	/* Whole batches. */
+	while (srccnt >= cnt) {
+		convert_batch(dst, src, devc->dig_channel_bits, cnt);
+		src += cnt;
+		srccnt -= cnt;
+		devc->conv_size += CONV_BATCH_SIZE;
+		dst += SAMPLES_PER_BATCH;
+	}
+
+	/* Start of a batch which continues in the next packet. */
+	if (srccnt) {
+		memset(dst, 0, CONV_BATCH_SIZE);
+		while (srccnt--) {
+			convert_word(dst, *src++,
+				devc->dig_channel_bits[batch_index++]);
+		}
+	}
+
+	devc->batch_index = batch_index;
+}
@@ -40,6 +40,7 @@ struct dev_context {
 	unsigned int dig_channel_cnt;
 	uint16_t dig_channel_mask;
 	uint16_t dig_channel_masks[16];
+	uint8_t dig_channel_bits[16];
 	uint64_t dig_samplerate;
 
 	uint32_t lfsr;
@@ -59,4 +60,7 @@ SR_PRIV int saleae_logic_pro_start(const struct sr_dev_inst *sdi);
 SR_PRIV int saleae_logic_pro_stop(const struct sr_dev_inst *sdi);
 SR_PRIV void LIBUSB_CALL saleae_logic_pro_receive_data(struct libusb_transfer *transfer);
 
+SR_PRIV void saleae_logic_pro_convert_data(struct dev_context *devc,
+	const uint32_t *src, size_t srccnt);
+
 #endif
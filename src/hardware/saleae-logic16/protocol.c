@@ -33,6 +33,7 @@
 
 #define FPGA_FIRMWARE_18	"saleae-logic16-fpga-18.bitstream"
 #define FPGA_FIRMWARE_33	"saleae-logic16-fpga-33.bitstream"
+#define FPGA_BITSTREAM_MAX_SIZE	(512 * 1024)
 
 #define MAX_SAMPLE_RATE		SR_MHZ(100)
 #define MAX_SAMPLE_RATE_X_CH	SR_MHZ(300)
@@ -382,6 +383,12 @@ static int setup_register_mapping(const struct sr_dev_inst *sdi)
 	return SR_OK;
 }
 
+static gboolean fpga_version_known(uint8_t version)
+{
+	return version == 0x10 || version == 0x13 ||
+		version == 0x40 || version == 0x41;
+}
+
 static int prime_fpga(const struct sr_dev_inst *sdi)
 {
 	struct dev_context *devc = sdi->priv;
@@ -427,7 +434,7 @@ static int prime_fpga(const struct sr_dev_inst *sdi)
 	if ((ret = read_fpga_register(sdi, FPGA_REG(VERSION), &version)) != SR_OK)
 		return ret;
 
-	if (version != 0x10 && version != 0x13 && version != 0x40 && version != 0x41) {
+	if (!fpga_version_known(version)) {
 		sr_warn("Unsupported FPGA version: 0x%02x.", version);
 	}
 
@@ -457,17 +464,73 @@ static int configure_led(const struct sr_dev_inst *sdi)
 	return set_led_mode(sdi, 1, 6250, 0, 1);
 }
 
+/*
+ * Check whether the FPGA still runs a bitstream which was uploaded
+ * before (when the device was opened last), and set it up for use.
+ */
+static gboolean fpga_bitstream_loaded(const struct sr_dev_inst *sdi,
+	const struct sr_resource_image *bitstream, const char *location)
+{
+	struct dev_context *devc;
+	struct drv_context *drvc;
+	uint8_t version;
+
+	devc = sdi->priv;
+	drvc = sdi->driver->context;
+
+	if (!sr_resource_image_loaded(drvc->sr_ctx, location, bitstream))
+		return FALSE;
+
+	if (setup_register_mapping(sdi) != SR_OK ||
+			read_fpga_register(sdi, FPGA_REG(VERSION), &version) != SR_OK ||
+			!fpga_version_known(version)) {
+		sr_info("FPGA doesn't respond, uploading the bitstream again.");
+		sr_resource_image_set_loaded(drvc->sr_ctx, location, NULL);
+		return FALSE;
+	}
+	sr_info("FPGA bitstream '%s' is loaded already.", bitstream->name);
+
+	return TRUE;
+}
+
+static int send_fpga_bitstream(const struct sr_dev_inst *sdi,
+	const struct sr_resource_image *bitstream)
+{
+	uint8_t command[64];
+	size_t chunksize, sum;
+	int ret;
+
+	sr_info("Uploading FPGA bitstream '%s'.", bitstream->name);
+
+	command[0] = COMMAND_FPGA_UPLOAD_INIT;
+	if ((ret = do_ep1_command(sdi, command, 1, NULL, 0)) != SR_OK)
+		return ret;
+
+	for (sum = 0; sum < bitstream->size; sum += chunksize) {
+		chunksize = MIN(bitstream->size - sum, sizeof(command) - 2);
+		command[0] = COMMAND_FPGA_UPLOAD_SEND_DATA;
+		command[1] = chunksize;
+		memcpy(&command[2], &bitstream->data[sum], chunksize);
+
+		ret = do_ep1_command(sdi, command, chunksize + 2, NULL, 0);
+		if (ret != SR_OK)
+			return ret;
+	}
+	sr_info("FPGA bitstream upload (%zu bytes) done.", sum);
+
+	/* This needs to be called before accessing any FPGA registers. */
+	return setup_register_mapping(sdi);
+}
+
 static int upload_fpga_bitstream(const struct sr_dev_inst *sdi,
 				 enum voltage_range vrange)
 {
-	uint64_t sum;
-	struct sr_resource bitstream;
+	struct sr_resource_image *bitstream;
 	struct dev_context *devc;
 	struct drv_context *drvc;
 	const char *name;
-	ssize_t chunksize;
+	char *location;
 	int ret;
-	uint8_t command[64];
 
 	devc = sdi->priv;
 	drvc = sdi->driver->context;
@@ -488,47 +551,31 @@ static int upload_fpga_bitstream(const struct sr_dev_inst *sdi,
 			return SR_ERR;
 		}
 
-		sr_info("Uploading FPGA bitstream '%s'.", name);
-		ret = sr_resource_open(drvc->sr_ctx, &bitstream,
-				SR_RESOURCE_FIRMWARE, name);
+		bitstream = sr_resource_image_get(drvc->sr_ctx,
+				SR_RESOURCE_FIRMWARE, name, FPGA_BITSTREAM_MAX_SIZE);
+		if (!bitstream)
+			return SR_ERR;
+
+		/* Skip the upload when the FPGA still runs this bitstream. */
+		location = sr_usb_location(sdi);
+		ret = SR_OK;
+		if (!fpga_bitstream_loaded(sdi, bitstream, location)) {
+			sr_resource_image_set_loaded(drvc->sr_ctx, location, NULL);
+			ret = send_fpga_bitstream(sdi, bitstream);
+			if (ret == SR_OK)
+				sr_resource_image_set_loaded(drvc->sr_ctx,
+					location, bitstream);
+		}
+		g_free(location);
+		sr_resource_image_unref(bitstream);
 		if (ret != SR_OK)
 			return ret;
-
-		command[0] = COMMAND_FPGA_UPLOAD_INIT;
-		if ((ret = do_ep1_command(sdi, command, 1, NULL, 0)) != SR_OK) {
-			sr_resource_close(drvc->sr_ctx, &bitstream);
+	} else {
+		/* This needs to be called before accessing any FPGA registers. */
+		if ((ret = setup_register_mapping(sdi)) != SR_OK)
 			return ret;
-		}
-
-		sum = 0;
-		while (1) {
-			chunksize = sr_resource_read(drvc->sr_ctx, &bitstream,
-					&command[2], sizeof(command) - 2);
-			if (chunksize < 0) {
-				sr_resource_close(drvc->sr_ctx, &bitstream);
-				return SR_ERR;
-			}
-			if (chunksize == 0)
-				break;
-			command[0] = COMMAND_FPGA_UPLOAD_SEND_DATA;
-			command[1] = chunksize;
-
-			ret = do_ep1_command(sdi, command, chunksize + 2,
-					NULL, 0);
-			if (ret != SR_OK) {
-				sr_resource_close(drvc->sr_ctx, &bitstream);
-				return ret;
-			}
-			sum += chunksize;
-		}
-		sr_resource_close(drvc->sr_ctx, &bitstream);
-		sr_info("FPGA bitstream upload (%" PRIu64 " bytes) done.", sum);
 	}
 
-	/* This needs to be called before accessing any FPGA registers. */
-	if ((ret = setup_register_mapping(sdi)) != SR_OK)
-		return ret;
-
 	if ((ret = prime_fpga(sdi)) != SR_OK)
 		return ret;
 
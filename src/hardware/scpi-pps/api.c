@@ -173,6 +173,11 @@ static struct sr_dev_inst *probe_device(struct sr_scpi_dev_inst *scpi,
 	sr_scpi_hw_info_free(hw_info);
 	hw_info = NULL;
 
+	/* Outputs and protection can get toggled on the front panel. */
+	sr_config_cache_volatile(sdi, SR_CONF_ENABLED);
+	sr_config_cache_volatile(sdi, SR_CONF_OVER_VOLTAGE_PROTECTION_ENABLED);
+	sr_config_cache_volatile(sdi, SR_CONF_OVER_CURRENT_PROTECTION_ENABLED);
+
 	/* Don't send SCPI_CMD_LOCAL for HP 66xxB using SCPI over GPIB. */
 	if (!(devc->device->dialect == SCPI_DIALECT_HP_66XXB &&
 			scpi->transport == SCPI_TRANSPORT_LIBGPIB))
@@ -275,6 +275,7 @@ static int dev_acquisition_start(const struct sr_dev_inst *sdi)
 	cb_func = receive_data;
 	cb_data = (void *)sdi;
 	dmm = (struct dmm_info *)sdi->driver;
+	devc->sync = dmm_sync_lookup(dmm);
 	if (dmm && dmm->acquire_start) {
 		ret = dmm->acquire_start(dmm->dmm_state, sdi,
 			&cb_func, &cb_data);
@@ -283,6 +284,19 @@ static int dev_acquisition_start(const struct sr_dev_inst *sdi)
 	}
 
 	serial = sdi->conn;
+
+	/*
+	 * Stateless fixed size packets can get received and checked by
+	 * the shared serial I/O reactor when it's available. Fall back
+	 * to the session's main loop otherwise.
+	 */
+	if (cb_func == receive_data && dmm && dmm->packet_valid) {
+		ret = serial_reactor_source_add(sdi->session, serial,
+			dmm->packet_size, dmm->packet_valid, NULL, NULL, 50,
+			cb_func, cb_data);
+		if (ret == SR_OK)
+			return SR_OK;
+	}
 	serial_source_add(sdi->session, serial, G_IO_IN, 50,
 		cb_func, cb_data);
 
@@ -27,6 +27,35 @@
 #include "libsigrok-internal.h"
 #include "protocol.h"
 
+/*
+ * Sync patterns of those chipsets which provide them. These speed up
+ * the search for the next packet's start in the RX data stream.
+ */
+static const struct {
+	gboolean (*packet_valid)(const uint8_t *buf);
+	const struct sr_dmm_sync *sync;
+} dmm_syncs[] = {
+	{ sr_dtm0660_packet_valid, &sr_dtm0660_sync, },
+	{ sr_fs9721_packet_valid, &sr_fs9721_sync, },
+	{ sr_fs9922_packet_valid, &sr_fs9922_sync, },
+	{ sr_metex14_packet_valid, &sr_metex14_sync, },
+};
+
+SR_PRIV const struct sr_dmm_sync *dmm_sync_lookup(const struct dmm_info *dmm)
+{
+	size_t idx;
+
+	if (!dmm || !dmm->packet_valid)
+		return NULL;
+
+	for (idx = 0; idx < ARRAY_SIZE(dmm_syncs); idx++) {
+		if (dmm_syncs[idx].packet_valid == dmm->packet_valid)
+			return dmm_syncs[idx].sync;
+	}
+
+	return NULL;
+}
+
 static void log_dmm_packet(const uint8_t *buf, size_t len)
 {
 	GString *text;
@@ -194,6 +223,10 @@ static void handle_new_data(struct sr_dev_inst *sdi, void *info)
 			if (!dmm->packet_valid(check_ptr)) {
 				sr_dbg("Not a valid packet, searching.");
 				check_pos++;
+				if (devc->sync)
+					check_pos += sr_dmm_sync_find(devc->sync,
+						&devc->buf[check_pos],
+						devc->buflen - check_pos);
 				continue;
 			}
 			pkt_size = dmm->packet_size;
@@ -234,11 +267,44 @@ static void handle_new_data(struct sr_dev_inst *sdi, void *info)
 	}
 }
 
+static void handle_reactor_packets(struct sr_dev_inst *sdi, void *info)
+{
+	struct dmm_info *dmm;
+	struct dev_context *devc;
+	int ret;
+	uint64_t deadline;
+
+	dmm = (struct dmm_info *)sdi->driver;
+	devc = sdi->priv;
+
+	/* The reactor has checked the packets already. Just process them. */
+	while ((ret = serial_reactor_read_packet(sdi->conn,
+			devc->buf, sizeof(devc->buf))) > 0) {
+		handle_packet(sdi, devc->buf, ret, info);
+
+		if (!dmm->packet_request)
+			continue;
+		if (dmm->req_timeout_ms || dmm->req_delay_ms) {
+			deadline = g_get_monotonic_time();
+			deadline += dmm->req_delay_ms * 1000;
+			devc->req_next_at = deadline;
+		}
+		req_packet(sdi);
+	}
+	if (ret == SR_ERR_IO) {
+		sr_err("Serial port hung up, stopping acquisition.");
+		sr_dev_acquisition_stop(sdi);
+	} else if (ret < 0) {
+		sr_err("Reactor packet read error: %d.", ret);
+	}
+}
+
 int receive_data(int fd, int revents, void *cb_data)
 {
 	struct sr_dev_inst *sdi;
 	struct dev_context *devc;
 	struct dmm_info *dmm;
+	struct sr_serial_dev_inst *serial;
 	void *info;
 
 	(void)fd;
@@ -254,7 +320,11 @@ int receive_data(int fd, int revents, void *cb_data)
 	if (revents == G_IO_IN) {
 		/* Serial data arrived. */
 		info = g_malloc(dmm->info_size);
-		handle_new_data(sdi, info);
+		serial = sdi->conn;
+		if (serial->reactor_port)
+			handle_reactor_packets(sdi, info);
+		else
+			handle_new_data(sdi, info);
 		g_free(info);
 	} else {
 		/* Timeout; send another packet request if DMM needs it. */
@@ -93,8 +93,13 @@ struct dev_context {
 	 * Used only if device needs polling.
 	 */
 	uint64_t req_next_at;
+
+	/** Chipset's sync pattern for re-synchronization (optional). */
+	const struct sr_dmm_sync *sync;
 };
 
+SR_PRIV const struct sr_dmm_sync *dmm_sync_lookup(const struct dmm_info *dmm);
+
 SR_PRIV int req_packet(struct sr_dev_inst *sdi);
 SR_PRIV int receive_data(int fd, int revents, void *cb_data);
 
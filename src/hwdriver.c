@@ -18,6 +18,7 @@
  */
 
 #include <config.h>
+#include <inttypes.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <sys/types.h>
@@ -218,6 +219,8 @@ static struct sr_key_info sr_key_info_config[] = {
 		"Session file", NULL},
 	{SR_CONF_CAPTUREFILE, SR_T_STRING, "capturefile",
 		"Capture file", NULL},
+	{SR_CONF_CAPTURE_FRAMEFILE, SR_T_STRING, "capture_framefile",
+		"Capture frame index file", NULL},
 	{SR_CONF_CAPTURE_UNITSIZE, SR_T_UINT64, "capture_unitsize",
 		"Capture unitsize", NULL},
 	{SR_CONF_POWER_OFF, SR_T_BOOL, "power_off",
@@ -228,6 +231,12 @@ static struct sr_key_info sr_key_info_config[] = {
 		"Probe factor", NULL},
 	{SR_CONF_ADC_POWERLINE_CYCLES, SR_T_FLOAT, "nplc",
 		"Number of ADC powerline cycles", NULL},
+	{SR_CONF_CAPTURE_FRAMES, SR_T_UINT64, "capture_frames",
+		"Capture frames", NULL},
+	{SR_CONF_FIRST_FRAME, SR_T_UINT64, "first_frame",
+		"First frame", NULL},
+	{SR_CONF_SESSION_STATS, SR_T_KEYVALUE, "session_stats",
+		"Session statistics", NULL},
 
 	/* Acquisition modes, sample limiting */
 	{SR_CONF_LIMIT_MSEC, SR_T_UINT64, "limit_time",
@@ -432,6 +441,9 @@ SR_API int sr_driver_init(struct sr_context *ctx, struct sr_dev_driver *driver)
 
 	/* No log message here, too verbose and not very useful. */
 
+	if ((ret = sr_transports_init(ctx)) < 0)
+		return ret;
+
 	if ((ret = driver->init(driver, ctx)) < 0)
 		sr_err("Failed to initialize the driver: %d.", ret);
 
@@ -570,6 +582,265 @@ SR_API GSList *sr_driver_scan(struct sr_dev_driver *driver, GSList *options)
 	return l;
 }
 
+/*
+ * Parallel scans. Drivers scan on a pool of worker threads, the thread
+ * local flag tells lower layers (serial ports, SCPI resources) that
+ * they need to coordinate with scans in other threads.
+ */
+static GPrivate scan_parallel;
+
+/** @private */
+SR_PRIV gboolean sr_driver_scan_is_parallel(void)
+{
+	return GPOINTER_TO_INT(g_private_get(&scan_parallel));
+}
+
+/** @private */
+SR_PRIV void sr_driver_scan_set_parallel(gboolean parallel)
+{
+	g_private_set(&scan_parallel, GINT_TO_POINTER(parallel ? 1 : 0));
+}
+
+/**
+ * Get the number of threads to use for parallel scans.
+ *
+ * Defaults to the number of processors (at least 4, at most 16, since
+ * scans mostly wait for I/O). The SIGROK_SCAN_THREADS environment
+ * variable overrides the default, 1 makes scans sequential.
+ *
+ * @private
+ */
+SR_PRIV unsigned int sr_driver_scan_threads(void)
+{
+	const char *env;
+	unsigned int count;
+
+	env = g_getenv("SIGROK_SCAN_THREADS");
+	if (env && *env) {
+		count = (unsigned int)g_ascii_strtoull(env, NULL, 10);
+		if (count)
+			return count;
+	}
+
+	count = g_get_num_processors();
+
+	return CLAMP(count, 4, 16);
+}
+
+/*
+ * Connections which are being probed by a parallel scan. Lower layers
+ * lock a connection (e.g. serial port) by name before talking to it.
+ */
+#define SCAN_LOCK_TIMEOUT_US	(30 * G_TIME_SPAN_SECOND)
+
+static GMutex scan_locks_mutex;
+static GCond scan_locks_cond;
+static GHashTable *scan_locks;
+
+/**
+ * Lock a connection for exclusive use by the calling scan.
+ *
+ * Only locks when called from a parallel scan (see sr_driver_scan_all()),
+ * always succeeds otherwise. Waits while another scan uses the
+ * connection.
+ *
+ * @param name The connection's name, e.g. the serial port.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_TIMEOUT The connection remained in use for too long.
+ *
+ * @private
+ */
+SR_PRIV int sr_scan_lock(const char *name)
+{
+	gint64 deadline;
+	int ret;
+
+	if (!name || !sr_driver_scan_is_parallel())
+		return SR_OK;
+
+	deadline = g_get_monotonic_time() + SCAN_LOCK_TIMEOUT_US;
+	ret = SR_OK;
+	g_mutex_lock(&scan_locks_mutex);
+	if (!scan_locks)
+		scan_locks = g_hash_table_new_full(g_str_hash, g_str_equal,
+			g_free, NULL);
+	while (g_hash_table_contains(scan_locks, name)) {
+		sr_spew("Waiting for %s, in use by another scan.", name);
+		if (!g_cond_wait_until(&scan_locks_cond, &scan_locks_mutex,
+				deadline)) {
+			sr_err("Timeout waiting for %s.", name);
+			ret = SR_ERR_TIMEOUT;
+			break;
+		}
+	}
+	if (ret == SR_OK)
+		g_hash_table_add(scan_locks, g_strdup(name));
+	g_mutex_unlock(&scan_locks_mutex);
+
+	return ret;
+}
+
+/**
+ * Release a connection which was locked by sr_scan_lock().
+ *
+ * @param name The connection's name.
+ *
+ * @private
+ */
+SR_PRIV void sr_scan_unlock(const char *name)
+{
+	if (!name)
+		return;
+
+	g_mutex_lock(&scan_locks_mutex);
+	if (scan_locks && g_hash_table_remove(scan_locks, name))
+		g_cond_broadcast(&scan_locks_cond);
+	g_mutex_unlock(&scan_locks_mutex);
+}
+
+struct scan_job {
+	struct sr_dev_driver *driver;
+	GSList *options;
+	GSList *devices;
+};
+
+/* Only pass options which the driver supports. */
+static GSList *scan_options_filter(struct sr_dev_driver *driver,
+		GSList *options)
+{
+	GArray *opts;
+	GSList *l, *filtered;
+	struct sr_config *src;
+	guint i;
+
+	if (!options)
+		return NULL;
+	if (!(opts = sr_driver_scan_options_list(driver)))
+		return NULL;
+
+	filtered = NULL;
+	for (l = options; l; l = l->next) {
+		src = l->data;
+		for (i = 0; i < opts->len; i++) {
+			if (g_array_index(opts, uint32_t, i) == src->key) {
+				filtered = g_slist_append(filtered, src);
+				break;
+			}
+		}
+	}
+	g_array_free(opts, TRUE);
+
+	return filtered;
+}
+
+static void scan_worker(gpointer data, gpointer user_data)
+{
+	struct scan_job *job;
+	GAsyncQueue *done;
+
+	job = data;
+	done = user_data;
+
+	sr_driver_scan_set_parallel(TRUE);
+	job->devices = sr_driver_scan(job->driver, job->options);
+	sr_driver_scan_set_parallel(FALSE);
+
+	g_async_queue_push(done, job);
+}
+
+/**
+ * Have several hardware drivers scan for devices in parallel.
+ *
+ * Drivers scan concurrently, on a pool of threads. Serial ports and
+ * other connections are locked while a driver probes them, so that
+ * two drivers never talk to the same port at the same time.
+ *
+ * Results are passed to the callback as soon as each driver has
+ * finished its scan. The callback runs in the caller's thread, in the
+ * order in which drivers finish.
+ *
+ * Before calling sr_driver_scan_all(), the user must have previously
+ * initialized the drivers by calling sr_driver_init(). Drivers which
+ * are not initialized are skipped.
+ *
+ * @param drivers NULL terminated array of drivers which should scan,
+ *                e.g. the result of sr_driver_list(). Must not be NULL.
+ * @param options A list of 'struct sr_config' options to pass to the
+ *                drivers' scanners. Each driver only gets passed the
+ *                options which it supports. Can be NULL/empty.
+ * @param cb Callback which gets the devices found by one driver, or NULL.
+ *           The list is only valid during the callback, the devices
+ *           are also part of the returned list.
+ * @param cb_data Data for the callback function. Can be NULL.
+ *
+ * @return A GSList * of 'struct sr_dev_inst', or NULL if no devices were
+ *         found (or errors were encountered). This list must be freed by
+ *         the caller using g_slist_free(), but without freeing the data
+ *         pointed to in the list.
+ *
+ * @since 0.6.0
+ */
+SR_API GSList *sr_driver_scan_all(struct sr_dev_driver **drivers,
+		GSList *options, sr_driver_scan_callback cb, void *cb_data)
+{
+	GThreadPool *pool;
+	GAsyncQueue *done;
+	struct scan_job *job;
+	GHashTable *seen;
+	GSList *devices;
+	GError *error;
+	unsigned int pending;
+	size_t i;
+
+	if (!drivers) {
+		sr_err("Invalid driver list, can't scan for devices.");
+		return NULL;
+	}
+
+	done = g_async_queue_new();
+	error = NULL;
+	pool = g_thread_pool_new(scan_worker, done,
+		sr_driver_scan_threads(), FALSE, &error);
+	if (!pool) {
+		sr_err("Cannot create scan threads: %s.", error->message);
+		g_error_free(error);
+		g_async_queue_unref(done);
+		return NULL;
+	}
+
+	seen = g_hash_table_new(g_direct_hash, g_direct_equal);
+	pending = 0;
+	for (i = 0; drivers[i]; i++) {
+		if (!drivers[i]->context || !drivers[i]->scan)
+			continue;
+		if (!g_hash_table_add(seen, drivers[i]))
+			continue;
+		job = g_malloc0(sizeof(*job));
+		job->driver = drivers[i];
+		job->options = scan_options_filter(drivers[i], options);
+		g_thread_pool_push(pool, job, NULL);
+		pending++;
+	}
+	g_hash_table_destroy(seen);
+
+	sr_dbg("Scanning with %u drivers in parallel.", pending);
+	devices = NULL;
+	while (pending--) {
+		job = g_async_queue_pop(done);
+		if (cb)
+			cb(job->driver, job->devices, cb_data);
+		devices = g_slist_concat(devices, job->devices);
+		g_slist_free(job->options);
+		g_free(job);
+	}
+
+	g_thread_pool_free(pool, FALSE, TRUE);
+	g_async_queue_unref(done);
+
+	return devices;
+}
+
 /**
  * Call driver cleanup function for all drivers.
  *
@@ -651,6 +922,8 @@ SR_PRIV int sr_dev_acquisition_start(struct sr_dev_inst *sdi)
 
 	sr_dbg("%s: Starting acquisition.", sdi->driver->name);
 
+	sr_config_cache_invalidate(sdi);
+
 	return sdi->driver->dev_acquisition_start(sdi);
 }
 
@@ -673,6 +946,272 @@ SR_PRIV int sr_dev_acquisition_stop(struct sr_dev_inst *sdi)
 	return sdi->driver->dev_acquisition_stop(sdi);
 }
 
+/*
+ * Configuration cache.
+ *
+ * Frontends tend to query the same keys over and over again, e.g. when
+ * they refresh their UI. Drivers of many instruments answer by sending
+ * queries to the device each time. Devices can have the results of
+ * config get and list calls cached, so that repeated calls do not reach
+ * the driver. The cache is opt-in, see sr_config_cache_enable().
+ *
+ * Any config set, commit, device open/close, or acquisition start drops
+ * all cached values of the device, since settings tend to depend on each
+ * other. Keys which reflect the device's current state rather than a
+ * setting are never cached. Drivers can declare additional keys of that
+ * kind, see sr_config_cache_volatile().
+ */
+
+struct sr_config_cache {
+	GMutex mutex;
+	gboolean enabled;
+	/* Cached results, key: struct config_cache_key, value: GVariant. */
+	GHashTable *values;
+	/* Keys which never get cached, in addition to volatile_keys[]. */
+	GArray *volatile_keys;
+	uint64_t hits, misses;
+};
+
+struct config_cache_key {
+	const struct sr_channel_group *cg;
+	uint32_t key;
+	unsigned int op;
+};
+
+/* Keys which reflect the device's state, and can change at any time. */
+static const uint32_t volatile_keys[] = {
+	SR_CONF_VOLTAGE,
+	SR_CONF_CURRENT,
+	SR_CONF_POWER,
+	SR_CONF_OUTPUT_FREQUENCY,
+	SR_CONF_OVER_VOLTAGE_PROTECTION_ACTIVE,
+	SR_CONF_OVER_CURRENT_PROTECTION_ACTIVE,
+	SR_CONF_OVER_TEMPERATURE_PROTECTION_ACTIVE,
+	SR_CONF_UNDER_VOLTAGE_CONDITION_ACTIVE,
+	SR_CONF_REGULATION,
+	SR_CONF_SESSIONFILE,
+	SR_CONF_CAPTUREFILE,
+	SR_CONF_CAPTURE_FRAMEFILE,
+	SR_CONF_CAPTURE_FRAMES,
+};
+
+static guint config_cache_key_hash(gconstpointer p)
+{
+	const struct config_cache_key *k = p;
+
+	return g_direct_hash(k->cg) ^ (k->key * 31) ^ (k->op << 28);
+}
+
+static gboolean config_cache_key_equal(gconstpointer a, gconstpointer b)
+{
+	const struct config_cache_key *ka = a, *kb = b;
+
+	return ka->cg == kb->cg && ka->key == kb->key && ka->op == kb->op;
+}
+
+static struct sr_config_cache *config_cache_get(struct sr_dev_inst *sdi)
+{
+	struct sr_config_cache *cache;
+
+	if (sdi->config_cache)
+		return sdi->config_cache;
+
+	cache = g_malloc0(sizeof(*cache));
+	g_mutex_init(&cache->mutex);
+	cache->values = g_hash_table_new_full(config_cache_key_hash,
+		config_cache_key_equal, g_free,
+		(GDestroyNotify)g_variant_unref);
+	cache->volatile_keys = g_array_new(FALSE, FALSE, sizeof(uint32_t));
+	sdi->config_cache = cache;
+
+	return cache;
+}
+
+static gboolean config_cache_is_volatile(const struct sr_config_cache *cache,
+		uint32_t key)
+{
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(volatile_keys); i++) {
+		if (volatile_keys[i] == key)
+			return TRUE;
+	}
+	for (i = 0; i < cache->volatile_keys->len; i++) {
+		if (g_array_index(cache->volatile_keys, uint32_t, i) == key)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/* Get a cached value, returns a new reference to it. */
+static GVariant *config_cache_lookup(const struct sr_dev_inst *sdi,
+		const struct sr_channel_group *cg, uint32_t key, unsigned int op)
+{
+	struct sr_config_cache *cache;
+	struct config_cache_key k;
+	GVariant *data;
+
+	if (!sdi || !(cache = sdi->config_cache) || !cache->enabled)
+		return NULL;
+
+	k.cg = cg;
+	k.key = key;
+	k.op = op;
+	g_mutex_lock(&cache->mutex);
+	data = g_hash_table_lookup(cache->values, &k);
+	if (data) {
+		g_variant_ref(data);
+		cache->hits++;
+	} else {
+		cache->misses++;
+	}
+	g_mutex_unlock(&cache->mutex);
+
+	return data;
+}
+
+static void config_cache_store(const struct sr_dev_inst *sdi,
+		const struct sr_channel_group *cg, uint32_t key, unsigned int op,
+		GVariant *data)
+{
+	struct sr_config_cache *cache;
+	struct config_cache_key *k;
+
+	if (!sdi || !(cache = sdi->config_cache) || !cache->enabled)
+		return;
+
+	g_mutex_lock(&cache->mutex);
+	if (op == SR_CONF_LIST || !config_cache_is_volatile(cache, key)) {
+		k = g_malloc(sizeof(*k));
+		k->cg = cg;
+		k->key = key;
+		k->op = op;
+		g_hash_table_replace(cache->values, k, g_variant_ref(data));
+	}
+	g_mutex_unlock(&cache->mutex);
+}
+
+/**
+ * Enable or disable caching of a device instance's configuration.
+ *
+ * While enabled, results of sr_config_get() and sr_config_list() calls
+ * for this device instance are kept, and repeated calls get answered
+ * without involving the driver. Cached values get dropped when the
+ * configuration gets changed (sr_config_set(), sr_config_commit()),
+ * when the device gets opened or closed, and when an acquisition
+ * starts.
+ *
+ * Keys which reflect the device's current state (measured values,
+ * protection status) are never cached.
+ *
+ * @param sdi The device instance. Must not be NULL.
+ * @param enable TRUE to enable the cache, FALSE to disable it.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid argument.
+ *
+ * @since 0.6.0
+ */
+SR_API int sr_config_cache_enable(struct sr_dev_inst *sdi, gboolean enable)
+{
+	struct sr_config_cache *cache;
+
+	if (!sdi)
+		return SR_ERR_ARG;
+
+	cache = config_cache_get(sdi);
+	g_mutex_lock(&cache->mutex);
+	cache->enabled = enable;
+	g_hash_table_remove_all(cache->values);
+	g_mutex_unlock(&cache->mutex);
+
+	return SR_OK;
+}
+
+/**
+ * Drop all cached configuration values of a device instance.
+ *
+ * Applications call this when they know that the device's configuration
+ * was changed by other means, e.g. on the instrument's front panel.
+ *
+ * @param sdi The device instance. Must not be NULL.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid argument.
+ *
+ * @since 0.6.0
+ */
+SR_API int sr_config_cache_invalidate(const struct sr_dev_inst *sdi)
+{
+	struct sr_config_cache *cache;
+
+	if (!sdi)
+		return SR_ERR_ARG;
+
+	if (!(cache = sdi->config_cache))
+		return SR_OK;
+
+	g_mutex_lock(&cache->mutex);
+	if (g_hash_table_size(cache->values))
+		sr_spew("%s: Dropping %u cached config values.",
+			sdi->driver ? sdi->driver->name : "unknown",
+			g_hash_table_size(cache->values));
+	g_hash_table_remove_all(cache->values);
+	g_mutex_unlock(&cache->mutex);
+
+	return SR_OK;
+}
+
+/**
+ * Have a configuration key of a device instance never get cached.
+ *
+ * Drivers call this for keys which reflect the device's current state,
+ * or which the device may change by itself.
+ *
+ * @param sdi The device instance. Must not be NULL.
+ * @param key The configuration key (SR_CONF_*).
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid argument.
+ *
+ * @private
+ */
+SR_PRIV int sr_config_cache_volatile(struct sr_dev_inst *sdi, uint32_t key)
+{
+	struct sr_config_cache *cache;
+
+	if (!sdi)
+		return SR_ERR_ARG;
+
+	cache = config_cache_get(sdi);
+	g_mutex_lock(&cache->mutex);
+	if (!config_cache_is_volatile(cache, key))
+		g_array_append_val(cache->volatile_keys, key);
+	g_mutex_unlock(&cache->mutex);
+	sr_config_cache_invalidate(sdi);
+
+	return SR_OK;
+}
+
+/** @private */
+SR_PRIV void sr_config_cache_free(struct sr_dev_inst *sdi)
+{
+	struct sr_config_cache *cache;
+
+	if (!sdi || !(cache = sdi->config_cache))
+		return;
+
+	if (cache->hits || cache->misses)
+		sr_dbg("Config cache: %" PRIu64 " hits, %" PRIu64 " misses.",
+			cache->hits, cache->misses);
+	g_hash_table_destroy(cache->values);
+	g_array_free(cache->volatile_keys, TRUE);
+	g_mutex_clear(&cache->mutex);
+	g_free(cache);
+	sdi->config_cache = NULL;
+}
+
 static void log_key(const struct sr_dev_inst *sdi,
 	const struct sr_channel_group *cg, uint32_t key, unsigned int op,
 	GVariant *data)
@@ -808,6 +1347,10 @@ SR_API int sr_config_get(const struct sr_dev_driver *driver,
 	if (!driver->config_get)
 		return SR_ERR_ARG;
 
+	/* Only successful (thus valid) requests get cached. */
+	if ((*data = config_cache_lookup(sdi, cg, key, SR_CONF_GET)))
+		return SR_OK;
+
 	if (check_key(driver, sdi, cg, key, SR_CONF_GET, NULL) != SR_OK)
 		return SR_ERR_ARG;
 
@@ -821,6 +1364,7 @@ SR_API int sr_config_get(const struct sr_dev_driver *driver,
 		/* Got a floating reference from the driver. Sink it here,
 		 * caller will need to unref when done with it. */
 		g_variant_ref_sink(*data);
+		config_cache_store(sdi, cg, key, SR_CONF_GET, *data);
 	}
 
 	if (ret == SR_ERR_CHANNEL_GROUP)
@@ -871,6 +1415,7 @@ SR_API int sr_config_set(const struct sr_dev_inst *sdi,
 	else if ((ret = sr_variant_type_check(key, data)) == SR_OK) {
 		log_key(sdi, cg, key, SR_CONF_SET, data);
 		ret = sdi->driver->config_set(key, data, sdi, cg);
+		sr_config_cache_invalidate(sdi);
 	}
 
 	g_variant_unref(data);
@@ -903,8 +1448,10 @@ SR_API int sr_config_commit(const struct sr_dev_inst *sdi)
 		sr_err("%s: Device instance not active, can't commit config.",
 			sdi->driver->name);
 		ret = SR_ERR_DEV_CLOSED;
-	} else
+	} else {
 		ret = sdi->driver->config_commit(sdi);
+		sr_config_cache_invalidate(sdi);
+	}
 
 	return ret;
 }
@@ -951,6 +1498,9 @@ SR_API int sr_config_list(const struct sr_dev_driver *driver,
 	if (!driver->config_list)
 		return SR_ERR_ARG;
 
+	if ((*data = config_cache_lookup(sdi, cg, key, SR_CONF_LIST)))
+		return SR_OK;
+
 	if (key != SR_CONF_SCAN_OPTIONS && key != SR_CONF_DEVICE_OPTIONS) {
 		if (check_key(driver, sdi, cg, key, SR_CONF_LIST, NULL) != SR_OK)
 			return SR_ERR_ARG;
@@ -985,6 +1535,7 @@ SR_API int sr_config_list(const struct sr_dev_driver *driver,
 	if ((ret = driver->config_list(key, data, sdi, cg)) == SR_OK) {
 		log_key(sdi, cg, key, SR_CONF_LIST, *data);
 		g_variant_ref_sink(*data);
+		config_cache_store(sdi, cg, key, SR_CONF_LIST, *data);
 	}
 
 	if (ret == SR_ERR_CHANNEL_GROUP)
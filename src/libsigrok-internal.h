@@ -1090,10 +1090,16 @@ struct sr_context {
 #ifdef HAVE_LIBUSB_1_0
 	libusb_context *libusb_ctx;
 #endif
+	/* USB and HID got initialized, see sr_transports_init(). */
+	gboolean transports_ready;
 	sr_resource_open_callback resource_open_cb;
 	sr_resource_close_callback resource_close_cb;
 	sr_resource_read_callback resource_read_cb;
 	void *resource_cb_data;
+	/* Loaded resources, and images loaded into devices (resource.c). */
+	GMutex resource_lock;
+	GHashTable *resource_cache;
+	GHashTable *loaded_images;
 };
 
 /** Input module metadata keys. */
@@ -1370,6 +1376,111 @@ struct sr_output_module {
 	int (*cleanup) (struct sr_output *o);
 };
 
+/*
+ * Acquisition metrics (see metrics.c). Counters get updated with relaxed
+ * atomic operations, so they can be read from any thread without locks.
+ */
+
+/* Histogram buckets: 0, then [2^(i-1), 2^i) for bucket i. */
+#define SR_METRIC_BUCKETS	24
+
+/** Distribution of values, usually durations in microseconds. */
+struct sr_metric_hist {
+	uint64_t count;
+	uint64_t sum;
+	uint64_t max;
+	uint64_t buckets[SR_METRIC_BUCKETS];
+};
+
+/** Statistics of a soft trigger's pre-trigger data. */
+struct soft_trigger_stats {
+	/* Pre-trigger data copied into the circular buffer. */
+	uint64_t bytes_copied;
+	/* Pre-trigger data kept in retained driver buffers. */
+	uint64_t bytes_retained;
+	uint64_t buffers_retained;
+	/* Data which fell out of the pre-trigger window. */
+	uint64_t bytes_dropped;
+	/* Pre-trigger data sent when the trigger fired. */
+	uint64_t bytes_sent;
+	uint64_t triggers;
+	/* Pre-trigger data which is held currently. */
+	uint64_t fill_bytes;
+};
+
+/** Metrics of a device's acquisition, see sr_session_stats_get(). */
+struct sr_dev_metrics {
+	/* Time when the acquisition started. */
+	int64_t start_us;
+	/* Between SR_DF_HEADER and SR_DF_END. */
+	gint streaming;
+	/* Datafeed packets from the driver. */
+	uint64_t packets;
+	uint64_t logic_bytes;
+	uint64_t analog_samples;
+	/* Time in sr_session_send(), transforms and callbacks. */
+	struct sr_metric_hist send_us;
+	/* Transport (USB transfers). */
+	uint64_t transfers;
+	uint64_t transfer_bytes;
+	uint64_t empty_transfers;
+	uint64_t failed_transfers;
+	uint64_t resubmits;
+	uint64_t starved;
+	struct sr_metric_hist transfer_latency_us;
+	/* Output module (data not written yet, time of writes). */
+	uint64_t output_queued_bytes;
+	struct sr_metric_hist output_write_us;
+	/* The driver's soft trigger. */
+	struct soft_trigger_stats soft_trigger;
+};
+
+#ifdef HAVE_ATOMIC_64
+static inline void sr_metric_add(uint64_t *counter, uint64_t value)
+{
+	__atomic_fetch_add(counter, value, __ATOMIC_RELAXED);
+}
+
+static inline void sr_metric_set(uint64_t *gauge, uint64_t value)
+{
+	__atomic_store_n(gauge, value, __ATOMIC_RELAXED);
+}
+
+static inline uint64_t sr_metric_get(const uint64_t *counter)
+{
+	return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+#else
+/* Without 64-bit atomics, metrics get updated under a lock. */
+SR_PRIV void sr_metric_add(uint64_t *counter, uint64_t value);
+SR_PRIV void sr_metric_set(uint64_t *gauge, uint64_t value);
+SR_PRIV uint64_t sr_metric_get(const uint64_t *counter);
+#endif
+
+/* Device metrics get updated through const device instances, too. */
+#define SR_DEV_METRICS(sdi)	((struct sr_dev_metrics *)&(sdi)->metrics)
+
+/** Sample position and timing of a device's acquisition, see timing.c. */
+struct sr_dev_timing {
+	uint64_t samplerate;
+	/* Index of the next logic sample. */
+	uint64_t logic_sample;
+	/* Index and length of the current round of analog packets. */
+	uint64_t analog_sample;
+	uint64_t analog_len;
+	/* First channel of a round's first packet. */
+	const struct sr_channel *analog_ch;
+	gboolean analog_seen;
+	/* Host time of a sample, which following timestamps refer to. */
+	uint64_t sync_sample;
+	int64_t sync_us;
+	/* Whether the driver synchronized the time. */
+	gboolean hw_timed;
+};
+
+/* Timestamps get computed when const device instances send packets. */
+#define SR_DEV_TIMING(sdi)	((struct sr_dev_timing *)&(sdi)->timing)
+
 /** Transform module instance. */
 struct sr_transform {
 	/** A pointer to this transform's module. */
@@ -1386,6 +1497,9 @@ struct sr_transform {
 	 * state between calls into its callback functions.
 	 */
 	void *priv;
+
+	/** Time spent in the module's receive(), see sr_session_stats_get(). */
+	struct sr_metric_hist receive_us;
 };
 
 struct sr_transform_module {
@@ -1473,6 +1587,7 @@ struct sr_serial_dev_inst;
 #ifdef HAVE_SERIAL_COMM
 struct ser_lib_functions;
 struct ser_hid_chip_functions;
+struct ser_reactor_port;
 struct sr_bt_desc;
 typedef void (*serial_rx_chunk_callback)(struct sr_serial_dev_inst *serial,
 	void *cb_data, const void *buf, size_t count);
@@ -1491,6 +1606,10 @@ struct sr_serial_dev_inst {
 	GString *rcv_buffer;
 	serial_rx_chunk_callback rx_chunk_cb_func;
 	void *rx_chunk_cb_data;
+	/** Registration with the shared I/O reactor (if any). */
+	struct ser_reactor_port *reactor_port;
+	/** Whether the port is locked for a parallel scan. */
+	gboolean port_locked;
 #ifdef HAVE_LIBSERIALPORT
 	/** libserialport port handle */
 	struct sp_port *sp_data;
@@ -1557,13 +1676,45 @@ SR_PRIV int sr_log(int loglevel, const char *format, ...)
 #else
 SR_PRIV int sr_log(int loglevel, const char *format, ...) G_GNUC_PRINTF(2, 3);
 #endif
+SR_PRIV int sr_log_msg(int loglevel, const char *format, ...) G_GNUC_PRINTF(2, 3);
+SR_PRIV gboolean sr_log_prefix_enabled(int loglevel, const char *prefix);
+SR_PRIV void sr_log_async_stop(void);
+
+/* Messages above this level get compiled out (see --with-max-loglevel). */
+#ifndef SR_LOG_MAX_LEVEL
+#define SR_LOG_MAX_LEVEL SR_LOG_SPEW
+#endif
+
+/* The highest level which is enabled for any subsystem. Atomic. */
+extern SR_PRIV gint sr_log_threshold;
+/* Whether some subsystems have their own level, see sr_log_filter_set(). */
+extern SR_PRIV gint sr_log_filtered;
+
+/*
+ * Check whether the calling subsystem logs messages of a level. This
+ * is done inline, so disabled messages don't cost a function call nor
+ * the evaluation of their arguments.
+ */
+#define sr_log_enabled(level) \
+	((level) <= SR_LOG_MAX_LEVEL && \
+	(level) <= g_atomic_int_get(&sr_log_threshold) && \
+	(!g_atomic_int_get(&sr_log_filtered) || \
+	sr_log_prefix_enabled((level), LOG_PREFIX)))
+
+#define sr_log_prefixed(level, ...) \
+	(sr_log_enabled(level) ? \
+	sr_log_msg((level), LOG_PREFIX ": " __VA_ARGS__) : SR_OK)
 
 /* Message logging helpers with subsystem-specific prefix string. */
-#define sr_spew(...)	sr_log(SR_LOG_SPEW, LOG_PREFIX ": " __VA_ARGS__)
-#define sr_dbg(...)	sr_log(SR_LOG_DBG,  LOG_PREFIX ": " __VA_ARGS__)
-#define sr_info(...)	sr_log(SR_LOG_INFO, LOG_PREFIX ": " __VA_ARGS__)
-#define sr_warn(...)	sr_log(SR_LOG_WARN, LOG_PREFIX ": " __VA_ARGS__)
-#define sr_err(...)	sr_log(SR_LOG_ERR,  LOG_PREFIX ": " __VA_ARGS__)
+#define sr_spew(...)	sr_log_prefixed(SR_LOG_SPEW, __VA_ARGS__)
+#define sr_dbg(...)	sr_log_prefixed(SR_LOG_DBG,  __VA_ARGS__)
+#define sr_info(...)	sr_log_prefixed(SR_LOG_INFO, __VA_ARGS__)
+#define sr_warn(...)	sr_log_prefixed(SR_LOG_WARN, __VA_ARGS__)
+#define sr_err(...)	sr_log_prefixed(SR_LOG_ERR,  __VA_ARGS__)
+
+/*--- backend.c -------------------------------------------------------------*/
+
+SR_PRIV int sr_transports_init(struct sr_context *ctx);
 
 /*--- device.c --------------------------------------------------------------*/
 
@@ -1619,6 +1770,12 @@ struct sr_dev_inst {
 	void *priv;
 	/** Session to which this device is currently assigned. */
 	struct sr_session *session;
+	/** Cached configuration values, see sr_config_cache_enable(). */
+	struct sr_config_cache *config_cache;
+	/** Acquisition metrics, see SR_DEV_METRICS(). */
+	struct sr_dev_metrics metrics;
+	/** Packet timestamps, see SR_DEV_TIMING(). */
+	struct sr_dev_timing timing;
 };
 
 /* Generic device instances */
@@ -1675,6 +1832,13 @@ SR_PRIV struct sr_config *sr_config_new(uint32_t key, GVariant *data);
 SR_PRIV void sr_config_free(struct sr_config *src);
 SR_PRIV int sr_dev_acquisition_start(struct sr_dev_inst *sdi);
 SR_PRIV int sr_dev_acquisition_stop(struct sr_dev_inst *sdi);
+SR_PRIV gboolean sr_driver_scan_is_parallel(void);
+SR_PRIV void sr_driver_scan_set_parallel(gboolean parallel);
+SR_PRIV unsigned int sr_driver_scan_threads(void);
+SR_PRIV int sr_scan_lock(const char *name);
+SR_PRIV void sr_scan_unlock(const char *name);
+SR_PRIV int sr_config_cache_volatile(struct sr_dev_inst *sdi, uint32_t key);
+SR_PRIV void sr_config_cache_free(struct sr_dev_inst *sdi);
 
 /*--- session.c -------------------------------------------------------------*/
 
@@ -1700,6 +1864,8 @@ struct sr_session {
 	/** Context of the session main loop. */
 	GMainContext *main_context;
 
+	/** Mutex protecting the event sources table and stop check. */
+	GMutex sources_mutex;
 	/** Registered event sources for this session. */
 	GHashTable *event_sources;
 	/** Session main loop. */
@@ -1708,6 +1874,26 @@ struct sr_session {
 	unsigned int stop_check_id;
 	/** Whether the session has been started. */
 	gboolean running;
+	/** Start of the current (or last) run. */
+	int64_t start_us;
+	/** Interval of SR_CONF_SESSION_STATS packets, 0 if disabled. */
+	unsigned int stats_interval_ms;
+	/** ID of the timer source which sends the stats packets. */
+	unsigned int stats_source_id;
+	/** Whether to measure the time spent in transforms and callbacks. */
+	gboolean stats_timing;
+	/** Whether each device runs on its own dispatch thread. */
+	gboolean device_threads;
+	/** Dispatch threads of the current run, NULL without them. */
+	GSList *dev_threads;
+	/** Serializes packets of the dispatch threads to the callbacks. */
+	GMutex feed_mutex;
+	/** Whether any datafeed callback wants timestamps. */
+	gboolean timed_callbacks;
+	/** Merge window of the devices' packets, 0 if disabled. */
+	uint64_t merge_window_us;
+	/** Merge of the devices' packets of the current run, or NULL. */
+	struct sr_merge *merge;
 };
 
 SR_PRIV int sr_session_source_add_internal(struct sr_session *session,
@@ -1742,6 +1928,39 @@ SR_PRIV int sr_sessionfile_check(const char *filename);
 SR_PRIV struct sr_dev_inst *sr_session_prepare_sdi(const char *filename,
 		struct sr_session **session);
 
+/*--- metrics.c -------------------------------------------------------------*/
+
+SR_PRIV void sr_metric_hist_add(struct sr_metric_hist *hist, uint64_t value);
+SR_PRIV void sr_metric_hist_reset(struct sr_metric_hist *hist);
+SR_PRIV GVariant *sr_metric_hist_variant(const struct sr_metric_hist *hist);
+SR_PRIV void sr_dev_metrics_reset(struct sr_dev_metrics *metrics);
+SR_PRIV void sr_dev_metrics_packet(struct sr_dev_metrics *metrics,
+		const struct sr_datafeed_packet *packet);
+SR_PRIV GVariant *sr_dev_metrics_variant(const struct sr_dev_inst *sdi);
+
+/*--- timing.c --------------------------------------------------------------*/
+
+typedef void (*sr_merge_emit_callback)(const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *packet,
+		const struct sr_datafeed_timestamp *ts, void *cb_data);
+
+SR_PRIV void sr_dev_timing_prepare(const struct sr_dev_inst *sdi);
+SR_PRIV void sr_dev_timing_stamp(const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *packet,
+		struct sr_datafeed_timestamp *ts);
+SR_PRIV void sr_dev_timing_sync(const struct sr_dev_inst *sdi,
+		int64_t time_us);
+SR_PRIV struct sr_merge *sr_merge_new(uint64_t window_us,
+		sr_merge_emit_callback emit, void *cb_data);
+SR_PRIV void sr_merge_dev_add(struct sr_merge *merge,
+		const struct sr_dev_inst *sdi);
+SR_PRIV int sr_merge_push(struct sr_merge *merge,
+		const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *packet,
+		const struct sr_datafeed_timestamp *ts);
+SR_PRIV void sr_merge_flush(struct sr_merge *merge);
+SR_PRIV void sr_merge_free(struct sr_merge *merge);
+
 /*--- session_file.c --------------------------------------------------------*/
 
 #if !HAVE_ZIP_DISCARD
@@ -1753,6 +1972,14 @@ SR_PRIV void sr_zip_discard(struct zip *archive);
 SR_PRIV GKeyFile *sr_sessionfile_read_metadata(struct zip *archive,
 			const struct zip_stat *entry);
 
+/*
+ * Frame index entries of segmented captures: First sample, number of
+ * samples, and trigger position within the frame, as little endian
+ * 64-bit values.
+ */
+#define SR_SESSIONFILE_FRAME_SIZE	24
+#define SR_SESSIONFILE_NO_TRIGGER	UINT64_MAX
+
 /*--- analog.c --------------------------------------------------------------*/
 
 SR_PRIV int sr_analog_init(struct sr_datafeed_analog *analog,
@@ -1852,6 +2079,28 @@ SR_PRIV void *sr_resource_load(struct sr_context *ctx, int type,
 		const char *name, size_t *size, size_t max_size)
 		G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
 
+/** A resource's contents, shared by the users of the resource cache. */
+struct sr_resource_image {
+	int type;
+	char *name;
+	const uint8_t *data;
+	size_t size;
+	/** SHA-256 of the contents, as a hex string. */
+	char *hash;
+};
+
+SR_PRIV struct sr_resource_image *sr_resource_image_get(struct sr_context *ctx,
+		int type, const char *name, size_t max_size)
+		G_GNUC_WARN_UNUSED_RESULT;
+SR_PRIV void sr_resource_image_unref(struct sr_resource_image *image);
+SR_PRIV gboolean sr_resource_image_loaded(struct sr_context *ctx,
+		const char *location, const struct sr_resource_image *image);
+SR_PRIV void sr_resource_image_set_loaded(struct sr_context *ctx,
+		const char *location, const struct sr_resource_image *image);
+SR_PRIV void sr_resource_cache_init(struct sr_context *ctx);
+SR_PRIV void sr_resource_cache_clear(struct sr_context *ctx);
+SR_PRIV void sr_resource_cache_free(struct sr_context *ctx);
+
 /*--- strutil.c -------------------------------------------------------------*/
 
 SR_PRIV int sr_atol(const char *str, long *ret);
@@ -1867,12 +2116,64 @@ SR_PRIV int sr_atof_ascii(const char *str, float *ret);
 SR_PRIV GString *sr_hexdump_new(const uint8_t *data, const size_t len);
 SR_PRIV void sr_hexdump_free(GString *s);
 
+/*--- trigger.c -------------------------------------------------------------*/
+
+/**
+ * Trigger matches of one stage for 64 channels, as bit masks. A sample
+ * matches when it has all bits of 'ones' set, all bits of 'zeros' clear,
+ * and the respective transitions from the previous sample.
+ */
+struct sr_trigger_masks {
+	uint64_t ones;
+	uint64_t zeros;
+	uint64_t rising;
+	uint64_t falling;
+	uint64_t edges;
+};
+
+/** A trigger's logic matches, compiled to masks for each stage. */
+struct sr_trigger_compiled {
+	size_t num_stages;
+	/* Number of 64-channel words in a sample. */
+	size_t num_words;
+	size_t unitsize;
+	/* Any stage has edge matches. */
+	gboolean has_edges;
+	/* num_words masks per stage. */
+	struct sr_trigger_masks *masks;
+};
+
+/* Bits of channels which do not match, zero when all of them match. */
+static inline uint64_t sr_trigger_masks_mismatch(
+	const struct sr_trigger_masks *m, uint64_t cur, uint64_t prev)
+{
+	return (~cur & m->ones) | (cur & m->zeros) |
+		((prev | ~cur) & m->rising) | ((~prev | cur) & m->falling) |
+		(~(prev ^ cur) & m->edges);
+}
+
+SR_API int sr_trigger_compile(const struct sr_trigger *trigger,
+		size_t unitsize, struct sr_trigger_compiled **compiled);
+SR_API void sr_trigger_compiled_free(struct sr_trigger_compiled *tc);
+SR_API gboolean sr_trigger_compiled_match(const struct sr_trigger_compiled *tc,
+		size_t stage, const uint8_t *sample, const uint8_t *prev);
+
 /*--- soft-trigger.c --------------------------------------------------------*/
 
+/* Called when the soft trigger no longer needs a retained buffer. */
+typedef void (*soft_trigger_release_cb)(void *handle, void *cb_data);
+
+struct soft_trigger_buffer {
+	const uint8_t *data;
+	size_t len;
+	void *handle;
+};
+
 struct soft_trigger_logic {
 	const struct sr_dev_inst *sdi;
 	const struct sr_trigger *trigger;
-	int count;
+	struct sr_trigger_compiled *compiled;
+	gboolean have_prev;
 	int unitsize;
 	int cur_stage;
 	uint8_t *prev_sample;
@@ -1880,6 +2181,17 @@ struct soft_trigger_logic {
 	uint8_t *pre_trigger_head;
 	int pre_trigger_size;
 	int pre_trigger_fill;
+	/* Retained driver buffers, the newest pre-trigger data. */
+	struct soft_trigger_buffer *retained;
+	size_t retained_max;
+	size_t retained_first;
+	size_t retained_count;
+	size_t retained_bytes;
+	soft_trigger_release_cb release;
+	void *release_cb_data;
+	struct soft_trigger_stats stats;
+	/* The part of the statistics which is in the device's metrics. */
+	struct soft_trigger_stats published;
 };
 
 SR_PRIV int logic_channel_unitsize(GSList *channels);
@@ -1889,6 +2201,12 @@ SR_PRIV struct soft_trigger_logic *soft_trigger_logic_new(
 SR_PRIV void soft_trigger_logic_free(struct soft_trigger_logic *st);
 SR_PRIV int soft_trigger_logic_check(struct soft_trigger_logic *st, uint8_t *buf,
 		int len, int *pre_trigger_samples);
+SR_PRIV void soft_trigger_logic_retain_buffers(struct soft_trigger_logic *stl,
+		size_t max_buffers, soft_trigger_release_cb release, void *cb_data);
+SR_PRIV int soft_trigger_logic_check_buffer(struct soft_trigger_logic *stl,
+		uint8_t *buf, int len, int *pre_trigger_samples,
+		void *handle, gboolean *retained);
+SR_PRIV void soft_trigger_logic_release_buffers(struct soft_trigger_logic *stl);
 
 /*--- serial.c --------------------------------------------------------------*/
 
@@ -1908,6 +2226,7 @@ typedef GSList *(*sr_ser_find_append_t)(GSList *devs, const char *name);
 
 SR_PRIV int serial_open(struct sr_serial_dev_inst *serial, int flags);
 SR_PRIV int serial_close(struct sr_serial_dev_inst *serial);
+SR_PRIV void serial_port_unlock(struct sr_serial_dev_inst *serial);
 SR_PRIV int serial_flush(struct sr_serial_dev_inst *serial);
 SR_PRIV int serial_drain(struct sr_serial_dev_inst *serial);
 SR_PRIV size_t serial_has_receive_data(struct sr_serial_dev_inst *serial);
@@ -1984,6 +2303,18 @@ extern SR_PRIV struct ser_lib_functions *ser_lib_funcs_hid;
 SR_PRIV int ser_name_is_bt(struct sr_serial_dev_inst *serial);
 extern SR_PRIV struct ser_lib_functions *ser_lib_funcs_bt;
 
+/*--- serial_reactor.c ------------------------------------------------------*/
+
+SR_PRIV int serial_reactor_source_add(struct sr_session *session,
+		struct sr_serial_dev_inst *serial, size_t packet_size,
+		packet_valid_callback is_valid,
+		packet_valid_len_callback is_valid_len, void *is_valid_state,
+		int timeout, sr_receive_data_callback cb, void *cb_data);
+SR_PRIV int serial_reactor_source_remove(struct sr_session *session,
+		struct sr_serial_dev_inst *serial);
+SR_PRIV int serial_reactor_read_packet(struct sr_serial_dev_inst *serial,
+		uint8_t *buf, size_t bufsize);
+
 #ifdef HAVE_LIBHIDAPI
 struct vid_pid_item {
 	uint16_t vid, pid;
@@ -2074,8 +2405,74 @@ SR_PRIV int usb_source_add(struct sr_session *session, struct sr_context *ctx,
 		int timeout, sr_receive_data_callback cb, void *cb_data);
 SR_PRIV int usb_source_remove(struct sr_session *session, struct sr_context *ctx);
 SR_PRIV int usb_get_port_path(libusb_device *dev, char *path, int path_len);
+SR_PRIV char *sr_usb_location(const struct sr_dev_inst *sdi);
 SR_PRIV gboolean usb_match_manuf_prod(libusb_device *dev,
 		const char *manufacturer, const char *product);
+
+/** Parameters of a USB bulk IN stream, see sr_usb_stream_start(). */
+struct sr_usb_stream_params {
+	/** The bulk IN endpoint. */
+	unsigned char endpoint;
+	/** The expected data rate, in bytes per millisecond. */
+	uint64_t bytes_per_ms;
+	/** Transfer sizes are a multiple of this (endpoint packet size). */
+	size_t align;
+	/** Initial size of one transfer, in milliseconds of data. */
+	unsigned int transfer_ms;
+	/** Transfers grow to at most this multiple of the initial size. */
+	unsigned int max_size_factor;
+	/** Data which all transfers in flight hold, in milliseconds. */
+	unsigned int total_ms;
+	/** Initial limit for the number of transfers in flight. */
+	unsigned int max_transfers;
+	/** Upper limit for transfers in flight when the stream adapts. */
+	unsigned int limit_transfers;
+	/** Try to use device memory (zero-copy) for transfer buffers. */
+	gboolean dev_mem;
+	/** Device metrics to update, or NULL (see SR_DEV_METRICS()). */
+	struct sr_dev_metrics *metrics;
+};
+
+/** Timing statistics of a USB stream, see sr_usb_stream_get_stats(). */
+struct sr_usb_stream_stats {
+	/** Number of completed transfers. */
+	uint64_t transfers;
+	/** Number of completed transfers which carried no data. */
+	uint64_t empty_transfers;
+	/** Number of received bytes. */
+	uint64_t bytes;
+	/** Completions which found (almost) no transfers left in flight. */
+	uint64_t starved;
+	/** Time from submission to completion of a transfer. */
+	uint64_t latency_min_us, latency_max_us, latency_sum_us;
+	/** Time which the driver's callback took to handle a transfer. */
+	uint64_t handler_max_us, handler_sum_us;
+	/** Number of transfers which the stream currently keeps in flight. */
+	unsigned int transfers_in_flight;
+	/** Current transfer size. */
+	size_t transfer_size;
+};
+
+struct sr_usb_stream;
+typedef void (*sr_usb_stream_callback)(struct sr_usb_stream *stream,
+		struct libusb_transfer *transfer, void *cb_data);
+
+SR_PRIV struct sr_usb_stream *sr_usb_stream_new(struct sr_usb_dev_inst *usb);
+SR_PRIV void sr_usb_stream_free(struct sr_usb_stream *stream);
+SR_PRIV int sr_usb_stream_start(struct sr_usb_stream *stream,
+		const struct sr_usb_stream_params *params,
+		sr_usb_stream_callback cb, void *cb_data);
+SR_PRIV int sr_usb_stream_resubmit(struct sr_usb_stream *stream,
+		struct libusb_transfer *transfer);
+SR_PRIV unsigned int sr_usb_stream_release(struct sr_usb_stream *stream,
+		struct libusb_transfer *transfer);
+SR_PRIV void sr_usb_stream_hold(struct sr_usb_stream *stream,
+		struct libusb_transfer *transfer);
+SR_PRIV void sr_usb_stream_cancel(struct sr_usb_stream *stream);
+SR_PRIV unsigned int sr_usb_stream_timeout(const struct sr_usb_stream *stream);
+SR_PRIV unsigned int sr_usb_stream_depth(const struct sr_usb_stream *stream);
+SR_PRIV void sr_usb_stream_get_stats(const struct sr_usb_stream *stream,
+		struct sr_usb_stream_stats *stats);
 #endif
 
 /*--- binary_helpers.c ------------------------------------------------------*/
@@ -2217,6 +2614,59 @@ SR_PRIV int sr_modbus_write_multiple_registers(struct sr_modbus_dev_inst*modbus,
 SR_PRIV int sr_modbus_close(struct sr_modbus_dev_inst *modbus);
 SR_PRIV void sr_modbus_free(struct sr_modbus_dev_inst *modbus);
 
+/**
+ * A set of holding register ranges which get read together. Adjacent
+ * ranges are merged into multi-register requests, ranges of static
+ * registers only get read once (until invalidated).
+ */
+struct sr_modbus_batch;
+
+SR_PRIV struct sr_modbus_batch *sr_modbus_batch_new(void);
+SR_PRIV void sr_modbus_batch_free(struct sr_modbus_batch *batch);
+SR_PRIV void sr_modbus_batch_set_max_gap(struct sr_modbus_batch *batch,
+		int nb_registers);
+SR_PRIV int sr_modbus_batch_add(struct sr_modbus_batch *batch,
+		int address, int nb_registers, gboolean is_static);
+SR_PRIV int sr_modbus_batch_read(struct sr_modbus_dev_inst *modbus,
+		struct sr_modbus_batch *batch);
+SR_PRIV int sr_modbus_batch_get(const struct sr_modbus_batch *batch,
+		int address, int nb_registers, uint16_t *registers);
+SR_PRIV void sr_modbus_batch_invalidate(struct sr_modbus_batch *batch,
+		int address, int nb_registers);
+
+/*--- dmm/lcd.c -------------------------------------------------------------*/
+
+/**
+ * Lookup table for seven segment LCD digits. Table entries hold the
+ * digit's value plus one, zero entries flag invalid segment patterns.
+ */
+struct sr_lcd_digits {
+	/** Bits of a segment pattern which are part of the digit. */
+	uint8_t mask;
+	uint8_t lut[256];
+};
+
+/** Initializer for sr_lcd_digits.lut from the patterns of digits 0-9. */
+#define SR_LCD_DIGIT_LUT(d0, d1, d2, d3, d4, d5, d6, d7, d8, d9) { \
+	[d0] = 1, [d1] = 2, [d2] = 3, [d3] = 4, [d4] = 5, \
+	[d5] = 6, [d6] = 7, [d7] = 8, [d8] = 9, [d9] = 10, \
+}
+
+SR_PRIV int sr_lcd_digits_decode(const struct sr_lcd_digits *digits,
+	const uint8_t *codes, size_t count, int *value);
+
+/** Fixed bits in a DMM packet which help synchronize to the stream. */
+struct sr_dmm_sync {
+	size_t length;
+	const uint8_t *mask;
+	const uint8_t *value;
+};
+
+SR_PRIV gboolean sr_dmm_sync_match(const struct sr_dmm_sync *sync,
+	const uint8_t *buf);
+SR_PRIV size_t sr_dmm_sync_find(const struct sr_dmm_sync *sync,
+	const uint8_t *buf, size_t len);
+
 /*--- dmm/es519xx.c ---------------------------------------------------------*/
 
 /**
@@ -2276,6 +2726,7 @@ struct fs9922_info {
 	int bargraph_sign, bargraph_value;
 };
 
+extern SR_PRIV const struct sr_dmm_sync sr_fs9922_sync;
 SR_PRIV gboolean sr_fs9922_packet_valid(const uint8_t *buf);
 SR_PRIV int sr_fs9922_parse(const uint8_t *buf, float *floatval,
 			    struct sr_datafeed_analog *analog, void *info);
@@ -2292,6 +2743,7 @@ struct fs9721_info {
 	gboolean is_c2c1_11, is_c2c1_10, is_c2c1_01, is_c2c1_00, is_sign;
 };
 
+extern SR_PRIV const struct sr_dmm_sync sr_fs9721_sync;
 SR_PRIV gboolean sr_fs9721_packet_valid(const uint8_t *buf);
 SR_PRIV int sr_fs9721_parse(const uint8_t *buf, float *floatval,
 			    struct sr_datafeed_analog *analog, void *info);
@@ -2362,6 +2814,7 @@ struct dtm0660_info {
 	gboolean is_minmax, is_max, is_sign;
 };
 
+extern SR_PRIV const struct sr_dmm_sync sr_dtm0660_sync;
 SR_PRIV gboolean sr_dtm0660_packet_valid(const uint8_t *buf);
 SR_PRIV int sr_dtm0660_parse(const uint8_t *buf, float *floatval,
 			struct sr_datafeed_analog *analog, void *info);
@@ -2394,6 +2847,7 @@ struct metex14_info {
 #ifdef HAVE_SERIAL_COMM
 SR_PRIV int sr_metex14_packet_request(struct sr_serial_dev_inst *serial);
 #endif
+extern SR_PRIV const struct sr_dmm_sync sr_metex14_sync;
 SR_PRIV gboolean sr_metex14_packet_valid(const uint8_t *buf);
 SR_PRIV int sr_metex14_parse(const uint8_t *buf, float *floatval,
 			     struct sr_datafeed_analog *analog, void *info);
@@ -20,6 +20,7 @@
 #include <config.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 #include <glib/gprintf.h>
 #include <libsigrok/libsigrok.h>
 #include "libsigrok-internal.h"
@@ -43,11 +44,43 @@
  */
 
 /* Currently selected libsigrok loglevel. Default: SR_LOG_WARN. */
-static int cur_loglevel = SR_LOG_WARN; /* Show errors+warnings per default. */
+static gint cur_loglevel = SR_LOG_WARN; /* Show errors+warnings per default. */
 
-/* Function prototype. */
+/*
+ * The inline checks read these without the filter lock, while another
+ * thread may change the filters. Access them with atomic operations.
+ */
+/** @cond PRIVATE */
+SR_PRIV gint sr_log_threshold = SR_LOG_WARN;
+SR_PRIV gint sr_log_filtered = 0;
+/** @endcond */
+
+/* Log levels of subsystems, which differ from the global loglevel. */
+struct log_filter {
+	char *prefix;
+	int loglevel;
+};
+static GMutex log_filter_lock;
+static GSList *log_filters;
+/* Changes with the filters, and invalidates the cached levels. */
+static gint log_filter_gen = 1;
+
+/*
+ * Cached levels of the subsystems, indexed by their LOG_PREFIX string's
+ * address. Entries hold the level and the filter generation they were
+ * looked up for (gen << 4 | level).
+ */
+#define LOG_PREFIX_CACHE_SIZE	64
+static struct {
+	gpointer prefix;
+	gint info;
+} log_prefix_cache[LOG_PREFIX_CACHE_SIZE];
+
+/* Function prototypes. */
 static int sr_logv(void *cb_data, int loglevel, const char *format,
 		   va_list args);
+static void async_stop(void);
+static void update_filters(void);
 
 /* Pointer to the currently selected log callback. Default: sr_logv(). */
 static sr_log_callback sr_log_cb = sr_logv;
@@ -63,6 +96,62 @@ static void *sr_log_cb_data = NULL;
 /** @endcond */
 static int64_t sr_log_start_time = 0;
 
+/** @cond PRIVATE */
+/* Number of records in the asynchronous logger's ring, a power of 2. */
+#define ASYNC_RECORDS		1024
+/* Longer messages get truncated. */
+#define ASYNC_MESSAGE_SIZE	256
+/* Call sites get hashed to this many rate limiting slots. */
+#define ASYNC_SITES		256
+/* A call site takes the first free slot of this many, from its hash on. */
+#define ASYNC_SITE_PROBES	4
+/* The drain thread checks for records this often, unless woken up. */
+#define ASYNC_WAIT_US		(10 * 1000)
+/** @endcond */
+
+struct log_record {
+	gint seq;
+	int loglevel;
+	int64_t time_us;
+	char message[ASYNC_MESSAGE_SIZE];
+};
+
+struct log_site {
+	gpointer format;
+	gint second;
+	gint count;
+};
+
+/*
+ * The asynchronous logger. Logging threads format their messages into
+ * the records of a bounded lock-free queue, a background thread passes
+ * them on. When the queue is full, messages get dropped instead of
+ * blocking the logging thread.
+ *
+ * The queue gets set up once and is never reset, so threads which still
+ * queue a message while the logger restarts can't corrupt it.
+ */
+static struct {
+	GMutex lock;
+	GCond cond;
+	/* Signalled by the drain thread when it emptied the queue. */
+	GCond flushed;
+	GThread *thread;
+	gboolean quit;
+	gint sleeping;
+	struct log_record *records;
+	gint enqueue_pos;
+	gint dequeue_pos;
+	sr_log_callback cb;
+	void *cb_data;
+	gint rate_limit;
+	struct log_site sites[ASYNC_SITES];
+	gint logged, dropped, limited;
+	/* The counters when the logger was (re)started. */
+	guint logged_start, dropped_start, limited_start;
+	guint reported;
+} async_log;
+
 /**
  * Set the libsigrok loglevel.
  *
@@ -90,7 +179,10 @@ SR_API int sr_log_loglevel_set(int loglevel)
 	if (loglevel >= LOGLEVEL_TIMESTAMP && sr_log_start_time == 0)
 		sr_log_start_time = g_get_monotonic_time();
 
-	cur_loglevel = loglevel;
+	g_mutex_lock(&log_filter_lock);
+	g_atomic_int_set(&cur_loglevel, loglevel);
+	update_filters();
+	g_mutex_unlock(&log_filter_lock);
 
 	sr_dbg("libsigrok loglevel set to %d.", loglevel);
 
@@ -106,7 +198,7 @@ SR_API int sr_log_loglevel_set(int loglevel)
  */
 SR_API int sr_log_loglevel_get(void)
 {
-	return cur_loglevel;
+	return g_atomic_int_get(&cur_loglevel);
 }
 
 /**
@@ -135,6 +227,7 @@ SR_API int sr_log_callback_set(sr_log_callback cb, void *cb_data)
 
 	sr_log_cb = cb;
 	sr_log_cb_data = cb_data;
+	async_stop();
 
 	return SR_OK;
 }
@@ -156,6 +249,7 @@ SR_API int sr_log_callback_set_default(void)
 	 */
 	sr_log_cb = sr_logv;
 	sr_log_cb_data = NULL;
+	async_stop();
 
 	return SR_OK;
 }
@@ -182,55 +276,570 @@ SR_API int sr_log_callback_get(sr_log_callback *cb, void **cb_data)
 	return SR_OK;
 }
 
-static int sr_logv(void *cb_data, int loglevel, const char *format, va_list args)
+/* Remove newlines from a message, in place. Returns the new length. */
+static size_t strip_newlines(char *message)
 {
-	uint64_t elapsed_us, minutes;
-	unsigned int rest_us, seconds, microseconds;
-	char *raw_output, *output;
-	int raw_len, raw_idx, idx, ret;
+	char *rdptr, *wrptr;
 
-	/* This specific log callback doesn't need the void pointer data. */
-	(void)cb_data;
+	for (rdptr = wrptr = message; *rdptr; rdptr++) {
+		if (*rdptr != '\n')
+			*wrptr++ = *rdptr;
+	}
+	*wrptr = '\0';
 
-	(void)loglevel;
+	return wrptr - message;
+}
+
+/* Print a message to stderr, with a time stamp at debug levels. */
+static int log_print(int64_t time_us, const char *message)
+{
+	uint64_t elapsed_us, minutes;
+	unsigned int rest_us, seconds, microseconds;
+	int ret;
 
-	if (cur_loglevel >= LOGLEVEL_TIMESTAMP) {
-		elapsed_us = g_get_monotonic_time() - sr_log_start_time;
+	if (g_atomic_int_get(&cur_loglevel) >= LOGLEVEL_TIMESTAMP) {
+		elapsed_us = time_us - sr_log_start_time;
 
 		minutes = elapsed_us / G_TIME_SPAN_MINUTE;
 		rest_us = elapsed_us % G_TIME_SPAN_MINUTE;
 		seconds = rest_us / G_TIME_SPAN_SECOND;
 		microseconds = rest_us % G_TIME_SPAN_SECOND;
 
-		ret = g_fprintf(stderr, "sr: [%.2" PRIu64 ":%.2u.%.6u] ",
-				minutes, seconds, microseconds);
+		ret = g_fprintf(stderr, "sr: [%.2" PRIu64 ":%.2u.%.6u] %s\n",
+				minutes, seconds, microseconds, message);
 	} else {
-		ret = fputs("sr: ", stderr);
+		ret = g_fprintf(stderr, "sr: %s\n", message);
 	}
+	fflush(stderr);
+
+	return ret < 0 ? SR_ERR : SR_OK;
+}
 
-	if (ret < 0 || (raw_len = g_vasprintf(&raw_output, format, args)) < 0)
+static int sr_logv(void *cb_data, int loglevel, const char *format, va_list args)
+{
+	char *output;
+	int ret;
+
+	/* This specific log callback doesn't need the void pointer data. */
+	(void)cb_data;
+
+	(void)loglevel;
+
+	if (g_vasprintf(&output, format, args) < 0)
 		return SR_ERR;
+	strip_newlines(output);
+	ret = log_print(g_get_monotonic_time(), output);
+	g_free(output);
 
-	output = g_malloc0(raw_len + 1);
+	return ret;
+}
+
+/* Find the rate limiting slot of a call site, or claim a free one. */
+static struct log_site *async_site_get(const char *format)
+{
+	struct log_site *site;
+	gpointer owner;
+	size_t hash;
+	int i;
+
+	hash = GPOINTER_TO_SIZE(format) >> 3;
+	for (i = 0; i < ASYNC_SITE_PROBES; i++) {
+		site = &async_log.sites[(hash + i) % ASYNC_SITES];
+		owner = g_atomic_pointer_get(&site->format);
+		if (!owner && g_atomic_pointer_compare_and_exchange(&site->format,
+				NULL, (gpointer)format))
+			return site;
+		if (g_atomic_pointer_get(&site->format) == format)
+			return site;
+	}
+
+	return NULL;
+}
+
+/*
+ * Per call site rate limit, the format string identifies the site.
+ * Sites which find no slot don't get limited.
+ */
+static gboolean async_rate_limited(const char *format, int64_t time_us)
+{
+	struct log_site *site;
+	gint limit, second;
+
+	limit = g_atomic_int_get(&async_log.rate_limit);
+	if (!limit)
+		return FALSE;
+
+	site = async_site_get(format);
+	if (!site)
+		return FALSE;
+	second = time_us / G_TIME_SPAN_SECOND;
+	if (g_atomic_int_get(&site->second) != second) {
+		g_atomic_int_set(&site->count, 0);
+		g_atomic_int_set(&site->second, second);
+	}
+
+	return g_atomic_int_add(&site->count, 1) >= limit;
+}
 
-	/* Copy the string without any unwanted newlines. */
-	raw_idx = idx = 0;
-	while (raw_idx < raw_len) {
-		if (raw_output[raw_idx] != '\n') {
-			output[idx] = raw_output[raw_idx];
-			idx++;
+/* The log callback which queues messages for the drain thread. */
+static int async_logv(void *cb_data, int loglevel, const char *format,
+		va_list args)
+{
+	struct log_record *rec;
+	guint pos;
+	gint diff;
+	int64_t time_us;
+
+	(void)cb_data;
+
+	time_us = g_get_monotonic_time();
+	if (async_rate_limited(format, time_us)) {
+		g_atomic_int_inc(&async_log.limited);
+		return SR_OK;
+	}
+
+	/*
+	 * Claim a record. Its sequence number tells whether the drain
+	 * thread is done with it (bounded MPMC queue after D. Vyukov).
+	 */
+	pos = g_atomic_int_get(&async_log.enqueue_pos);
+	for (;;) {
+		rec = &async_log.records[pos % ASYNC_RECORDS];
+		diff = (gint)((guint)g_atomic_int_get(&rec->seq) - pos);
+		if (diff == 0) {
+			if (g_atomic_int_compare_and_exchange(&async_log.enqueue_pos,
+					pos, pos + 1))
+				break;
+			pos = g_atomic_int_get(&async_log.enqueue_pos);
+		} else if (diff < 0) {
+			g_atomic_int_inc(&async_log.dropped);
+			return SR_OK;
+		} else {
+			pos = g_atomic_int_get(&async_log.enqueue_pos);
 		}
-		raw_idx++;
 	}
 
-	g_fprintf(stderr, "%s\n", output);
-	fflush(stderr);
-	g_free(raw_output);
-	g_free(output);
+	rec->loglevel = loglevel;
+	rec->time_us = time_us;
+	g_vsnprintf(rec->message, sizeof(rec->message), format, args);
+	strip_newlines(rec->message);
+	g_atomic_int_set(&rec->seq, pos + 1);
+
+	if (g_atomic_int_get(&async_log.sleeping))
+		g_cond_signal(&async_log.cond);
 
 	return SR_OK;
 }
 
+static int async_sink(int loglevel, const char *format, ...)
+{
+	va_list args;
+	int ret;
+
+	va_start(args, format);
+	ret = async_log.cb(async_log.cb_data, loglevel, format, args);
+	va_end(args);
+
+	return ret;
+}
+
+static void async_deliver(int loglevel, int64_t time_us, const char *message)
+{
+	if (async_log.cb)
+		async_sink(loglevel, "%s", message);
+	else
+		log_print(time_us, message);
+}
+
+/* Pass on the oldest queued message, if there is one. */
+static gboolean async_drain(void)
+{
+	struct log_record *rec;
+	guint pos;
+
+	pos = g_atomic_int_get(&async_log.dequeue_pos);
+	rec = &async_log.records[pos % ASYNC_RECORDS];
+	if ((guint)g_atomic_int_get(&rec->seq) != pos + 1)
+		return FALSE;
+
+	async_deliver(rec->loglevel, rec->time_us, rec->message);
+	g_atomic_int_set(&rec->seq, pos + ASYNC_RECORDS);
+	g_atomic_int_set(&async_log.dequeue_pos, pos + 1);
+	g_atomic_int_inc(&async_log.logged);
+
+	return TRUE;
+}
+
+static gpointer async_thread(gpointer data)
+{
+	guint dropped;
+	char *message;
+
+	(void)data;
+
+	for (;;) {
+		while (async_drain())
+			;
+		dropped = g_atomic_int_get(&async_log.dropped) +
+			g_atomic_int_get(&async_log.limited);
+		if (dropped != async_log.reported) {
+			message = g_strdup_printf("%s: %u messages dropped.",
+				LOG_PREFIX, dropped - async_log.reported);
+			async_deliver(SR_LOG_WARN, g_get_monotonic_time(), message);
+			g_free(message);
+			async_log.reported = dropped;
+		}
+
+		g_mutex_lock(&async_log.lock);
+		g_cond_broadcast(&async_log.flushed);
+		if (async_log.quit) {
+			g_mutex_unlock(&async_log.lock);
+			break;
+		}
+		g_atomic_int_set(&async_log.sleeping, 1);
+		g_cond_wait_until(&async_log.cond, &async_log.lock,
+			g_get_monotonic_time() + ASYNC_WAIT_US);
+		g_atomic_int_set(&async_log.sleeping, 0);
+		g_mutex_unlock(&async_log.lock);
+	}
+	while (async_drain())
+		;
+	g_mutex_lock(&async_log.lock);
+	g_cond_broadcast(&async_log.flushed);
+	g_mutex_unlock(&async_log.lock);
+
+	return NULL;
+}
+
+/* Stop the drain thread, after it passed on all queued messages. */
+static void async_stop(void)
+{
+	if (!async_log.thread)
+		return;
+
+	g_mutex_lock(&async_log.lock);
+	async_log.quit = TRUE;
+	g_cond_signal(&async_log.cond);
+	g_mutex_unlock(&async_log.lock);
+
+	g_thread_join(async_log.thread);
+	async_log.thread = NULL;
+}
+
+/**
+ * Stop asynchronous logging, if it is active, after all queued messages
+ * were passed on. Restores the default log callback.
+ *
+ * @private
+ */
+SR_PRIV void sr_log_async_stop(void)
+{
+	if (sr_log_cb == async_logv)
+		sr_log_callback_set_default();
+}
+
+/**
+ * Have log messages passed on asynchronously, by a background thread.
+ *
+ * Logging threads only format their messages into a queue, they never
+ * block on the log output. This allows debug logging during fast
+ * acquisitions, where log output would otherwise slow down or stall
+ * USB callbacks and the session's datafeed.
+ *
+ * When the queue is full, messages get dropped. Messages longer than
+ * 255 characters get truncated. The number of dropped messages is
+ * reported in the log from time to time, see also
+ * sr_log_async_stats_get().
+ *
+ * The asynchronous logging stops when another log callback gets set,
+ * or on sr_exit(), after all queued messages were passed on.
+ *
+ * @param cb Function pointer to the log callback function which gets
+ *           invoked from the background thread. Its format string is
+ *           always "%s", with the complete message as the argument.
+ *           NULL selects the built-in output to stderr.
+ * @param cb_data Pointer to private data to be passed on.
+ *
+ * @retval SR_OK Success.
+ *
+ * @since 0.6.0
+ */
+SR_API int sr_log_callback_set_async(sr_log_callback cb, void *cb_data)
+{
+	static gsize records_set = 0;
+	guint i;
+
+	/*
+	 * When restarting, messages keep getting queued, and the new
+	 * drain thread passes them on.
+	 */
+	async_stop();
+
+	/*
+	 * The records are kept when the asynchronous logging stops,
+	 * threads which are about to queue a message may still use them.
+	 * Messages they queue after the drain thread stopped get passed
+	 * on once it runs again.
+	 */
+	if (g_once_init_enter(&records_set)) {
+		async_log.records = g_malloc0(ASYNC_RECORDS * sizeof(async_log.records[0]));
+		for (i = 0; i < ASYNC_RECORDS; i++)
+			g_atomic_int_set(&async_log.records[i].seq, i);
+		g_once_init_leave(&records_set, 1);
+	}
+	async_log.logged_start = g_atomic_int_get(&async_log.logged);
+	async_log.dropped_start = g_atomic_int_get(&async_log.dropped);
+	async_log.limited_start = g_atomic_int_get(&async_log.limited);
+	async_log.reported = async_log.dropped_start + async_log.limited_start;
+
+	async_log.cb = cb;
+	async_log.cb_data = cb_data;
+	g_mutex_lock(&async_log.lock);
+	async_log.quit = FALSE;
+	async_log.thread = g_thread_new("sr-log", async_thread, NULL);
+	g_mutex_unlock(&async_log.lock);
+
+	sr_log_cb = async_logv;
+	sr_log_cb_data = NULL;
+
+	return SR_OK;
+}
+
+/**
+ * Limit the number of messages per second and call site, which get
+ * queued for asynchronous logging.
+ *
+ * Call sites are identified by their format strings. Excess messages
+ * are dropped, and counted separately from messages which are dropped
+ * because the queue is full.
+ *
+ * @param per_second The number of messages per second. 0 disables the
+ *                   rate limit, which is the default.
+ *
+ * @retval SR_OK Success.
+ *
+ * @since 0.6.0
+ */
+SR_API int sr_log_async_rate_limit_set(unsigned int per_second)
+{
+	guint i;
+
+	/* Count from zero for the new limit. */
+	for (i = 0; i < ASYNC_SITES; i++)
+		g_atomic_int_set(&async_log.sites[i].count, 0);
+	g_atomic_int_set(&async_log.rate_limit, MIN(per_second, G_MAXINT));
+
+	return SR_OK;
+}
+
+/**
+ * Wait until all messages which were queued for asynchronous logging
+ * have been passed on.
+ *
+ * @retval SR_OK Success.
+ *
+ * @since 0.6.0
+ */
+SR_API int sr_log_async_flush(void)
+{
+	g_mutex_lock(&async_log.lock);
+	while (async_log.thread && !async_log.quit &&
+			g_atomic_int_get(&async_log.dequeue_pos) !=
+			g_atomic_int_get(&async_log.enqueue_pos)) {
+		g_cond_signal(&async_log.cond);
+		g_cond_wait(&async_log.flushed, &async_log.lock);
+	}
+	g_mutex_unlock(&async_log.lock);
+
+	return SR_OK;
+}
+
+/**
+ * Get the asynchronous logger's statistics, since it was started.
+ *
+ * @param[out] logged Number of messages passed on. Optional, can be NULL.
+ * @param[out] dropped Number of messages dropped because the queue was
+ *                     full. Optional, can be NULL.
+ * @param[out] limited Number of messages dropped by the rate limit.
+ *                     Optional, can be NULL.
+ *
+ * @retval SR_OK Success.
+ *
+ * @since 0.6.0
+ */
+SR_API int sr_log_async_stats_get(uint64_t *logged, uint64_t *dropped,
+		uint64_t *limited)
+{
+	if (logged)
+		*logged = (guint)g_atomic_int_get(&async_log.logged) -
+			async_log.logged_start;
+	if (dropped)
+		*dropped = (guint)g_atomic_int_get(&async_log.dropped) -
+			async_log.dropped_start;
+	if (limited)
+		*limited = (guint)g_atomic_int_get(&async_log.limited) -
+			async_log.limited_start;
+
+	return SR_OK;
+}
+
+/* Recompute the inline checks' state, with the filter lock held. */
+static void update_filters(void)
+{
+	const struct log_filter *filter;
+	GSList *l;
+	int threshold;
+
+	threshold = cur_loglevel;
+	for (l = log_filters; l; l = l->next) {
+		filter = l->data;
+		threshold = MAX(threshold, filter->loglevel);
+	}
+	g_atomic_int_set(&sr_log_threshold, threshold);
+	g_atomic_int_set(&sr_log_filtered, log_filters != NULL);
+	g_atomic_int_inc(&log_filter_gen);
+}
+
+static struct log_filter *find_filter(const char *prefix)
+{
+	struct log_filter *filter;
+	GSList *l;
+
+	for (l = log_filters; l; l = l->next) {
+		filter = l->data;
+		if (strcmp(filter->prefix, prefix) == 0)
+			return filter;
+	}
+
+	return NULL;
+}
+
+/*
+ * The level of a subsystem. Filters apply to their prefix, and to the
+ * prefixes below it ("output" applies to "output/srzip"), the longest
+ * match wins.
+ */
+static int prefix_loglevel(const char *prefix)
+{
+	const struct log_filter *filter;
+	GSList *l;
+	size_t len, best_len;
+	int loglevel;
+
+	loglevel = cur_loglevel;
+	best_len = 0;
+	for (l = log_filters; l; l = l->next) {
+		filter = l->data;
+		len = strlen(filter->prefix);
+		if (len <= best_len || strncmp(prefix, filter->prefix, len) != 0)
+			continue;
+		if (prefix[len] != '\0' && prefix[len] != '/')
+			continue;
+		loglevel = filter->loglevel;
+		best_len = len;
+	}
+
+	return loglevel;
+}
+
+/**
+ * Set the loglevel of a subsystem, which overrides the global loglevel.
+ *
+ * Subsystems are identified by the prefix of their log messages, for
+ * example "fx2lafw" or "session". A filter also applies to the
+ * subsystems below it, "output" applies to "output/srzip" as well.
+ *
+ * Enabling debug output for one subsystem doesn't slow down the others,
+ * their messages still get discarded without formatting them.
+ *
+ * @param prefix The subsystem's log message prefix. Must not be NULL.
+ * @param loglevel The loglevel to set (SR_LOG_NONE to SR_LOG_SPEW).
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid arguments.
+ *
+ * @since 0.6.0
+ */
+SR_API int sr_log_filter_set(const char *prefix, int loglevel)
+{
+	struct log_filter *filter;
+
+	if (!prefix || loglevel < SR_LOG_NONE || loglevel > SR_LOG_SPEW)
+		return SR_ERR_ARG;
+
+	g_mutex_lock(&log_filter_lock);
+	filter = find_filter(prefix);
+	if (!filter) {
+		filter = g_malloc0(sizeof(*filter));
+		filter->prefix = g_strdup(prefix);
+		log_filters = g_slist_prepend(log_filters, filter);
+	}
+	filter->loglevel = loglevel;
+	update_filters();
+	g_mutex_unlock(&log_filter_lock);
+
+	return SR_OK;
+}
+
+/**
+ * Remove the loglevel of a subsystem, which then uses the global
+ * loglevel again.
+ *
+ * @param prefix The subsystem's log message prefix, or NULL to remove
+ *               all subsystems' loglevels.
+ *
+ * @retval SR_OK Success.
+ *
+ * @since 0.6.0
+ */
+SR_API int sr_log_filter_clear(const char *prefix)
+{
+	struct log_filter *filter;
+	GSList *l, *next;
+
+	g_mutex_lock(&log_filter_lock);
+	for (l = log_filters; l; l = next) {
+		next = l->next;
+		filter = l->data;
+		if (prefix && strcmp(filter->prefix, prefix) != 0)
+			continue;
+		log_filters = g_slist_delete_link(log_filters, l);
+		g_free(filter->prefix);
+		g_free(filter);
+	}
+	update_filters();
+	g_mutex_unlock(&log_filter_lock);
+
+	return SR_OK;
+}
+
+/** @private */
+SR_PRIV gboolean sr_log_prefix_enabled(int loglevel, const char *prefix)
+{
+	gpointer cached;
+	gint gen, info;
+	int prefix_level;
+	size_t idx;
+
+	idx = (GPOINTER_TO_SIZE(prefix) >> 3) % LOG_PREFIX_CACHE_SIZE;
+	gen = g_atomic_int_get(&log_filter_gen);
+	cached = g_atomic_pointer_get(&log_prefix_cache[idx].prefix);
+	info = g_atomic_int_get(&log_prefix_cache[idx].info);
+	if (cached == prefix && (info >> 4) == gen &&
+			g_atomic_pointer_get(&log_prefix_cache[idx].prefix) == cached)
+		return loglevel <= (info & 0xf);
+
+	g_mutex_lock(&log_filter_lock);
+	prefix_level = prefix_loglevel(prefix);
+	gen = g_atomic_int_get(&log_filter_gen);
+	g_atomic_pointer_set(&log_prefix_cache[idx].prefix, NULL);
+	g_atomic_int_set(&log_prefix_cache[idx].info, gen << 4 | prefix_level);
+	g_atomic_pointer_set(&log_prefix_cache[idx].prefix, (gpointer)prefix);
+	g_mutex_unlock(&log_filter_lock);
+
+	return loglevel <= prefix_level;
+}
+
 /** @private */
 SR_PRIV int sr_log(int loglevel, const char *format, ...)
 {
@@ -238,7 +847,7 @@ SR_PRIV int sr_log(int loglevel, const char *format, ...)
 	va_list args;
 
 	/* Only output messages of at least the selected loglevel(s). */
-	if (loglevel > cur_loglevel)
+	if (loglevel > g_atomic_int_get(&cur_loglevel))
 		return SR_OK;
 
 	va_start(args, format);
@@ -248,4 +857,21 @@ SR_PRIV int sr_log(int loglevel, const char *format, ...)
 	return ret;
 }
 
+/**
+ * Output a message which passed sr_log_enabled() already.
+ *
+ * @private
+ */
+SR_PRIV int sr_log_msg(int loglevel, const char *format, ...)
+{
+	int ret;
+	va_list args;
+
+	va_start(args, format);
+	ret = sr_log_cb(sr_log_cb_data, loglevel, format, args);
+	va_end(args);
+
+	return ret;
+}
+
 /** @} */
@@ -0,0 +1,298 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 libsigrok contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Acquisition metrics: Counters and histograms which the session, the
+ * USB stream and output modules update while data flows, and their
+ * conversion to GVariant dictionaries for sr_session_stats_get().
+ *
+ * Updates are relaxed atomic operations, without locks. Each device's
+ * metrics are mostly updated from the thread which handles the device's
+ * data, so there is no contention between devices. Platforms without
+ * 64-bit atomics update the metrics under a lock instead.
+ */
+
+#include <config.h>
+#include <string.h>
+#include <glib.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+
+/** @cond PRIVATE */
+#define LOG_PREFIX "metrics"
+/** @endcond */
+
+#ifndef HAVE_ATOMIC_64
+static GMutex metrics_mutex;
+
+/** @private */
+SR_PRIV void sr_metric_add(uint64_t *counter, uint64_t value)
+{
+	g_mutex_lock(&metrics_mutex);
+	*counter += value;
+	g_mutex_unlock(&metrics_mutex);
+}
+
+/** @private */
+SR_PRIV void sr_metric_set(uint64_t *gauge, uint64_t value)
+{
+	g_mutex_lock(&metrics_mutex);
+	*gauge = value;
+	g_mutex_unlock(&metrics_mutex);
+}
+
+/** @private */
+SR_PRIV uint64_t sr_metric_get(const uint64_t *counter)
+{
+	uint64_t value;
+
+	g_mutex_lock(&metrics_mutex);
+	value = *counter;
+	g_mutex_unlock(&metrics_mutex);
+
+	return value;
+}
+#endif
+
+/* The number of significant bits of the value. */
+static unsigned int hist_bucket(uint64_t value)
+{
+	unsigned int bucket;
+
+	if (value >> 32)
+		bucket = 32 + g_bit_storage((gulong)(value >> 32));
+	else if (value)
+		bucket = g_bit_storage((gulong)value);
+	else
+		bucket = 0;
+
+	return MIN(bucket, SR_METRIC_BUCKETS - 1);
+}
+
+/**
+ * Add a value to a histogram.
+ *
+ * @param hist The histogram.
+ * @param value The value, usually a duration in microseconds.
+ *
+ * @private
+ */
+SR_PRIV void sr_metric_hist_add(struct sr_metric_hist *hist, uint64_t value)
+{
+	uint64_t max;
+
+	sr_metric_add(&hist->count, 1);
+	sr_metric_add(&hist->sum, value);
+	sr_metric_add(&hist->buckets[hist_bucket(value)], 1);
+
+#ifdef HAVE_ATOMIC_64
+	max = sr_metric_get(&hist->max);
+	while (value > max) {
+		if (__atomic_compare_exchange_n(&hist->max, &max, value,
+				TRUE, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			break;
+	}
+#else
+	g_mutex_lock(&metrics_mutex);
+	max = hist->max;
+	if (value > max)
+		hist->max = value;
+	g_mutex_unlock(&metrics_mutex);
+#endif
+}
+
+/** @private */
+SR_PRIV void sr_metric_hist_reset(struct sr_metric_hist *hist)
+{
+	unsigned int i;
+
+	sr_metric_set(&hist->count, 0);
+	sr_metric_set(&hist->sum, 0);
+	sr_metric_set(&hist->max, 0);
+	for (i = 0; i < SR_METRIC_BUCKETS; i++)
+		sr_metric_set(&hist->buckets[i], 0);
+}
+
+/**
+ * Get a histogram as a dictionary: "count", "sum" and "max" (uint64),
+ * and "buckets" (array of uint64). Bucket 0 counts zero values, bucket
+ * i counts values in [2^(i-1), 2^i), the last bucket all larger values.
+ *
+ * @private
+ */
+SR_PRIV GVariant *sr_metric_hist_variant(const struct sr_metric_hist *hist)
+{
+	GVariantBuilder builder;
+	uint64_t buckets[SR_METRIC_BUCKETS];
+	unsigned int i, used;
+
+	/* Leave out the unused buckets at the end. */
+	used = 0;
+	for (i = 0; i < SR_METRIC_BUCKETS; i++) {
+		buckets[i] = sr_metric_get(&hist->buckets[i]);
+		if (buckets[i])
+			used = i + 1;
+	}
+
+	g_variant_builder_init(&builder, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_add(&builder, "{sv}", "count",
+		g_variant_new_uint64(sr_metric_get(&hist->count)));
+	g_variant_builder_add(&builder, "{sv}", "sum",
+		g_variant_new_uint64(sr_metric_get(&hist->sum)));
+	g_variant_builder_add(&builder, "{sv}", "max",
+		g_variant_new_uint64(sr_metric_get(&hist->max)));
+	g_variant_builder_add(&builder, "{sv}", "buckets",
+		g_variant_new_fixed_array(G_VARIANT_TYPE_UINT64,
+			buckets, used, sizeof(buckets[0])));
+
+	return g_variant_builder_end(&builder);
+}
+
+/**
+ * Reset a device's metrics, when its acquisition starts.
+ *
+ * @private
+ */
+SR_PRIV void sr_dev_metrics_reset(struct sr_dev_metrics *metrics)
+{
+	metrics->start_us = g_get_monotonic_time();
+	g_atomic_int_set(&metrics->streaming, FALSE);
+	sr_metric_set(&metrics->packets, 0);
+	sr_metric_set(&metrics->logic_bytes, 0);
+	sr_metric_set(&metrics->analog_samples, 0);
+	sr_metric_hist_reset(&metrics->send_us);
+	sr_metric_set(&metrics->transfers, 0);
+	sr_metric_set(&metrics->transfer_bytes, 0);
+	sr_metric_set(&metrics->empty_transfers, 0);
+	sr_metric_set(&metrics->failed_transfers, 0);
+	sr_metric_set(&metrics->resubmits, 0);
+	sr_metric_set(&metrics->starved, 0);
+	sr_metric_hist_reset(&metrics->transfer_latency_us);
+	sr_metric_set(&metrics->output_queued_bytes, 0);
+	sr_metric_hist_reset(&metrics->output_write_us);
+	sr_metric_set(&metrics->soft_trigger.bytes_copied, 0);
+	sr_metric_set(&metrics->soft_trigger.bytes_retained, 0);
+	sr_metric_set(&metrics->soft_trigger.buffers_retained, 0);
+	sr_metric_set(&metrics->soft_trigger.bytes_dropped, 0);
+	sr_metric_set(&metrics->soft_trigger.bytes_sent, 0);
+	sr_metric_set(&metrics->soft_trigger.triggers, 0);
+	sr_metric_set(&metrics->soft_trigger.fill_bytes, 0);
+}
+
+/**
+ * Count a packet which a device's driver sent.
+ *
+ * @private
+ */
+SR_PRIV void sr_dev_metrics_packet(struct sr_dev_metrics *metrics,
+		const struct sr_datafeed_packet *packet)
+{
+	const struct sr_datafeed_logic *logic;
+	const struct sr_datafeed_analog *analog;
+
+	sr_metric_add(&metrics->packets, 1);
+	switch (packet->type) {
+	case SR_DF_HEADER:
+		g_atomic_int_set(&metrics->streaming, TRUE);
+		break;
+	case SR_DF_END:
+		g_atomic_int_set(&metrics->streaming, FALSE);
+		break;
+	case SR_DF_LOGIC:
+		logic = packet->payload;
+		sr_metric_add(&metrics->logic_bytes, logic->length);
+		break;
+	case SR_DF_ANALOG:
+		analog = packet->payload;
+		sr_metric_add(&metrics->analog_samples, analog->num_samples);
+		break;
+	}
+}
+
+static void add_u64(GVariantBuilder *builder, const char *key,
+		const uint64_t *counter)
+{
+	g_variant_builder_add(builder, "{sv}", key,
+		g_variant_new_uint64(sr_metric_get(counter)));
+}
+
+static GVariant *soft_trigger_variant(const struct soft_trigger_stats *st)
+{
+	GVariantBuilder builder;
+
+	g_variant_builder_init(&builder, G_VARIANT_TYPE_VARDICT);
+	add_u64(&builder, "bytes_copied", &st->bytes_copied);
+	add_u64(&builder, "bytes_retained", &st->bytes_retained);
+	add_u64(&builder, "buffers_retained", &st->buffers_retained);
+	add_u64(&builder, "bytes_dropped", &st->bytes_dropped);
+	add_u64(&builder, "bytes_sent", &st->bytes_sent);
+	add_u64(&builder, "triggers", &st->triggers);
+	add_u64(&builder, "fill_bytes", &st->fill_bytes);
+
+	return g_variant_builder_end(&builder);
+}
+
+/**
+ * Get a device's metrics as a dictionary, see sr_session_stats_get().
+ *
+ * @private
+ */
+SR_PRIV GVariant *sr_dev_metrics_variant(const struct sr_dev_inst *sdi)
+{
+	const struct sr_dev_metrics *m;
+	GVariantBuilder builder;
+	uint64_t elapsed_us, logic_bytes;
+
+	m = &sdi->metrics;
+	elapsed_us = m->start_us ? g_get_monotonic_time() - m->start_us : 0;
+	logic_bytes = sr_metric_get(&m->logic_bytes);
+
+	g_variant_builder_init(&builder, G_VARIANT_TYPE_VARDICT);
+	if (sdi->driver)
+		g_variant_builder_add(&builder, "{sv}", "driver",
+			g_variant_new_string(sdi->driver->name));
+	if (sdi->connection_id)
+		g_variant_builder_add(&builder, "{sv}", "connection_id",
+			g_variant_new_string(sdi->connection_id));
+	g_variant_builder_add(&builder, "{sv}", "elapsed_us",
+		g_variant_new_uint64(elapsed_us));
+	add_u64(&builder, "packets", &m->packets);
+	add_u64(&builder, "logic_bytes", &m->logic_bytes);
+	add_u64(&builder, "analog_samples", &m->analog_samples);
+	g_variant_builder_add(&builder, "{sv}", "logic_bytes_per_s",
+		g_variant_new_double(elapsed_us ?
+			logic_bytes * 1e6 / elapsed_us : 0.0));
+	g_variant_builder_add(&builder, "{sv}", "send_us",
+		sr_metric_hist_variant(&m->send_us));
+	add_u64(&builder, "transfers", &m->transfers);
+	add_u64(&builder, "transfer_bytes", &m->transfer_bytes);
+	add_u64(&builder, "empty_transfers", &m->empty_transfers);
+	add_u64(&builder, "failed_transfers", &m->failed_transfers);
+	add_u64(&builder, "resubmits", &m->resubmits);
+	add_u64(&builder, "starved", &m->starved);
+	g_variant_builder_add(&builder, "{sv}", "transfer_latency_us",
+		sr_metric_hist_variant(&m->transfer_latency_us));
+	add_u64(&builder, "output_queued_bytes", &m->output_queued_bytes);
+	g_variant_builder_add(&builder, "{sv}", "output_write_us",
+		sr_metric_hist_variant(&m->output_write_us));
+	g_variant_builder_add(&builder, "{sv}", "soft_trigger",
+		soft_trigger_variant(&m->soft_trigger));
+
+	return g_variant_builder_end(&builder);
+}
@@ -552,6 +552,312 @@ SR_PRIV int sr_modbus_write_multiple_registers(struct sr_modbus_dev_inst*modbus,
 	return SR_OK;
 }
 
+/* Maximum number of registers in a read holding registers request. */
+#define MODBUS_MAX_READ_REGISTERS 125
+
+struct modbus_batch_range {
+	int address;
+	int nb_registers;
+	gboolean is_static;
+};
+
+struct modbus_batch_block {
+	int address;
+	int nb_registers;
+	gboolean is_static;
+	gboolean valid;
+	uint16_t *registers;
+};
+
+struct sr_modbus_batch {
+	/* Ranges as specified by the caller. */
+	GArray *ranges;
+	/* Merged ranges, each of them gets read in a single request. */
+	GArray *blocks;
+	gboolean blocks_dirty;
+	int max_gap;
+};
+
+/**
+ * Create a set of holding register ranges which get read together.
+ *
+ * @return The new batch. Free it with sr_modbus_batch_free().
+ */
+SR_PRIV struct sr_modbus_batch *sr_modbus_batch_new(void)
+{
+	struct sr_modbus_batch *batch;
+
+	batch = g_malloc0(sizeof(*batch));
+	batch->ranges = g_array_new(FALSE, FALSE,
+		sizeof(struct modbus_batch_range));
+	batch->blocks = g_array_new(FALSE, FALSE,
+		sizeof(struct modbus_batch_block));
+
+	return batch;
+}
+
+static void modbus_batch_clear_blocks(struct sr_modbus_batch *batch)
+{
+	struct modbus_batch_block *block;
+	guint i;
+
+	for (i = 0; i < batch->blocks->len; i++) {
+		block = &g_array_index(batch->blocks, struct modbus_batch_block, i);
+		g_free(block->registers);
+	}
+	g_array_set_size(batch->blocks, 0);
+}
+
+/**
+ * Free a set of holding register ranges.
+ *
+ * @param batch The batch to free. Can be NULL.
+ */
+SR_PRIV void sr_modbus_batch_free(struct sr_modbus_batch *batch)
+{
+	if (!batch)
+		return;
+
+	modbus_batch_clear_blocks(batch);
+	g_array_free(batch->blocks, TRUE);
+	g_array_free(batch->ranges, TRUE);
+	g_free(batch);
+}
+
+/**
+ * Allow merging of ranges which are not adjacent.
+ *
+ * By default only adjacent or overlapping ranges get merged, since some
+ * devices reject requests which span unimplemented registers. Devices
+ * which accept such requests can save round trips by also reading the
+ * registers in small gaps between ranges.
+ *
+ * @param batch The batch to configure.
+ * @param nb_registers The maximum number of unused registers between
+ *                     two ranges which get merged.
+ */
+SR_PRIV void sr_modbus_batch_set_max_gap(struct sr_modbus_batch *batch,
+		int nb_registers)
+{
+	if (!batch || nb_registers < 0)
+		return;
+
+	batch->max_gap = nb_registers;
+	batch->blocks_dirty = TRUE;
+}
+
+/**
+ * Add a range of holding registers to a batch.
+ *
+ * @param batch The batch to add the range to.
+ * @param address The Modbus address of the range's first register.
+ * @param nb_registers The number of registers in the range.
+ * @param is_static Whether the registers' values never change (model,
+ *                  version, calibration data). Static registers are
+ *                  only read once, or after sr_modbus_batch_invalidate().
+ *
+ * @return SR_OK upon success, SR_ERR_ARG upon invalid arguments.
+ */
+SR_PRIV int sr_modbus_batch_add(struct sr_modbus_batch *batch,
+		int address, int nb_registers, gboolean is_static)
+{
+	struct modbus_batch_range range;
+
+	if (!batch || address < 0 || address > 0xFFFF
+	    || nb_registers < 1 || nb_registers > MODBUS_MAX_READ_REGISTERS
+	    || address + nb_registers > 0x10000)
+		return SR_ERR_ARG;
+
+	range.address = address;
+	range.nb_registers = nb_registers;
+	range.is_static = is_static;
+	g_array_append_val(batch->ranges, range);
+	batch->blocks_dirty = TRUE;
+
+	return SR_OK;
+}
+
+static gint modbus_batch_range_cmp(gconstpointer a, gconstpointer b)
+{
+	const struct modbus_batch_range *ra = a, *rb = b;
+
+	return ra->address - rb->address;
+}
+
+/*
+ * Merge the caller's ranges into as few requests as possible. Ranges
+ * which overlap always get merged (the result is static only if all of
+ * its parts are). Ranges which are merely close to each other only get
+ * merged when they are of the same kind, so that static registers can
+ * be skipped in subsequent reads.
+ */
+static void modbus_batch_plan(struct sr_modbus_batch *batch)
+{
+	GArray *sorted;
+	const struct modbus_batch_range *range;
+	struct modbus_batch_block block, *last;
+	int end, last_end, merged_end;
+	guint i;
+
+	modbus_batch_clear_blocks(batch);
+
+	sorted = g_array_sized_new(FALSE, FALSE,
+		sizeof(struct modbus_batch_range), batch->ranges->len);
+	g_array_append_vals(sorted, batch->ranges->data, batch->ranges->len);
+	g_array_sort(sorted, modbus_batch_range_cmp);
+
+	last = NULL;
+	for (i = 0; i < sorted->len; i++) {
+		range = &g_array_index(sorted, struct modbus_batch_range, i);
+		end = range->address + range->nb_registers;
+		if (last) {
+			last_end = last->address + last->nb_registers;
+			merged_end = MAX(last_end, end);
+			if (merged_end - last->address <= MODBUS_MAX_READ_REGISTERS) {
+				if (range->address < last_end) {
+					last->nb_registers = merged_end - last->address;
+					last->is_static &= range->is_static;
+					continue;
+				}
+				if (range->address - last_end <= batch->max_gap
+				    && range->is_static == last->is_static) {
+					last->nb_registers = merged_end - last->address;
+					continue;
+				}
+			}
+		}
+		block.address = range->address;
+		block.nb_registers = range->nb_registers;
+		block.is_static = range->is_static;
+		block.valid = FALSE;
+		block.registers = NULL;
+		g_array_append_val(batch->blocks, block);
+		last = &g_array_index(batch->blocks, struct modbus_batch_block,
+			batch->blocks->len - 1);
+	}
+	g_array_free(sorted, TRUE);
+
+	for (i = 0; i < batch->blocks->len; i++) {
+		last = &g_array_index(batch->blocks, struct modbus_batch_block, i);
+		last->registers = g_malloc0(last->nb_registers * sizeof(uint16_t));
+		sr_spew("Batch request %u: %d registers at 0x%04X%s.", i,
+			last->nb_registers, last->address,
+			last->is_static ? " (static)" : "");
+	}
+	batch->blocks_dirty = FALSE;
+}
+
+/**
+ * Read all holding registers of a batch.
+ *
+ * Each merged range is read with a single request. Ranges of static
+ * registers which were read before are skipped.
+ *
+ * @param modbus Previously initialized Modbus device structure.
+ * @param batch The batch to read.
+ *
+ * @return SR_OK upon success, SR_ERR_ARG upon invalid arguments,
+ *         SR_ERR_DATA upon invalid data, or SR_ERR on failure. Upon
+ *         failure, ranges which were read successfully remain available.
+ */
+SR_PRIV int sr_modbus_batch_read(struct sr_modbus_dev_inst *modbus,
+		struct sr_modbus_batch *batch)
+{
+	struct modbus_batch_block *block;
+	guint i;
+	int ret, first_ret;
+
+	if (!modbus || !batch)
+		return SR_ERR_ARG;
+
+	if (batch->blocks_dirty)
+		modbus_batch_plan(batch);
+
+	first_ret = SR_OK;
+	for (i = 0; i < batch->blocks->len; i++) {
+		block = &g_array_index(batch->blocks, struct modbus_batch_block, i);
+		if (block->is_static && block->valid)
+			continue;
+		block->valid = FALSE;
+		ret = sr_modbus_read_holding_registers(modbus,
+			block->address, block->nb_registers, block->registers);
+		if (ret != SR_OK) {
+			if (first_ret == SR_OK)
+				first_ret = ret;
+			continue;
+		}
+		block->valid = TRUE;
+	}
+
+	return first_ret;
+}
+
+/**
+ * Get register values from the most recent read of a batch.
+ *
+ * @param batch The batch which was read before.
+ * @param address The Modbus address of the first register to get.
+ * @param nb_registers The number of registers to get.
+ * @param registers Buffer to store the registers' values, in the format
+ *                  of sr_modbus_read_holding_registers().
+ *
+ * @return SR_OK upon success, SR_ERR_ARG when the registers are not
+ *         part of a range of the batch, SR_ERR_DATA when the registers
+ *         could not be read.
+ */
+SR_PRIV int sr_modbus_batch_get(const struct sr_modbus_batch *batch,
+		int address, int nb_registers, uint16_t *registers)
+{
+	const struct modbus_batch_block *block;
+	guint i;
+
+	if (!batch || !registers || nb_registers < 1 || batch->blocks_dirty)
+		return SR_ERR_ARG;
+
+	for (i = 0; i < batch->blocks->len; i++) {
+		block = &g_array_index(batch->blocks, struct modbus_batch_block, i);
+		if (address < block->address || address + nb_registers >
+		    block->address + block->nb_registers)
+			continue;
+		if (!block->valid)
+			return SR_ERR_DATA;
+		memcpy(registers, &block->registers[address - block->address],
+			nb_registers * sizeof(uint16_t));
+		return SR_OK;
+	}
+
+	return SR_ERR_ARG;
+}
+
+/**
+ * Have static registers get read again in the next batch read.
+ *
+ * Drivers call this after writing to registers which they consider
+ * static otherwise, e.g. protection thresholds.
+ *
+ * @param batch The batch to invalidate.
+ * @param address The Modbus address of the first changed register,
+ *                or -1 to invalidate all registers.
+ * @param nb_registers The number of changed registers.
+ */
+SR_PRIV void sr_modbus_batch_invalidate(struct sr_modbus_batch *batch,
+		int address, int nb_registers)
+{
+	struct modbus_batch_block *block;
+	guint i;
+
+	if (!batch)
+		return;
+
+	for (i = 0; i < batch->blocks->len; i++) {
+		block = &g_array_index(batch->blocks, struct modbus_batch_block, i);
+		if (address >= 0 && (address + nb_registers <= block->address
+		    || address >= block->address + block->nb_registers))
+			continue;
+		block->valid = FALSE;
+	}
+}
+
 /**
  * Close Modbus device.
  *
@@ -30,12 +30,234 @@
 
 #define BUFFER_SIZE 1024
 
-struct modbus_serial_rtu {
+/*
+ * Several devices (slaves) can share one RTU bus (typically RS-485).
+ * Device instances which refer to the same serial port share a bus,
+ * which owns the serial port and a single event source.
+ *
+ * The bus is half duplex, so only one request can be in flight at any
+ * time. Requests which get sent while another device waits for its
+ * reply are queued, and get transmitted in the order of submission as
+ * soon as the bus becomes available. This interleaves the polling of
+ * devices on the bus, and keeps the bus busy without the drivers
+ * having to know about each other.
+ *
+ * Devices on a shared bus are expected to get driven from one thread.
+ * Parallel scans are the exception: every device which opens the bus
+ * during a scan holds the bus' scan lock until it closes the bus, so
+ * that probes of different drivers do not interleave.
+ */
+struct modbus_rtu_bus {
+	char *port;
+	char *lock_name;
 	struct sr_serial_dev_inst *serial;
+	int refcount;
+	int open_count;
+	GMutex mutex;
+	/* Devices with a registered event source. */
+	GSList *clients;
+	GSList *next_client;
+	struct sr_session *session;
+	/* Device which waits for its reply. */
+	struct modbus_serial_rtu *owner;
+	/* Devices with a request which waits for the bus. */
+	GQueue pending;
+};
+
+struct modbus_serial_rtu {
+	struct modbus_rtu_bus *bus;
 	uint8_t slave_addr;
 	uint16_t crc;
+	gboolean scan_locked;
+	/* Event source registration. */
+	sr_receive_data_callback cb;
+	void *cb_data;
+	int timeout;
+	/* The callback runs, it must not get entered again. */
+	gboolean in_callback;
+	/* Request which waits for the bus (address, PDU, CRC). */
+	uint8_t *frame;
+	size_t frame_len;
 };
 
+static GMutex buses_mutex;
+static GSList *buses;
+
+static struct modbus_rtu_bus *bus_get(const char *resource,
+		const char *serialcomm)
+{
+	struct modbus_rtu_bus *bus;
+	GSList *l;
+
+	g_mutex_lock(&buses_mutex);
+	for (l = buses; l; l = l->next) {
+		bus = l->data;
+		if (strcmp(bus->port, resource) != 0)
+			continue;
+		if (serialcomm && g_strcmp0(serialcomm, bus->serial->serialcomm))
+			sr_warn("Bus %s already uses %s, ignoring %s.", resource,
+				bus->serial->serialcomm, serialcomm);
+		bus->refcount++;
+		g_mutex_unlock(&buses_mutex);
+		return bus;
+	}
+
+	bus = g_malloc0(sizeof(*bus));
+	bus->port = g_strdup(resource);
+	bus->lock_name = g_strdup_printf("modbus:%s", resource);
+	bus->serial = sr_serial_dev_inst_new(resource, serialcomm);
+	bus->refcount = 1;
+	g_mutex_init(&bus->mutex);
+	g_queue_init(&bus->pending);
+	buses = g_slist_prepend(buses, bus);
+	g_mutex_unlock(&buses_mutex);
+
+	return bus;
+}
+
+static void bus_put(struct modbus_rtu_bus *bus)
+{
+	g_mutex_lock(&buses_mutex);
+	if (--bus->refcount > 0) {
+		g_mutex_unlock(&buses_mutex);
+		return;
+	}
+	buses = g_slist_remove(buses, bus);
+	g_mutex_unlock(&buses_mutex);
+
+	sr_serial_dev_inst_free(bus->serial);
+	g_queue_clear(&bus->pending);
+	g_slist_free(bus->clients);
+	g_mutex_clear(&bus->mutex);
+	g_free(bus->lock_name);
+	g_free(bus->port);
+	g_free(bus);
+}
+
+static int bus_transmit(struct modbus_rtu_bus *bus,
+		struct modbus_serial_rtu *modbus,
+		const uint8_t *frame, size_t frame_len)
+{
+	int result;
+
+	bus->owner = modbus;
+	result = serial_write_blocking(bus->serial, frame, frame_len, 0);
+	if (result < 0) {
+		bus->owner = NULL;
+		return SR_ERR;
+	}
+
+	return SR_OK;
+}
+
+/* Transmit the next queued request when the bus is available. */
+static int bus_kick(struct modbus_rtu_bus *bus)
+{
+	struct modbus_serial_rtu *modbus;
+	uint8_t *frame;
+	size_t frame_len;
+
+	if (bus->owner)
+		return SR_OK;
+	modbus = g_queue_pop_head(&bus->pending);
+	if (!modbus)
+		return SR_OK;
+
+	frame = modbus->frame;
+	frame_len = modbus->frame_len;
+	modbus->frame = NULL;
+	modbus->frame_len = 0;
+	sr_spew("Sending queued request for slave %u.", modbus->slave_addr);
+	bus_transmit(bus, modbus, frame, frame_len);
+	g_free(frame);
+
+	return SR_OK;
+}
+
+/*
+ * The device consumed its reply, or gave up on it. Let the next queued
+ * request go out.
+ */
+static void bus_release(struct modbus_rtu_bus *bus,
+		struct modbus_serial_rtu *modbus, gboolean flush)
+{
+	g_mutex_lock(&bus->mutex);
+	if (bus->owner == modbus) {
+		bus->owner = NULL;
+		if (flush)
+			serial_flush(bus->serial);
+		bus_kick(bus);
+	}
+	g_mutex_unlock(&bus->mutex);
+}
+
+/* Forget about a device's queued or in flight request. */
+static void bus_cancel(struct modbus_rtu_bus *bus,
+		struct modbus_serial_rtu *modbus)
+{
+	g_mutex_lock(&bus->mutex);
+	if (g_queue_remove(&bus->pending, modbus)) {
+		g_free(modbus->frame);
+		modbus->frame = NULL;
+		modbus->frame_len = 0;
+	}
+	if (bus->owner == modbus) {
+		/* Drop a late reply, it would confuse the next request. */
+		bus->owner = NULL;
+		serial_flush(bus->serial);
+	}
+	bus_kick(bus);
+	g_mutex_unlock(&bus->mutex);
+}
+
+/*
+ * The bus' event source. Replies go to the device which waits for it.
+ * Otherwise devices get their turn one after another, for periodic
+ * polling.
+ */
+static int bus_receive_data(int fd, int revents, void *cb_data)
+{
+	struct modbus_rtu_bus *bus;
+	struct modbus_serial_rtu *modbus;
+	sr_receive_data_callback cb;
+	int ret;
+
+	bus = cb_data;
+
+	g_mutex_lock(&bus->mutex);
+	bus_kick(bus);
+	modbus = bus->owner;
+	if (!modbus && bus->clients) {
+		if (!bus->next_client)
+			bus->next_client = bus->clients;
+		modbus = bus->next_client->data;
+		bus->next_client = bus->next_client->next;
+	}
+	cb = (modbus && !modbus->in_callback) ? modbus->cb : NULL;
+	if (!cb) {
+		g_mutex_unlock(&bus->mutex);
+		return TRUE;
+	}
+	modbus->in_callback = TRUE;
+	g_mutex_unlock(&bus->mutex);
+
+	ret = cb(fd, revents, modbus->cb_data);
+
+	g_mutex_lock(&bus->mutex);
+	modbus->in_callback = FALSE;
+	g_mutex_unlock(&bus->mutex);
+
+	return ret;
+}
+
+static void scan_unlock(struct modbus_serial_rtu *modbus)
+{
+	if (!modbus->scan_locked)
+		return;
+	sr_scan_unlock(modbus->bus->lock_name);
+	modbus->scan_locked = FALSE;
+}
+
 static int modbus_serial_rtu_dev_inst_new(void *priv, const char *resource,
 		char **params, const char *serialcomm, int modbusaddr)
 {
@@ -43,7 +265,7 @@ static int modbus_serial_rtu_dev_inst_new(void *priv, const char *resource,
 
 	(void)params;
 
-	modbus->serial = sr_serial_dev_inst_new(resource, serialcomm);
+	modbus->bus = bus_get(resource, serialcomm);
 	modbus->slave_addr = modbusaddr;
 
 	return SR_OK;
@@ -52,72 +274,218 @@ static int modbus_serial_rtu_dev_inst_new(void *priv, const char *resource,
 static int modbus_serial_rtu_open(void *priv)
 {
 	struct modbus_serial_rtu *modbus = priv;
-	struct sr_serial_dev_inst *serial = modbus->serial;
+	struct modbus_rtu_bus *bus = modbus->bus;
+	int ret;
 
-	if (serial_open(serial, SERIAL_RDWR) != SR_OK)
-		return SR_ERR;
+	/*
+	 * Only the first device which opens the bus opens the serial port
+	 * (and takes the port's scan lock), take the bus' lock on every
+	 * open. Wait for it outside of the bus' mutex.
+	 */
+	if (!modbus->scan_locked && sr_driver_scan_is_parallel()) {
+		ret = sr_scan_lock(bus->lock_name);
+		if (ret != SR_OK)
+			return ret;
+		modbus->scan_locked = TRUE;
+	}
 
-	return SR_OK;
+	ret = SR_OK;
+	g_mutex_lock(&bus->mutex);
+	if (bus->open_count == 0 && serial_open(bus->serial, SERIAL_RDWR) != SR_OK)
+		ret = SR_ERR;
+	if (ret == SR_OK)
+		bus->open_count++;
+	g_mutex_unlock(&bus->mutex);
+
+	if (ret != SR_OK)
+		scan_unlock(modbus);
+
+	return ret;
 }
 
 static int modbus_serial_rtu_source_add(struct sr_session *session, void *priv,
 		int events, int timeout, sr_receive_data_callback cb, void *cb_data)
 {
 	struct modbus_serial_rtu *modbus = priv;
-	struct sr_serial_dev_inst *serial = modbus->serial;
+	struct modbus_rtu_bus *bus = modbus->bus;
+	struct modbus_serial_rtu *client;
+	GSList *l;
+	int ret, bus_timeout;
+
+	g_mutex_lock(&bus->mutex);
+	if (bus->clients && session != bus->session) {
+		g_mutex_unlock(&bus->mutex);
+		sr_err("Devices on bus %s must be in the same session.",
+			bus->port);
+		return SR_ERR_ARG;
+	}
+	modbus->cb = cb;
+	modbus->cb_data = cb_data;
+	modbus->timeout = timeout;
+	if (!g_slist_find(bus->clients, modbus))
+		bus->clients = g_slist_append(bus->clients, modbus);
+
+	/* The bus gets polled as often as its most demanding device asks. */
+	bus_timeout = 0;
+	for (l = bus->clients; l; l = l->next) {
+		client = l->data;
+		if (client->timeout <= 0)
+			continue;
+		if (!bus_timeout || client->timeout < bus_timeout)
+			bus_timeout = client->timeout;
+	}
+	if (bus->session)
+		serial_source_remove(bus->session, bus->serial);
+	bus->session = session;
+	ret = serial_source_add(session, bus->serial, events, bus_timeout,
+		bus_receive_data, bus);
+	g_mutex_unlock(&bus->mutex);
 
-	return serial_source_add(session, serial, events, timeout, cb, cb_data);
+	return ret;
 }
 
 static int modbus_serial_rtu_source_remove(struct sr_session *session,
 		void *priv)
 {
 	struct modbus_serial_rtu *modbus = priv;
-	struct sr_serial_dev_inst *serial = modbus->serial;
+	struct modbus_rtu_bus *bus = modbus->bus;
+	int ret;
+
+	bus_cancel(bus, modbus);
+
+	g_mutex_lock(&bus->mutex);
+	ret = SR_OK;
+	bus->clients = g_slist_remove(bus->clients, modbus);
+	bus->next_client = NULL;
+	modbus->cb = NULL;
+	modbus->cb_data = NULL;
+	if (!bus->clients && bus->session) {
+		ret = serial_source_remove(session, bus->serial);
+		bus->session = NULL;
+	}
+	g_mutex_unlock(&bus->mutex);
 
-	return serial_source_remove(session, serial);
+	return ret;
 }
 
 static int modbus_serial_rtu_send(void *priv,
 		const uint8_t *buffer, int buffer_size)
 {
-	int result;
 	struct modbus_serial_rtu *modbus = priv;
-	struct sr_serial_dev_inst *serial = modbus->serial;
-	uint8_t slave_addr = modbus->slave_addr;
+	struct modbus_rtu_bus *bus = modbus->bus;
+	uint8_t *frame;
+	size_t frame_len;
 	uint16_t crc;
+	int ret;
 
-	result = serial_write_blocking(serial, &slave_addr, sizeof(slave_addr), 0);
-	if (result < 0)
-		return SR_ERR;
+	/* Assemble the complete frame, the bus may need to queue it. */
+	frame_len = 1 + buffer_size + sizeof(crc);
+	frame = g_malloc(frame_len);
+	frame[0] = modbus->slave_addr;
+	memcpy(&frame[1], buffer, buffer_size);
+	crc = sr_crc16(SR_CRC16_DEFAULT_INIT, frame, 1 + buffer_size);
+	memcpy(&frame[1 + buffer_size], &crc, sizeof(crc));
+
+	g_mutex_lock(&bus->mutex);
+	if (bus->owner == modbus) {
+		/* Previous reply was not read, drop it. */
+		serial_flush(bus->serial);
+		bus->owner = NULL;
+	}
+	if (modbus->frame || bus->owner || !g_queue_is_empty(&bus->pending)) {
+		/* Wait for the bus. Only the latest request is kept. */
+		if (!modbus->frame)
+			g_queue_push_tail(&bus->pending, modbus);
+		g_free(modbus->frame);
+		modbus->frame = frame;
+		modbus->frame_len = frame_len;
+		ret = bus_kick(bus);
+		g_mutex_unlock(&bus->mutex);
+		return ret;
+	}
+	ret = bus_transmit(bus, modbus, frame, frame_len);
+	g_mutex_unlock(&bus->mutex);
+	g_free(frame);
 
-	result = serial_write_blocking(serial, buffer, buffer_size, 0);
-	if (result < 0)
-		return SR_ERR;
+	return ret;
+}
 
-	crc = sr_crc16(SR_CRC16_DEFAULT_INIT, &slave_addr, sizeof(slave_addr));
-	crc = sr_crc16(crc, buffer, buffer_size);
+/*
+ * Have the reply to this device's request arrive next. When another
+ * device waits for its reply, that device's callback gets to receive
+ * it first, then queued requests get sent in order. A callback which
+ * already runs (further up the stack) does not get entered again, the
+ * wait fails instead.
+ */
+static int bus_wait_turn(struct modbus_rtu_bus *bus,
+		struct modbus_serial_rtu *modbus)
+{
+	struct modbus_serial_rtu *owner;
+	sr_receive_data_callback cb;
+	guint rounds;
+	int ret;
 
-	result = serial_write_blocking(serial, &crc, sizeof(crc), 0);
-	if (result < 0)
-		return SR_ERR;
+	g_mutex_lock(&bus->mutex);
+	rounds = g_slist_length(bus->clients);
+	rounds += g_queue_get_length(&bus->pending) + 1;
+	while (bus->owner != modbus && rounds--) {
+		bus_kick(bus);
+		owner = bus->owner;
+		if (owner == modbus)
+			break;
+		cb = (owner && !owner->in_callback) ? owner->cb : NULL;
+		if (!cb) {
+			/*
+			 * Nothing in flight, nobody cares about the reply, or
+			 * the reply's device is busy.
+			 */
+			g_mutex_unlock(&bus->mutex);
+			return SR_ERR;
+		}
+		owner->in_callback = TRUE;
+		g_mutex_unlock(&bus->mutex);
+		cb(-1, G_IO_IN, owner->cb_data);
+		g_mutex_lock(&bus->mutex);
+		owner->in_callback = FALSE;
+		if (bus->owner == owner) {
+			/* The device did not pick up its reply. */
+			bus->owner = NULL;
+			serial_flush(bus->serial);
+		}
+	}
+	ret = (bus->owner == modbus) ? SR_OK : SR_ERR;
+	g_mutex_unlock(&bus->mutex);
 
-	return SR_OK;
+	return ret;
 }
 
 static int modbus_serial_rtu_read_begin(void *priv, uint8_t *function_code)
 {
 	struct modbus_serial_rtu *modbus = priv;
+	struct modbus_rtu_bus *bus = modbus->bus;
 	uint8_t slave_addr;
 	int ret;
 
-	ret = serial_read_blocking(modbus->serial, &slave_addr, 1, 500);
-	if (ret != 1 || slave_addr != modbus->slave_addr)
+	/*
+	 * The device keeps the bus until its reply is read completely,
+	 * read_end() releases it.
+	 */
+	if (bus_wait_turn(bus, modbus) != SR_OK) {
+		sr_err("No request in flight for slave %u.", modbus->slave_addr);
+		return SR_ERR;
+	}
+
+	ret = serial_read_blocking(bus->serial, &slave_addr, 1, 500);
+	if (ret != 1 || slave_addr != modbus->slave_addr) {
+		bus_release(bus, modbus, TRUE);
 		return SR_ERR;
+	}
 
-	ret = serial_read_blocking(modbus->serial, function_code, 1, 100);
-	if (ret != 1)
+	ret = serial_read_blocking(bus->serial, function_code, 1, 100);
+	if (ret != 1) {
+		bus_release(bus, modbus, TRUE);
 		return SR_ERR;
+	}
 
 	modbus->crc = sr_crc16(SR_CRC16_DEFAULT_INIT, &slave_addr, sizeof(slave_addr));
 	modbus->crc = sr_crc16(modbus->crc, function_code, 1);
@@ -130,7 +498,7 @@ static int modbus_serial_rtu_read_data(void *priv, uint8_t *buf, int maxlen)
 	struct modbus_serial_rtu *modbus = priv;
 	int ret;
 
-	ret = serial_read_nonblocking(modbus->serial, buf, maxlen);
+	ret = serial_read_nonblocking(modbus->bus->serial, buf, maxlen);
 	if (ret < 0)
 		return ret;
 	modbus->crc = sr_crc16(modbus->crc, buf, ret);
@@ -140,17 +508,22 @@ static int modbus_serial_rtu_read_data(void *priv, uint8_t *buf, int maxlen)
 static int modbus_serial_rtu_read_end(void *priv)
 {
 	struct modbus_serial_rtu *modbus = priv;
+	struct modbus_rtu_bus *bus = modbus->bus;
 	uint16_t crc;
 	int ret;
 
-	ret = serial_read_blocking(modbus->serial, &crc, sizeof(crc), 100);
-	if (ret != 2)
+	ret = serial_read_blocking(bus->serial, &crc, sizeof(crc), 100);
+	if (ret != 2) {
+		bus_release(bus, modbus, TRUE);
 		return SR_ERR;
+	}
 
 	if (crc != modbus->crc) {
 		sr_err("CRC error (0x%04X vs 0x%04X).", crc, modbus->crc);
+		bus_release(bus, modbus, TRUE);
 		return SR_ERR_DATA;
 	}
+	bus_release(bus, modbus, FALSE);
 
 	return SR_OK;
 }
@@ -158,15 +531,31 @@ static int modbus_serial_rtu_read_end(void *priv)
 static int modbus_serial_rtu_close(void *priv)
 {
 	struct modbus_serial_rtu *modbus = priv;
+	struct modbus_rtu_bus *bus = modbus->bus;
+	int ret;
 
-	return serial_close(modbus->serial);
+	bus_cancel(bus, modbus);
+
+	ret = SR_OK;
+	g_mutex_lock(&bus->mutex);
+	if (bus->open_count > 0 && --bus->open_count == 0)
+		ret = serial_close(bus->serial);
+	g_mutex_unlock(&bus->mutex);
+	scan_unlock(modbus);
+
+	return ret;
 }
 
 static void modbus_serial_rtu_free(void *priv)
 {
 	struct modbus_serial_rtu *modbus = priv;
 
-	sr_serial_dev_inst_free(modbus->serial);
+	if (!modbus->bus)
+		return;
+	bus_cancel(modbus->bus, modbus);
+	scan_unlock(modbus);
+	bus_put(modbus->bus);
+	modbus->bus = NULL;
 }
 
 SR_PRIV const struct sr_modbus_dev_inst modbus_serial_rtu_dev = {
@@ -0,0 +1,860 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 libsigrok contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Apache Arrow IPC stream output, which pyarrow, pandas, polars and
+ * most other analysis tools read directly, e.g. with
+ * pyarrow.ipc.open_stream().
+ *
+ * Each enabled channel is a column. Logic channels are bool columns
+ * (bit-packed), analog channels are float32 columns. The samplerate
+ * is kept in the schema's custom metadata when it's known. Rows which
+ * some channel never sent data for are null.
+ *
+ * Options:
+ *
+ * batch:       Number of rows per record batch. Defaults to 262144.
+ *              Columns buffer up to 16 batches, when drivers send the
+ *              channels in separate packets.
+ *
+ * compression: Compress the record batch buffers. "none" (default) or
+ *              "zstd", when libsigrok was built with libzstd.
+ */
+
+#include <config.h>
+#include <string.h>
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+
+#define LOG_PREFIX "output/arrow"
+
+#define DEFAULT_BATCH_ROWS	(256 * 1024)
+/*
+ * Columns buffer rows until all columns have a batch. A column which
+ * gets this many batches ahead of another forces a batch out, with
+ * nulls for the missing rows.
+ */
+#define MAX_BATCHES		16
+
+/* Arrow IPC format constants, from Message.fbs and Schema.fbs. */
+#define METADATA_V5		4
+#define HEADER_SCHEMA		1
+#define HEADER_RECORD_BATCH	3
+#define TYPE_FLOATING_POINT	3
+#define TYPE_BOOL		6
+#define PRECISION_SINGLE	1
+#define COMPRESSION_ZSTD	1
+#define CONTINUATION		0xffffffff
+
+struct column {
+	struct sr_channel *ch;
+	/* Float values, or bits for logic channels. */
+	uint8_t *data;
+	/* Rows filled in. Negative when the rows were sent as nulls. */
+	int64_t used;
+	size_t size;
+};
+
+struct context {
+	int num_columns;
+	struct column *columns;
+	uint64_t batch_rows;
+	gboolean compress;
+	gboolean schema_done;
+	uint64_t samplerate;
+	float *fdata;
+	size_t fdata_size;
+	/* Kept across record batches, they only grow up to a batch. */
+	GString *fb;
+	GString *body;
+	uint8_t *validity;
+	uint8_t *zbuf;
+	size_t zbuf_size;
+	int64_t *nodes;
+	int64_t *buffers;
+};
+
+/*
+ * A minimal flatbuffers writer, for the IPC metadata. Buffers get
+ * written front to back: Tables come with their vtable in front, and
+ * offsets to strings, vectors and tables which are written later get
+ * patched in.
+ */
+
+enum fb_type {
+	FB_ABSENT,
+	FB_U8,
+	FB_I16,
+	FB_I64,
+	FB_OFFSET,
+};
+
+struct fb_field {
+	enum fb_type type;
+	int64_t value;
+};
+
+static const unsigned int fb_sizes[] = {
+	[FB_ABSENT] = 0,
+	[FB_U8] = 1,
+	[FB_I16] = 2,
+	[FB_I64] = 8,
+	[FB_OFFSET] = 4,
+};
+
+static void fb_zeros(GString *fb, size_t len)
+{
+	static const char zeros[16];
+
+	while (len > sizeof(zeros)) {
+		g_string_append_len(fb, zeros, sizeof(zeros));
+		len -= sizeof(zeros);
+	}
+	g_string_append_len(fb, zeros, len);
+}
+
+static void fb_align(GString *fb, size_t align)
+{
+	fb_zeros(fb, (align - fb->len % align) % align);
+}
+
+static void fb_patch(GString *fb, size_t slot, size_t pos)
+{
+	WL32(fb->str + slot, pos - slot);
+}
+
+/*
+ * Writes a table and returns its position. The positions of offset
+ * fields go to slots[], to be patched when their targets get written.
+ */
+static size_t fb_table(GString *fb, const struct fb_field *fields,
+		unsigned int num, size_t *slots)
+{
+	uint16_t offsets[8];
+	unsigned int i, size, table_size;
+	size_t vtable, table;
+	uint8_t *p;
+
+	/* Largest fields first, after the vtable offset. */
+	table_size = 4;
+	memset(offsets, 0, sizeof(offsets));
+	for (size = 8; size > 0; size /= 2) {
+		for (i = 0; i < num; i++) {
+			if (fb_sizes[fields[i].type] != size)
+				continue;
+			table_size = (table_size + size - 1) / size * size;
+			offsets[i] = table_size;
+			table_size += size;
+		}
+	}
+
+	fb_align(fb, 2);
+	vtable = fb->len;
+	fb_zeros(fb, 4 + 2 * num);
+	WL16(fb->str + vtable, 4 + 2 * num);
+	WL16(fb->str + vtable + 2, table_size);
+	for (i = 0; i < num; i++)
+		WL16(fb->str + vtable + 4 + 2 * i, offsets[i]);
+
+	fb_align(fb, 8);
+	table = fb->len;
+	fb_zeros(fb, table_size);
+	WL32(fb->str + table, table - vtable);
+	for (i = 0; i < num; i++) {
+		p = (uint8_t *)fb->str + table + offsets[i];
+		switch (fields[i].type) {
+		case FB_U8:
+			*p = fields[i].value;
+			break;
+		case FB_I16:
+			WL16(p, fields[i].value);
+			break;
+		case FB_I64:
+			WL64(p, fields[i].value);
+			break;
+		case FB_OFFSET:
+			slots[i] = table + offsets[i];
+			break;
+		default:
+			break;
+		}
+	}
+
+	return table;
+}
+
+/* Writes a vector's length, and returns the position of its elements. */
+static size_t fb_vector(GString *fb, size_t slot, size_t count,
+		size_t elem_size, size_t align)
+{
+	size_t pos;
+
+	while ((fb->len + 4) % align)
+		g_string_append_c(fb, 0);
+	fb_patch(fb, slot, fb->len);
+	pos = fb->len + 4;
+	fb_zeros(fb, 4 + count * elem_size);
+	WL32(fb->str + pos - 4, count);
+
+	return pos;
+}
+
+static void fb_string(GString *fb, size_t slot, const char *s)
+{
+	char tmp[4];
+
+	fb_align(fb, 4);
+	fb_patch(fb, slot, fb->len);
+	WL32(tmp, strlen(s));
+	g_string_append_len(fb, tmp, 4);
+	g_string_append_len(fb, s, strlen(s) + 1);
+}
+
+/* The Message table, which wraps the schema and record batches. */
+static size_t fb_message(GString *fb, int header_type, uint64_t body_len)
+{
+	struct fb_field fields[] = {
+		{ FB_I16, METADATA_V5 },
+		{ FB_U8, header_type },
+		{ FB_OFFSET, 0 },
+		{ FB_I64, body_len },
+	};
+	size_t slots[G_N_ELEMENTS(fields)], table;
+
+	g_string_truncate(fb, 0);
+	/* The root table's offset. */
+	fb_zeros(fb, 4);
+	table = fb_table(fb, fields, G_N_ELEMENTS(fields), slots);
+	fb_patch(fb, 0, table);
+
+	/* The header's slot. */
+	return slots[2];
+}
+
+/* An encapsulated message: Marker, metadata size, metadata, body. */
+static void append_message(GString *out, GString *fb, const GString *body)
+{
+	char tmp[8];
+
+	fb_align(fb, 8);
+	WL32(tmp, CONTINUATION);
+	WL32(tmp + 4, fb->len);
+	g_string_append_len(out, tmp, 8);
+	g_string_append_len(out, fb->str, fb->len);
+	if (body)
+		g_string_append_len(out, body->str, body->len);
+}
+
+/* The schema message, with a field for each column. */
+static void gen_schema(const struct sr_output *o, GString *out)
+{
+	struct context *ctx;
+	struct sr_channel *ch;
+	struct fb_field schema[3], field[6], type[1], kv[2];
+	size_t slots[3], field_slots[6], type_slots[1], header, vec, table;
+	char *samplerate;
+	int i;
+
+	ctx = o->priv;
+	header = fb_message(ctx->fb, HEADER_SCHEMA, 0);
+	/* Endianness (little), fields, custom metadata. */
+	schema[0] = (struct fb_field){ FB_ABSENT, 0 };
+	schema[1] = (struct fb_field){ FB_OFFSET, 0 };
+	schema[2] = (struct fb_field){ ctx->samplerate ? FB_OFFSET : FB_ABSENT, 0 };
+	table = fb_table(ctx->fb, schema, G_N_ELEMENTS(schema), slots);
+	fb_patch(ctx->fb, header, table);
+
+	vec = fb_vector(ctx->fb, slots[1], ctx->num_columns, 4, 4);
+	for (i = 0; i < ctx->num_columns; i++) {
+		ch = ctx->columns[i].ch;
+		/* Name, nullable, type, dictionary, children. */
+		field[0] = (struct fb_field){ FB_OFFSET, 0 };
+		field[1] = (struct fb_field){ FB_U8, TRUE };
+		field[2] = (struct fb_field){ FB_U8, ch->type == SR_CHANNEL_LOGIC ?
+			TYPE_BOOL : TYPE_FLOATING_POINT };
+		field[3] = (struct fb_field){ FB_OFFSET, 0 };
+		field[4] = (struct fb_field){ FB_ABSENT, 0 };
+		field[5] = (struct fb_field){ FB_OFFSET, 0 };
+		table = fb_table(ctx->fb, field, G_N_ELEMENTS(field), field_slots);
+		fb_patch(ctx->fb, vec + 4 * i, table);
+		fb_string(ctx->fb, field_slots[0], ch->name);
+		type[0] = (struct fb_field){ FB_I16, PRECISION_SINGLE };
+		table = fb_table(ctx->fb, type,
+			ch->type == SR_CHANNEL_LOGIC ? 0 : 1, type_slots);
+		fb_patch(ctx->fb, field_slots[3], table);
+		/* No children, but readers want the vector. */
+		fb_vector(ctx->fb, field_slots[5], 0, 4, 4);
+	}
+
+	if (ctx->samplerate) {
+		vec = fb_vector(ctx->fb, slots[2], 1, 4, 4);
+		kv[0] = (struct fb_field){ FB_OFFSET, 0 };
+		kv[1] = (struct fb_field){ FB_OFFSET, 0 };
+		table = fb_table(ctx->fb, kv, G_N_ELEMENTS(kv), field_slots);
+		fb_patch(ctx->fb, vec, table);
+		samplerate = g_strdup_printf("%" PRIu64, ctx->samplerate);
+		fb_string(ctx->fb, field_slots[0], "samplerate");
+		fb_string(ctx->fb, field_slots[1], samplerate);
+		g_free(samplerate);
+	}
+
+	append_message(out, ctx->fb, NULL);
+}
+
+/* Adds a buffer to the record batch body, compressed if enabled. */
+static int body_add(struct context *ctx, const void *data, size_t len,
+		int64_t *buffer)
+{
+#ifdef HAVE_LIBZSTD
+	size_t bound, zlen;
+	uint8_t *zbuf;
+	char tmp[8];
+#endif
+
+	fb_align(ctx->body, 8);
+	buffer[0] = ctx->body->len;
+	if (!len) {
+		buffer[1] = 0;
+		return SR_OK;
+	}
+
+#ifdef HAVE_LIBZSTD
+	if (ctx->compress) {
+		bound = ZSTD_compressBound(len);
+		if (bound > ctx->zbuf_size) {
+			if (!(zbuf = g_try_realloc(ctx->zbuf, bound)))
+				return SR_ERR_MALLOC;
+			ctx->zbuf = zbuf;
+			ctx->zbuf_size = bound;
+		}
+		zlen = ZSTD_compress(ctx->zbuf, bound, data, len, 1);
+		if (ZSTD_isError(zlen)) {
+			sr_err("Cannot compress: %s.", ZSTD_getErrorName(zlen));
+			return SR_ERR;
+		}
+		/* Buffers come with their size, or -1 when stored as is. */
+		if (zlen < len) {
+			WL64(tmp, len);
+			g_string_append_len(ctx->body, tmp, 8);
+			g_string_append_len(ctx->body, (const char *)ctx->zbuf, zlen);
+		} else {
+			WL64(tmp, -1);
+			g_string_append_len(ctx->body, tmp, 8);
+			g_string_append_len(ctx->body, data, len);
+		}
+		buffer[1] = ctx->body->len - buffer[0];
+		return SR_OK;
+	}
+#endif
+
+	g_string_append_len(ctx->body, data, len);
+	buffer[1] = len;
+
+	return SR_OK;
+}
+
+/*
+ * Sends the first rows of all columns as a record batch. Columns which
+ * haven't got that many rows yet get nulls for the missing ones.
+ */
+static int gen_record_batch(const struct sr_output *o, uint64_t rows,
+		GString *out)
+{
+	struct context *ctx;
+	struct column *col;
+	struct fb_field batch[4], compression[1];
+	size_t slots[4], comp_slots[1], header, vec, table, bytes, valid;
+	size_t keep;
+	int i, j, ret;
+
+	ctx = o->priv;
+	g_string_truncate(ctx->body, 0);
+	for (i = 0; i < ctx->num_columns; i++) {
+		col = &ctx->columns[i];
+		valid = MIN((uint64_t)MAX(col->used, 0), rows);
+		ctx->nodes[2 * i] = rows;
+		ctx->nodes[2 * i + 1] = rows - valid;
+		if (valid < rows) {
+			memset(ctx->validity, 0, (rows + 7) / 8);
+			memset(ctx->validity, 0xff, valid / 8);
+			if (valid % 8)
+				ctx->validity[valid / 8] = (1 << (valid % 8)) - 1;
+			ret = body_add(ctx, ctx->validity, (rows + 7) / 8,
+				&ctx->buffers[4 * i]);
+		} else {
+			ret = body_add(ctx, NULL, 0, &ctx->buffers[4 * i]);
+		}
+		if (ret != SR_OK)
+			return ret;
+		if (col->ch->type == SR_CHANNEL_LOGIC)
+			bytes = (rows + 7) / 8;
+		else
+			bytes = rows * sizeof(float);
+		ret = body_add(ctx, col->data, bytes, &ctx->buffers[4 * i + 2]);
+		if (ret != SR_OK)
+			return ret;
+	}
+	fb_align(ctx->body, 8);
+
+	header = fb_message(ctx->fb, HEADER_RECORD_BATCH, ctx->body->len);
+	/* Length, nodes, buffers, compression. */
+	batch[0] = (struct fb_field){ FB_I64, rows };
+	batch[1] = (struct fb_field){ FB_OFFSET, 0 };
+	batch[2] = (struct fb_field){ FB_OFFSET, 0 };
+	batch[3] = (struct fb_field){ ctx->compress ? FB_OFFSET : FB_ABSENT, 0 };
+	table = fb_table(ctx->fb, batch, G_N_ELEMENTS(batch), slots);
+	fb_patch(ctx->fb, header, table);
+	vec = fb_vector(ctx->fb, slots[1], ctx->num_columns, 16, 8);
+	for (j = 0; j < 2 * ctx->num_columns; j++)
+		WL64(ctx->fb->str + vec + 8 * j, ctx->nodes[j]);
+	vec = fb_vector(ctx->fb, slots[2], 2 * ctx->num_columns, 16, 8);
+	for (j = 0; j < 4 * ctx->num_columns; j++)
+		WL64(ctx->fb->str + vec + 8 * j, ctx->buffers[j]);
+	if (ctx->compress) {
+		compression[0] = (struct fb_field){ FB_U8, COMPRESSION_ZSTD };
+		table = fb_table(ctx->fb, compression, 1, comp_slots);
+		fb_patch(ctx->fb, slots[3], table);
+	}
+	append_message(out, ctx->fb, ctx->body);
+
+	/* Move the remaining rows to the front. */
+	for (i = 0; i < ctx->num_columns; i++) {
+		col = &ctx->columns[i];
+		if (col->used > (int64_t)rows) {
+			keep = col->used - rows;
+			if (col->ch->type == SR_CHANNEL_LOGIC)
+				memmove(col->data, col->data + rows / 8,
+					(keep + 7) / 8);
+			else
+				memmove(col->data, col->data + rows * sizeof(float),
+					keep * sizeof(float));
+		}
+		col->used -= rows;
+	}
+
+	return SR_OK;
+}
+
+/*
+ * Sends record batches while all columns have a batch of rows, or one
+ * of them has filled its buffer up to the limit. With final set, sends
+ * all rows.
+ */
+static int flush_batches(const struct sr_output *o, gboolean final,
+		GString **out)
+{
+	struct context *ctx;
+	int64_t min_used, max_used;
+	int i, ret;
+
+	ctx = o->priv;
+	while (ctx->num_columns) {
+		min_used = max_used = ctx->columns[0].used;
+		for (i = 1; i < ctx->num_columns; i++) {
+			min_used = MIN(min_used, ctx->columns[i].used);
+			max_used = MAX(max_used, ctx->columns[i].used);
+		}
+		if (final && max_used <= 0)
+			break;
+		if (!final && min_used < (int64_t)ctx->batch_rows &&
+				max_used < MAX_BATCHES * (int64_t)ctx->batch_rows)
+			break;
+		if (!*out)
+			*out = g_string_sized_new(ctx->batch_rows);
+		ret = gen_record_batch(o, final ?
+			MIN((uint64_t)max_used, ctx->batch_rows) : ctx->batch_rows,
+			*out);
+		if (ret != SR_OK)
+			return ret;
+	}
+
+	return SR_OK;
+}
+
+static struct column *find_column(struct context *ctx, struct sr_channel *ch)
+{
+	int i;
+
+	for (i = 0; i < ctx->num_columns; i++) {
+		if (ctx->columns[i].ch == ch)
+			return &ctx->columns[i];
+	}
+
+	return NULL;
+}
+
+/* Samples which were sent as nulls already, and get dropped. */
+static size_t column_skip(const struct column *col, size_t count)
+{
+	return col->used < 0 ? MIN((uint64_t)-col->used, count) : 0;
+}
+
+/*
+ * Grows the column for the next samples, up to the limit, and returns
+ * how many of them fit.
+ */
+static int column_reserve(struct context *ctx, struct column *col,
+		size_t count, size_t *room)
+{
+	size_t used, size, max_rows;
+	uint8_t *data;
+
+	used = MAX(col->used, 0);
+	max_rows = MAX_BATCHES * ctx->batch_rows;
+	if (used + count > col->size && col->size < max_rows) {
+		size = MIN(MAX(2 * col->size, used + count), max_rows);
+		size = (size + 7) / 8 * 8;
+		if (col->ch->type == SR_CHANNEL_LOGIC)
+			data = g_try_realloc(col->data, size / 8);
+		else
+			data = g_try_realloc(col->data, size * sizeof(float));
+		if (!data) {
+			sr_err("Unable to allocate enough column memory.");
+			return SR_ERR_MALLOC;
+		}
+		col->data = data;
+		col->size = size;
+	}
+	*room = col->size - used;
+
+	return SR_OK;
+}
+
+static void store_logic(struct column *col, const uint8_t *data,
+		unsigned int unitsize, size_t count)
+{
+	unsigned int offset;
+	uint8_t mask, *bits;
+	uint64_t row;
+	size_t i;
+
+	offset = col->ch->index / 8;
+	mask = 1 << (col->ch->index % 8);
+	bits = col->data;
+	row = col->used;
+	data += offset;
+	for (i = 0; i < count; i++, row++, data += unitsize) {
+		if (*data & mask)
+			bits[row / 8] |= 1 << (row % 8);
+		else
+			bits[row / 8] &= ~(1 << (row % 8));
+	}
+	col->used += count;
+}
+
+static int add_logic(const struct sr_output *o,
+		const struct sr_datafeed_logic *logic, GString **out)
+{
+	struct context *ctx;
+	struct column *col;
+	const uint8_t *data;
+	size_t count, todo, skip, room;
+	int i, ret;
+
+	ctx = o->priv;
+	if (!logic->unitsize)
+		return SR_OK;
+	data = logic->data;
+	count = logic->length / logic->unitsize;
+	while (count) {
+		/* All logic columns take the same rows. */
+		todo = count;
+		for (i = 0; i < ctx->num_columns; i++) {
+			col = &ctx->columns[i];
+			if (col->ch->type != SR_CHANNEL_LOGIC)
+				continue;
+			if (col->ch->index / 8 >= logic->unitsize)
+				continue;
+			skip = column_skip(col, count);
+			ret = column_reserve(ctx, col, count - skip, &room);
+			if (ret != SR_OK)
+				return ret;
+			todo = MIN(todo, skip + room);
+		}
+		for (i = 0; i < ctx->num_columns; i++) {
+			col = &ctx->columns[i];
+			if (col->ch->type != SR_CHANNEL_LOGIC)
+				continue;
+			if (col->ch->index / 8 >= logic->unitsize)
+				continue;
+			skip = column_skip(col, todo);
+			col->used += skip;
+			store_logic(col, data + skip * logic->unitsize,
+				logic->unitsize, todo - skip);
+		}
+		data += todo * logic->unitsize;
+		count -= todo;
+		if ((ret = flush_batches(o, FALSE, out)) != SR_OK)
+			return ret;
+	}
+
+	return SR_OK;
+}
+
+static int add_analog(const struct sr_output *o,
+		const struct sr_datafeed_analog *analog, GString **out)
+{
+	struct context *ctx;
+	struct column *col;
+	const GSList *l;
+	size_t num_samples, num_channels, size, done, count, todo, skip;
+	size_t room, i;
+	float *fdata, *dst;
+	const float *src;
+	int j, ret;
+
+	ctx = o->priv;
+	num_samples = analog->num_samples;
+	num_channels = g_slist_length(analog->meaning->channels);
+	if (!num_samples || !num_channels)
+		return SR_OK;
+
+	size = num_samples * num_channels;
+	if (size > ctx->fdata_size) {
+		if (!(fdata = g_try_realloc(ctx->fdata, sizeof(float) * size)))
+			return SR_ERR_MALLOC;
+		ctx->fdata = fdata;
+		ctx->fdata_size = size;
+	}
+	if ((ret = sr_analog_to_float(analog, ctx->fdata)) != SR_OK)
+		return ret;
+
+	for (done = 0; done < num_samples; done += todo) {
+		/* All channels of the packet take the same rows. */
+		count = num_samples - done;
+		todo = count;
+		for (l = analog->meaning->channels; l; l = l->next) {
+			if (!(col = find_column(ctx, l->data))) {
+				sr_err("Packet has a channel which isn't enabled.");
+				return SR_ERR;
+			}
+			skip = column_skip(col, count);
+			ret = column_reserve(ctx, col, count - skip, &room);
+			if (ret != SR_OK)
+				return ret;
+			todo = MIN(todo, skip + room);
+		}
+		for (l = analog->meaning->channels, j = 0; l; l = l->next, j++) {
+			col = find_column(ctx, l->data);
+			skip = column_skip(col, todo);
+			col->used += skip;
+			dst = (float *)col->data + col->used;
+			src = ctx->fdata + (done + skip) * num_channels + j;
+			for (i = 0; i < todo - skip; i++)
+				dst[i] = src[i * num_channels];
+			col->used += todo - skip;
+		}
+		if ((ret = flush_batches(o, FALSE, out)) != SR_OK)
+			return ret;
+	}
+
+	return SR_OK;
+}
+
+static int init(struct sr_output *o, GHashTable *options)
+{
+	struct context *ctx;
+	struct column *col;
+	struct sr_channel *ch;
+	const char *compression;
+	GSList *l;
+
+	ctx = g_malloc0(sizeof(struct context));
+	/* Whole bytes of logic data per batch. */
+	ctx->batch_rows = g_variant_get_uint32(g_hash_table_lookup(options, "batch"));
+	ctx->batch_rows = MAX((ctx->batch_rows + 7) / 8 * 8, 8);
+	compression = g_variant_get_string(g_hash_table_lookup(options,
+		"compression"), NULL);
+	if (!strcmp(compression, "zstd")) {
+#ifdef HAVE_LIBZSTD
+		ctx->compress = TRUE;
+#else
+		sr_err("No zstd compression, libsigrok was built without libzstd.");
+		g_free(ctx);
+		return SR_ERR_ARG;
+#endif
+	} else if (strcmp(compression, "none")) {
+		sr_err("Unknown compression '%s'.", compression);
+		g_free(ctx);
+		return SR_ERR_ARG;
+	}
+
+	ctx->columns = g_malloc0(sizeof(struct column) *
+		g_slist_length(o->sdi->channels));
+	for (l = o->sdi->channels; l; l = l->next) {
+		ch = l->data;
+		if (!ch->enabled)
+			continue;
+		if (ch->type != SR_CHANNEL_LOGIC && ch->type != SR_CHANNEL_ANALOG)
+			continue;
+		col = &ctx->columns[ctx->num_columns++];
+		col->ch = ch;
+		/* Room for a batch, even of nulls. Grows when needed. */
+		col->size = ctx->batch_rows;
+		if (ch->type == SR_CHANNEL_LOGIC)
+			col->data = g_malloc0(col->size / 8);
+		else
+			col->data = g_malloc0(col->size * sizeof(float));
+	}
+
+	ctx->validity = g_malloc0(ctx->batch_rows / 8);
+	ctx->nodes = g_malloc0(sizeof(int64_t) * 2 * ctx->num_columns);
+	ctx->buffers = g_malloc0(sizeof(int64_t) * 4 * ctx->num_columns);
+	ctx->fb = g_string_sized_new(1024);
+	ctx->body = g_string_sized_new(1024);
+	o->priv = ctx;
+
+	return SR_OK;
+}
+
+static int receive(const struct sr_output *o, const struct sr_datafeed_packet *packet,
+		GString **out)
+{
+	struct context *ctx;
+	const struct sr_datafeed_meta *meta;
+	const struct sr_config *src;
+	GVariant *gvar;
+	GSList *l;
+	char tmp[8];
+	int ret;
+
+	*out = NULL;
+	if (!o || !o->sdi || !(ctx = o->priv))
+		return SR_ERR_ARG;
+
+	switch (packet->type) {
+	case SR_DF_META:
+		meta = packet->payload;
+		for (l = meta->config; l; l = l->next) {
+			src = l->data;
+			if (src->key != SR_CONF_SAMPLERATE)
+				continue;
+			ctx->samplerate = g_variant_get_uint64(src->data);
+		}
+		return SR_OK;
+	case SR_DF_LOGIC:
+	case SR_DF_ANALOG:
+	case SR_DF_END:
+		break;
+	default:
+		return SR_OK;
+	}
+
+	/* The schema goes first, once the samplerate is likely known. */
+	if (!ctx->schema_done) {
+		if (ctx->samplerate == 0 && sr_config_get(o->sdi->driver, o->sdi,
+				NULL, SR_CONF_SAMPLERATE, &gvar) == SR_OK) {
+			ctx->samplerate = g_variant_get_uint64(gvar);
+			g_variant_unref(gvar);
+		}
+		*out = g_string_sized_new(1024);
+		gen_schema(o, *out);
+		ctx->schema_done = TRUE;
+	}
+
+	if (packet->type == SR_DF_LOGIC)
+		return add_logic(o, packet->payload, out);
+	if (packet->type == SR_DF_ANALOG)
+		return add_analog(o, packet->payload, out);
+
+	if ((ret = flush_batches(o, TRUE, out)) != SR_OK)
+		return ret;
+	if (!*out)
+		*out = g_string_sized_new(8);
+	/* End of stream. */
+	WL32(tmp, CONTINUATION);
+	WL32(tmp + 4, 0);
+	g_string_append_len(*out, tmp, 8);
+
+	return SR_OK;
+}
+
+static struct sr_option options[] = {
+	{ "batch", "Batch size", "Number of rows per record batch", NULL, NULL },
+	{ "compression", "Compression", "Buffer compression (none, zstd)", NULL, NULL },
+	ALL_ZERO
+};
+
+static const struct sr_option *get_options(void)
+{
+	GSList *l;
+
+	if (!options[0].def) {
+		options[0].def = g_variant_ref_sink(g_variant_new_uint32(DEFAULT_BATCH_ROWS));
+		options[1].def = g_variant_ref_sink(g_variant_new_string("none"));
+		l = g_slist_append(NULL, g_variant_ref_sink(g_variant_new_string("none")));
+#ifdef HAVE_LIBZSTD
+		l = g_slist_append(l, g_variant_ref_sink(g_variant_new_string("zstd")));
+#endif
+		options[1].values = l;
+	}
+
+	return options;
+}
+
+static int cleanup(struct sr_output *o)
+{
+	struct context *ctx;
+	int i;
+
+	if (!o || !o->sdi)
+		return SR_ERR_ARG;
+
+	if ((ctx = o->priv)) {
+		for (i = 0; i < ctx->num_columns; i++)
+			g_free(ctx->columns[i].data);
+		g_free(ctx->columns);
+		g_free(ctx->fdata);
+		g_string_free(ctx->fb, TRUE);
+		g_string_free(ctx->body, TRUE);
+		g_free(ctx->validity);
+		g_free(ctx->zbuf);
+		g_free(ctx->nodes);
+		g_free(ctx->buffers);
+		g_free(ctx);
+		o->priv = NULL;
+	}
+
+	for (i = 0; options[i].id; i++) {
+		if (options[i].def) {
+			g_variant_unref(options[i].def);
+			options[i].def = NULL;
+		}
+		g_slist_free_full(options[i].values,
+			(GDestroyNotify)g_variant_unref);
+		options[i].values = NULL;
+	}
+
+	return SR_OK;
+}
+
+SR_PRIV struct sr_output_module output_arrow = {
+	.id = "arrow",
+	.name = "Arrow",
+	.desc = "Apache Arrow IPC stream, columnar binary data",
+	.exts = (const char*[]){"arrows", "arrow", NULL},
+	.flags = 0,
+	.options = get_options,
+	.init = init,
+	.receive = receive,
+	.cleanup = cleanup,
+};
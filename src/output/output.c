@@ -65,6 +65,7 @@ extern SR_PRIV struct sr_output_module output_analog;
 extern SR_PRIV struct sr_output_module output_srzip;
 extern SR_PRIV struct sr_output_module output_wav;
 extern SR_PRIV struct sr_output_module output_wavedrom;
+extern SR_PRIV struct sr_output_module output_arrow;
 extern SR_PRIV struct sr_output_module output_null;
 /** @endcond */
 
@@ -81,6 +82,7 @@ static const struct sr_output_module *output_module_list[] = {
 	&output_srzip,
 	&output_wav,
 	&output_wavedrom,
+	&output_arrow,
 	&output_null,
 	NULL,
 };
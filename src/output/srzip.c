@@ -30,6 +30,20 @@
 #define LOG_PREFIX "output/srzip"
 #define CHUNK_SIZE (4 * 1024 * 1024)
 
+/*
+ * Segmented captures get a frame index, in the "frames-1" archive
+ * entry (see SR_SESSIONFILE_FRAME_SIZE). The sample positions count
+ * logic samples, or the first analog channel's samples when no logic
+ * data is saved.
+ */
+#define FRAMEFILE "frames-1"
+
+struct frame {
+	uint64_t start;
+	uint64_t count;
+	uint64_t trigger;
+};
+
 struct out_context {
 	gboolean zip_created;
 	uint64_t samplerate;
@@ -37,6 +51,10 @@ struct out_context {
 	size_t first_analog_index;
 	size_t analog_ch_count;
 	gint *analog_index_map;
+	gboolean have_logic;
+	uint64_t samples;
+	GArray *frames;
+	gboolean in_frame;
 	struct logic_buff {
 		size_t unit_size;
 		size_t alloc_size;
@@ -63,6 +81,7 @@ static int init(struct sr_output *o, GHashTable *options)
 
 	outc = g_malloc0(sizeof(*outc));
 	outc->filename = g_strdup(o->filename);
+	outc->frames = g_array_new(FALSE, FALSE, sizeof(struct frame));
 	o->priv = outc;
 
 	return SR_OK;
@@ -144,6 +163,7 @@ static int zip_create(const struct sr_output *o)
 		outc->first_analog_index = logic_channels + 1;
 	else
 		outc->first_analog_index = 1;
+	outc->have_logic = enabled_logic_channels > 0;
 
 	/* Only set capturefile and probes if we will actually save logic data. */
 	if (enabled_logic_channels > 0) {
@@ -384,6 +404,30 @@ static int zip_append(const struct sr_output *o,
 	return SR_OK;
 }
 
+/* Write the queued logic data to the archive, as one chunk. */
+static int zip_append_buff(const struct sr_output *o)
+{
+	struct out_context *outc;
+	struct logic_buff *buff;
+	int64_t start;
+	int ret;
+
+	outc = o->priv;
+	buff = &outc->logic_buff;
+	start = g_get_monotonic_time();
+	ret = zip_append(o, buff->samples, buff->unit_size,
+		buff->fill_size * buff->unit_size);
+	if (o->sdi) {
+		sr_metric_hist_add(&SR_DEV_METRICS(o->sdi)->output_write_us,
+			g_get_monotonic_time() - start);
+	}
+	if (ret != SR_OK)
+		return ret;
+	buff->fill_size = 0;
+
+	return SR_OK;
+}
+
 /**
  * Queue a block of logic data for srzip archive writes.
  *
@@ -429,22 +473,23 @@ static int zip_append_queue(const struct sr_output *o,
 			remain -= copy_size;
 		}
 		if (send_size && !remain) {
-			ret = zip_append(o, buff->samples, buff->unit_size,
-				buff->fill_size * buff->unit_size);
+			ret = zip_append_buff(o);
 			if (ret != SR_OK)
 				return ret;
-			buff->fill_size = 0;
 			remain = buff->alloc_size - buff->fill_size;
 		}
 	}
 
 	/* Flush to the ZIP archive if the caller wants us to. */
 	if (flush && buff->fill_size) {
-		ret = zip_append(o, buff->samples, buff->unit_size,
-			buff->fill_size * buff->unit_size);
+		ret = zip_append_buff(o);
 		if (ret != SR_OK)
 			return ret;
-		buff->fill_size = 0;
+	}
+
+	if (o->sdi) {
+		sr_metric_set(&SR_DEV_METRICS(o->sdi)->output_queued_bytes,
+			buff->fill_size * buff->unit_size);
 	}
 
 	return SR_OK;
@@ -580,6 +625,8 @@ static int zip_append_analog_queue(const struct sr_output *o,
 		return SR_ERR_ARG;
 	nr = outc->first_analog_index + idx;
 	buff = &outc->analog_buff[idx];
+	if (idx == 0 && !outc->have_logic)
+		outc->samples += analog->num_samples;
 
 	/* Convert the analog data to an array of float values. */
 	values = g_try_malloc0(analog->num_samples * sizeof(values[0]));
@@ -632,6 +679,97 @@ static int zip_append_analog_queue(const struct sr_output *o,
 	return SR_OK;
 }
 
+/**
+ * Write the frame index to an srzip archive, and reference it from
+ * the metadata.
+ *
+ * @param[in] o Output module instance.
+ *
+ * @returns SR_OK et al error codes.
+ */
+static int zip_append_frames(const struct sr_output *o)
+{
+	struct out_context *outc;
+	struct zip *archive;
+	struct zip_source *framesrc, *metasrc;
+	struct zip_stat zs;
+	const struct frame *frame;
+	GKeyFile *kf;
+	uint8_t *table, *p;
+	char *metabuf;
+	gsize metalen;
+	guint i;
+
+	outc = o->priv;
+	if (!(archive = zip_open(outc->filename, 0, NULL)))
+		return SR_ERR;
+
+	if (zip_stat(archive, "metadata", 0, &zs) < 0) {
+		sr_err("Failed to open metadata: %s", zip_strerror(archive));
+		zip_discard(archive);
+		return SR_ERR;
+	}
+	kf = sr_sessionfile_read_metadata(archive, &zs);
+	if (!kf) {
+		zip_discard(archive);
+		return SR_ERR_DATA;
+	}
+	g_key_file_set_string(kf, "device 1", "framefile", FRAMEFILE);
+	g_key_file_set_uint64(kf, "device 1", "frames", outc->frames->len);
+	metabuf = g_key_file_to_data(kf, &metalen, NULL);
+	g_key_file_free(kf);
+	metasrc = zip_source_buffer(archive, metabuf, metalen, FALSE);
+	if (zip_replace(archive, zs.index, metasrc) < 0) {
+		sr_err("Failed to replace metadata: %s", zip_strerror(archive));
+		zip_source_free(metasrc);
+		zip_discard(archive);
+		g_free(metabuf);
+		return SR_ERR;
+	}
+
+	table = g_malloc(outc->frames->len * SR_SESSIONFILE_FRAME_SIZE);
+	p = table;
+	for (i = 0; i < outc->frames->len; i++) {
+		frame = &g_array_index(outc->frames, struct frame, i);
+		WL64(&p[0], frame->start);
+		WL64(&p[8], frame->count);
+		WL64(&p[16], frame->trigger);
+		p += SR_SESSIONFILE_FRAME_SIZE;
+	}
+	framesrc = zip_source_buffer(archive, table, p - table, FALSE);
+	if (zip_add(archive, FRAMEFILE, framesrc) < 0) {
+		sr_err("Failed to add frame index: %s", zip_strerror(archive));
+		zip_source_free(framesrc);
+		zip_discard(archive);
+		g_free(table);
+		g_free(metabuf);
+		return SR_ERR;
+	}
+	if (zip_close(archive) < 0) {
+		sr_err("Error saving session file: %s", zip_strerror(archive));
+		zip_discard(archive);
+		g_free(table);
+		g_free(metabuf);
+		return SR_ERR;
+	}
+	g_free(table);
+	g_free(metabuf);
+
+	return SR_OK;
+}
+
+static void frame_end(struct out_context *outc)
+{
+	struct frame *frame;
+
+	if (!outc->in_frame)
+		return;
+	frame = &g_array_index(outc->frames, struct frame,
+		outc->frames->len - 1);
+	frame->count = outc->samples - frame->start;
+	outc->in_frame = FALSE;
+}
+
 static int receive(const struct sr_output *o, const struct sr_datafeed_packet *packet,
 		GString **out)
 {
@@ -640,6 +778,7 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
 	const struct sr_datafeed_logic *logic;
 	const struct sr_datafeed_analog *analog;
 	const struct sr_config *src;
+	struct frame frame, *cur;
 	GSList *l;
 	int ret;
 
@@ -668,6 +807,8 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
 			logic->unitsize, logic->length, FALSE);
 		if (ret != SR_OK)
 			return ret;
+		if (logic->unitsize)
+			outc->samples += logic->length / logic->unitsize;
 		break;
 	case SR_DF_ANALOG:
 		if (!outc->zip_created) {
@@ -680,6 +821,25 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
 		if (ret != SR_OK)
 			return ret;
 		break;
+	case SR_DF_FRAME_BEGIN:
+		frame_end(outc);
+		frame.start = outc->samples;
+		frame.count = 0;
+		frame.trigger = SR_SESSIONFILE_NO_TRIGGER;
+		g_array_append_val(outc->frames, frame);
+		outc->in_frame = TRUE;
+		break;
+	case SR_DF_TRIGGER:
+		if (!outc->in_frame)
+			break;
+		cur = &g_array_index(outc->frames, struct frame,
+			outc->frames->len - 1);
+		if (cur->trigger == SR_SESSIONFILE_NO_TRIGGER)
+			cur->trigger = outc->samples - cur->start;
+		break;
+	case SR_DF_FRAME_END:
+		frame_end(outc);
+		break;
 	case SR_DF_END:
 		if (outc->zip_created) {
 			ret = zip_append_queue(o, NULL, 0, 0, TRUE);
@@ -688,6 +848,12 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
 			ret = zip_append_analog_queue(o, NULL, TRUE);
 			if (ret != SR_OK)
 				return ret;
+			frame_end(outc);
+			if (outc->frames->len) {
+				ret = zip_append_frames(o);
+				if (ret != SR_OK)
+					return ret;
+			}
 		}
 		break;
 	}
@@ -717,6 +883,7 @@ static int cleanup(struct sr_output *o)
 	for (idx = 0; idx < outc->analog_ch_count; idx++)
 		g_free(outc->analog_buff[idx].samples);
 	g_free(outc->analog_buff);
+	g_array_free(outc->frames, TRUE);
 
 	g_free(outc);
 	o->priv = NULL;
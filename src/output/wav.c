@@ -18,85 +18,108 @@
  */
 
 #include <config.h>
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
 #include <string.h>
+#include <glib/gstdio.h>
 #include <libsigrok/libsigrok.h>
 #include "libsigrok-internal.h"
 
 #define LOG_PREFIX "output/wav"
 
-/* Minimum/maximum number of samples per channel to put in a data chunk */
-#define MIN_DATA_CHUNK_SAMPLES 10
+/*
+ * The header reserves room for a ds64 chunk in a JUNK chunk. Files
+ * which end up larger than 4GiB turn into RF64 files when the header
+ * gets rewritten at the end, without moving the sample data.
+ */
+#define DS64_SIZE	28
+
+/*
+ * Upper limit of frames which get buffered while waiting for channels
+ * to send their samples. Beyond this limit, a channel which sent no
+ * samples in IDLE_ROUNDS packets of every other channel gets silence
+ * in the frames. Channels which do send, even in large separate
+ * packets like scopes do, are waited for.
+ */
+#define MAX_PENDING_FRAMES	(256 * 1024)
+#define IDLE_ROUNDS		4
+
+enum sample_format {
+	FORMAT_FLOAT32,
+	FORMAT_PCM16,
+	FORMAT_PCM24,
+};
+
+static const struct {
+	const char *name;
+	uint16_t tag;
+	unsigned int size;
+} formats[] = {
+	/* Format code 3 = IEEE float, 1 = PCM */
+	[FORMAT_FLOAT32] = { "float32", 0x0003, 4 },
+	[FORMAT_PCM16] = { "pcm16", 0x0001, 2 },
+	[FORMAT_PCM24] = { "pcm24", 0x0001, 3 },
+};
 
 struct out_context {
 	double scale;
+	enum sample_format format;
 	gboolean header_done;
 	uint64_t samplerate;
 	int num_channels;
 	GSList *channels;
-	int chanbuf_size;
-	int *chanbuf_used;
-	uint8_t **chanbuf;
+	size_t frame_size;
+	/*
+	 * Frames in the output format. Drivers may send the channels in
+	 * separate packets, each channel's samples get stored in their
+	 * slot of the frames, and complete frames are written out.
+	 */
+	uint8_t *frames;
+	size_t frames_size;
+	size_t *frames_used;
+	/* Per channel, the number of packets since it sent samples. */
+	unsigned int *idle_packets;
 	float *fdata;
+	size_t fdata_size;
+	/* Written directly when there is a file, returned otherwise. */
+	FILE *file;
+	uint64_t data_bytes;
 };
 
-static int realloc_chanbufs(const struct sr_output *o, int size)
-{
-	struct out_context *outc;
-	int i;
-
-	outc = o->priv;
-	for (i = 0; i < outc->num_channels; i++) {
-		if (!(outc->chanbuf[i] = g_try_realloc(outc->chanbuf[i], sizeof(float) * size))) {
-			sr_err("Unable to allocate enough output buffer memory.");
-			return SR_ERR;
-		}
-		outc->chanbuf_used[i] = 0;
-	}
-	outc->chanbuf_size = size;
-
-	return SR_OK;
-}
-
-static int flush_chanbufs(const struct sr_output *o, GString *out)
+static void cleanup_context(struct out_context *outc)
 {
-	struct out_context *outc;
-	int num_samples, i, j;
-	char *buf, *bufp;
-
-	outc = o->priv;
-
-	/* Any one of them will do. */
-	num_samples = outc->chanbuf_used[0];
-	if (!(buf = g_try_malloc(4 * num_samples * outc->num_channels))) {
-		sr_err("Unable to allocate enough interleaved output buffer memory.");
-		return SR_ERR;
-	}
-
-	bufp = buf;
-	for (i = 0; i < num_samples; i++) {
-		for (j = 0; j < outc->num_channels; j++) {
-			memcpy(bufp, outc->chanbuf[j] + i * 4, 4);
-			bufp += 4;
-		}
-	}
-	g_string_append_len(out, buf, 4 * num_samples * outc->num_channels);
-	g_free(buf);
-
-	for (i = 0; i < outc->num_channels; i++)
-		outc->chanbuf_used[i] = 0;
-
-	return SR_OK;
+	if (outc->file)
+		fclose(outc->file);
+	g_slist_free(outc->channels);
+	g_free(outc->frames);
+	g_free(outc->frames_used);
+	g_free(outc->idle_packets);
+	g_free(outc->fdata);
+	g_free(outc);
 }
 
 static int init(struct sr_output *o, GHashTable *options)
 {
 	struct out_context *outc;
 	struct sr_channel *ch;
+	const char *format;
 	GSList *l;
+	size_t i;
 
 	outc = g_malloc0(sizeof(struct out_context));
-	o->priv = outc;
 	outc->scale = g_variant_get_double(g_hash_table_lookup(options, "scale"));
+	format = g_variant_get_string(g_hash_table_lookup(options, "format"), NULL);
+	for (i = 0; i < G_N_ELEMENTS(formats); i++) {
+		if (!strcmp(format, formats[i].name))
+			break;
+	}
+	if (i == G_N_ELEMENTS(formats)) {
+		sr_err("Unknown sample format '%s'.", format);
+		g_free(outc);
+		return SR_ERR_ARG;
+	}
+	outc->format = i;
 
 	for (l = o->sdi->channels; l; l = l->next) {
 		ch = l->data;
@@ -107,28 +130,38 @@ static int init(struct sr_output *o, GHashTable *options)
 		outc->channels = g_slist_append(outc->channels, ch);
 		outc->num_channels++;
 	}
-
-	outc->chanbuf = g_malloc0(sizeof(float *) * outc->num_channels);
-	outc->chanbuf_used = g_malloc0(sizeof(int) * outc->num_channels);
-
-	/* Start off the interleaved buffer with 100 samples/channel. */
-	realloc_chanbufs(o, 100);
+	outc->frame_size = formats[outc->format].size * outc->num_channels;
+	outc->frames_used = g_malloc0(sizeof(size_t) * outc->num_channels);
+	outc->idle_packets = g_malloc0(sizeof(unsigned int) * outc->num_channels);
+
+	/* The sizes in the header can only be filled in with a file. */
+	if (o->filename && o->filename[0] != '\0') {
+		if (!(outc->file = g_fopen(o->filename, "wb"))) {
+			sr_err("Cannot create %s: %s.", o->filename,
+				g_strerror(errno));
+			cleanup_context(outc);
+			return SR_ERR;
+		}
+	}
+	o->priv = outc;
 
 	return SR_OK;
 }
 
-static void add_data_chunk(const struct sr_output *o, GString *gs)
+static void add_data_chunk(const struct sr_output *o, GString *gs,
+		gboolean sized)
 {
 	struct out_context *outc;
+	unsigned int size;
 	char tmp[4];
 
 	outc = o->priv;
+	size = formats[outc->format].size;
 	g_string_append(gs, "fmt ");
-	/* Remaining chunk size */
-	WL32(tmp, 0x12);
+	/* Remaining chunk size, floats carry an extension size. */
+	WL32(tmp, outc->format == FORMAT_FLOAT32 ? 0x12 : 0x10);
 	g_string_append_len(gs, tmp, 4);
-	/* Format code 3 = IEEE float */
-	WL16(tmp, 0x0003);
+	WL16(tmp, formats[outc->format].tag);
 	g_string_append_len(gs, tmp, 2);
 	/* Number of channels */
 	WL16(tmp, outc->num_channels);
@@ -136,29 +169,39 @@ static void add_data_chunk(const struct sr_output *o, GString *gs)
 	/* Samplerate */
 	WL32(tmp, outc->samplerate);
 	g_string_append_len(gs, tmp, 4);
-	/* Byterate, using 32-bit floats. */
-	WL32(tmp, outc->samplerate * outc->num_channels * 4);
+	/* Byterate */
+	WL32(tmp, outc->samplerate * outc->frame_size);
 	g_string_append_len(gs, tmp, 4);
 	/* Blockalign */
-	WL16(tmp, outc->num_channels * 4);
+	WL16(tmp, outc->frame_size);
 	g_string_append_len(gs, tmp, 2);
 	/* Bits per sample */
-	WL16(tmp, 32);
-	g_string_append_len(gs, tmp, 2);
-	WL16(tmp, 0);
+	WL16(tmp, size * 8);
 	g_string_append_len(gs, tmp, 2);
+	if (outc->format == FORMAT_FLOAT32) {
+		WL16(tmp, 0);
+		g_string_append_len(gs, tmp, 2);
+	}
 
 	g_string_append(gs, "data");
-	/* Data chunk size, max it out. */
-	WL32(tmp, 0xffffffff);
+	/* Data chunk size, maxed out while it's unknown or too large. */
+	WL32(tmp, sized ? outc->data_bytes : 0xffffffff);
 	g_string_append_len(gs, tmp, 4);
 }
 
-static GString *gen_header(const struct sr_output *o)
+/*
+ * Generates the header. While the data is still being written the
+ * sizes are maxed out, which readers take as "until the end of the
+ * file". At the end the real sizes go in, as RF64 when they don't fit.
+ */
+static GString *gen_header(const struct sr_output *o, gboolean final)
 {
 	struct out_context *outc;
 	GVariant *gvar;
 	GString *header;
+	uint64_t riff_size;
+	gboolean rf64;
+	uint8_t ds64[DS64_SIZE];
 	char tmp[4];
 
 	outc = o->priv;
@@ -171,66 +214,268 @@ static GString *gen_header(const struct sr_output *o)
 	}
 
 	header = g_string_sized_new(512);
-	g_string_append(header, "RIFF");
-	/* Total size. Max out the field. */
-	WL32(tmp, 0xffffffff);
+	/* WAVE, ds64/JUNK, fmt and data chunk headers, data, pad byte. */
+	riff_size = 4 + 8 + DS64_SIZE + 8 + (outc->format == FORMAT_FLOAT32 ?
+		0x12 : 0x10) + 8 + outc->data_bytes + (outc->data_bytes & 1);
+	rf64 = final && riff_size > 0xffffffff;
+
+	g_string_append(header, rf64 ? "RF64" : "RIFF");
+	WL32(tmp, final && !rf64 ? riff_size : 0xffffffff);
 	g_string_append_len(header, tmp, 4);
 	g_string_append(header, "WAVE");
-	add_data_chunk(o, header);
+
+	memset(ds64, 0, sizeof(ds64));
+	if (rf64) {
+		WL64(ds64, riff_size);
+		WL64(ds64 + 8, outc->data_bytes);
+		WL64(ds64 + 16, outc->data_bytes / outc->frame_size);
+		/* No table entries follow. */
+		WL32(ds64 + 24, 0);
+	}
+	g_string_append(header, rf64 ? "ds64" : "JUNK");
+	WL32(tmp, DS64_SIZE);
+	g_string_append_len(header, tmp, 4);
+	g_string_append_len(header, (const char *)ds64, DS64_SIZE);
+
+	add_data_chunk(o, header, final && !rf64);
 
 	return header;
 }
 
+static int write_out(const struct sr_output *o, GString **out,
+		const void *data, size_t len)
+{
+	struct out_context *outc;
+
+	outc = o->priv;
+	if (!outc->file) {
+		if (!*out)
+			*out = g_string_sized_new(len);
+		g_string_append_len(*out, data, len);
+		return SR_OK;
+	}
+
+	if (fwrite(data, 1, len, outc->file) != len) {
+		sr_err("Cannot write to %s: %s.", o->filename, g_strerror(errno));
+		return SR_ERR_IO;
+	}
+
+	return SR_OK;
+}
+
+static int write_header(const struct sr_output *o, GString **out,
+		gboolean final)
+{
+	GString *header;
+	int ret;
+
+	header = gen_header(o, final);
+	ret = write_out(o, out, header->str, header->len);
+	g_string_free(header, TRUE);
+
+	return ret;
+}
+
+static inline int32_t float_to_pcm(float f, int32_t max)
+{
+	if (isnan(f))
+		return 0;
+
+	return lrintf(CLAMP(f, -1.0f, 1.0f) * max);
+}
+
 /*
- * Stores the float in little-endian BINARY32 IEEE-754 2008 format.
+ * Converts one channel's samples into its slot of the output frames.
+ * The loops are kept free of calls and branches on the sample values,
+ * to let the compiler vectorize them.
  */
-static void float_to_le(uint8_t *buf, float value)
+static void store_samples(const struct out_context *outc, uint8_t *dst,
+		const float *src, size_t src_step, size_t count)
 {
-	uint8_t *old;
-
-	old = (uint8_t *)&value;
-#ifdef WORDS_BIGENDIAN
-	buf[0] = old[3];
-	buf[1] = old[2];
-	buf[2] = old[1];
-	buf[3] = old[0];
-#else
-	buf[0] = old[0];
-	buf[1] = old[1];
-	buf[2] = old[2];
-	buf[3] = old[3];
-#endif
+	size_t i, step;
+	double scale;
+	int32_t value;
+
+	step = outc->frame_size;
+	scale = outc->scale;
+	switch (outc->format) {
+	case FORMAT_FLOAT32:
+		if (scale == 1.0) {
+			for (i = 0; i < count; i++, dst += step)
+				write_fltle(dst, src[i * src_step]);
+		} else {
+			for (i = 0; i < count; i++, dst += step)
+				write_fltle(dst, src[i * src_step] / scale);
+		}
+		break;
+	case FORMAT_PCM16:
+		for (i = 0; i < count; i++, dst += step) {
+			value = float_to_pcm(src[i * src_step] / scale, INT16_MAX);
+			WL16(dst, value);
+		}
+		break;
+	case FORMAT_PCM24:
+		for (i = 0; i < count; i++, dst += step) {
+			value = float_to_pcm(src[i * src_step] / scale, 0x7fffff);
+			dst[0] = value & 0xff;
+			dst[1] = (value >> 8) & 0xff;
+			dst[2] = (value >> 16) & 0xff;
+		}
+		break;
+	}
+}
+
+/* Fills a channel's slots in a range of frames with silence. */
+static void fill_silence(struct out_context *outc, int idx,
+		size_t from, size_t to)
+{
+	unsigned int sample_size;
+	uint8_t *dst;
+
+	sample_size = formats[outc->format].size;
+	dst = outc->frames + from * outc->frame_size + idx * sample_size;
+	for (; from < to; from++, dst += outc->frame_size)
+		memset(dst, 0, sample_size);
 }
 
 /*
- * Returns the number of samples used in the current channel buffers,
- * or -1 if they're not all the same.
+ * Writes out the frames which all channels have filled in. When too
+ * many frames are pending, channels which stopped sending samples get
+ * silence in them.
  */
-static int check_chanbuf_size(const struct sr_output *o)
+static int flush_frames(const struct sr_output *o, GString **out)
 {
 	struct out_context *outc;
-	int size, i;
+	struct sr_channel *ch;
+	size_t complete, filled;
+	int i, ret;
 
 	outc = o->priv;
-	size = 0;
+	filled = outc->frames_used[0];
+	for (i = 1; i < outc->num_channels; i++)
+		filled = MAX(filled, outc->frames_used[i]);
+	complete = filled;
 	for (i = 0; i < outc->num_channels; i++) {
-		if (size == 0) {
-			if (outc->chanbuf_used[i] == 0) {
-				/* Nothing in all the buffers yet. */
-				size = -1;
-				break;
-			} else {
-				/* New high water mark. */
-				size = outc->chanbuf_used[i];
+		if (filled > MAX_PENDING_FRAMES && outc->frames_used[i] < filled &&
+				outc->idle_packets[i] > IDLE_ROUNDS * outc->num_channels) {
+			ch = g_slist_nth_data(outc->channels, i);
+			sr_warn("Channel %s sends no samples, writing silence.",
+				ch->name);
+			fill_silence(outc, i, outc->frames_used[i], filled);
+			outc->frames_used[i] = filled;
+		}
+		complete = MIN(complete, outc->frames_used[i]);
+	}
+	if (!complete)
+		return SR_OK;
+
+	ret = write_out(o, out, outc->frames, complete * outc->frame_size);
+	if (ret != SR_OK)
+		return ret;
+	outc->data_bytes += complete * outc->frame_size;
+
+	if (filled > complete)
+		memmove(outc->frames, outc->frames + complete * outc->frame_size,
+			(filled - complete) * outc->frame_size);
+	for (i = 0; i < outc->num_channels; i++)
+		outc->frames_used[i] -= complete;
+
+	return SR_OK;
+}
+
+static int add_analog(const struct sr_output *o,
+		const struct sr_datafeed_analog *analog, GString **out)
+{
+	struct out_context *outc;
+	const GSList *l;
+	size_t num_samples, num_channels, size, used;
+	unsigned int sample_size;
+	int idx, j, ret;
+	float *fdata;
+	uint8_t *frames;
+
+	outc = o->priv;
+	num_samples = analog->num_samples;
+	num_channels = g_slist_length(analog->meaning->channels);
+	if (num_samples == 0)
+		return SR_OK;
+
+	if (num_channels > (size_t)outc->num_channels) {
+		sr_err("Packet has %zu channels, but only %d were enabled.",
+				num_channels, outc->num_channels);
+		return SR_ERR;
+	}
+
+	/* The buffers are kept across packets, and only ever grow. */
+	size = num_samples * num_channels;
+	if (size > outc->fdata_size) {
+		if (!(fdata = g_try_realloc(outc->fdata, sizeof(float) * size)))
+			return SR_ERR_MALLOC;
+		outc->fdata = fdata;
+		outc->fdata_size = size;
+	}
+	ret = sr_analog_to_float(analog, outc->fdata);
+	if (ret != SR_OK)
+		return ret;
+
+	for (idx = 0; idx < outc->num_channels; idx++)
+		outc->idle_packets[idx]++;
+	sample_size = formats[outc->format].size;
+	for (l = analog->meaning->channels, j = 0; l; l = l->next, j++) {
+		idx = g_slist_index(outc->channels, l->data);
+		if (idx < 0) {
+			sr_err("Packet has a channel which isn't enabled.");
+			return SR_ERR;
+		}
+		used = outc->frames_used[idx];
+		if (used + num_samples > outc->frames_size) {
+			size = MAX(used + num_samples, 2 * outc->frames_size);
+			if (!(frames = g_try_realloc(outc->frames,
+					size * outc->frame_size))) {
+				sr_err("Unable to allocate enough output buffer memory.");
+				return SR_ERR_MALLOC;
 			}
-		} else if (outc->chanbuf_used[i] != size) {
-			/* All channel buffers are not equally full yet. */
-			size = -1;
-			break;
+			outc->frames = frames;
+			outc->frames_size = size;
 		}
+		store_samples(outc, outc->frames + used * outc->frame_size +
+			idx * sample_size, outc->fdata + j, num_channels,
+			num_samples);
+		outc->frames_used[idx] += num_samples;
+		outc->idle_packets[idx] = 0;
 	}
 
-	return size;
+	return flush_frames(o, out);
+}
+
+/* Pads the data chunk, and rewrites the header with the sizes. */
+static int finish_file(const struct sr_output *o)
+{
+	struct out_context *outc;
+	GString *header;
+	size_t written;
+	int ret;
+
+	outc = o->priv;
+	ret = SR_OK;
+	if ((outc->data_bytes & 1) && fputc(0, outc->file) == EOF)
+		ret = SR_ERR_IO;
+	if (ret == SR_OK && fseek(outc->file, 0, SEEK_SET) != 0)
+		ret = SR_ERR_IO;
+	if (ret == SR_OK) {
+		header = gen_header(o, TRUE);
+		written = fwrite(header->str, 1, header->len, outc->file);
+		if (written != header->len)
+			ret = SR_ERR_IO;
+		g_string_free(header, TRUE);
+	}
+	if (fclose(outc->file) != 0)
+		ret = SR_ERR_IO;
+	outc->file = NULL;
+	if (ret != SR_OK)
+		sr_err("Cannot write to %s: %s.", o->filename, g_strerror(errno));
+
+	return ret;
 }
 
 static int receive(const struct sr_output *o, const struct sr_datafeed_packet *packet,
@@ -238,15 +483,9 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
 {
 	struct out_context *outc;
 	const struct sr_datafeed_meta *meta;
-	const struct sr_datafeed_analog *analog;
 	const struct sr_config *src;
-	struct sr_channel *ch;
 	GSList *l;
-	const GSList *channels;
-	float f;
-	int num_channels, num_samples, size, *chan_idx, idx, i, j, ret;
-	float *data;
-	uint8_t *buf;
+	int ret;
 
 	*out = NULL;
 	if (!o || !o->sdi || !(outc = o->priv))
@@ -263,70 +502,26 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
 		}
 		break;
 	case SR_DF_ANALOG:
+		if (!outc->num_channels)
+			break;
 		if (!outc->header_done) {
-			*out = gen_header(o);
+			ret = write_header(o, out, FALSE);
+			if (ret != SR_OK)
+				return ret;
 			outc->header_done = TRUE;
-		} else {
-			*out = g_string_sized_new(512);
-		}
-
-		analog = packet->payload;
-		num_samples = analog->num_samples;
-		channels = analog->meaning->channels;
-		num_channels = g_slist_length(analog->meaning->channels);
-		if (!(data = g_try_realloc(outc->fdata, sizeof(float) * num_samples * num_channels)))
-			return SR_ERR_MALLOC;
-		outc->fdata = data;
-		ret = sr_analog_to_float(analog, data);
-		if (ret != SR_OK)
-			return ret;
-
-		if (num_samples == 0)
-			return SR_OK;
-
-		if (num_channels > outc->num_channels) {
-			sr_err("Packet has %d channels, but only %d were enabled.",
-					num_channels, outc->num_channels);
-			return SR_ERR;
-		}
-
-		if (num_samples > outc->chanbuf_size) {
-			if (realloc_chanbufs(o, analog->num_samples) != SR_OK)
-				return SR_ERR_MALLOC;
-		}
-
-		/* Index the channels in this packet, so we can interleave quicker. */
-		chan_idx = g_malloc(sizeof(int) * outc->num_channels);
-		for (i = 0; i < num_channels; i++) {
-			ch = g_slist_nth_data((GSList *) channels, i);
-			chan_idx[i] = g_slist_index(outc->channels, ch);
 		}
-
-		for (i = 0; i < num_samples; i++) {
-			for (j = 0; j < num_channels; j++) {
-				idx = chan_idx[j];
-				buf = outc->chanbuf[idx] + outc->chanbuf_used[idx]++ * 4;
-				f = data[i * num_channels + j];
-				if (outc->scale != 1.0)
-					f /= outc->scale;
-				float_to_le(buf, f);
-			}
-		}
-		g_free(chan_idx);
-
-		size = check_chanbuf_size(o);
-		if (size > MIN_DATA_CHUNK_SAMPLES)
-			if (flush_chanbufs(o, *out) != SR_OK)
-				return SR_ERR;
-		break;
+		return add_analog(o, packet->payload, out);
 	case SR_DF_END:
-		size = check_chanbuf_size(o);
-		if (size > 0) {
-			*out = g_string_sized_new(4 * size * outc->num_channels);
-			if (flush_chanbufs(o, *out) != SR_OK)
-				return SR_ERR;
+		/* Frames which some channels never filled in are dropped. */
+		if (!outc->file)
+			break;
+		if (!outc->header_done) {
+			ret = write_header(o, out, FALSE);
+			if (ret != SR_OK)
+				return ret;
+			outc->header_done = TRUE;
 		}
-		break;
+		return finish_file(o);
 	}
 
 	return SR_OK;
@@ -334,13 +529,25 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
 
 static struct sr_option options[] = {
 	{ "scale", "Scale", "Scale values by factor", NULL, NULL },
+	{ "format", "Format", "Sample format (float32, pcm16, pcm24)", NULL, NULL },
 	ALL_ZERO
 };
 
 static const struct sr_option *get_options(void)
 {
-	if (!options[0].def)
+	GSList *l;
+	size_t i;
+
+	if (!options[0].def) {
 		options[0].def = g_variant_ref_sink(g_variant_new_double(1.0));
+		options[1].def = g_variant_ref_sink(g_variant_new_string(
+			formats[FORMAT_FLOAT32].name));
+		l = NULL;
+		for (i = 0; i < G_N_ELEMENTS(formats); i++)
+			l = g_slist_append(l, g_variant_ref_sink(
+				g_variant_new_string(formats[i].name)));
+		options[1].values = l;
+	}
 
 	return options;
 }
@@ -351,16 +558,19 @@ static int cleanup(struct sr_output *o)
 	int i;
 
 	outc = o->priv;
-	g_slist_free(outc->channels);
-	g_variant_unref(options[0].def);
-	for (i = 0; i < outc->num_channels; i++)
-		g_free(outc->chanbuf[i]);
-	g_free(outc->chanbuf_used);
-	g_free(outc->chanbuf);
-	g_free(outc->fdata);
-	g_free(outc);
+	cleanup_context(outc);
 	o->priv = NULL;
 
+	for (i = 0; options[i].id; i++) {
+		if (options[i].def) {
+			g_variant_unref(options[i].def);
+			options[i].def = NULL;
+		}
+		g_slist_free_full(options[i].values,
+			(GDestroyNotify)g_variant_unref);
+		options[i].values = NULL;
+	}
+
 	return SR_OK;
 }
 
@@ -369,7 +579,7 @@ SR_PRIV struct sr_output_module output_wav = {
 	.name = "WAV",
 	.desc = "Microsoft WAV file format data",
 	.exts = (const char*[]){"wav", NULL},
-	.flags = 0,
+	.flags = SR_OUTPUT_INTERNAL_IO_HANDLING,
 	.options = get_options,
 	.init = init,
 	.receive = receive,
@@ -20,6 +20,7 @@
 #include <config.h>
 #include <errno.h>
 #include <stdio.h>
+#include <string.h>
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <libsigrok/libsigrok.h>
@@ -29,6 +30,19 @@
 #define LOG_PREFIX "resource"
 /** @endcond */
 
+/* Cached resource image, see sr_resource_image_get(). */
+struct image_entry {
+	struct sr_resource_image image;
+	gint refcount;
+	/* Backing storage, either of them. */
+	GMappedFile *mapped;
+	void *buf;
+	/* Identity of the file, for resources from the default hooks. */
+	char *filename;
+	int64_t mtime;
+	int64_t filesize;
+};
+
 /**
  * @file
  *
@@ -261,11 +275,13 @@ SR_API int sr_resource_set_hooks(struct sr_context *ctx,
 		ctx->resource_close_cb = close_cb;
 		ctx->resource_read_cb = read_cb;
 		ctx->resource_cb_data = cb_data;
+		sr_resource_cache_clear(ctx);
 	} else if (!open_cb && !close_cb && !read_cb) {
 		ctx->resource_open_cb = &resource_open_default;
 		ctx->resource_close_cb = &resource_close_default;
 		ctx->resource_read_cb = &resource_read_default;
 		ctx->resource_cb_data = ctx;
+		sr_resource_cache_clear(ctx);
 	} else {
 		sr_err("%s: inconsistent callback pointers.", __func__);
 		return SR_ERR_ARG;
@@ -356,23 +372,113 @@ SR_PRIV gssize sr_resource_read(struct sr_context *ctx,
 	return n_read;
 }
 
-/**
- * Load a resource into memory.
- *
- * @param ctx libsigrok context. Must not be NULL.
- * @param type Resource type ID.
- * @param name Name of the resource. Must not be NULL.
- * @param[out] size Size in bytes of the returned buffer. Must not be NULL.
- * @param max_size Size limit. Error out if the resource is larger than this.
- *
- * @return A buffer containing the resource data, or NULL on failure. Must
- *         be freed by the caller using g_free().
- *
- * @private
+static void image_entry_free(struct image_entry *entry)
+{
+	if (entry->mapped)
+		g_mapped_file_unref(entry->mapped);
+	g_free(entry->buf);
+	g_free(entry->filename);
+	g_free(entry->image.name);
+	g_free(entry->image.hash);
+	g_free(entry);
+}
+
+static void image_entry_unref(gpointer data)
+{
+	struct image_entry *entry;
+
+	entry = data;
+	if (g_atomic_int_dec_and_test(&entry->refcount))
+		image_entry_free(entry);
+}
+
+static char *cache_key(int type, const char *name)
+{
+	return g_strdup_printf("%d/%s", type, name);
+}
+
+/* Find the file the default hooks would open, and its identity. */
+static char *locate_file(int type, const char *name, GStatBuf *st)
+{
+	GSList *paths, *p;
+	char *filename;
+
+	filename = NULL;
+	paths = sr_resourcepaths_get(type);
+	for (p = paths; p && !filename; p = p->next) {
+		filename = g_build_filename(p->data, name, NULL);
+		if (g_stat(filename, st) != 0 || !S_ISREG(st->st_mode)) {
+			g_free(filename);
+			filename = NULL;
+		}
+	}
+	g_slist_free_full(paths, g_free);
+
+	return filename;
+}
+
+/*
+ * Load a resource file from the default locations. Files can get mapped
+ * instead of read (SIGROK_FIRMWARE_MMAP), which is not the default since
+ * files which get truncated while in use would crash the process.
  */
-SR_PRIV void *sr_resource_load(struct sr_context *ctx,
-		int type, const char *name, size_t *size, size_t max_size)
+static struct image_entry *image_load_file(int type, const char *name,
+		size_t max_size)
+{
+	struct image_entry *entry;
+	GMappedFile *mapped;
+	GError *error;
+	GStatBuf st;
+	char *filename, *buf;
+	gsize len;
+
+	filename = locate_file(type, name, &st);
+	if (!filename) {
+		sr_err("Failed to locate resource '%s'.", name);
+		return NULL;
+	}
+	if ((uint64_t)st.st_size > max_size) {
+		sr_err("Size %" PRIu64 " of '%s' exceeds limit %zu.",
+			(uint64_t)st.st_size, name, max_size);
+		g_free(filename);
+		return NULL;
+	}
+
+	entry = g_malloc0(sizeof(*entry));
+	error = NULL;
+	if (g_getenv("SIGROK_FIRMWARE_MMAP")) {
+		mapped = g_mapped_file_new(filename, FALSE, &error);
+		if (mapped) {
+			entry->mapped = mapped;
+			entry->image.data = (const uint8_t *)
+				g_mapped_file_get_contents(mapped);
+			entry->image.size = g_mapped_file_get_length(mapped);
+		}
+	} else if (g_file_get_contents(filename, &buf, &len, &error)) {
+		entry->buf = buf;
+		entry->image.data = (const uint8_t *)buf;
+		entry->image.size = len;
+	}
+	if (error) {
+		sr_err("Failed to load '%s': %s.", filename, error->message);
+		g_error_free(error);
+		g_free(filename);
+		g_free(entry);
+		return NULL;
+	}
+	sr_info("Loaded '%s'.", filename);
+	entry->filename = filename;
+	entry->mtime = st.st_mtime;
+	entry->filesize = st.st_size;
+
+	return entry;
+}
+
+/* Read a resource through the (user provided) hooks. */
+static struct image_entry *image_read(struct sr_context *ctx, int type,
+		const char *name, size_t max_size)
 {
+	struct image_entry *entry;
 	struct sr_resource res;
 	void *buf;
 	size_t res_size;
@@ -407,6 +513,239 @@ SR_PRIV void *sr_resource_load(struct sr_context *ctx,
 		return NULL;
 	}
 
-	*size = res_size;
+	entry = g_malloc0(sizeof(*entry));
+	entry->buf = buf;
+	entry->image.data = buf;
+	entry->image.size = res_size;
+
+	return entry;
+}
+
+/* Check whether a cached file from the default locations is current. */
+static gboolean image_current(const struct image_entry *entry,
+		int type, const char *name)
+{
+	GStatBuf st;
+	char *filename;
+	gboolean current;
+
+	if (!entry->filename)
+		return TRUE;
+
+	filename = locate_file(type, name, &st);
+	current = filename && strcmp(filename, entry->filename) == 0 &&
+		st.st_mtime == entry->mtime && st.st_size == entry->filesize;
+	g_free(filename);
+
+	return current;
+}
+
+/**
+ * Get a resource's contents, from the context's resource cache.
+ *
+ * Resources get loaded once, and are kept in memory for further use.
+ * With the default resource hooks, files get reloaded when they change
+ * on disk, and can get mapped into memory instead of read (set the
+ * SIGROK_FIRMWARE_MMAP environment variable). With user provided hooks, the
+ * cache is kept until the hooks change.
+ *
+ * The image carries a hash of its contents, which allows drivers to
+ * tell whether a device still runs an image (see
+ * sr_resource_image_loaded()).
+ *
+ * @param ctx libsigrok context. Must not be NULL.
+ * @param type Resource type ID.
+ * @param name Name of the resource. Must not be NULL.
+ * @param max_size Size limit. Error out if the resource is larger than this.
+ *
+ * @return The resource image, or NULL on failure. Must be released by the
+ *         caller using sr_resource_image_unref().
+ *
+ * @private
+ */
+SR_PRIV struct sr_resource_image *sr_resource_image_get(struct sr_context *ctx,
+		int type, const char *name, size_t max_size)
+{
+	struct image_entry *entry;
+	char *key;
+
+	key = cache_key(type, name);
+	g_mutex_lock(&ctx->resource_lock);
+	entry = g_hash_table_lookup(ctx->resource_cache, key);
+	if (entry && entry->image.size <= max_size &&
+			image_current(entry, type, name)) {
+		g_atomic_int_inc(&entry->refcount);
+		g_mutex_unlock(&ctx->resource_lock);
+		g_free(key);
+		sr_dbg("Using cached resource '%s'.", name);
+		return &entry->image;
+	}
+	g_mutex_unlock(&ctx->resource_lock);
+
+	if (ctx->resource_open_cb == &resource_open_default)
+		entry = image_load_file(type, name, max_size);
+	else
+		entry = image_read(ctx, type, name, max_size);
+	if (!entry) {
+		g_free(key);
+		return NULL;
+	}
+	entry->image.type = type;
+	entry->image.name = g_strdup(name);
+	entry->image.hash = g_compute_checksum_for_data(G_CHECKSUM_SHA256,
+		entry->image.data, entry->image.size);
+	/* One reference for the cache, one for the caller. */
+	entry->refcount = 2;
+
+	g_mutex_lock(&ctx->resource_lock);
+	g_hash_table_replace(ctx->resource_cache, key, entry);
+	g_mutex_unlock(&ctx->resource_lock);
+
+	return &entry->image;
+}
+
+/**
+ * Release a resource image.
+ *
+ * @param image The image from sr_resource_image_get(), or NULL.
+ *
+ * @private
+ */
+SR_PRIV void sr_resource_image_unref(struct sr_resource_image *image)
+{
+	if (image)
+		image_entry_unref(image);
+}
+
+/**
+ * Check whether a device still runs a resource image.
+ *
+ * Drivers record the images they uploaded to a device (firmware, FPGA
+ * bitstreams) with sr_resource_image_set_loaded(). When the device gets
+ * opened again, and the image to use is the same, the upload can get
+ * skipped.
+ *
+ * The location identifies the device's instance on the bus. For USB
+ * devices, sr_usb_location() includes the device address, which changes
+ * when the device re-enumerates (after a replug, or a firmware upload).
+ *
+ * @param ctx libsigrok context. Must not be NULL.
+ * @param location The device's location. Must not be NULL.
+ * @param image The image to check for. Must not be NULL.
+ *
+ * @return TRUE when the device was last loaded with the same contents.
+ *
+ * @private
+ */
+SR_PRIV gboolean sr_resource_image_loaded(struct sr_context *ctx,
+		const char *location, const struct sr_resource_image *image)
+{
+	const char *hash;
+	gboolean loaded;
+
+	g_mutex_lock(&ctx->resource_lock);
+	hash = g_hash_table_lookup(ctx->loaded_images, location);
+	loaded = hash && strcmp(hash, image->hash) == 0;
+	g_mutex_unlock(&ctx->resource_lock);
+
+	return loaded;
+}
+
+/**
+ * Record the resource image a device got loaded with.
+ *
+ * @param ctx libsigrok context. Must not be NULL.
+ * @param location The device's location. Must not be NULL.
+ * @param image The loaded image, or NULL when the device's state is not
+ *              known (after a failed upload, for example).
+ *
+ * @private
+ */
+SR_PRIV void sr_resource_image_set_loaded(struct sr_context *ctx,
+		const char *location, const struct sr_resource_image *image)
+{
+	g_mutex_lock(&ctx->resource_lock);
+	if (image) {
+		g_hash_table_replace(ctx->loaded_images, g_strdup(location),
+			g_strdup(image->hash));
+	} else {
+		g_hash_table_remove(ctx->loaded_images, location);
+	}
+	g_mutex_unlock(&ctx->resource_lock);
+}
+
+/** @private */
+SR_PRIV void sr_resource_cache_init(struct sr_context *ctx)
+{
+	g_mutex_init(&ctx->resource_lock);
+	ctx->resource_cache = g_hash_table_new_full(g_str_hash, g_str_equal,
+		g_free, image_entry_unref);
+	ctx->loaded_images = g_hash_table_new_full(g_str_hash, g_str_equal,
+		g_free, g_free);
+}
+
+/**
+ * Drop all cached resources. Images still in use stay valid until they
+ * get released.
+ *
+ * @private
+ */
+SR_PRIV void sr_resource_cache_clear(struct sr_context *ctx)
+{
+	if (!ctx->resource_cache)
+		return;
+
+	g_mutex_lock(&ctx->resource_lock);
+	g_hash_table_remove_all(ctx->resource_cache);
+	g_mutex_unlock(&ctx->resource_lock);
+}
+
+/** @private */
+SR_PRIV void sr_resource_cache_free(struct sr_context *ctx)
+{
+	g_hash_table_destroy(ctx->resource_cache);
+	g_hash_table_destroy(ctx->loaded_images);
+	ctx->resource_cache = NULL;
+	ctx->loaded_images = NULL;
+	g_mutex_clear(&ctx->resource_lock);
+}
+
+/**
+ * Load a resource into memory.
+ *
+ * The resource gets read through the context's resource cache, repeated
+ * loads don't access the resource again.
+ *
+ * @param ctx libsigrok context. Must not be NULL.
+ * @param type Resource type ID.
+ * @param name Name of the resource. Must not be NULL.
+ * @param[out] size Size in bytes of the returned buffer. Must not be NULL.
+ * @param max_size Size limit. Error out if the resource is larger than this.
+ *
+ * @return A buffer containing the resource data, or NULL on failure. Must
+ *         be freed by the caller using g_free().
+ *
+ * @private
+ */
+SR_PRIV void *sr_resource_load(struct sr_context *ctx,
+		int type, const char *name, size_t *size, size_t max_size)
+{
+	struct sr_resource_image *image;
+	void *buf;
+
+	image = sr_resource_image_get(ctx, type, name, max_size);
+	if (!image)
+		return NULL;
+
+	buf = g_try_malloc(image->size);
+	if (!buf && image->size) {
+		sr_err("Failed to allocate buffer for '%s'.", name);
+		sr_resource_image_unref(image);
+		return NULL;
+	}
+	memcpy(buf, image->data, image->size);
+	*size = image->size;
+	sr_resource_image_unref(image);
+
 	return buf;
 }
@@ -310,21 +310,63 @@ static int scpi_get_data(struct sr_scpi_dev_inst *scpi,
 	return SR_OK;
 }
 
+/* A resource which gets probed during a scan. */
+struct scpi_scan_job {
+	struct drv_context *drvc;
+	struct sr_dev_inst *(*probe_device)(struct sr_scpi_dev_inst *scpi);
+	char *connection_id;
+	gchar **res;
+	const char *serialcomm;
+	gboolean parallel;
+	struct sr_dev_inst *sdi;
+};
+
+static void scpi_scan_job_run(gpointer data, gpointer user_data)
+{
+	struct scpi_scan_job *job;
+	const char *conn, *comm;
+	char *lock_name;
+
+	job = data;
+	(void)user_data;
+
+	if (job->parallel)
+		sr_driver_scan_set_parallel(TRUE);
+
+	/* Other drivers may probe the same resource at the same time. */
+	conn = job->res[0];
+	comm = job->serialcomm ? : job->res[1];
+	lock_name = g_strconcat("scpi:", conn, NULL);
+	if (sr_scan_lock(lock_name) == SR_OK) {
+		job->sdi = sr_scpi_scan_resource(job->drvc, conn, comm,
+			job->probe_device);
+		sr_scan_unlock(lock_name);
+	}
+	g_free(lock_name);
+
+	if (job->parallel)
+		sr_driver_scan_set_parallel(FALSE);
+}
+
 SR_PRIV GSList *sr_scpi_scan(struct drv_context *drvc, GSList *options,
 		struct sr_dev_inst *(*probe_device)(struct sr_scpi_dev_inst *scpi))
 {
 	GSList *resources, *l, *devices;
+	GPtrArray *jobs;
+	GThreadPool *pool;
+	struct scpi_scan_job *job;
 	struct sr_dev_inst *sdi;
-	const char *resource, *conn;
-	const char *serialcomm, *comm;
+	const char *resource;
+	const char *serialcomm;
 	gchar **res;
-	unsigned i;
+	unsigned i, threads;
 
 	resource = NULL;
 	serialcomm = NULL;
 	(void)sr_serial_extract_options(options, &resource, &serialcomm);
 
-	devices = NULL;
+	/* Collect the candidate resources of all transports. */
+	jobs = g_ptr_array_new();
 	for (i = 0; i < ARRAY_SIZE(scpi_devs); i++) {
 		if (resource && strcmp(resource, scpi_devs[i]->prefix) != 0)
 			continue;
@@ -337,18 +379,55 @@ SR_PRIV GSList *sr_scpi_scan(struct drv_context *drvc, GSList *options,
 				g_strfreev(res);
 				continue;
 			}
-			conn = res[0];
-			comm = serialcomm ? : res[1];
-			sdi = sr_scpi_scan_resource(drvc, conn, comm, probe_device);
-			if (sdi) {
-				devices = g_slist_append(devices, sdi);
-				sdi->connection_id = g_strdup(l->data);
-			}
-			g_strfreev(res);
+			job = g_malloc0(sizeof(*job));
+			job->drvc = drvc;
+			job->probe_device = probe_device;
+			job->connection_id = g_strdup(l->data);
+			job->res = res;
+			job->serialcomm = serialcomm;
+			g_ptr_array_add(jobs, job);
 		}
 		g_slist_free_full(resources, g_free);
 	}
 
+	/*
+	 * Probe the resources. Each probe can take a while when nothing
+	 * responds, so probe several resources at the same time. Only do
+	 * so when the scan itself runs in parallel, sequential scans must
+	 * not touch resources concurrently.
+	 */
+	threads = MIN(sr_driver_scan_threads(), jobs->len);
+	pool = NULL;
+	if (threads > 1 && sr_driver_scan_is_parallel())
+		pool = g_thread_pool_new(scpi_scan_job_run, NULL,
+			threads, FALSE, NULL);
+	for (i = 0; i < jobs->len; i++) {
+		job = g_ptr_array_index(jobs, i);
+		if (pool) {
+			job->parallel = TRUE;
+			g_thread_pool_push(pool, job, NULL);
+		} else {
+			scpi_scan_job_run(job, NULL);
+		}
+	}
+	if (pool)
+		g_thread_pool_free(pool, FALSE, TRUE);
+
+	/* Keep the order of resources in the result. */
+	devices = NULL;
+	for (i = 0; i < jobs->len; i++) {
+		job = g_ptr_array_index(jobs, i);
+		if (job->sdi) {
+			devices = g_slist_append(devices, job->sdi);
+			job->sdi->connection_id = job->connection_id;
+			job->connection_id = NULL;
+		}
+		g_free(job->connection_id);
+		g_strfreev(job->res);
+		g_free(job);
+	}
+	g_ptr_array_free(jobs, TRUE);
+
 	if (!devices && resource) {
 		sdi = sr_scpi_scan_resource(drvc, resource, serialcomm, probe_device);
 		if (sdi)
@@ -64,6 +64,42 @@ static int dev_is_supported(struct sr_serial_dev_inst *serial)
 	return 1;
 }
 
+/*
+ * While drivers scan in parallel (see sr_driver_scan_all()), a port
+ * only gets opened by one of them at a time, so that probe sequences
+ * of different drivers do not get mixed up. The lock is held from open
+ * to close, or until the port's instance gets released. Outside of
+ * parallel scans nothing gets locked, and nothing may get unlocked
+ * either: the port's name may be locked by a scan in another thread.
+ */
+static int serial_port_lock(struct sr_serial_dev_inst *serial)
+{
+	int ret;
+
+	if (!serial->port || serial->port_locked)
+		return SR_OK;
+	if (!sr_driver_scan_is_parallel())
+		return SR_OK;
+
+	ret = sr_scan_lock(serial->port);
+	if (ret == SR_OK)
+		serial->port_locked = TRUE;
+
+	return ret;
+}
+
+/** @private */
+SR_PRIV void serial_port_unlock(struct sr_serial_dev_inst *serial)
+{
+	if (!serial || !serial->port_locked)
+		return;
+
+	sr_scan_unlock(serial->port);
+	serial->port_locked = FALSE;
+}
+
+static int serial_open_port(struct sr_serial_dev_inst *serial, int flags);
+
 /**
  * Open the specified serial port.
  *
@@ -88,6 +124,21 @@ SR_PRIV int serial_open(struct sr_serial_dev_inst *serial, int flags)
 		return SR_ERR;
 	}
 
+	ret = serial_port_lock(serial);
+	if (ret != SR_OK)
+		return ret;
+
+	ret = serial_open_port(serial, flags);
+	if (ret != SR_OK)
+		serial_port_unlock(serial);
+
+	return ret;
+}
+
+static int serial_open_port(struct sr_serial_dev_inst *serial, int flags)
+{
+	int ret;
+
 	sr_spew("Opening serial port '%s' (flags %d).", serial->port, flags);
 
 	/*
@@ -166,11 +217,15 @@ SR_PRIV int serial_close(struct sr_serial_dev_inst *serial)
 	if (!serial->lib_funcs || !serial->lib_funcs->close)
 		return SR_ERR_NA;
 
+	if (serial->reactor_port)
+		serial_reactor_source_remove(NULL, serial);
+
 	rc = serial->lib_funcs->close(serial);
 	if (rc == SR_OK && serial->rcv_buffer) {
 		g_string_free(serial->rcv_buffer, TRUE);
 		serial->rcv_buffer = NULL;
 	}
+	serial_port_unlock(serial);
 
 	return rc;
 }
@@ -1012,6 +1067,9 @@ SR_PRIV int serial_source_remove(struct sr_session *session,
 		return SR_ERR_ARG;
 	}
 
+	if (serial->reactor_port)
+		return serial_reactor_source_remove(session, serial);
+
 	if (!serial->lib_funcs || !serial->lib_funcs->setup_source_remove)
 		return SR_ERR_NA;
 
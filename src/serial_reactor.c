@@ -0,0 +1,736 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 libsigrok contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Shared I/O reactor for serial ports.
+ *
+ * Drivers which receive fixed or self-describing packets from a serial
+ * port usually register the port with the session's main loop, and read
+ * and re-synchronize to the RX data stream from within the main loop's
+ * callback. With many ports in a session most of the time is spent in
+ * source dispatch and short timeouts.
+ *
+ * The reactor is a single background thread which waits for RX data on
+ * all registered ports (epoll(7)), reads the data as it arrives, and
+ * runs the driver's packet validity checker to cut the stream into
+ * packets. Complete packets are queued per port, and the session gets
+ * woken up via a per port notification pipe. The driver's receive
+ * callback then fetches the queued packets and only does the parsing
+ * and the submission to the session feed.
+ *
+ * Use of the reactor is optional. It requires epoll support and ports
+ * which are backed by libserialport, and must be enabled at runtime
+ * by setting the SIGROK_SERIAL_REACTOR environment variable. Callers
+ * fall back to serial_source_add() when registration is declined.
+ */
+
+#include <config.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <glib.h>
+#ifdef HAVE_LIBSERIALPORT
+#include <libserialport.h>
+#endif
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+
+/** @cond PRIVATE */
+#define LOG_PREFIX "serial-reactor"
+/** @endcond */
+
+#ifdef HAVE_SERIAL_COMM
+
+#if defined HAVE_LIBSERIALPORT && defined HAVE_SYS_EPOLL_H
+
+/* Size of the per port RX buffer which the packet checker operates on. */
+#define REACTOR_RX_BUFSIZE	1024
+/* Upper limit of queued packets per port before old packets get dropped. */
+#define REACTOR_MAX_QUEUED	256
+/* Number of epoll events to handle per wakeup. */
+#define REACTOR_MAX_EVENTS	32
+
+struct ser_reactor_packet {
+	int64_t rx_time_us;
+	size_t len;
+	uint8_t data[];
+};
+
+struct ser_reactor_port {
+	struct sr_serial_dev_inst *serial;
+	struct sr_session *session;
+	int port_fd;
+	int notify_fds[2];
+	/* Set while the reactor thread reads the port (reactor.lock). */
+	gboolean busy;
+	/* Protects the queue, the flags and the counters below. */
+	GMutex lock;
+	gboolean notified;
+	gboolean dead;
+	GQueue packets;
+	struct sr_serial_reactor_stats stats;
+	/* Only accessed by the reactor thread. */
+	size_t packet_size;
+	packet_valid_callback is_valid;
+	packet_valid_len_callback is_valid_len;
+	void *is_valid_state;
+	uint8_t rx_buf[REACTOR_RX_BUFSIZE];
+	size_t rx_len;
+};
+
+static struct {
+	/* Serializes reactor setup and teardown (add/remove of ports). */
+	GMutex lifecycle;
+	/*
+	 * Protects the port list, and the ports' busy flags. Not held
+	 * while ports get read, so that slow ports don't block others.
+	 */
+	GMutex lock;
+	/* Signalled when the reactor thread is done reading its ports. */
+	GCond idle;
+	GThread *thread;
+	int epoll_fd;
+	int ctrl_fds[2];
+	gboolean quit;
+	GSList *ports;
+} reactor;
+
+static int set_nonblocking(int fd)
+{
+	int flags;
+
+	flags = fcntl(fd, F_GETFL);
+	if (flags < 0)
+		return -1;
+	if (fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+		return -1;
+	if (fcntl(fd, F_SETFD, FD_CLOEXEC) < 0)
+		return -1;
+
+	return 0;
+}
+
+static int open_pipe(int fds[2])
+{
+	if (pipe(fds) < 0)
+		return -1;
+	if (set_nonblocking(fds[0]) < 0 || set_nonblocking(fds[1]) < 0) {
+		close(fds[0]);
+		close(fds[1]);
+		fds[0] = fds[1] = -1;
+		return -1;
+	}
+
+	return 0;
+}
+
+static void close_pipe(int fds[2])
+{
+	if (fds[0] >= 0)
+		close(fds[0]);
+	if (fds[1] >= 0)
+		close(fds[1]);
+	fds[0] = fds[1] = -1;
+}
+
+static void drain_pipe(int fd)
+{
+	uint8_t junk[64];
+
+	while (read(fd, junk, sizeof(junk)) > 0)
+		;
+}
+
+static void kick_pipe(int fd)
+{
+	uint8_t b;
+	ssize_t ret;
+
+	/* A full pipe already is a pending notification. */
+	b = 0;
+	ret = write(fd, &b, sizeof(b));
+	(void)ret;
+}
+
+/* Wake up the port's reader. Called with the port's lock held. */
+static void port_notify(struct ser_reactor_port *port)
+{
+	if (port->notified)
+		return;
+	port->notified = TRUE;
+	kick_pipe(port->notify_fds[1]);
+}
+
+static void queue_packet(struct ser_reactor_port *port,
+	const uint8_t *data, size_t len, int64_t now)
+{
+	struct ser_reactor_packet *pkt, *old;
+
+	if (g_queue_get_length(&port->packets) >= REACTOR_MAX_QUEUED) {
+		old = g_queue_pop_head(&port->packets);
+		g_free(old);
+		port->stats.dropped_packets++;
+	}
+
+	pkt = g_malloc(sizeof(*pkt) + len);
+	pkt->rx_time_us = now;
+	pkt->len = len;
+	memcpy(pkt->data, data, len);
+	g_queue_push_tail(&port->packets, pkt);
+	port->stats.rx_packets++;
+}
+
+/*
+ * Cut the port's RX buffer into packets. Follows the logic of the
+ * serial-dmm driver's receive routine: Check for a packet at the
+ * current position, advance by one byte when the data is invalid,
+ * advance by the packet's size when a packet was found. Called with
+ * the port's lock held.
+ */
+static size_t frame_packets(struct ser_reactor_port *port, int64_t now)
+{
+	size_t check_pos, check_len, pkt_size, count;
+	uint8_t *check_ptr;
+	int ret;
+
+	count = 0;
+	check_pos = 0;
+	while (check_pos < port->rx_len) {
+		check_len = port->rx_len - check_pos;
+		if (check_len < port->packet_size)
+			break;
+		check_ptr = &port->rx_buf[check_pos];
+		if (port->is_valid_len) {
+			ret = port->is_valid_len(port->is_valid_state,
+				check_ptr, check_len, &pkt_size);
+			if (ret == SR_PACKET_NEED_RX)
+				break;
+			if (ret == SR_PACKET_INVALID) {
+				check_pos++;
+				port->stats.dropped_bytes++;
+				continue;
+			}
+		} else {
+			if (!port->is_valid(check_ptr)) {
+				check_pos++;
+				port->stats.dropped_bytes++;
+				continue;
+			}
+			pkt_size = port->packet_size;
+		}
+		queue_packet(port, check_ptr, pkt_size, now);
+		check_pos += pkt_size;
+		count++;
+	}
+
+	if (check_pos) {
+		port->rx_len -= check_pos;
+		if (port->rx_len)
+			memmove(&port->rx_buf[0], &port->rx_buf[check_pos],
+				port->rx_len);
+	}
+
+	/* Nothing could get processed in a full buffer. Re-sync. */
+	if (port->rx_len == sizeof(port->rx_buf)) {
+		port->stats.dropped_bytes += port->rx_len;
+		port->rx_len = 0;
+	}
+
+	return count;
+}
+
+/*
+ * Read all available RX data of a port. The port's lock is only taken
+ * to queue the packets, not during the read() calls.
+ */
+static void port_receive(struct ser_reactor_port *port)
+{
+	struct sr_serial_dev_inst *serial;
+	size_t space, count;
+	int ret;
+	int64_t now;
+
+	serial = port->serial;
+	count = 0;
+	do {
+		space = sizeof(port->rx_buf) - port->rx_len;
+		ret = serial->lib_funcs->read(serial,
+			&port->rx_buf[port->rx_len], space, 1, 0);
+		if (ret <= 0)
+			break;
+		port->rx_len += ret;
+		now = g_get_monotonic_time();
+		g_mutex_lock(&port->lock);
+		port->stats.rx_bytes += ret;
+		count += frame_packets(port, now);
+		if (count)
+			port_notify(port);
+		g_mutex_unlock(&port->lock);
+	} while ((size_t)ret == space);
+}
+
+/*
+ * The port got disconnected or failed. Stop watching it (a hung up fd
+ * keeps signalling), and wake up the reader which then sees the error
+ * after it has fetched the remaining packets.
+ */
+static void port_hangup(struct ser_reactor_port *port)
+{
+	sr_warn("Port %s hung up or failed.", port->serial->port);
+	epoll_ctl(reactor.epoll_fd, EPOLL_CTL_DEL, port->port_fd, NULL);
+	g_mutex_lock(&port->lock);
+	port->dead = TRUE;
+	port_notify(port);
+	g_mutex_unlock(&port->lock);
+}
+
+static gpointer reactor_thread(gpointer data)
+{
+	struct epoll_event events[REACTOR_MAX_EVENTS];
+	struct ser_reactor_port *port;
+	int nfds, i;
+	gboolean quit;
+
+	(void)data;
+
+	sr_dbg("Reactor thread running.");
+	quit = FALSE;
+	while (!quit) {
+		nfds = epoll_wait(reactor.epoll_fd, events,
+			G_N_ELEMENTS(events), -1);
+		if (nfds < 0) {
+			if (errno == EINTR)
+				continue;
+			sr_err("epoll_wait() failed: %s.", g_strerror(errno));
+			break;
+		}
+		g_mutex_lock(&reactor.lock);
+		for (i = 0; i < nfds; i++) {
+			port = events[i].data.ptr;
+			if (!port) {
+				drain_pipe(reactor.ctrl_fds[0]);
+				quit = reactor.quit;
+				continue;
+			}
+			/* Port might have been removed after epoll_wait(). */
+			if (g_slist_find(reactor.ports, port))
+				port->busy = TRUE;
+			else
+				events[i].data.ptr = NULL;
+		}
+		g_mutex_unlock(&reactor.lock);
+
+		/* Removal of busy ports waits until they were read. */
+		for (i = 0; i < nfds; i++) {
+			if (!(port = events[i].data.ptr))
+				continue;
+			port_receive(port);
+			if (events[i].events & (EPOLLHUP | EPOLLERR))
+				port_hangup(port);
+		}
+
+		g_mutex_lock(&reactor.lock);
+		for (i = 0; i < nfds; i++) {
+			if ((port = events[i].data.ptr))
+				port->busy = FALSE;
+		}
+		g_cond_broadcast(&reactor.idle);
+		g_mutex_unlock(&reactor.lock);
+	}
+	sr_dbg("Reactor thread done.");
+
+	return NULL;
+}
+
+static int reactor_start(void)
+{
+	struct epoll_event ev;
+
+	reactor.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (reactor.epoll_fd < 0) {
+		sr_err("Cannot create epoll instance: %s.", g_strerror(errno));
+		return SR_ERR_IO;
+	}
+	if (open_pipe(reactor.ctrl_fds) < 0) {
+		sr_err("Cannot create control pipe: %s.", g_strerror(errno));
+		close(reactor.epoll_fd);
+		reactor.epoll_fd = -1;
+		return SR_ERR_IO;
+	}
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.ptr = NULL;
+	if (epoll_ctl(reactor.epoll_fd, EPOLL_CTL_ADD,
+			reactor.ctrl_fds[0], &ev) < 0) {
+		sr_err("Cannot watch control pipe: %s.", g_strerror(errno));
+		close_pipe(reactor.ctrl_fds);
+		close(reactor.epoll_fd);
+		reactor.epoll_fd = -1;
+		return SR_ERR_IO;
+	}
+	reactor.quit = FALSE;
+	reactor.thread = g_thread_new("sr-serial-reactor",
+		reactor_thread, NULL);
+
+	return SR_OK;
+}
+
+static void reactor_stop(void)
+{
+	g_mutex_lock(&reactor.lock);
+	reactor.quit = TRUE;
+	g_mutex_unlock(&reactor.lock);
+	kick_pipe(reactor.ctrl_fds[1]);
+
+	g_thread_join(reactor.thread);
+	reactor.thread = NULL;
+
+	close_pipe(reactor.ctrl_fds);
+	close(reactor.epoll_fd);
+	reactor.epoll_fd = -1;
+}
+
+static void port_free(struct ser_reactor_port *port)
+{
+	struct ser_reactor_packet *pkt;
+
+	while ((pkt = g_queue_pop_head(&port->packets)))
+		g_free(pkt);
+	close_pipe(port->notify_fds);
+	g_mutex_clear(&port->lock);
+	g_free(port);
+}
+
+/**
+ * Register a serial port with the shared I/O reactor.
+ *
+ * The reactor thread reads RX data as it arrives, and uses the caller's
+ * validity checker to cut the stream into packets. The 'cb' routine gets
+ * invoked from the session's main loop when complete packets are queued
+ * (with G_IO_IN in revents), or when the timeout expired (with 0 revents).
+ * Queued packets are fetched by means of serial_reactor_read_packet().
+ *
+ * The checker routines run in the reactor thread. Their state (if any)
+ * must not be accessed from other threads while the port is registered.
+ *
+ * @param[in] session The session to notify about received packets.
+ * @param[in] serial Previously opened serial port instance.
+ * @param[in] packet_size The (minimum) size of a packet.
+ * @param[in] is_valid Checker for fixed size packets.
+ * @param[in] is_valid_len Checker for variable length packets.
+ * @param[in] is_valid_state Opaque state to pass to 'is_valid_len'.
+ * @param[in] timeout Timeout [ms] of the session callback, or -1.
+ * @param[in] cb Session callback which processes packets.
+ * @param[in] cb_data Data to pass to the session callback.
+ *
+ * @retval SR_OK Port got registered with the reactor.
+ * @retval SR_ERR_NA Reactor not enabled, or port not supported. The
+ *   caller should use serial_source_add() instead.
+ * @retval SR_ERR_ARG Invalid parameters.
+ * @retval SR_ERR_IO Failed to setup the reactor.
+ *
+ * @private
+ */
+SR_PRIV int serial_reactor_source_add(struct sr_session *session,
+	struct sr_serial_dev_inst *serial, size_t packet_size,
+	packet_valid_callback is_valid, packet_valid_len_callback is_valid_len,
+	void *is_valid_state, int timeout,
+	sr_receive_data_callback cb, void *cb_data)
+{
+	struct ser_reactor_port *port;
+	struct epoll_event ev;
+	int fd, ret;
+
+	if (!serial || !packet_size || (!is_valid && !is_valid_len))
+		return SR_ERR_ARG;
+	if (!g_getenv("SIGROK_SERIAL_REACTOR"))
+		return SR_ERR_NA;
+	if (serial->lib_funcs != ser_lib_funcs_libsp || !serial->sp_data)
+		return SR_ERR_NA;
+	if (serial->reactor_port)
+		return SR_ERR_ARG;
+	if (sp_get_port_handle(serial->sp_data, &fd) != SP_OK)
+		return SR_ERR_NA;
+
+	port = g_malloc0(sizeof(*port));
+	port->serial = serial;
+	port->session = session;
+	port->port_fd = fd;
+	port->packet_size = packet_size;
+	port->is_valid = is_valid;
+	port->is_valid_len = is_valid_len;
+	port->is_valid_state = is_valid_state;
+	g_mutex_init(&port->lock);
+	g_queue_init(&port->packets);
+	if (open_pipe(port->notify_fds) < 0) {
+		sr_err("Cannot create notification pipe: %s.",
+			g_strerror(errno));
+		g_mutex_clear(&port->lock);
+		g_free(port);
+		return SR_ERR_IO;
+	}
+
+	ret = sr_session_fd_source_add(session, port, port->notify_fds[0],
+		G_IO_IN, timeout, cb, cb_data);
+	if (ret != SR_OK) {
+		port_free(port);
+		return ret;
+	}
+
+	g_mutex_lock(&reactor.lifecycle);
+	if (!reactor.ports && !reactor.thread) {
+		ret = reactor_start();
+		if (ret != SR_OK) {
+			g_mutex_unlock(&reactor.lifecycle);
+			sr_session_source_remove_internal(session, port);
+			port_free(port);
+			return ret;
+		}
+	}
+	g_mutex_lock(&reactor.lock);
+	reactor.ports = g_slist_append(reactor.ports, port);
+	serial->reactor_port = port;
+	g_mutex_unlock(&reactor.lock);
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.ptr = port;
+	if (epoll_ctl(reactor.epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+		sr_err("Cannot watch port %s: %s.", serial->port,
+			g_strerror(errno));
+		g_mutex_lock(&reactor.lock);
+		reactor.ports = g_slist_remove(reactor.ports, port);
+		serial->reactor_port = NULL;
+		g_mutex_unlock(&reactor.lock);
+		if (!reactor.ports)
+			reactor_stop();
+		g_mutex_unlock(&reactor.lifecycle);
+		sr_session_source_remove_internal(session, port);
+		port_free(port);
+		return SR_ERR_IO;
+	}
+	g_mutex_unlock(&reactor.lifecycle);
+
+	sr_dbg("Port %s handled by reactor.", serial->port);
+
+	return SR_OK;
+}
+
+/**
+ * Unregister a serial port from the shared I/O reactor.
+ *
+ * Removes the session source, and discards packets which were not
+ * fetched yet. Stops the reactor thread when the last port is gone.
+ *
+ * @param[in] session The session which the port was registered with,
+ *   or NULL to use the registration's session.
+ * @param[in] serial Previously registered serial port instance.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Port was not registered with the reactor.
+ *
+ * @private
+ */
+SR_PRIV int serial_reactor_source_remove(struct sr_session *session,
+	struct sr_serial_dev_inst *serial)
+{
+	struct ser_reactor_port *port;
+	struct sr_serial_reactor_stats *st;
+
+	if (!serial || !serial->reactor_port)
+		return SR_ERR_ARG;
+	port = serial->reactor_port;
+	if (!session)
+		session = port->session;
+
+	g_mutex_lock(&reactor.lifecycle);
+	epoll_ctl(reactor.epoll_fd, EPOLL_CTL_DEL, port->port_fd, NULL);
+	g_mutex_lock(&reactor.lock);
+	reactor.ports = g_slist_remove(reactor.ports, port);
+	serial->reactor_port = NULL;
+	while (port->busy)
+		g_cond_wait(&reactor.idle, &reactor.lock);
+	g_mutex_unlock(&reactor.lock);
+	if (!reactor.ports)
+		reactor_stop();
+	g_mutex_unlock(&reactor.lifecycle);
+
+	st = &port->stats;
+	sr_dbg("Port %s: %" PRIu64 " bytes, %" PRIu64 " packets, "
+		"%" PRIu64 " bytes skipped, %" PRIu64 " packets dropped, "
+		"latency avg %" PRIu64 "us max %" PRIu64 "us.",
+		serial->port, st->rx_bytes, st->rx_packets,
+		st->dropped_bytes, st->dropped_packets,
+		st->latency_count ? st->latency_us_sum / st->latency_count : 0,
+		st->latency_us_max);
+
+	sr_session_source_remove_internal(session, port);
+	port_free(port);
+
+	return SR_OK;
+}
+
+/**
+ * Fetch the next complete packet which the reactor has received.
+ *
+ * Callers should fetch packets until none are left when their session
+ * callback was invoked with G_IO_IN.
+ *
+ * @param[in] serial Previously registered serial port instance.
+ * @param[out] buf Caller provided buffer for the packet's data.
+ * @param[in] bufsize The caller's buffer size.
+ *
+ * @return The packet's length, 0 when no packet is queued, or a
+ *   negative libsigrok error code. SR_ERR_IO when the port hung up
+ *   or failed, and all its packets have been fetched.
+ *
+ * @private
+ */
+SR_PRIV int serial_reactor_read_packet(struct sr_serial_dev_inst *serial,
+	uint8_t *buf, size_t bufsize)
+{
+	struct ser_reactor_port *port;
+	struct ser_reactor_packet *pkt;
+	uint64_t latency;
+	int ret;
+
+	if (!serial || !serial->reactor_port || !buf)
+		return SR_ERR_ARG;
+	port = serial->reactor_port;
+
+	g_mutex_lock(&port->lock);
+	pkt = g_queue_pop_head(&port->packets);
+	if (!pkt) {
+		drain_pipe(port->notify_fds[0]);
+		port->notified = FALSE;
+		ret = port->dead ? SR_ERR_IO : 0;
+		g_mutex_unlock(&port->lock);
+		return ret;
+	}
+	latency = g_get_monotonic_time() - pkt->rx_time_us;
+	port->stats.latency_us_sum += latency;
+	port->stats.latency_count++;
+	if (latency > port->stats.latency_us_max)
+		port->stats.latency_us_max = latency;
+	g_mutex_unlock(&port->lock);
+
+	if (pkt->len > bufsize) {
+		sr_err("Packet size %zu exceeds buffer size %zu.",
+			pkt->len, bufsize);
+		g_free(pkt);
+		return SR_ERR_DATA;
+	}
+	memcpy(buf, pkt->data, pkt->len);
+	ret = pkt->len;
+	g_free(pkt);
+
+	return ret;
+}
+
+#else
+
+SR_PRIV int serial_reactor_source_add(struct sr_session *session,
+	struct sr_serial_dev_inst *serial, size_t packet_size,
+	packet_valid_callback is_valid, packet_valid_len_callback is_valid_len,
+	void *is_valid_state, int timeout,
+	sr_receive_data_callback cb, void *cb_data)
+{
+	(void)session;
+	(void)serial;
+	(void)packet_size;
+	(void)is_valid;
+	(void)is_valid_len;
+	(void)is_valid_state;
+	(void)timeout;
+	(void)cb;
+	(void)cb_data;
+
+	return SR_ERR_NA;
+}
+
+SR_PRIV int serial_reactor_source_remove(struct sr_session *session,
+	struct sr_serial_dev_inst *serial)
+{
+	(void)session;
+	(void)serial;
+
+	return SR_ERR_ARG;
+}
+
+SR_PRIV int serial_reactor_read_packet(struct sr_serial_dev_inst *serial,
+	uint8_t *buf, size_t bufsize)
+{
+	(void)serial;
+	(void)buf;
+	(void)bufsize;
+
+	return SR_ERR_NA;
+}
+
+#endif
+
+#endif
+
+/**
+ * Get the serial reactor's receive statistics of a device.
+ *
+ * The statistics are available while the device's acquisition runs,
+ * and its serial port is handled by the reactor (see the
+ * SIGROK_SERIAL_REACTOR environment variable).
+ *
+ * @param[in] sdi The device instance. Must not be NULL.
+ * @param[out] stats Caller provided storage for a copy of the counters.
+ *                   Must not be NULL.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid arguments, or not a serial device.
+ * @retval SR_ERR_NA The device's port is not handled by the reactor.
+ *
+ * @since 0.6.0
+ */
+SR_API int sr_serial_reactor_stats_get(const struct sr_dev_inst *sdi,
+	struct sr_serial_reactor_stats *stats)
+{
+#if defined HAVE_SERIAL_COMM && defined HAVE_LIBSERIALPORT && \
+	defined HAVE_SYS_EPOLL_H
+	struct sr_serial_dev_inst *serial;
+	struct ser_reactor_port *port;
+
+	if (!sdi || !stats || sdi->inst_type != SR_INST_SERIAL || !sdi->conn)
+		return SR_ERR_ARG;
+	serial = sdi->conn;
+	if (!(port = serial->reactor_port))
+		return SR_ERR_NA;
+
+	g_mutex_lock(&port->lock);
+	*stats = port->stats;
+	g_mutex_unlock(&port->lock);
+
+	return SR_OK;
+#else
+	if (!sdi || !stats)
+		return SR_ERR_ARG;
+
+	return SR_ERR_NA;
+#endif
+}
@@ -48,9 +48,36 @@
 
 struct datafeed_callback {
 	sr_datafeed_callback cb;
+	/* Instead of cb, for callbacks which get timestamps. */
+	sr_datafeed_timed_callback timed_cb;
 	void *cb_data;
+	/* Time spent in the callback, see sr_session_stats_get(). */
+	struct sr_metric_hist cb_us;
+	/* Called without the feed mutex, see sr_session_send(). */
+	gboolean concurrent;
 };
 
+/*
+ * A device's dispatch thread, see sr_session_device_threads_set(). The
+ * thread runs a main loop on its own main context, which executes the
+ * device's acquisition start and stop, and its event sources.
+ */
+struct dev_thread {
+	struct sr_session *session;
+	struct sr_dev_inst *sdi;
+	GMainContext *main_context;
+	GMainLoop *main_loop;
+	GThread *thread;
+	/* Signals the result of the acquisition start. */
+	GMutex mutex;
+	GCond cond;
+	gboolean started;
+	int start_ret;
+};
+
+/* The dispatch thread which the current thread is, if any. */
+static GPrivate current_dev_thread = G_PRIVATE_INIT(NULL);
+
 /** Custom GLib event source for generic descriptor I/O.
  * @see https://developer.gnome.org/glib/stable/glib-The-Main-Event-Loop.html
  */
@@ -225,6 +252,8 @@ SR_API int sr_session_new(struct sr_context *ctx,
 	session->ctx = ctx;
 
 	g_mutex_init(&session->main_mutex);
+	g_mutex_init(&session->sources_mutex);
+	g_mutex_init(&session->feed_mutex);
 
 	/* To maintain API compatibility, we need a lookup table
 	 * which maps poll_object IDs to GSource* pointers.
@@ -262,6 +291,8 @@ SR_API int sr_session_destroy(struct sr_session *session)
 	g_hash_table_unref(session->event_sources);
 
 	g_mutex_clear(&session->main_mutex);
+	g_mutex_clear(&session->sources_mutex);
+	g_mutex_clear(&session->feed_mutex);
 
 	g_free(session);
 
@@ -463,6 +494,7 @@ SR_API int sr_session_datafeed_callback_remove_all(struct sr_session *session)
 
 	g_slist_free_full(session->datafeed_callbacks, g_free);
 	session->datafeed_callbacks = NULL;
+	session->timed_callbacks = FALSE;
 
 	return SR_OK;
 }
@@ -505,6 +537,139 @@ SR_API int sr_session_datafeed_callback_add(struct sr_session *session,
 	return SR_OK;
 }
 
+/**
+ * Add a datafeed callback which accepts concurrent calls.
+ *
+ * Like sr_session_datafeed_callback_add(), but when the session runs
+ * with dispatch threads (see sr_session_device_threads_set()), the
+ * callback may get called from several devices' threads at the same
+ * time, so that a slow callback for one device doesn't hold up the
+ * others. Packets of one device still arrive in order, after the other
+ * callbacks got them. Sessions with transform modules and sessions
+ * without dispatch threads call the callback like any other.
+ *
+ * @param session The session to use. Must not be NULL.
+ * @param cb Function to call when a chunk of data is received.
+ *           Must not be NULL.
+ * @param cb_data Opaque pointer passed in by the caller.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid argument.
+ *
+ * @since 0.6.0
+ */
+SR_API int sr_session_datafeed_callback_add_concurrent(
+		struct sr_session *session, sr_datafeed_callback cb, void *cb_data)
+{
+	struct datafeed_callback *cb_struct;
+	int ret;
+
+	if (!session) {
+		sr_err("%s: session was NULL", __func__);
+		return SR_ERR_ARG;
+	}
+
+	ret = sr_session_datafeed_callback_add(session, cb, cb_data);
+	if (ret != SR_OK)
+		return ret;
+
+	cb_struct = g_slist_last(session->datafeed_callbacks)->data;
+	cb_struct->concurrent = TRUE;
+
+	return SR_OK;
+}
+
+/**
+ * Add a datafeed callback which gets timestamps.
+ *
+ * Like sr_session_datafeed_callback_add(), but the callback also gets
+ * each packet's timestamp: The index of the packet's first sample since
+ * the start of the device's acquisition, and the host time when that
+ * sample got acquired. For devices with a samplerate, the time gets
+ * computed from the sample index, and drivers which know their
+ * hardware's timing keep it in sync. Other devices' packets get the
+ * time when they were sent. Packets without samples get the sample
+ * index and time where the device's data currently ends.
+ *
+ * Timestamps are comparable between the devices of a session, see
+ * sr_session_merge_set() to get packets in time order.
+ *
+ * @param session The session to use. Must not be NULL.
+ * @param cb Function to call when a chunk of data is received.
+ *           Must not be NULL.
+ * @param cb_data Opaque pointer passed in by the caller.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid argument.
+ *
+ * @since 0.6.0
+ */
+SR_API int sr_session_datafeed_callback_add_timed(struct sr_session *session,
+		sr_datafeed_timed_callback cb, void *cb_data)
+{
+	struct datafeed_callback *cb_struct;
+
+	if (!session) {
+		sr_err("%s: session was NULL", __func__);
+		return SR_ERR_ARG;
+	}
+
+	if (!cb) {
+		sr_err("%s: cb was NULL", __func__);
+		return SR_ERR_ARG;
+	}
+
+	cb_struct = g_malloc0(sizeof(struct datafeed_callback));
+	cb_struct->timed_cb = cb;
+	cb_struct->cb_data = cb_data;
+
+	session->datafeed_callbacks =
+	    g_slist_append(session->datafeed_callbacks, cb_struct);
+	session->timed_callbacks = TRUE;
+
+	return SR_OK;
+}
+
+/**
+ * Pass the packets of a session's devices on in time order.
+ *
+ * Without this, the datafeed callbacks get each device's packets as the
+ * device sends them, and packets of different devices interleave in no
+ * particular order. With a merge window, packets wait until each device
+ * which may send older packets sent a packet, and then get passed on in
+ * the order of their timestamps (see
+ * sr_session_datafeed_callback_add_timed()). A packet waits no longer
+ * than the window, in timestamps of later packets. So the window bounds
+ * the buffering to about the amount of data which the devices acquire
+ * in that time, and packets of a device which falls further behind get
+ * passed on late. Packets of one device keep their order.
+ *
+ * Waiting packets are copies, which costs some throughput. All
+ * callbacks get called one at a time, even the ones added with
+ * sr_session_datafeed_callback_add_concurrent(). Takes effect when the
+ * session gets started.
+ *
+ * @param session The session to use. Must not be NULL.
+ * @param window_us The merge window in microseconds, 0 (the default)
+ *                  to pass packets on unordered.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid argument.
+ *
+ * @since 0.6.0
+ */
+SR_API int sr_session_merge_set(struct sr_session *session,
+		uint64_t window_us)
+{
+	if (!session) {
+		sr_err("%s: session was NULL", __func__);
+		return SR_ERR_ARG;
+	}
+	session->merge_window_us = window_us;
+
+	return SR_OK;
+}
+
 /**
  * Get the trigger assigned to this session.
  *
@@ -635,23 +800,26 @@ static int set_main_context(struct sr_session *session)
  */
 static int unset_main_context(struct sr_session *session)
 {
-	int ret;
+	GMainContext *main_context;
 
 	g_mutex_lock(&session->main_mutex);
+	main_context = session->main_context;
+	session->main_context = NULL;
+	g_mutex_unlock(&session->main_mutex);
 
-	if (session->main_context) {
-		g_main_context_unref(session->main_context);
-		session->main_context = NULL;
-		ret = SR_OK;
-	} else {
+	if (!main_context) {
 		/* May happen if the set/unset calls are not matched.
 		 */
 		sr_err("No main context to unset.");
-		ret = SR_ERR;
+		return SR_ERR;
 	}
-	g_mutex_unlock(&session->main_mutex);
+	/*
+	 * Not with the mutex held: Finalizing the main context finalizes
+	 * its sources, which may still get unregistered.
+	 */
+	g_main_context_unref(main_context);
 
-	return ret;
+	return SR_OK;
 }
 
 static unsigned int session_source_attach(struct sr_session *session,
@@ -671,25 +839,337 @@ static unsigned int session_source_attach(struct sr_session *session,
 	return id;
 }
 
+/* Reset all metrics of a session, when it starts. */
+static void session_metrics_reset(struct sr_session *session)
+{
+	struct datafeed_callback *cb_struct;
+	struct sr_transform *t;
+	struct sr_dev_inst *sdi;
+	GSList *l;
+
+	session->start_us = g_get_monotonic_time();
+	for (l = session->devs; l; l = l->next) {
+		sdi = l->data;
+		sr_dev_metrics_reset(&sdi->metrics);
+	}
+	for (l = session->transforms; l; l = l->next) {
+		t = l->data;
+		sr_metric_hist_reset(&t->receive_us);
+	}
+	for (l = session->datafeed_callbacks; l; l = l->next) {
+		cb_struct = l->data;
+		sr_metric_hist_reset(&cb_struct->cb_us);
+	}
+}
+
+static gpointer dev_thread_main(gpointer data)
+{
+	struct dev_thread *dt;
+
+	dt = data;
+	g_private_set(&current_dev_thread, dt);
+	g_main_context_push_thread_default(dt->main_context);
+	g_main_loop_run(dt->main_loop);
+	g_main_context_pop_thread_default(dt->main_context);
+
+	return NULL;
+}
+
+/* Have a function called on a device's dispatch thread. */
+static void dev_thread_invoke(struct dev_thread *dt, GSourceFunc func)
+{
+	GSource *source;
+
+	/*
+	 * Not g_main_context_invoke(), which calls the function right away
+	 * if the calling thread can acquire the context.
+	 */
+	source = g_idle_source_new();
+	g_source_set_callback(source, func, dt, NULL);
+	g_source_attach(source, dt->main_context);
+	g_source_unref(source);
+}
+
+static gboolean dev_thread_start_cb(void *data)
+{
+	struct dev_thread *dt;
+	int ret;
+
+	dt = data;
+	ret = sr_dev_acquisition_start(dt->sdi);
+
+	g_mutex_lock(&dt->mutex);
+	dt->start_ret = ret;
+	dt->started = TRUE;
+	g_cond_signal(&dt->cond);
+	g_mutex_unlock(&dt->mutex);
+
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean dev_thread_stop_cb(void *data)
+{
+	struct dev_thread *dt;
+
+	dt = data;
+	sr_dev_acquisition_stop(dt->sdi);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void send_stats(struct sr_dev_inst *sdi)
+{
+	if (!g_atomic_int_get(&sdi->metrics.streaming))
+		return;
+	sr_session_send_meta(sdi, SR_CONF_SESSION_STATS,
+		sr_dev_metrics_variant(sdi));
+}
+
+static gboolean dev_thread_stats_cb(void *data)
+{
+	struct dev_thread *dt;
+
+	dt = data;
+	send_stats(dt->sdi);
+
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean dev_thread_quit_cb(void *data)
+{
+	struct dev_thread *dt;
+
+	dt = data;
+	g_main_loop_quit(dt->main_loop);
+
+	return G_SOURCE_REMOVE;
+}
+
+static struct dev_thread *dev_thread_find(struct sr_session *session,
+		const struct sr_dev_inst *sdi)
+{
+	struct dev_thread *dt;
+	GSList *l;
+
+	for (l = session->dev_threads; l; l = l->next) {
+		dt = l->data;
+		if (dt->sdi == sdi)
+			return dt;
+	}
+
+	return NULL;
+}
+
+/*
+ * Quit and join the dispatch threads. Calls which are pending on them
+ * (like acquisition stops) get handled before they quit.
+ */
+static void dev_threads_stop(struct sr_session *session)
+{
+	struct dev_thread *dt;
+	GSList *l;
+
+	for (l = session->dev_threads; l; l = l->next) {
+		dt = l->data;
+		if (dt->thread) {
+			dev_thread_invoke(dt, &dev_thread_quit_cb);
+			g_thread_join(dt->thread);
+		}
+	}
+	for (l = session->dev_threads; l; l = l->next) {
+		dt = l->data;
+		g_main_loop_unref(dt->main_loop);
+		g_main_context_unref(dt->main_context);
+		g_mutex_clear(&dt->mutex);
+		g_cond_clear(&dt->cond);
+		g_free(dt);
+	}
+	g_slist_free(session->dev_threads);
+	session->dev_threads = NULL;
+}
+
+static int dev_threads_start(struct sr_session *session)
+{
+	struct dev_thread *dt;
+	GError *error;
+	GSList *l;
+
+	for (l = session->devs; l; l = l->next) {
+		dt = g_malloc0(sizeof(struct dev_thread));
+		dt->session = session;
+		dt->sdi = l->data;
+		dt->main_context = g_main_context_new();
+		dt->main_loop = g_main_loop_new(dt->main_context, FALSE);
+		g_mutex_init(&dt->mutex);
+		g_cond_init(&dt->cond);
+		session->dev_threads = g_slist_append(session->dev_threads, dt);
+
+		error = NULL;
+		dt->thread = g_thread_try_new("sr-dev", &dev_thread_main,
+			dt, &error);
+		if (!dt->thread) {
+			sr_err("Cannot create dispatch thread: %s.",
+				error->message);
+			g_error_free(error);
+			dev_threads_stop(session);
+			return SR_ERR;
+		}
+	}
+
+	return SR_OK;
+}
+
+/* Start a device's acquisition, on its dispatch thread if it has one. */
+static int dev_acquisition_start(struct sr_session *session,
+		struct sr_dev_inst *sdi)
+{
+	struct dev_thread *dt;
+	int ret;
+
+	dt = dev_thread_find(session, sdi);
+	if (!dt)
+		return sr_dev_acquisition_start(sdi);
+
+	dev_thread_invoke(dt, &dev_thread_start_cb);
+	g_mutex_lock(&dt->mutex);
+	while (!dt->started)
+		g_cond_wait(&dt->cond, &dt->mutex);
+	ret = dt->start_ret;
+	g_mutex_unlock(&dt->mutex);
+
+	return ret;
+}
+
+/* Stop a device's acquisition. Asynchronous with a dispatch thread. */
+static void dev_acquisition_stop(struct sr_session *session,
+		struct sr_dev_inst *sdi)
+{
+	struct dev_thread *dt;
+
+	dt = dev_thread_find(session, sdi);
+	if (dt)
+		dev_thread_invoke(dt, &dev_thread_stop_cb);
+	else
+		sr_dev_acquisition_stop(sdi);
+}
+
+/*
+ * Timer which sends the devices' metrics to the datafeed callbacks.
+ * Devices with a dispatch thread send them from that thread, so that
+ * the metrics are in order with the device's other packets.
+ */
+static gboolean stats_timeout(void *data)
+{
+	struct sr_session *session;
+	struct sr_dev_inst *sdi;
+	struct dev_thread *dt;
+	GSList *l;
+
+	session = data;
+	for (l = session->devs; l; l = l->next) {
+		sdi = l->data;
+		dt = dev_thread_find(session, sdi);
+		if (dt)
+			dev_thread_invoke(dt, &dev_thread_stats_cb);
+		else
+			send_stats(sdi);
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+/*
+ * The timer is no event source of the session (it is not kept in the
+ * event_sources table), it doesn't keep the session running.
+ */
+static void stats_timer_start(struct sr_session *session)
+{
+	GSource *source;
+
+	if (!session->stats_interval_ms)
+		return;
+
+	source = g_timeout_source_new(session->stats_interval_ms);
+	g_source_set_callback(source, &stats_timeout, session, NULL);
+	session->stats_source_id = session_source_attach(session, source);
+	g_source_unref(source);
+}
+
+static void stats_timer_stop(struct sr_session *session)
+{
+	GSource *source;
+
+	if (!session->stats_source_id)
+		return;
+
+	g_mutex_lock(&session->main_mutex);
+	if (session->main_context) {
+		source = g_main_context_find_source_by_id(session->main_context,
+			session->stats_source_id);
+		if (source)
+			g_source_destroy(source);
+	}
+	g_mutex_unlock(&session->main_mutex);
+	session->stats_source_id = 0;
+}
+
+static void merge_emit(const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *packet,
+		const struct sr_datafeed_timestamp *ts, void *cb_data);
+
+static void merge_start(struct sr_session *session)
+{
+	GSList *l;
+
+	if (!session->merge_window_us)
+		return;
+
+	session->merge = sr_merge_new(session->merge_window_us,
+		&merge_emit, session);
+	for (l = session->devs; l; l = l->next)
+		sr_merge_dev_add(session->merge, l->data);
+}
+
+/* Pass on what's left in the merge, once the devices stopped. */
+static void merge_stop(struct sr_session *session)
+{
+	struct sr_merge *merge;
+
+	if (!(merge = session->merge))
+		return;
+
+	sr_merge_flush(merge);
+	session->merge = NULL;
+	sr_merge_free(merge);
+}
+
 /* Idle handler; invoked when the number of registered event sources
  * for a running session drops to zero.
  */
 static gboolean delayed_stop_check(void *data)
 {
 	struct sr_session *session;
+	unsigned int num_sources;
 
 	session = data;
+
+	g_mutex_lock(&session->sources_mutex);
 	session->stop_check_id = 0;
+	num_sources = g_hash_table_size(session->event_sources);
+	g_mutex_unlock(&session->sources_mutex);
 
 	/* Session already ended? */
 	if (!session->running)
 		return G_SOURCE_REMOVE;
 
 	/* New event sources may have been installed in the meantime. */
-	if (g_hash_table_size(session->event_sources) != 0)
+	if (num_sources != 0)
 		return G_SOURCE_REMOVE;
 
 	session->running = FALSE;
+	dev_threads_stop(session);
+	merge_stop(session);
+	stats_timer_stop(session);
 	unset_main_context(session);
 
 	sr_info("Stopped.");
@@ -710,6 +1190,7 @@ static gboolean delayed_stop_check(void *data)
 	return G_SOURCE_REMOVE;
 }
 
+/* Must be called with the sources mutex held. */
 static int stop_check_later(struct sr_session *session)
 {
 	GSource *source;
@@ -741,6 +1222,8 @@ static int stop_check_later(struct sr_session *session)
  * If a thread-default GLib main context has been set, and is not owned by
  * any other thread, it will be used. Otherwise, libsigrok will create its
  * own main context for the current thread.
+ * With sr_session_device_threads_set(), the devices' events get
+ * processed on their own threads instead.
  *
  * @param session The session to use. Must not be NULL.
  *
@@ -800,15 +1283,27 @@ SR_API int sr_session_start(struct sr_session *session)
 				sdi->driver->name, sdi->connection_id);
 			return ret;
 		}
+		sr_dev_timing_prepare(sdi);
 	}
 
 	ret = set_main_context(session);
 	if (ret != SR_OK)
 		return ret;
 
+	if (session->device_threads) {
+		ret = dev_threads_start(session);
+		if (ret != SR_OK) {
+			unset_main_context(session);
+			return ret;
+		}
+	}
+
 	sr_info("Starting.");
 
 	session->running = TRUE;
+	session_metrics_reset(session);
+	merge_start(session);
+	stats_timer_start(session);
 
 	/* Have all devices start acquisition. */
 	for (l = session->devs; l; l = l->next) {
@@ -817,7 +1312,7 @@ SR_API int sr_session_start(struct sr_session *session)
 			ret = SR_ERR;
 			break;
 		}
-		ret = sr_dev_acquisition_start(sdi);
+		ret = dev_acquisition_start(session, sdi);
 		if (ret != SR_OK) {
 			sr_err("Could not start %s device %s acquisition.",
 				sdi->driver->name, sdi->connection_id);
@@ -831,18 +1326,23 @@ SR_API int sr_session_start(struct sr_session *session)
 		lend = l->next;
 		for (l = session->devs; l != lend; l = l->next) {
 			sdi = l->data;
-			sr_dev_acquisition_stop(sdi);
+			dev_acquisition_stop(session, sdi);
 		}
 		/* TODO: Handle delayed stops. Need to iterate the event
 		 * sources... */
 		session->running = FALSE;
 
+		dev_threads_stop(session);
+		merge_stop(session);
+		stats_timer_stop(session);
 		unset_main_context(session);
 		return ret;
 	}
 
+	g_mutex_lock(&session->sources_mutex);
 	if (g_hash_table_size(session->event_sources) == 0)
 		stop_check_later(session);
+	g_mutex_unlock(&session->sources_mutex);
 
 	return SR_OK;
 }
@@ -914,7 +1414,7 @@ static gboolean session_stop_sync(void *user_data)
 
 	for (node = session->devs; node; node = node->next) {
 		sdi = node->data;
-		sr_dev_acquisition_stop(sdi);
+		dev_acquisition_stop(session, sdi);
 	}
 
 	return G_SOURCE_REMOVE;
@@ -1026,6 +1526,208 @@ SR_API int sr_session_stopped_callback_set(struct sr_session *session,
 	return SR_OK;
 }
 
+/**
+ * Get the acquisition metrics of a session.
+ *
+ * The metrics are counted from the last start of the session, and can
+ * be queried while the session is running, or after it stopped. The
+ * result is a dictionary with these entries:
+ *
+ *  - "running" (boolean): Whether the session is running.
+ *  - "elapsed_us" (uint64): Time since the session started.
+ *  - "devices" (array of dictionaries): Per device "driver",
+ *    "connection_id", "elapsed_us", the number of "packets",
+ *    "logic_bytes" and "analog_samples" sent, "logic_bytes_per_s",
+ *    the time spent sending packets ("send_us"), the USB "transfers",
+ *    "transfer_bytes", "empty_transfers", "failed_transfers",
+ *    "resubmits", "starved" (no transfer was pending when one
+ *    completed) and "transfer_latency_us", the bytes which an output
+ *    module didn't write yet ("output_queued_bytes") and the duration
+ *    of its writes ("output_write_us"), and the pre-trigger data of
+ *    the driver's soft trigger ("soft_trigger", a dictionary of
+ *    "bytes_copied", "bytes_retained", "buffers_retained",
+ *    "bytes_dropped", "bytes_sent", "triggers" and the data held
+ *    currently, "fill_bytes").
+ *  - "transforms" (array of dictionaries): Per transform module "id"
+ *    and the time spent in its receive() ("receive_us").
+ *  - "callbacks" (array of dictionaries): Per datafeed callback, in the
+ *    order they were added, "index" and the time spent in it ("cb_us").
+ *
+ * Durations are histograms, dictionaries with "count", "sum", "max"
+ * (uint64, in microseconds) and "buckets" (array of uint64). Bucket 0
+ * counts durations below 1us, bucket i durations in [2^(i-1), 2^i) us.
+ * The datafeed's durations only get measured when enabled, see
+ * sr_session_stats_timing_set().
+ * Drivers without USB streaming and sessions without output modules
+ * which report metrics have zero counts for the respective entries.
+ *
+ * @param session The session to use. Must not be NULL.
+ * @param[out] stats The metrics, a floating reference. Must not be NULL.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid argument.
+ *
+ * @since 0.6.0
+ */
+SR_API int sr_session_stats_get(struct sr_session *session, GVariant **stats)
+{
+	struct datafeed_callback *cb_struct;
+	struct sr_transform *t;
+	GVariantBuilder builder, list, entry;
+	GSList *l;
+	uint32_t index;
+
+	if (!session || !stats) {
+		sr_err("%s: invalid argument", __func__);
+		return SR_ERR_ARG;
+	}
+
+	g_variant_builder_init(&builder, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_add(&builder, "{sv}", "running",
+		g_variant_new_boolean(session->running));
+	g_variant_builder_add(&builder, "{sv}", "elapsed_us",
+		g_variant_new_uint64(session->start_us ?
+			g_get_monotonic_time() - session->start_us : 0));
+
+	g_variant_builder_init(&list, G_VARIANT_TYPE("aa{sv}"));
+	for (l = session->devs; l; l = l->next)
+		g_variant_builder_add_value(&list,
+			sr_dev_metrics_variant(l->data));
+	g_variant_builder_add(&builder, "{sv}", "devices",
+		g_variant_builder_end(&list));
+
+	g_variant_builder_init(&list, G_VARIANT_TYPE("aa{sv}"));
+	for (l = session->transforms; l; l = l->next) {
+		t = l->data;
+		g_variant_builder_init(&entry, G_VARIANT_TYPE_VARDICT);
+		g_variant_builder_add(&entry, "{sv}", "id",
+			g_variant_new_string(t->module->id));
+		g_variant_builder_add(&entry, "{sv}", "receive_us",
+			sr_metric_hist_variant(&t->receive_us));
+		g_variant_builder_add_value(&list,
+			g_variant_builder_end(&entry));
+	}
+	g_variant_builder_add(&builder, "{sv}", "transforms",
+		g_variant_builder_end(&list));
+
+	g_variant_builder_init(&list, G_VARIANT_TYPE("aa{sv}"));
+	index = 0;
+	for (l = session->datafeed_callbacks; l; l = l->next) {
+		cb_struct = l->data;
+		g_variant_builder_init(&entry, G_VARIANT_TYPE_VARDICT);
+		g_variant_builder_add(&entry, "{sv}", "index",
+			g_variant_new_uint32(index++));
+		g_variant_builder_add(&entry, "{sv}", "cb_us",
+			sr_metric_hist_variant(&cb_struct->cb_us));
+		g_variant_builder_add_value(&list,
+			g_variant_builder_end(&entry));
+	}
+	g_variant_builder_add(&builder, "{sv}", "callbacks",
+		g_variant_builder_end(&list));
+
+	*stats = g_variant_builder_end(&builder);
+
+	return SR_OK;
+}
+
+/**
+ * Set the interval of periodic metrics reports.
+ *
+ * While the session runs, each streaming device's metrics (see
+ * sr_session_stats_get()) get sent to the datafeed callbacks at this
+ * interval, as SR_CONF_SESSION_STATS in an SR_DF_META packet. Takes
+ * effect when the session gets started.
+ *
+ * @param session The session to use. Must not be NULL.
+ * @param interval_ms The interval in milliseconds, 0 disables the reports
+ *                    (the default).
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid argument.
+ *
+ * @since 0.6.0
+ */
+SR_API int sr_session_stats_interval_set(struct sr_session *session,
+		unsigned int interval_ms)
+{
+	if (!session) {
+		sr_err("%s: session was NULL", __func__);
+		return SR_ERR_ARG;
+	}
+	session->stats_interval_ms = interval_ms;
+
+	return SR_OK;
+}
+
+/**
+ * Enable the measurement of durations in the session's datafeed.
+ *
+ * Measuring the time spent in sr_session_send(), in transform modules
+ * and in datafeed callbacks ("send_us", "receive_us" and "cb_us", see
+ * sr_session_stats_get()) takes several clock reads per packet. This
+ * is only done when enabled here, or when periodic reports are enabled
+ * (see sr_session_stats_interval_set()). The counters of packets and
+ * bytes are always kept.
+ *
+ * @param session The session to use. Must not be NULL.
+ * @param enable TRUE to measure durations, FALSE (the default) to not.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid argument.
+ *
+ * @since 0.6.0
+ */
+SR_API int sr_session_stats_timing_set(struct sr_session *session,
+		gboolean enable)
+{
+	if (!session) {
+		sr_err("%s: session was NULL", __func__);
+		return SR_ERR_ARG;
+	}
+	session->stats_timing = enable;
+
+	return SR_OK;
+}
+
+/**
+ * Run each device of a session on its own dispatch thread.
+ *
+ * By default, the event sources of all devices run on the session's
+ * main context, so that a device which is slow to handle its events
+ * (like a polled SCPI instrument) delays the data of all others. With
+ * dispatch threads, each device gets a thread with its own GLib main
+ * context, which starts and stops the device's acquisition and runs
+ * its event sources. The session's main context still handles the
+ * session stop and the stats timer.
+ *
+ * Datafeed callbacks and transform modules then get called from the
+ * devices' threads. The session serializes the packets, so these never
+ * get called concurrently, except for the callbacks which were added
+ * with sr_session_datafeed_callback_add_concurrent().
+ *
+ * Takes effect when the session gets started.
+ *
+ * @param session The session to use. Must not be NULL.
+ * @param enable TRUE for a thread per device, FALSE (the default) to
+ *               run all devices on the session's main context.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid argument.
+ *
+ * @since 0.6.0
+ */
+SR_API int sr_session_device_threads_set(struct sr_session *session,
+		gboolean enable)
+{
+	if (!session) {
+		sr_err("%s: session was NULL", __func__);
+		return SR_ERR_ARG;
+	}
+	session->device_threads = enable;
+
+	return SR_OK;
+}
+
 /**
  * Debug helper.
  *
@@ -1108,6 +1810,69 @@ SR_PRIV int sr_session_send_meta(const struct sr_dev_inst *sdi,
 	return ret;
 }
 
+/* Which datafeed callbacks to run, see sr_session_send(). */
+enum callback_select {
+	CALLBACKS_ALL,
+	CALLBACKS_SERIALIZED,
+	CALLBACKS_CONCURRENT,
+};
+
+/* Whether the durations in the datafeed get measured. */
+static gboolean stats_timing(const struct sr_session *session)
+{
+	return session->stats_timing || session->stats_interval_ms;
+}
+
+/*
+ * Pass a packet to the datafeed callbacks. Returns the time when the
+ * last callback returned, now is the time before the first one (both
+ * are 0 when durations don't get measured).
+ */
+static int64_t datafeed_callbacks_run(struct sr_session *session,
+		const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *packet,
+		const struct sr_datafeed_timestamp *ts,
+		enum callback_select select, int64_t now)
+{
+	struct datafeed_callback *cb_struct;
+	GSList *l;
+	gboolean timing;
+	int64_t then;
+
+	timing = stats_timing(session);
+	for (l = session->datafeed_callbacks; l; l = l->next) {
+		cb_struct = l->data;
+		if (select == CALLBACKS_SERIALIZED && cb_struct->concurrent)
+			continue;
+		if (select == CALLBACKS_CONCURRENT && !cb_struct->concurrent)
+			continue;
+		if (sr_log_enabled(SR_LOG_DBG))
+			datafeed_dump(packet);
+		if (cb_struct->timed_cb)
+			cb_struct->timed_cb(sdi, packet, ts, cb_struct->cb_data);
+		else
+			cb_struct->cb(sdi, packet, cb_struct->cb_data);
+		if (!timing)
+			continue;
+		then = now;
+		now = g_get_monotonic_time();
+		sr_metric_hist_add(&cb_struct->cb_us, now - then);
+	}
+
+	return now;
+}
+
+static void merge_emit(const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *packet,
+		const struct sr_datafeed_timestamp *ts, void *cb_data)
+{
+	struct sr_session *session;
+
+	session = cb_data;
+	datafeed_callbacks_run(session, sdi, packet, ts, CALLBACKS_ALL,
+		stats_timing(session) ? g_get_monotonic_time() : 0);
+}
+
 /**
  * Send a packet to whatever is listening on the datafeed bus.
  *
@@ -1125,9 +1890,14 @@ SR_PRIV int sr_session_send(const struct sr_dev_inst *sdi,
 		const struct sr_datafeed_packet *packet)
 {
 	GSList *l;
-	struct datafeed_callback *cb_struct;
+	struct sr_session *session;
 	struct sr_datafeed_packet *packet_in, *packet_out;
+	struct sr_datafeed_timestamp ts, *tsp;
 	struct sr_transform *t;
+	struct sr_dev_metrics *metrics;
+	GMutex *feed_mutex;
+	gboolean deferred, timing;
+	int64_t start, then, now;
 	int ret;
 
 	if (!sdi) {
@@ -1145,18 +1915,51 @@ SR_PRIV int sr_session_send(const struct sr_dev_inst *sdi,
 		return SR_ERR_BUG;
 	}
 
+	session = sdi->session;
+	metrics = SR_DEV_METRICS(sdi);
+	sr_dev_metrics_packet(metrics, packet);
+	timing = stats_timing(session);
+	start = now = timing ? g_get_monotonic_time() : 0;
+
+	/*
+	 * With dispatch threads, this is where the devices' packets merge.
+	 * Transforms and callbacks get them one at a time, except for the
+	 * concurrent callbacks, which get them after the lock is released.
+	 * Transforms may reuse their output packet, and the time-ordered
+	 * merge delivers packets later, the concurrent callbacks can't run
+	 * unlocked then.
+	 */
+	feed_mutex = session->dev_threads ? &session->feed_mutex : NULL;
+	deferred = feed_mutex && !session->transforms && !session->merge;
+	if (feed_mutex)
+		g_mutex_lock(feed_mutex);
+
+	/* Timestamps refer to the samples as the driver sent them. */
+	tsp = NULL;
+	if (session->timed_callbacks || session->merge) {
+		sr_dev_timing_stamp(sdi, packet, &ts);
+		tsp = &ts;
+	}
+
 	/*
 	 * Pass the packet to the first transform module. If that returns
 	 * another packet (instead of NULL), pass that packet to the next
 	 * transform module in the list, and so on.
 	 */
 	packet_in = (struct sr_datafeed_packet *)packet;
-	for (l = sdi->session->transforms; l; l = l->next) {
+	for (l = session->transforms; l; l = l->next) {
 		t = l->data;
 		sr_spew("Running transform module '%s'.", t->module->id);
 		ret = t->module->receive(t, packet_in, &packet_out);
+		if (timing) {
+			then = now;
+			now = g_get_monotonic_time();
+			sr_metric_hist_add(&t->receive_us, now - then);
+		}
 		if (ret < 0) {
 			sr_err("Error while running transform module: %d.", ret);
+			if (feed_mutex)
+				g_mutex_unlock(feed_mutex);
 			return SR_ERR;
 		}
 		if (!packet_out) {
@@ -1165,6 +1968,10 @@ SR_PRIV int sr_session_send(const struct sr_dev_inst *sdi,
 			 * packet, abort.
 			 */
 			sr_spew("Transform module didn't return a packet, aborting.");
+			if (feed_mutex)
+				g_mutex_unlock(feed_mutex);
+			if (timing)
+				sr_metric_hist_add(&metrics->send_us, now - start);
 			return SR_OK;
 		} else {
 			/*
@@ -1178,16 +1985,27 @@ SR_PRIV int sr_session_send(const struct sr_dev_inst *sdi,
 
 	/*
 	 * If the last transform did output a packet, pass it to all datafeed
-	 * callbacks.
+	 * callbacks, or to the merge, which passes it on in time order.
 	 */
-	for (l = sdi->session->datafeed_callbacks; l; l = l->next) {
-		if (sr_log_loglevel_get() >= SR_LOG_DBG)
-			datafeed_dump(packet);
-		cb_struct = l->data;
-		cb_struct->cb(sdi, packet, cb_struct->cb_data);
+	ret = SR_OK;
+	if (session->merge) {
+		ret = sr_merge_push(session->merge, sdi, packet, tsp);
+		if (timing)
+			now = g_get_monotonic_time();
+	} else {
+		now = datafeed_callbacks_run(session, sdi, packet, tsp,
+			deferred ? CALLBACKS_SERIALIZED : CALLBACKS_ALL, now);
 	}
+	if (feed_mutex)
+		g_mutex_unlock(feed_mutex);
 
-	return SR_OK;
+	if (deferred)
+		now = datafeed_callbacks_run(session, sdi, packet, tsp,
+			CALLBACKS_CONCURRENT, now);
+	if (timing)
+		sr_metric_hist_add(&metrics->send_us, now - start);
+
+	return ret;
 }
 
 /**
@@ -1207,6 +2025,10 @@ SR_PRIV int sr_session_send(const struct sr_dev_inst *sdi,
 SR_PRIV int sr_session_source_add_internal(struct sr_session *session,
 		void *key, GSource *source)
 {
+	struct dev_thread *dt;
+	unsigned int id;
+
+	g_mutex_lock(&session->sources_mutex);
 	/*
 	 * This must not ever happen, since the source has already been
 	 * created and its finalize() method will remove the key for the
@@ -1214,12 +2036,20 @@ SR_PRIV int sr_session_source_add_internal(struct sr_session *session,
 	 * another sanity check there.)
 	 */
 	if (g_hash_table_contains(session->event_sources, key)) {
+		g_mutex_unlock(&session->sources_mutex);
 		sr_err("Event source with key %p already exists.", key);
 		return SR_ERR_BUG;
 	}
 	g_hash_table_insert(session->event_sources, key, source);
+	g_mutex_unlock(&session->sources_mutex);
 
-	if (session_source_attach(session, source) == 0)
+	/* Sources which a dispatch thread adds belong to its device. */
+	dt = g_private_get(&current_dev_thread);
+	if (dt && dt->session == session)
+		id = g_source_attach(source, dt->main_context);
+	else
+		id = session_source_attach(session, source);
+	if (id == 0)
 		return SR_ERR;
 
 	return SR_OK;
@@ -1357,7 +2187,12 @@ SR_PRIV int sr_session_source_remove_internal(struct sr_session *session,
 {
 	GSource *source;
 
+	g_mutex_lock(&session->sources_mutex);
 	source = g_hash_table_lookup(session->event_sources, key);
+	/* Keep it alive, its finalize() locks the table. */
+	if (source)
+		g_source_ref(source);
+	g_mutex_unlock(&session->sources_mutex);
 	/*
 	 * Trying to remove an already removed event source is problematic
 	 * since the poll_object handle may have been reused in the meantime.
@@ -1367,6 +2202,7 @@ SR_PRIV int sr_session_source_remove_internal(struct sr_session *session,
 		return SR_ERR_BUG;
 	}
 	g_source_destroy(source);
+	g_source_unref(source);
 
 	return SR_OK;
 }
@@ -1453,31 +2289,37 @@ SR_PRIV int sr_session_source_destroyed(struct sr_session *session,
 		void *key, GSource *source)
 {
 	GSource *registered_source;
+	int ret;
 
+	g_mutex_lock(&session->sources_mutex);
 	registered_source = g_hash_table_lookup(session->event_sources, key);
 	/*
 	 * Trying to remove an already removed event source is problematic
 	 * since the poll_object handle may have been reused in the meantime.
 	 */
 	if (!registered_source) {
+		g_mutex_unlock(&session->sources_mutex);
 		sr_err("No event source for key %p found.", key);
 		return SR_ERR_BUG;
 	}
 	if (registered_source != source) {
+		g_mutex_unlock(&session->sources_mutex);
 		sr_err("Event source for key %p does not match"
 			" destroyed source.", key);
 		return SR_ERR_BUG;
 	}
 	g_hash_table_remove(session->event_sources, key);
 
-	if (g_hash_table_size(session->event_sources) > 0)
-		return SR_OK;
-
 	/* If no event sources are left, consider the acquisition finished.
 	 * This is pretty crude, as it requires all event sources to be
 	 * registered via the libsigrok API.
 	 */
-	return stop_check_later(session);
+	ret = SR_OK;
+	if (g_hash_table_size(session->event_sources) == 0)
+		ret = stop_check_later(session);
+	g_mutex_unlock(&session->sources_mutex);
+
+	return ret;
 }
 
 static void copy_src(struct sr_config *src, struct sr_datafeed_meta *meta_copy)
@@ -1514,6 +2356,8 @@ SR_API int sr_packet_copy(const struct sr_datafeed_packet *packet,
 	switch (packet->type) {
 	case SR_DF_TRIGGER:
 	case SR_DF_END:
+	case SR_DF_FRAME_BEGIN:
+	case SR_DF_FRAME_END:
 		/* No payload. */
 		break;
 	case SR_DF_HEADER:
@@ -1524,7 +2368,7 @@ SR_API int sr_packet_copy(const struct sr_datafeed_packet *packet,
 	case SR_DF_META:
 		meta = packet->payload;
 		meta_copy = g_malloc0(sizeof(struct sr_datafeed_meta));
-		g_slist_foreach(meta->config, (GFunc)copy_src, meta_copy->config);
+		g_slist_foreach(meta->config, (GFunc)copy_src, meta_copy);
 		(*copy)->payload = meta_copy;
 		break;
 	case SR_DF_LOGIC:
@@ -1534,12 +2378,12 @@ SR_API int sr_packet_copy(const struct sr_datafeed_packet *packet,
 			return SR_ERR;
 		logic_copy->length = logic->length;
 		logic_copy->unitsize = logic->unitsize;
-		logic_copy->data = g_malloc(logic->length * logic->unitsize);
+		logic_copy->data = g_malloc(logic->length);
 		if (!logic_copy->data) {
 			g_free(logic_copy);
 			return SR_ERR;
 		}
-		memcpy(logic_copy->data, logic->data, logic->length * logic->unitsize);
+		memcpy(logic_copy->data, logic->data, logic->length);
 		(*copy)->payload = logic_copy;
 		break;
 	case SR_DF_ANALOG:
@@ -1585,6 +2429,8 @@ SR_API void sr_packet_free(struct sr_datafeed_packet *packet)
 	switch (packet->type) {
 	case SR_DF_TRIGGER:
 	case SR_DF_END:
+	case SR_DF_FRAME_BEGIN:
+	case SR_DF_FRAME_END:
 		/* No payload. */
 		break;
 	case SR_DF_HEADER:
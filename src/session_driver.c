@@ -36,6 +36,12 @@
 
 SR_PRIV struct sr_dev_driver session_driver_info;
 
+struct frame {
+	uint64_t start;
+	uint64_t count;
+	uint64_t trigger;
+};
+
 struct session_vdev {
 	char *sessionfile;
 	char *capturefile;
@@ -50,6 +56,19 @@ struct session_vdev {
 	GArray *analog_channels;
 	int cur_chunk;
 	gboolean finished;
+	/* Frame index of segmented captures. */
+	char *framefile;
+	struct frame *frames;
+	uint64_t num_frames;
+	uint64_t first_frame;
+	uint64_t limit_frames;
+	/* Selected frames and sample range, position in the capture file. */
+	uint64_t cur_frame, end_frame;
+	uint64_t range_start, range_end;
+	uint64_t pos;
+	gboolean in_frame;
+	gboolean trigger_sent;
+	gboolean pass_done;
 };
 
 static const uint32_t devopts[] = {
@@ -59,9 +78,189 @@ static const uint32_t devopts[] = {
 	SR_CONF_NUM_ANALOG_CHANNELS | SR_CONF_SET,
 	SR_CONF_SAMPLERATE | SR_CONF_GET | SR_CONF_SET,
 	SR_CONF_SESSIONFILE | SR_CONF_SET,
+	SR_CONF_CAPTURE_FRAMEFILE | SR_CONF_SET,
+	SR_CONF_CAPTURE_FRAMES | SR_CONF_GET,
+	SR_CONF_FIRST_FRAME | SR_CONF_GET | SR_CONF_SET,
+	SR_CONF_LIMIT_FRAMES | SR_CONF_GET | SR_CONF_SET,
 };
 
-static gboolean stream_session_data(struct sr_dev_inst *sdi)
+static int load_frames(struct session_vdev *vdev, struct zip *archive)
+{
+	struct zip_stat zs;
+	struct zip_file *zf;
+	struct frame *frame;
+	uint8_t *table, *p;
+	uint64_t i, count;
+	int64_t ret;
+
+	if (vdev->frames || !vdev->framefile)
+		return SR_OK;
+
+	if (zip_stat(archive, vdev->framefile, 0, &zs) < 0) {
+		sr_err("No frame index '%s' in session file '%s'.",
+			vdev->framefile, vdev->sessionfile);
+		return SR_ERR_DATA;
+	}
+	count = zs.size / SR_SESSIONFILE_FRAME_SIZE;
+	if (!count)
+		return SR_OK;
+	if (!(zf = zip_fopen(archive, vdev->framefile, 0)))
+		return SR_ERR;
+	table = g_malloc(count * SR_SESSIONFILE_FRAME_SIZE);
+	ret = zip_fread(zf, table, count * SR_SESSIONFILE_FRAME_SIZE);
+	zip_fclose(zf);
+	if (ret < 0 || (uint64_t)ret != count * SR_SESSIONFILE_FRAME_SIZE) {
+		sr_err("Failed to read frame index '%s'.", vdev->framefile);
+		g_free(table);
+		return SR_ERR_DATA;
+	}
+
+	vdev->frames = g_malloc(count * sizeof(vdev->frames[0]));
+	for (i = 0, p = table; i < count; i++) {
+		frame = &vdev->frames[i];
+		frame->start = RL64(&p[0]);
+		frame->count = RL64(&p[8]);
+		frame->trigger = RL64(&p[16]);
+		if (frame->trigger > frame->count)
+			frame->trigger = SR_SESSIONFILE_NO_TRIGGER;
+		p += SR_SESSIONFILE_FRAME_SIZE;
+	}
+	vdev->num_frames = count;
+	g_free(table);
+	sr_dbg("Loaded index of %" PRIu64 " frames.", count);
+
+	return SR_OK;
+}
+
+static void free_frames(struct session_vdev *vdev)
+{
+	g_free(vdev->frames);
+	vdev->frames = NULL;
+	vdev->num_frames = 0;
+}
+
+static size_t sample_size(const struct session_vdev *vdev)
+{
+	return vdev->cur_analog_channel ? sizeof(float) : vdev->unitsize;
+}
+
+/*
+ * Frame markers come with logic data, else with the first analog channel.
+ * The file's channels are streamed one after the other, so markers in
+ * each pass would repeat every frame. Later analog passes get the same
+ * range of samples, but no markers; receivers which need the frames of
+ * analog data have to take them from the logic (or first analog) pass.
+ */
+static gboolean send_markers(const struct session_vdev *vdev)
+{
+	return vdev->cur_analog_channel == (vdev->unitsize ? 0 : 1);
+}
+
+/*
+ * Prepare streaming a capture file: Without a selection of frames, all
+ * samples get sent. Otherwise only the range from the first selected
+ * frame's start to the last one's end.
+ */
+static void frames_rewind(struct session_vdev *vdev)
+{
+	const struct frame *last;
+	uint64_t first, end;
+
+	first = MIN(vdev->first_frame, vdev->num_frames);
+	end = vdev->num_frames;
+	if (vdev->limit_frames && vdev->limit_frames < end - first)
+		end = first + vdev->limit_frames;
+
+	vdev->cur_frame = first;
+	vdev->end_frame = end;
+	vdev->pos = 0;
+	vdev->in_frame = FALSE;
+	vdev->pass_done = FALSE;
+	vdev->range_start = 0;
+	vdev->range_end = UINT64_MAX;
+	if (vdev->num_frames && (vdev->first_frame || vdev->limit_frames)) {
+		if (first == end) {
+			vdev->range_end = 0;
+		} else {
+			last = &vdev->frames[end - 1];
+			vdev->range_start = vdev->frames[first].start;
+			vdev->range_end = last->start + last->count;
+		}
+	}
+}
+
+/*
+ * Send the frame markers at the current position. Returns the position
+ * of the next marker.
+ */
+static uint64_t frames_advance(const struct sr_dev_inst *sdi)
+{
+	struct session_vdev *vdev;
+	const struct frame *frame;
+
+	vdev = sdi->priv;
+
+	while (vdev->cur_frame < vdev->end_frame) {
+		frame = &vdev->frames[vdev->cur_frame];
+		if (!vdev->in_frame) {
+			if (vdev->pos < frame->start)
+				return frame->start;
+			std_session_send_df_frame_begin(sdi);
+			vdev->in_frame = TRUE;
+			vdev->trigger_sent =
+				frame->trigger == SR_SESSIONFILE_NO_TRIGGER;
+			continue;
+		}
+		if (!vdev->trigger_sent) {
+			if (vdev->pos < frame->start + frame->trigger)
+				return frame->start + frame->trigger;
+			std_session_send_df_trigger(sdi);
+			vdev->trigger_sent = TRUE;
+			continue;
+		}
+		if (vdev->pos < frame->start + frame->count)
+			return frame->start + frame->count;
+		std_session_send_df_frame_end(sdi);
+		vdev->in_frame = FALSE;
+		vdev->cur_frame++;
+	}
+
+	return UINT64_MAX;
+}
+
+/* Close a frame which is cut short by the end of the capture file. */
+static void frames_finish(const struct sr_dev_inst *sdi)
+{
+	struct session_vdev *vdev;
+
+	vdev = sdi->priv;
+
+	if (send_markers(vdev))
+		frames_advance(sdi);
+	if (vdev->in_frame) {
+		std_session_send_df_frame_end(sdi);
+		vdev->in_frame = FALSE;
+	}
+}
+
+/* Skip a whole chunk which precedes the selected frames. */
+static gboolean skip_chunk(struct session_vdev *vdev,
+	const struct zip_stat *zs)
+{
+	uint64_t count;
+
+	if (!sample_size(vdev))
+		return FALSE;
+	count = zs->size / sample_size(vdev);
+	if (vdev->pos + count > vdev->range_start)
+		return FALSE;
+	vdev->pos += count;
+
+	return TRUE;
+}
+
+static void send_samples(const struct sr_dev_inst *sdi,
+	void *buf, uint64_t count)
 {
 	struct session_vdev *vdev;
 	struct sr_datafeed_packet packet;
@@ -70,6 +269,71 @@ static gboolean stream_session_data(struct sr_dev_inst *sdi)
 	struct sr_analog_encoding encoding;
 	struct sr_analog_meaning meaning;
 	struct sr_analog_spec spec;
+
+	vdev = sdi->priv;
+
+	if (vdev->cur_analog_channel != 0) {
+		packet.type = SR_DF_ANALOG;
+		packet.payload = &analog;
+		/* TODO: Use proper 'digits' value for this device (and its modes). */
+		sr_analog_init(&analog, &encoding, &meaning, &spec, 2);
+		analog.meaning->channels = g_slist_prepend(NULL,
+				g_array_index(vdev->analog_channels,
+					struct sr_channel *, vdev->cur_analog_channel - 1));
+		analog.num_samples = count;
+		analog.meaning->mq = SR_MQ_VOLTAGE;
+		analog.meaning->unit = SR_UNIT_VOLT;
+		analog.meaning->mqflags = SR_MQFLAG_DC;
+		analog.data = buf;
+	} else {
+		packet.type = SR_DF_LOGIC;
+		packet.payload = &logic;
+		logic.length = count * vdev->unitsize;
+		logic.unitsize = vdev->unitsize;
+		logic.data = buf;
+	}
+	vdev->bytes_read += count * sample_size(vdev);
+	sr_session_send(sdi, &packet);
+}
+
+/*
+ * Send a block of samples, split at frame boundaries. Samples outside
+ * of the selected frames are skipped.
+ */
+static void send_frames(const struct sr_dev_inst *sdi,
+	uint8_t *buf, size_t len)
+{
+	struct session_vdev *vdev;
+	uint64_t count, next, n;
+	size_t size;
+
+	vdev = sdi->priv;
+	size = sample_size(vdev);
+	count = len / size;
+
+	while (count && !vdev->pass_done) {
+		if (vdev->pos < vdev->range_start) {
+			n = MIN(count, vdev->range_start - vdev->pos);
+		} else {
+			next = vdev->range_end;
+			if (send_markers(vdev))
+				next = MIN(next, frames_advance(sdi));
+			if (vdev->pos >= vdev->range_end) {
+				vdev->pass_done = TRUE;
+				break;
+			}
+			n = MIN(count, next - vdev->pos);
+			send_samples(sdi, buf, n);
+		}
+		buf += n * size;
+		count -= n;
+		vdev->pos += n;
+	}
+}
+
+static gboolean stream_session_data(struct sr_dev_inst *sdi)
+{
+	struct session_vdev *vdev;
 	struct zip_stat zs;
 	int ret, got_data;
 	char capturefile[128];
@@ -95,6 +359,8 @@ static gboolean stream_session_data(struct sr_dev_inst *sdi)
 				snprintf(capturefile, sizeof(capturefile) - 1, "%s-1", vdev->capturefile);
 				if (zip_stat(vdev->archive, capturefile, 0, &zs) != -1) {
 					vdev->cur_chunk = 1;
+					if (skip_chunk(vdev, &zs))
+						return TRUE;
 					if (!(vdev->capfile = zip_fopen(vdev->archive,
 							capturefile, 0)))
 						return FALSE;
@@ -110,16 +376,21 @@ static gboolean stream_session_data(struct sr_dev_inst *sdi)
 			vdev->cur_chunk++;
 			snprintf(capturefile, sizeof(capturefile) - 1, "%s-%d", vdev->capturefile,
 					vdev->cur_chunk);
-			if (zip_stat(vdev->archive, capturefile, 0, &zs) != -1) {
+			if (!vdev->pass_done &&
+					zip_stat(vdev->archive, capturefile, 0, &zs) != -1) {
+				if (skip_chunk(vdev, &zs))
+					return TRUE;
 				if (!(vdev->capfile = zip_fopen(vdev->archive,
 						capturefile, 0)))
 					return FALSE;
 				sr_dbg("Opened %s.", capturefile);
 			} else if (vdev->cur_analog_channel < vdev->num_analog_channels) {
+				frames_finish(sdi);
 				vdev->capturefile = g_strdup_printf("analog-1-%d",
 						vdev->num_logic_channels + vdev->cur_analog_channel + 1);
 				vdev->cur_analog_channel++;
 				vdev->cur_chunk = 0;
+				frames_rewind(vdev);
 				return TRUE;
 			} else {
 				/* We got all the chunks, finish up. */
@@ -152,28 +423,13 @@ static gboolean stream_session_data(struct sr_dev_inst *sdi)
 	if (ret > 0) {
 		if (vdev->cur_analog_channel != 0) {
 			got_data = TRUE;
-			packet.type = SR_DF_ANALOG;
-			packet.payload = &analog;
-			/* TODO: Use proper 'digits' value for this device (and its modes). */
-			sr_analog_init(&analog, &encoding, &meaning, &spec, 2);
-			analog.meaning->channels = g_slist_prepend(NULL,
-					g_array_index(vdev->analog_channels,
-						struct sr_channel *, vdev->cur_analog_channel - 1));
-			analog.num_samples = ret / sizeof(float);
-			analog.meaning->mq = SR_MQ_VOLTAGE;
-			analog.meaning->unit = SR_UNIT_VOLT;
-			analog.meaning->mqflags = SR_MQFLAG_DC;
-			analog.data = (float *) buf;
+			send_frames(sdi, buf, ret);
 		} else if (vdev->unitsize) {
 			got_data = TRUE;
 			if (ret % vdev->unitsize != 0)
 				sr_warn("Read size %d not a multiple of the"
 					" unit size %d.", ret, vdev->unitsize);
-			packet.type = SR_DF_LOGIC;
-			packet.payload = &logic;
-			logic.length = ret;
-			logic.unitsize = vdev->unitsize;
-			logic.data = buf;
+			send_frames(sdi, buf, ret);
 		} else {
 			/*
 			 * Neither analog data, nor logic which has
@@ -181,9 +437,11 @@ static gboolean stream_session_data(struct sr_dev_inst *sdi)
 			 */
 			sr_warn("Neither analog nor logic data. Ignoring.");
 		}
-		if (got_data) {
-			vdev->bytes_read += ret;
-			sr_session_send(sdi, &packet);
+		if (vdev->pass_done) {
+			/* Past the selected frames, skip remaining chunks. */
+			zip_fclose(vdev->capfile);
+			vdev->capfile = NULL;
+			got_data = vdev->cur_chunk != 0;
 		}
 	} else {
 		/* done with this capture file */
@@ -225,6 +483,7 @@ static int receive_data(int fd, int revents, void *cb_data)
 		vdev->archive = NULL;
 	}
 
+	frames_finish(sdi);
 	std_session_send_df_end(sdi);
 
 	return G_SOURCE_REMOVE;
@@ -252,6 +511,8 @@ static int dev_close(struct sr_dev_inst *sdi)
 	const struct session_vdev *const vdev = sdi->priv;
 	g_free(vdev->sessionfile);
 	g_free(vdev->capturefile);
+	g_free(vdev->framefile);
+	g_free(vdev->frames);
 
 	g_free(sdi->priv);
 	sdi->priv = NULL;
@@ -263,6 +524,8 @@ static int config_get(uint32_t key, GVariant **data,
 	const struct sr_dev_inst *sdi, const struct sr_channel_group *cg)
 {
 	struct session_vdev *vdev;
+	struct zip *archive;
+	int ret;
 
 	(void)cg;
 
@@ -278,6 +541,23 @@ static int config_get(uint32_t key, GVariant **data,
 	case SR_CONF_CAPTURE_UNITSIZE:
 		*data = g_variant_new_uint64(vdev->unitsize);
 		break;
+	case SR_CONF_CAPTURE_FRAMES:
+		if (vdev->framefile && !vdev->frames) {
+			if (!(archive = zip_open(vdev->sessionfile, 0, NULL)))
+				return SR_ERR;
+			ret = load_frames(vdev, archive);
+			zip_discard(archive);
+			if (ret != SR_OK)
+				return ret;
+		}
+		*data = g_variant_new_uint64(vdev->num_frames);
+		break;
+	case SR_CONF_FIRST_FRAME:
+		*data = g_variant_new_uint64(vdev->first_frame);
+		break;
+	case SR_CONF_LIMIT_FRAMES:
+		*data = g_variant_new_uint64(vdev->limit_frames);
+		break;
 	default:
 		return SR_ERR_NA;
 	}
@@ -312,6 +592,17 @@ static int config_set(uint32_t key, GVariant *data,
 	case SR_CONF_CAPTURE_UNITSIZE:
 		vdev->unitsize = g_variant_get_uint64(data);
 		break;
+	case SR_CONF_CAPTURE_FRAMEFILE:
+		g_free(vdev->framefile);
+		vdev->framefile = g_strdup(g_variant_get_string(data, NULL));
+		free_frames(vdev);
+		break;
+	case SR_CONF_FIRST_FRAME:
+		vdev->first_frame = g_variant_get_uint64(data);
+		break;
+	case SR_CONF_LIMIT_FRAMES:
+		vdev->limit_frames = g_variant_get_uint64(data);
+		break;
 	case SR_CONF_NUM_LOGIC_CHANNELS:
 		vdev->num_logic_channels = g_variant_get_int32(data);
 		break;
@@ -360,6 +651,13 @@ static int dev_acquisition_start(const struct sr_dev_inst *sdi)
 		return SR_ERR;
 	}
 
+	if ((ret = load_frames(vdev, vdev->archive)) != SR_OK) {
+		zip_discard(vdev->archive);
+		vdev->archive = NULL;
+		return ret;
+	}
+	frames_rewind(vdev);
+
 	std_session_send_df_header(sdi);
 
 	/* freewheeling source */
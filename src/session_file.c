@@ -290,6 +290,17 @@ SR_API int sr_session_load(struct sr_context *ctx, const char *filename,
 					g_free(val);
 					sr_config_set(sdi, NULL, SR_CONF_SAMPLERATE,
 							g_variant_new_uint64(tmp_u64));
+				} else if (!strcmp(keys[j], "framefile")) {
+					val = g_key_file_get_string(kf, sections[i],
+							keys[j], &error);
+					if (!sdi || !val) {
+						g_free(val);
+						ret = SR_ERR_DATA;
+						break;
+					}
+					sr_config_set(sdi, NULL, SR_CONF_CAPTURE_FRAMEFILE,
+							g_variant_new_string(val));
+					g_free(val);
 				} else if (!strcmp(keys[j], "unitsize") && file_has_logic) {
 					unitsize = g_key_file_get_integer(kf, sections[i],
 							keys[j], &error);
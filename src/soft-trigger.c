@@ -18,6 +18,7 @@
  */
 
 #include <config.h>
+#include <inttypes.h>
 #include <string.h>
 #include <libsigrok/libsigrok.h>
 #include "libsigrok-internal.h"
@@ -41,6 +42,32 @@ SR_PRIV int logic_channel_unitsize(GSList *channels)
 	return (number + 7) / 8;
 }
 
+/*
+ * Add the statistics since the last call to the device's metrics (see
+ * sr_session_stats_get()). Counting happens in the soft trigger, only
+ * the totals are published, once per buffer.
+ */
+static void stats_publish(struct soft_trigger_logic *stl)
+{
+	struct soft_trigger_stats *st, *pub, *m;
+
+	st = &stl->stats;
+	pub = &stl->published;
+	m = &SR_DEV_METRICS(stl->sdi)->soft_trigger;
+	st->fill_bytes = stl->pre_trigger_fill + stl->retained_bytes;
+
+	sr_metric_add(&m->bytes_copied, st->bytes_copied - pub->bytes_copied);
+	sr_metric_add(&m->bytes_retained,
+		st->bytes_retained - pub->bytes_retained);
+	sr_metric_add(&m->buffers_retained,
+		st->buffers_retained - pub->buffers_retained);
+	sr_metric_add(&m->bytes_dropped, st->bytes_dropped - pub->bytes_dropped);
+	sr_metric_add(&m->bytes_sent, st->bytes_sent - pub->bytes_sent);
+	sr_metric_add(&m->triggers, st->triggers - pub->triggers);
+	sr_metric_set(&m->fill_bytes, st->fill_bytes);
+	*pub = *st;
+}
+
 SR_PRIV struct soft_trigger_logic *soft_trigger_logic_new(
 		const struct sr_dev_inst *sdi, struct sr_trigger *trigger,
 		int pre_trigger_samples)
@@ -51,6 +78,10 @@ SR_PRIV struct soft_trigger_logic *soft_trigger_logic_new(
 	stl->sdi = sdi;
 	stl->trigger = trigger;
 	stl->unitsize = logic_channel_unitsize(sdi->channels);
+	if (sr_trigger_compile(trigger, stl->unitsize, &stl->compiled) != SR_OK) {
+		soft_trigger_logic_free(stl);
+		return NULL;
+	}
 	stl->prev_sample = g_malloc0(stl->unitsize);
 	stl->pre_trigger_size = stl->unitsize * pre_trigger_samples;
 	stl->pre_trigger_buffer = g_try_malloc(stl->pre_trigger_size);
@@ -75,21 +106,119 @@ SR_PRIV struct soft_trigger_logic *soft_trigger_logic_new(
 
 SR_PRIV void soft_trigger_logic_free(struct soft_trigger_logic *stl)
 {
+	const struct soft_trigger_stats *st;
+
+	st = &stl->stats;
+	if (st->triggers || st->bytes_copied || st->bytes_retained) {
+		sr_dbg("Pre-trigger: %" PRIu64 " bytes copied, %" PRIu64
+			" bytes retained in %" PRIu64 " buffers, %" PRIu64
+			" bytes dropped, %" PRIu64 " bytes sent on %" PRIu64
+			" triggers.", st->bytes_copied, st->bytes_retained,
+			st->buffers_retained, st->bytes_dropped, st->bytes_sent,
+			st->triggers);
+	}
+
+	soft_trigger_logic_release_buffers(stl);
+	sr_trigger_compiled_free(stl->compiled);
+	g_free(stl->retained);
 	g_free(stl->pre_trigger_buffer);
 	g_free(stl->prev_sample);
 	g_free(stl);
 }
 
+/**
+ * Have the soft trigger keep the driver's buffers for pre-trigger data.
+ *
+ * Buffers passed to soft_trigger_logic_check_buffer() which don't contain
+ * the trigger are kept instead of copied, as long as their data is part of
+ * the pre-trigger window. Only when more than max_buffers are needed, the
+ * data of the oldest one gets copied. The release callback is invoked when
+ * a buffer is no longer needed, from within the soft trigger calls.
+ */
+SR_PRIV void soft_trigger_logic_retain_buffers(struct soft_trigger_logic *stl,
+		size_t max_buffers, soft_trigger_release_cb release, void *cb_data)
+{
+	soft_trigger_logic_release_buffers(stl);
+	g_free(stl->retained);
+	stl->retained = NULL;
+	stl->retained_max = 0;
+	if (!release || !max_buffers || !stl->pre_trigger_size)
+		return;
+
+	stl->retained = g_malloc0_n(max_buffers, sizeof(stl->retained[0]));
+	stl->retained_max = max_buffers;
+	stl->release = release;
+	stl->release_cb_data = cb_data;
+}
+
+/* Remove the oldest retained buffer, and hand it back to the driver. */
+static void release_oldest(struct soft_trigger_logic *stl)
+{
+	struct soft_trigger_buffer *b;
+
+	b = &stl->retained[stl->retained_first];
+	stl->retained_first = (stl->retained_first + 1) % stl->retained_max;
+	stl->retained_count--;
+	stl->retained_bytes -= b->len;
+	stl->release(b->handle, stl->release_cb_data);
+}
+
+/**
+ * Hand all retained buffers back to the driver, dropping their data.
+ *
+ * Drivers need to call this when the acquisition gets aborted. The
+ * callbacks may free the soft trigger, it is not accessed after the
+ * last one returned.
+ */
+SR_PRIV void soft_trigger_logic_release_buffers(struct soft_trigger_logic *stl)
+{
+	struct soft_trigger_buffer *b;
+	soft_trigger_release_cb release;
+	void *handles[16], *cb_data;
+	size_t count, i;
+	gboolean last;
+
+	release = stl->release;
+	cb_data = stl->release_cb_data;
+	while (stl->retained_count) {
+		/* Detach a number of buffers before calling back. */
+		count = MIN(stl->retained_count, G_N_ELEMENTS(handles));
+		for (i = 0; i < count; i++) {
+			b = &stl->retained[stl->retained_first];
+			handles[i] = b->handle;
+			stl->stats.bytes_dropped += b->len;
+			stl->retained_bytes -= b->len;
+			stl->retained_first = (stl->retained_first + 1) %
+				stl->retained_max;
+		}
+		stl->retained_count -= count;
+		last = !stl->retained_count;
+		if (last)
+			stats_publish(stl);
+		for (i = 0; i < count; i++)
+			release(handles[i], cb_data);
+		if (last)
+			return;
+	}
+}
+
 static void pre_trigger_append(struct soft_trigger_logic *stl,
-		uint8_t *buf, int len)
+		const uint8_t *buf, int len)
 {
+	int overflow;
+
 	/* Avoid uselessly copying more than the pre-trigger size. */
 	if (len > stl->pre_trigger_size) {
+		stl->stats.bytes_dropped += len - stl->pre_trigger_size;
 		buf += len - stl->pre_trigger_size;
 		len = stl->pre_trigger_size;
 	}
+	stl->stats.bytes_copied += len;
 
 	/* Update the filling level of the pre-trigger circular buffer. */
+	overflow = stl->pre_trigger_fill + len - stl->pre_trigger_size;
+	if (overflow > 0)
+		stl->stats.bytes_dropped += overflow;
 	stl->pre_trigger_fill = MIN(stl->pre_trigger_fill + len,
 	                            stl->pre_trigger_size);
 
@@ -107,110 +236,143 @@ static void pre_trigger_append(struct soft_trigger_logic *stl,
 	}
 }
 
-static void pre_trigger_send(struct soft_trigger_logic *stl,
-		int *pre_trigger_samples)
+/* Keep a buffer which doesn't contain the trigger for pre-trigger data. */
+static void pre_trigger_retain(struct soft_trigger_logic *stl,
+		const uint8_t *buf, int len, void *handle)
+{
+	struct soft_trigger_buffer *b;
+	size_t idx;
+
+	/* Copy the oldest buffer when the driver needs its buffers back. */
+	while (stl->retained_count >= stl->retained_max) {
+		b = &stl->retained[stl->retained_first];
+		pre_trigger_append(stl, b->data, b->len);
+		release_oldest(stl);
+	}
+
+	idx = (stl->retained_first + stl->retained_count) % stl->retained_max;
+	b = &stl->retained[idx];
+	b->data = buf;
+	b->len = len;
+	b->handle = handle;
+	stl->retained_count++;
+	stl->retained_bytes += len;
+	stl->stats.bytes_retained += len;
+	stl->stats.buffers_retained++;
+
+	/*
+	 * Buffers which are older than the pre-trigger window are not
+	 * needed, neither is the copied data which is older still.
+	 */
+	while (stl->retained_bytes - stl->retained[stl->retained_first].len >=
+			(size_t)stl->pre_trigger_size) {
+		stl->stats.bytes_dropped += stl->pre_trigger_fill +
+			stl->retained[stl->retained_first].len;
+		stl->pre_trigger_fill = 0;
+		stl->pre_trigger_head = stl->pre_trigger_buffer;
+		release_oldest(stl);
+	}
+}
+
+/* Send data, after skipping the given number of leading bytes. */
+static void send_skipped(struct soft_trigger_logic *stl,
+		const uint8_t *data, size_t len, size_t *skip)
 {
 	struct sr_datafeed_packet packet;
 	struct sr_datafeed_logic logic;
+	size_t n;
+
+	n = MIN(*skip, len);
+	*skip -= n;
+	data += n;
+	len -= n;
+	if (!len)
+		return;
 
 	packet.type = SR_DF_LOGIC;
 	packet.payload = &logic;
 	logic.unitsize = stl->unitsize;
+	logic.length = len;
+	logic.data = (void *)data;
+	sr_session_send(stl->sdi, &packet);
+	stl->stats.bytes_sent += len;
+}
 
-	if (pre_trigger_samples)
-		*pre_trigger_samples = 0;
+/*
+ * Send the pre-trigger window: the last pre_trigger_size bytes of the
+ * copied data, the retained buffers, and the current buffer's data
+ * before the trigger. Retained buffers are handed back afterwards.
+ */
+static void pre_trigger_send(struct soft_trigger_logic *stl,
+		const uint8_t *buf, int len, int *pre_trigger_samples)
+{
+	const struct soft_trigger_buffer *b;
+	const uint8_t *oldest;
+	size_t total, sent, skip, i, size;
+
+	total = stl->pre_trigger_fill + stl->retained_bytes + len;
+	sent = MIN(total, (size_t)stl->pre_trigger_size);
+	skip = total - sent;
+	stl->stats.bytes_dropped += skip;
+	stl->stats.triggers++;
 
-	/* If pre-trigger buffer not full, rewind head to the first valid sample. */
+	/* Copied data, starting with the oldest, which may wrap around. */
 	if (stl->pre_trigger_fill < stl->pre_trigger_size)
-		stl->pre_trigger_head = stl->pre_trigger_buffer;
+		oldest = stl->pre_trigger_buffer;
+	else
+		oldest = stl->pre_trigger_head;
+	size = MIN((size_t)(stl->pre_trigger_buffer + stl->pre_trigger_size -
+		oldest), (size_t)stl->pre_trigger_fill);
+	send_skipped(stl, oldest, size, &skip);
+	send_skipped(stl, stl->pre_trigger_buffer,
+		stl->pre_trigger_fill - size, &skip);
+	stl->pre_trigger_fill = 0;
+	stl->pre_trigger_head = stl->pre_trigger_buffer;
 
-	/* Send logic packets for the pre-trigger circular buffer content. */
-	while (stl->pre_trigger_fill > 0) {
-		size_t size = MIN(stl->pre_trigger_buffer + stl->pre_trigger_size
-		                  - stl->pre_trigger_head, stl->pre_trigger_fill);
-		logic.length = size;
-		logic.data = stl->pre_trigger_head;
-		sr_session_send(stl->sdi, &packet);
-		stl->pre_trigger_head = stl->pre_trigger_buffer;
-		stl->pre_trigger_fill -= size;
-		if (pre_trigger_samples)
-			*pre_trigger_samples += size / stl->unitsize;
+	for (i = 0; i < stl->retained_count; i++) {
+		b = &stl->retained[(stl->retained_first + i) % stl->retained_max];
+		send_skipped(stl, b->data, b->len, &skip);
 	}
-}
+	send_skipped(stl, buf, len, &skip);
 
-static gboolean logic_check_match(struct soft_trigger_logic *stl,
-		uint8_t *sample, struct sr_trigger_match *match)
-{
-	int bit, prev_bit;
-	gboolean result;
-
-	stl->count++;
-	result = FALSE;
-	bit = *(sample + match->channel->index / 8)
-			& (1 << (match->channel->index % 8));
-	if (match->match == SR_TRIGGER_ZERO)
-		result = bit == 0;
-	else if (match->match == SR_TRIGGER_ONE)
-		result = bit != 0;
-	else {
-		/* Edge matches. */
-		if (stl->count == 1)
-			/* First sample, don't have enough for an edge match yet. */
-			return FALSE;
-		prev_bit = *(stl->prev_sample + match->channel->index / 8)
-				& (1 << (match->channel->index % 8));
-		if (match->match == SR_TRIGGER_RISING)
-			result = prev_bit == 0 && bit != 0;
-		else if (match->match == SR_TRIGGER_FALLING)
-			result = prev_bit != 0 && bit == 0;
-		else if (match->match == SR_TRIGGER_EDGE)
-			result = prev_bit != bit;
-	}
+	if (pre_trigger_samples)
+		*pre_trigger_samples = sent / stl->unitsize;
 
-	return result;
+	while (stl->retained_count)
+		release_oldest(stl);
 }
 
-/* Returns the offset (in samples) within buf of where the trigger
- * occurred, or -1 if not triggered. */
-SR_PRIV int soft_trigger_logic_check(struct soft_trigger_logic *stl,
-		uint8_t *buf, int len, int *pre_trigger_samples)
+static int check_buffer(struct soft_trigger_logic *stl,
+		uint8_t *buf, int len, int *pre_trigger_samples,
+		void *handle, gboolean *retained)
 {
-	struct sr_trigger_stage *stage;
-	struct sr_trigger_match *match;
-	GSList *l, *l_stage;
+	const struct sr_trigger_compiled *tc;
+	const uint8_t *prev;
 	int offset;
 	int i;
 	gboolean match_found;
 
+	if (retained)
+		*retained = FALSE;
+	tc = stl->compiled;
 	offset = -1;
 	for (i = 0; i < len; i += stl->unitsize) {
-		l_stage = g_slist_nth(stl->trigger->stages, stl->cur_stage);
-		stage = l_stage->data;
-		if (!stage->matches)
-			/* No matches supplied, client error. */
-			return SR_ERR_ARG;
-
-		match_found = TRUE;
-		for (l = stage->matches; l; l = l->next) {
-			match = l->data;
-			if (!match->channel->enabled)
-				/* Ignore disabled channels with a trigger. */
-				continue;
-			if (!logic_check_match(stl, buf + i, match)) {
-				match_found = FALSE;
-				break;
-			}
-		}
-		memcpy(stl->prev_sample, buf + i, stl->unitsize);
+		/* The previous sample is in the buffer, except for the first. */
+		if (i > 0)
+			prev = buf + i - stl->unitsize;
+		else
+			prev = stl->have_prev ? stl->prev_sample : NULL;
+		match_found = sr_trigger_compiled_match(tc, stl->cur_stage,
+			buf + i, prev);
+		stl->have_prev = TRUE;
 		if (match_found) {
 			/* Matched on the current stage. */
-			if (l_stage->next) {
+			if ((size_t)stl->cur_stage + 1 < tc->num_stages) {
 				/* Advance to next stage. */
 				stl->cur_stage++;
 			} else {
 				/* Matched on last stage, send pre-trigger data. */
-				pre_trigger_append(stl, buf, i);
-				pre_trigger_send(stl, pre_trigger_samples);
+				pre_trigger_send(stl, buf, i, pre_trigger_samples);
 
 				/* Fire trigger. */
 				offset = i / stl->unitsize;
@@ -229,15 +391,52 @@ SR_PRIV int soft_trigger_logic_check(struct soft_trigger_logic *stl,
 			 * takes care of.
 			 */
 			i -= stl->cur_stage * stl->unitsize;
-			if (i < -1)
-				i = -1; /* Oops, went back past this buffer. */
+			if (i < -stl->unitsize)
+				i = -stl->unitsize; /* Oops, went back past this buffer. */
 			/* Reset trigger stage. */
 			stl->cur_stage = 0;
 		}
 	}
 
-	if (offset == -1)
-		pre_trigger_append(stl, buf, len);
+	if (len >= stl->unitsize) {
+		if (offset == -1)
+			i = len - stl->unitsize;
+		memcpy(stl->prev_sample, buf + i, stl->unitsize);
+	}
+
+	if (offset == -1 && stl->pre_trigger_size > 0) {
+		if (handle && stl->retained_max) {
+			pre_trigger_retain(stl, buf, len, handle);
+			*retained = TRUE;
+		} else {
+			pre_trigger_append(stl, buf, len);
+		}
+	}
+	if (stl->pre_trigger_size > 0)
+		stats_publish(stl);
 
 	return offset;
 }
+
+/* Returns the offset (in samples) within buf of where the trigger
+ * occurred, or -1 if not triggered. */
+SR_PRIV int soft_trigger_logic_check(struct soft_trigger_logic *stl,
+		uint8_t *buf, int len, int *pre_trigger_samples)
+{
+	return check_buffer(stl, buf, len, pre_trigger_samples, NULL, NULL);
+}
+
+/*
+ * Like soft_trigger_logic_check(), for drivers which had the soft trigger
+ * retain their buffers. When *retained is set on return, the soft trigger
+ * keeps the buffer, and hands the handle to the release callback once
+ * the buffer is no longer needed. Otherwise the buffer remains with the
+ * caller, this is always the case when the trigger was found.
+ */
+SR_PRIV int soft_trigger_logic_check_buffer(struct soft_trigger_logic *stl,
+		uint8_t *buf, int len, int *pre_trigger_samples,
+		void *handle, gboolean *retained)
+{
+	return check_buffer(stl, buf, len, pre_trigger_samples,
+		handle, retained);
+}
@@ -0,0 +1,451 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 libsigrok contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Datafeed packet timestamps, and the merge of several devices' packets
+ * in time order.
+ *
+ * A timestamp holds the index of the packet's first sample, and the host
+ * time when that sample was acquired. Without a samplerate, that is the
+ * time when the packet was sent. With a samplerate, it gets computed from
+ * the sample index, relative to the start of the acquisition, or to the
+ * last point in time which the driver synchronized with its hardware's
+ * timing (sr_dev_timing_sync()).
+ *
+ * Drivers which send analog channels in separate packets send a round of
+ * packets for the same samples. All packets of a round get the same
+ * index, a round starts with the channel which the first packet had.
+ */
+
+#include <config.h>
+#include <string.h>
+#include <glib.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+
+/** @cond PRIVATE */
+#define LOG_PREFIX "timing"
+/** @endcond */
+
+/* A packet waiting in the merge. */
+struct merge_entry {
+	struct sr_datafeed_packet *packet;
+	struct sr_datafeed_timestamp ts;
+	/* Order of arrival, which breaks ties between equal times. */
+	uint64_t seq;
+	/* Whether packet is a copy, the sender's packet otherwise. */
+	gboolean owned;
+};
+
+/* The merge's queue of a device. */
+struct merge_dev {
+	const struct sr_dev_inst *sdi;
+	GQueue queue;
+	/* Sent SR_DF_END, will not send older packets. */
+	gboolean ended;
+};
+
+struct sr_merge {
+	int64_t window_us;
+	sr_merge_emit_callback emit;
+	void *cb_data;
+	/* List of struct merge_dev pointers. */
+	GSList *devs;
+	/* Newest timestamp which the merge got. */
+	int64_t newest_us;
+	uint64_t seq;
+};
+
+static int64_t sample_time(const struct sr_dev_timing *t, uint64_t sample)
+{
+	double offset;
+
+	if (!t->samplerate)
+		return g_get_monotonic_time();
+
+	offset = ((double)sample - (double)t->sync_sample) * 1e6 / t->samplerate;
+
+	return t->sync_us + (int64_t)offset;
+}
+
+/* The end of the samples which the device sent. */
+static uint64_t timing_position(const struct sr_dev_timing *t)
+{
+	return MAX(t->logic_sample, t->analog_sample + t->analog_len);
+}
+
+static void timing_start(struct sr_dev_timing *t)
+{
+	uint64_t samplerate;
+
+	/* Keep the samplerate from sr_dev_timing_prepare(). */
+	samplerate = t->samplerate;
+	memset(t, 0, sizeof(*t));
+	t->samplerate = samplerate;
+	t->sync_us = g_get_monotonic_time();
+}
+
+static void timing_meta(struct sr_dev_timing *t,
+		const struct sr_datafeed_meta *meta)
+{
+	const struct sr_config *src;
+	uint64_t position;
+	GSList *l;
+
+	for (l = meta->config; l; l = l->next) {
+		src = l->data;
+		if (src->key != SR_CONF_SAMPLERATE)
+			continue;
+		/* Following samples are relative to the change. */
+		position = timing_position(t);
+		t->sync_us = sample_time(t, position);
+		t->sync_sample = position;
+		t->samplerate = g_variant_get_uint64(src->data);
+	}
+}
+
+/**
+ * Get a device's samplerate for its timestamps, before it starts its
+ * acquisition.
+ *
+ * Drivers rarely send their samplerate, so it gets asked for here.
+ * Asking during the acquisition (from the datafeed) would interfere
+ * with drivers which talk to their device to answer.
+ *
+ * @param sdi The device instance.
+ *
+ * @private
+ */
+SR_PRIV void sr_dev_timing_prepare(const struct sr_dev_inst *sdi)
+{
+	struct sr_dev_timing *t;
+	GVariant *gvar;
+
+	t = SR_DEV_TIMING(sdi);
+	t->samplerate = 0;
+	if (!sdi->driver || !sr_dev_has_option(sdi, SR_CONF_SAMPLERATE))
+		return;
+	if (!(sr_dev_config_capabilities_list(sdi, NULL,
+			SR_CONF_SAMPLERATE) & SR_CONF_GET))
+		return;
+	if (sr_config_get(sdi->driver, sdi, NULL, SR_CONF_SAMPLERATE,
+			&gvar) != SR_OK)
+		return;
+	t->samplerate = g_variant_get_uint64(gvar);
+	g_variant_unref(gvar);
+}
+
+/**
+ * Get the timestamp of a packet which a device sends, and advance the
+ * device's sample position past the packet's samples.
+ *
+ * @param sdi The device instance which sends the packet.
+ * @param packet The packet, as the driver sent it.
+ * @param[out] ts The timestamp.
+ *
+ * @private
+ */
+SR_PRIV void sr_dev_timing_stamp(const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *packet,
+		struct sr_datafeed_timestamp *ts)
+{
+	struct sr_dev_timing *t;
+	const struct sr_datafeed_logic *logic;
+	const struct sr_datafeed_analog *analog;
+	const struct sr_channel *ch;
+	uint64_t sample;
+
+	t = SR_DEV_TIMING(sdi);
+	switch (packet->type) {
+	case SR_DF_HEADER:
+		timing_start(t);
+		sample = 0;
+		break;
+	case SR_DF_META:
+		timing_meta(t, packet->payload);
+		sample = timing_position(t);
+		break;
+	case SR_DF_LOGIC:
+		logic = packet->payload;
+		sample = t->logic_sample;
+		if (logic->unitsize)
+			t->logic_sample += logic->length / logic->unitsize;
+		break;
+	case SR_DF_ANALOG:
+		analog = packet->payload;
+		ch = analog->meaning->channels ?
+			analog->meaning->channels->data : NULL;
+		if (!t->analog_seen) {
+			t->analog_seen = TRUE;
+			t->analog_ch = ch;
+		} else if (ch == t->analog_ch) {
+			t->analog_sample += t->analog_len;
+		}
+		t->analog_len = analog->num_samples;
+		sample = t->analog_sample;
+		break;
+	default:
+		sample = timing_position(t);
+		break;
+	}
+
+	ts->sample = sample;
+	ts->time_us = sample_time(t, sample);
+	ts->hw_timed = t->hw_timed;
+}
+
+/**
+ * Synchronize a device's timestamps with its hardware's timing.
+ *
+ * Drivers which know when the samples which they sent so far ended
+ * (like at the completion of a streaming transfer) call this after
+ * sending them. Timestamps of the following packets get computed from
+ * this point. Has no effect on devices without a samplerate.
+ *
+ * @param sdi The device instance.
+ * @param time_us The host time when the last sample which the device
+ *                sent got acquired, see g_get_monotonic_time().
+ *
+ * @private
+ */
+SR_PRIV void sr_dev_timing_sync(const struct sr_dev_inst *sdi,
+		int64_t time_us)
+{
+	struct sr_session *session;
+	struct sr_dev_timing *t;
+	GMutex *feed_mutex;
+
+	/* Timestamps get computed with the feed mutex held. */
+	session = sdi->session;
+	feed_mutex = session && session->dev_threads ?
+		&session->feed_mutex : NULL;
+	if (feed_mutex)
+		g_mutex_lock(feed_mutex);
+
+	t = SR_DEV_TIMING(sdi);
+	t->sync_sample = timing_position(t);
+	t->sync_us = time_us;
+	t->hw_timed = TRUE;
+
+	if (feed_mutex)
+		g_mutex_unlock(feed_mutex);
+}
+
+/**
+ * Create a merge of devices' packets.
+ *
+ * Packets get passed on in the order of their timestamps. A packet waits
+ * until each device which may still send older packets sent a packet,
+ * but no longer than the window: Once the merge got a packet which is
+ * window_us newer, it is passed on.
+ *
+ * @param window_us The longest time a packet waits for other devices.
+ * @param emit The function which gets the packets in time order.
+ * @param cb_data Data for emit.
+ *
+ * @private
+ */
+SR_PRIV struct sr_merge *sr_merge_new(uint64_t window_us,
+		sr_merge_emit_callback emit, void *cb_data)
+{
+	struct sr_merge *merge;
+
+	merge = g_malloc0(sizeof(struct sr_merge));
+	merge->window_us = MIN(window_us, G_MAXINT64);
+	merge->emit = emit;
+	merge->cb_data = cb_data;
+	merge->newest_us = G_MININT64;
+
+	return merge;
+}
+
+static struct merge_dev *merge_dev_find(struct sr_merge *merge,
+		const struct sr_dev_inst *sdi)
+{
+	struct merge_dev *md;
+	GSList *l;
+
+	for (l = merge->devs; l; l = l->next) {
+		md = l->data;
+		if (md->sdi == sdi)
+			return md;
+	}
+
+	return NULL;
+}
+
+/**
+ * Add a device to a merge. Until the device sends its first packet,
+ * packets of other devices wait for it.
+ *
+ * @private
+ */
+SR_PRIV void sr_merge_dev_add(struct sr_merge *merge,
+		const struct sr_dev_inst *sdi)
+{
+	struct merge_dev *md;
+
+	if (merge_dev_find(merge, sdi))
+		return;
+
+	md = g_malloc0(sizeof(struct merge_dev));
+	md->sdi = sdi;
+	g_queue_init(&md->queue);
+	merge->devs = g_slist_append(merge->devs, md);
+}
+
+static void merge_entry_free(struct merge_entry *entry)
+{
+	if (entry->owned)
+		sr_packet_free(entry->packet);
+	g_free(entry);
+}
+
+/*
+ * Pass on packets in time order, as long as no device which may still
+ * send older packets holds them up. With all set, pass on all packets.
+ */
+static void merge_drain(struct sr_merge *merge, gboolean all)
+{
+	struct merge_dev *md, *oldest;
+	struct merge_entry *entry, *head;
+	gboolean waiting;
+	GSList *l;
+
+	while (TRUE) {
+		oldest = NULL;
+		head = NULL;
+		waiting = FALSE;
+		for (l = merge->devs; l; l = l->next) {
+			md = l->data;
+			entry = g_queue_peek_head(&md->queue);
+			if (!entry) {
+				if (!md->ended)
+					waiting = TRUE;
+				continue;
+			}
+			if (!head || entry->ts.time_us < head->ts.time_us ||
+					(entry->ts.time_us == head->ts.time_us &&
+					entry->seq < head->seq)) {
+				oldest = md;
+				head = entry;
+			}
+		}
+		if (!head)
+			break;
+		if (waiting && !all &&
+				merge->newest_us - head->ts.time_us < merge->window_us)
+			break;
+
+		g_queue_pop_head(&oldest->queue);
+		merge->emit(oldest->sdi, head->packet, &head->ts,
+			merge->cb_data);
+		merge_entry_free(head);
+	}
+}
+
+/**
+ * Add a packet to a merge, and pass on the packets which are due.
+ *
+ * @param merge The merge.
+ * @param sdi The device instance which sent the packet.
+ * @param packet The packet. Gets copied if it has to wait.
+ * @param ts The packet's timestamp.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR The packet could not be copied.
+ *
+ * @private
+ */
+SR_PRIV int sr_merge_push(struct sr_merge *merge,
+		const struct sr_dev_inst *sdi,
+		const struct sr_datafeed_packet *packet,
+		const struct sr_datafeed_timestamp *ts)
+{
+	struct merge_dev *md;
+	struct merge_entry *entry;
+
+	if (!(md = merge_dev_find(merge, sdi))) {
+		sr_merge_dev_add(merge, sdi);
+		md = merge_dev_find(merge, sdi);
+	}
+	if (packet->type == SR_DF_HEADER)
+		md->ended = FALSE;
+
+	/* No copy yet, most packets get passed on right away. */
+	entry = g_malloc(sizeof(struct merge_entry));
+	entry->packet = (struct sr_datafeed_packet *)packet;
+	entry->ts = *ts;
+	entry->seq = merge->seq++;
+	entry->owned = FALSE;
+	g_queue_push_tail(&md->queue, entry);
+	if (packet->type == SR_DF_END)
+		md->ended = TRUE;
+	merge->newest_us = MAX(merge->newest_us, ts->time_us);
+
+	merge_drain(merge, FALSE);
+
+	/* Still waiting, keep a copy, the sender reuses its packet. */
+	if (g_queue_is_empty(&md->queue))
+		return SR_OK;
+	entry = g_queue_peek_tail(&md->queue);
+	if (sr_packet_copy(packet, &entry->packet) != SR_OK) {
+		sr_err("Cannot copy packet of type %d.", packet->type);
+		g_queue_pop_tail(&md->queue);
+		g_free(entry);
+		return SR_ERR;
+	}
+	entry->owned = TRUE;
+
+	return SR_OK;
+}
+
+/**
+ * Pass on all packets which wait in a merge.
+ *
+ * @private
+ */
+SR_PRIV void sr_merge_flush(struct sr_merge *merge)
+{
+	merge_drain(merge, TRUE);
+}
+
+/**
+ * Free a merge, and the packets which wait in it.
+ *
+ * @private
+ */
+SR_PRIV void sr_merge_free(struct sr_merge *merge)
+{
+	struct merge_dev *md;
+	struct merge_entry *entry;
+	GSList *l;
+
+	if (!merge)
+		return;
+
+	for (l = merge->devs; l; l = l->next) {
+		md = l->data;
+		while ((entry = g_queue_pop_head(&md->queue)))
+			merge_entry_free(entry);
+		g_free(md);
+	}
+	g_slist_free(merge->devs);
+	g_free(merge);
+}
@@ -18,6 +18,7 @@
  */
 
 #include <config.h>
+#include <string.h>
 #include <libsigrok/libsigrok.h>
 #include "libsigrok-internal.h"
 
@@ -178,4 +179,170 @@ SR_API int sr_trigger_match_add(struct sr_trigger_stage *stage,
 	return SR_OK;
 }
 
+/**
+ * Compile the logic channel matches of a trigger to bit masks.
+ *
+ * The result has one set of masks per stage, which checks all matches of
+ * the stage at once, see sr_trigger_compiled_match(). Matches on disabled
+ * channels and on non-logic channels are ignored.
+ *
+ * @param[in] trigger The trigger to compile. Must not be NULL.
+ * @param[in] unitsize The size of a logic sample in bytes. Channel N is
+ *   bit N % 8 of byte N / 8 in the sample.
+ * @param[out] compiled The compiled trigger. Must be freed with
+ *   sr_trigger_compiled_free().
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid arguments, no stages, a stage without
+ *   matches, or a channel which does not fit the unit size.
+ *
+ * @private
+ */
+SR_API int sr_trigger_compile(const struct sr_trigger *trigger,
+		size_t unitsize, struct sr_trigger_compiled **compiled)
+{
+	struct sr_trigger_compiled *tc;
+	const struct sr_trigger_stage *stage;
+	const struct sr_trigger_match *match;
+	struct sr_trigger_masks *masks;
+	const GSList *l, *m;
+	size_t stage_idx, index;
+	uint64_t bit;
+
+	if (!trigger || !unitsize || !compiled)
+		return SR_ERR_ARG;
+	*compiled = NULL;
+	if (!trigger->stages) {
+		sr_err("Trigger has no stages.");
+		return SR_ERR_ARG;
+	}
+
+	tc = g_malloc0(sizeof(*tc));
+	tc->num_stages = g_slist_length(trigger->stages);
+	tc->num_words = (unitsize + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+	tc->unitsize = unitsize;
+	tc->masks = g_malloc0_n(tc->num_stages * tc->num_words,
+		sizeof(tc->masks[0]));
+
+	stage_idx = 0;
+	for (l = trigger->stages; l; l = l->next, stage_idx++) {
+		stage = l->data;
+		if (!stage->matches) {
+			sr_err("Trigger stage %zu has no matches.", stage_idx);
+			sr_trigger_compiled_free(tc);
+			return SR_ERR_ARG;
+		}
+		for (m = stage->matches; m; m = m->next) {
+			match = m->data;
+			if (!match->channel->enabled)
+				continue;
+			if (match->channel->type != SR_CHANNEL_LOGIC)
+				continue;
+			index = match->channel->index;
+			if (index >= unitsize * 8) {
+				sr_err("Trigger channel %s exceeds the sample size.",
+					match->channel->name);
+				sr_trigger_compiled_free(tc);
+				return SR_ERR_ARG;
+			}
+			masks = &tc->masks[stage_idx * tc->num_words + index / 64];
+			bit = UINT64_C(1) << (index % 64);
+			switch (match->match) {
+			case SR_TRIGGER_ZERO:
+				masks->zeros |= bit;
+				break;
+			case SR_TRIGGER_ONE:
+				masks->ones |= bit;
+				break;
+			case SR_TRIGGER_RISING:
+				masks->rising |= bit;
+				break;
+			case SR_TRIGGER_FALLING:
+				masks->falling |= bit;
+				break;
+			case SR_TRIGGER_EDGE:
+				masks->edges |= bit;
+				break;
+			default:
+				continue;
+			}
+			if (match->match != SR_TRIGGER_ZERO &&
+					match->match != SR_TRIGGER_ONE)
+				tc->has_edges = TRUE;
+		}
+	}
+	*compiled = tc;
+
+	return SR_OK;
+}
+
+/**
+ * Free a compiled trigger.
+ *
+ * @param[in] tc The compiled trigger. Can be NULL.
+ *
+ * @private
+ */
+SR_API void sr_trigger_compiled_free(struct sr_trigger_compiled *tc)
+{
+	if (!tc)
+		return;
+	g_free(tc->masks);
+	g_free(tc);
+}
+
+/* Load up to eight bytes of a sample, channel N to bit N. */
+static uint64_t load_sample_word(const uint8_t *sample, size_t len)
+{
+	uint64_t w;
+
+	w = 0;
+	memcpy(&w, sample, MIN(len, sizeof(w)));
+
+	return GUINT64_FROM_LE(w);
+}
+
+/**
+ * Check whether a sample matches a stage of a compiled trigger.
+ *
+ * @param[in] tc The compiled trigger.
+ * @param[in] stage The stage to check.
+ * @param[in] sample The sample, unitsize bytes.
+ * @param[in] prev The previous sample, or NULL when there is none. Edge
+ *   matches never match without a previous sample.
+ *
+ * @return TRUE when all of the stage's matches are met.
+ *
+ * @private
+ */
+SR_API gboolean sr_trigger_compiled_match(const struct sr_trigger_compiled *tc,
+		size_t stage, const uint8_t *sample, const uint8_t *prev)
+{
+	const struct sr_trigger_masks *masks;
+	uint64_t cur_word, prev_word, mismatch;
+	size_t word, offset;
+
+	masks = &tc->masks[stage * tc->num_words];
+	if (!prev && tc->has_edges) {
+		for (word = 0; word < tc->num_words; word++) {
+			if (masks[word].rising | masks[word].falling |
+					masks[word].edges)
+				return FALSE;
+		}
+	}
+
+	mismatch = 0;
+	for (word = 0; word < tc->num_words; word++) {
+		offset = word * sizeof(uint64_t);
+		cur_word = load_sample_word(sample + offset,
+			tc->unitsize - offset);
+		prev_word = prev ? load_sample_word(prev + offset,
+			tc->unitsize - offset) : 0;
+		mismatch |= sr_trigger_masks_mismatch(&masks[word],
+			cur_word, prev_word);
+	}
+
+	return mismatch == 0;
+}
+
 /** @} */
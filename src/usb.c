@@ -507,6 +507,27 @@ SR_PRIV int usb_get_port_path(libusb_device *dev, char *path, int path_len)
 	return SR_OK;
 }
 
+/**
+ * Get the location of a USB device instance, for the tracking of images
+ * loaded into the device (see sr_resource_image_loaded()). The location
+ * combines the physical port with the device address, so it changes
+ * when the device re-enumerates.
+ *
+ * @param sdi The USB device instance. Must not be NULL.
+ *
+ * @return The location string, to be freed with g_free().
+ */
+SR_PRIV char *sr_usb_location(const struct sr_dev_inst *sdi)
+{
+	const struct sr_usb_dev_inst *usb;
+
+	usb = sdi->conn;
+
+	return g_strdup_printf("%s@%d.%d",
+		sdi->connection_id ? sdi->connection_id : "usb",
+		usb->bus, usb->address);
+}
+
 /**
  * Check the USB configuration to determine if this device has a given
  * manufacturer and product string.
@@ -550,3 +571,546 @@ SR_PRIV gboolean usb_match_manuf_prod(libusb_device *dev,
 
 	return ret;
 }
+
+/*
+ * USB bulk IN streams.
+ *
+ * Streaming logic analyzers keep a number of bulk transfers in flight,
+ * and resubmit each transfer after its data was handled. The stream
+ * owns the transfers and their buffers, and keeps them in a pool which
+ * is reused across acquisitions. Buffers are page aligned, or device
+ * memory (zero-copy) where the platform supports it.
+ *
+ * The number of transfers in flight and the transfer size start from
+ * the driver's parameters, and grow at runtime: When completions find
+ * (almost) no transfers left in flight, the host did not keep up with
+ * resubmission, and another transfer gets added. When the driver's
+ * callback takes a large part of a transfer's duration, transfers get
+ * larger, to reduce the per-transfer overhead.
+ */
+
+/* Alignment of transfer buffers. */
+#define STREAM_BUFFER_ALIGN	4096
+
+struct usb_stream_xfer {
+	struct sr_usb_stream *stream;
+	struct libusb_transfer *transfer;
+	uint8_t *buffer;
+	size_t buffer_size;
+	gboolean dev_mem;
+	gboolean active;
+	gboolean in_flight;
+	gboolean held;
+	int64_t submitted_us;
+};
+
+struct sr_usb_stream {
+	struct sr_usb_dev_inst *usb;
+	/* All transfers, active or not. */
+	GPtrArray *xfers;
+
+	struct sr_usb_stream_params params;
+	sr_usb_stream_callback cb;
+	void *cb_data;
+
+	size_t transfer_size;
+	size_t max_transfer_size;
+	unsigned int depth;
+	unsigned int active;
+	unsigned int in_flight;
+	/* Active transfers which the driver holds, see sr_usb_stream_hold(). */
+	unsigned int held;
+	unsigned int timeout;
+	gboolean cancelled;
+
+	struct sr_usb_stream_stats stats;
+};
+
+static uint8_t *stream_buffer_alloc(struct sr_usb_stream *stream,
+	struct usb_stream_xfer *xfer, size_t size)
+{
+	void *buf;
+
+#ifdef HAVE_LIBUSB_DEV_MEM_ALLOC
+	if (stream->params.dev_mem) {
+		buf = libusb_dev_mem_alloc(stream->usb->devhdl, size);
+		if (buf) {
+			xfer->dev_mem = TRUE;
+			return buf;
+		}
+	}
+#else
+	(void)stream;
+#endif
+	xfer->dev_mem = FALSE;
+#ifdef HAVE_POSIX_MEMALIGN
+	if (posix_memalign(&buf, STREAM_BUFFER_ALIGN, size) != 0)
+		buf = NULL;
+#else
+	buf = g_try_malloc(size);
+#endif
+
+	return buf;
+}
+
+static void stream_buffer_free(struct sr_usb_stream *stream,
+	struct usb_stream_xfer *xfer)
+{
+	if (!xfer->buffer)
+		return;
+
+#ifdef HAVE_LIBUSB_DEV_MEM_ALLOC
+	if (xfer->dev_mem)
+		libusb_dev_mem_free(stream->usb->devhdl,
+			xfer->buffer, xfer->buffer_size);
+#else
+	(void)stream;
+#endif
+	if (!xfer->dev_mem) {
+#ifdef HAVE_POSIX_MEMALIGN
+		free(xfer->buffer);
+#else
+		g_free(xfer->buffer);
+#endif
+	}
+	xfer->buffer = NULL;
+	xfer->buffer_size = 0;
+}
+
+static void stream_update_timeout(struct sr_usb_stream *stream)
+{
+	uint64_t total_size, timeout;
+
+	/* Leave a headroom of 25% on the time to fill all transfers. */
+	total_size = (uint64_t)stream->transfer_size * stream->depth;
+	timeout = total_size / MAX(stream->params.bytes_per_ms, 1);
+	timeout += timeout / 4;
+	/* libusb takes a timeout of 0 as no timeout at all. */
+	stream->timeout = MAX(timeout, 1);
+}
+
+static void LIBUSB_CALL stream_transfer_done(struct libusb_transfer *transfer)
+{
+	struct usb_stream_xfer *xfer;
+	struct sr_usb_stream *stream;
+	struct sr_usb_stream_stats *stats;
+	struct sr_dev_metrics *metrics;
+	int64_t now, latency, handler;
+	uint64_t duration_us;
+
+	xfer = transfer->user_data;
+	stream = xfer->stream;
+	stats = &stream->stats;
+
+	now = g_get_monotonic_time();
+	xfer->in_flight = FALSE;
+	stream->in_flight--;
+
+	latency = now - xfer->submitted_us;
+	if (!stats->transfers || (uint64_t)latency < stats->latency_min_us)
+		stats->latency_min_us = latency;
+	if ((uint64_t)latency > stats->latency_max_us)
+		stats->latency_max_us = latency;
+	stats->latency_sum_us += latency;
+	stats->transfers++;
+	stats->bytes += transfer->actual_length;
+	if (!transfer->actual_length)
+		stats->empty_transfers++;
+
+	if ((metrics = stream->params.metrics)) {
+		sr_metric_add(&metrics->transfers, 1);
+		sr_metric_add(&metrics->transfer_bytes, transfer->actual_length);
+		if (!transfer->actual_length)
+			sr_metric_add(&metrics->empty_transfers, 1);
+		if (transfer->status != LIBUSB_TRANSFER_COMPLETED &&
+				transfer->status != LIBUSB_TRANSFER_CANCELLED)
+			sr_metric_add(&metrics->failed_transfers, 1);
+		sr_metric_hist_add(&metrics->transfer_latency_us, latency);
+	}
+
+	/* Grow the queue when the host got behind with resubmission. */
+	if (!stream->cancelled && stream->in_flight * 4 < stream->depth) {
+		stats->starved++;
+		if (metrics)
+			sr_metric_add(&metrics->starved, 1);
+		if (stream->depth < stream->params.limit_transfers) {
+			stream->depth++;
+			stream_update_timeout(stream);
+			sr_dbg("Stream starved, %u transfers in flight.",
+				stream->depth);
+		}
+	}
+
+	stream->cb(stream, transfer, stream->cb_data);
+
+	/*
+	 * Grow transfers when handling takes more than a quarter of the
+	 * time it takes to fill a transfer.
+	 */
+	handler = g_get_monotonic_time() - now;
+	if ((uint64_t)handler > stats->handler_max_us)
+		stats->handler_max_us = handler;
+	stats->handler_sum_us += handler;
+	duration_us = stream->transfer_size * 1000 /
+		MAX(stream->params.bytes_per_ms, 1);
+	if (!stream->cancelled && (uint64_t)handler * 4 > duration_us &&
+			stream->transfer_size < stream->max_transfer_size) {
+		stream->transfer_size = MIN(stream->transfer_size * 2,
+			stream->max_transfer_size);
+		stream_update_timeout(stream);
+		sr_dbg("Handler is slow, transfer size is now %zu.",
+			stream->transfer_size);
+	}
+}
+
+static struct usb_stream_xfer *stream_xfer_get(struct sr_usb_stream *stream)
+{
+	struct usb_stream_xfer *xfer;
+	unsigned int i;
+
+	for (i = 0; i < stream->xfers->len; i++) {
+		xfer = g_ptr_array_index(stream->xfers, i);
+		if (!xfer->active)
+			return xfer;
+	}
+
+	xfer = g_malloc0(sizeof(*xfer));
+	xfer->stream = stream;
+	xfer->transfer = libusb_alloc_transfer(0);
+	if (!xfer->transfer) {
+		g_free(xfer);
+		return NULL;
+	}
+	g_ptr_array_add(stream->xfers, xfer);
+
+	return xfer;
+}
+
+static int stream_xfer_submit(struct sr_usb_stream *stream,
+	struct usb_stream_xfer *xfer)
+{
+	int ret;
+
+	/* The buffer may need to grow, after transfers grew. */
+	if (xfer->buffer_size < stream->transfer_size) {
+		stream_buffer_free(stream, xfer);
+		xfer->buffer = stream_buffer_alloc(stream, xfer,
+			stream->transfer_size);
+		if (!xfer->buffer) {
+			sr_err("USB transfer buffer malloc failed.");
+			return SR_ERR_MALLOC;
+		}
+		xfer->buffer_size = stream->transfer_size;
+	}
+
+	libusb_fill_bulk_transfer(xfer->transfer, stream->usb->devhdl,
+		stream->params.endpoint, xfer->buffer, stream->transfer_size,
+		stream_transfer_done, xfer, stream->timeout);
+	xfer->submitted_us = g_get_monotonic_time();
+	if ((ret = libusb_submit_transfer(xfer->transfer)) != 0) {
+		sr_err("Failed to submit transfer: %s.", libusb_error_name(ret));
+		return SR_ERR;
+	}
+	xfer->in_flight = TRUE;
+	stream->in_flight++;
+
+	return SR_OK;
+}
+
+/* Submit transfers from the pool until the desired depth is reached. */
+static int stream_fill(struct sr_usb_stream *stream)
+{
+	struct usb_stream_xfer *xfer;
+	int ret;
+
+	while (stream->active - stream->held < stream->depth) {
+		if (!(xfer = stream_xfer_get(stream)))
+			return SR_ERR_MALLOC;
+		if ((ret = stream_xfer_submit(stream, xfer)) != SR_OK)
+			return ret;
+		xfer->active = TRUE;
+		stream->active++;
+	}
+
+	return SR_OK;
+}
+
+/**
+ * Create a USB bulk IN stream.
+ *
+ * @param usb The USB device which the stream reads from.
+ *
+ * @return The stream, to be freed with sr_usb_stream_free().
+ *
+ * @private
+ */
+SR_PRIV struct sr_usb_stream *sr_usb_stream_new(struct sr_usb_dev_inst *usb)
+{
+	struct sr_usb_stream *stream;
+
+	stream = g_malloc0(sizeof(*stream));
+	stream->usb = usb;
+	stream->xfers = g_ptr_array_new();
+
+	return stream;
+}
+
+/**
+ * Free a USB stream and its pool of transfers.
+ *
+ * Must not be called while transfers are active, and must be called
+ * before the USB device gets closed.
+ *
+ * @param stream The stream to free. Can be NULL.
+ *
+ * @private
+ */
+SR_PRIV void sr_usb_stream_free(struct sr_usb_stream *stream)
+{
+	struct usb_stream_xfer *xfer;
+	unsigned int i;
+
+	if (!stream)
+		return;
+
+	if (stream->active)
+		sr_err("Freeing stream with %u active transfers.", stream->active);
+	for (i = 0; i < stream->xfers->len; i++) {
+		xfer = g_ptr_array_index(stream->xfers, i);
+		stream_buffer_free(stream, xfer);
+		libusb_free_transfer(xfer->transfer);
+		g_free(xfer);
+	}
+	g_ptr_array_free(stream->xfers, TRUE);
+	g_free(stream);
+}
+
+/**
+ * Start streaming, submit the initial set of transfers.
+ *
+ * The callback receives each completed transfer. It must hand the
+ * transfer back by means of either sr_usb_stream_resubmit() or
+ * sr_usb_stream_release().
+ *
+ * @param stream The stream.
+ * @param params The stream's parameters.
+ * @param cb The callback for completed transfers.
+ * @param cb_data Data for the callback.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_ARG Invalid arguments, or the stream is still active.
+ * @retval SR_ERR_MALLOC Out of memory.
+ * @retval SR_ERR Submission failed. Transfers which were submitted
+ *   before the failure remain active, the caller should cancel them.
+ *
+ * @private
+ */
+SR_PRIV int sr_usb_stream_start(struct sr_usb_stream *stream,
+		const struct sr_usb_stream_params *params,
+		sr_usb_stream_callback cb, void *cb_data)
+{
+	size_t align, size;
+	unsigned int depth;
+
+	if (!stream || !params || !cb || stream->active)
+		return SR_ERR_ARG;
+
+	stream->params = *params;
+	stream->cb = cb;
+	stream->cb_data = cb_data;
+	stream->cancelled = FALSE;
+	memset(&stream->stats, 0, sizeof(stream->stats));
+
+	align = MAX(params->align, 1);
+	size = params->transfer_ms * params->bytes_per_ms;
+	size = MAX((size + align - 1) / align * align, align);
+	stream->transfer_size = size;
+	stream->max_transfer_size = size * MAX(params->max_size_factor, 1);
+
+	depth = params->total_ms * params->bytes_per_ms / size;
+	depth = CLAMP(depth, 1, MAX(params->max_transfers, 1));
+	stream->depth = depth;
+	if (stream->params.limit_transfers < depth)
+		stream->params.limit_transfers = depth;
+	stream_update_timeout(stream);
+
+	sr_dbg("Starting stream, %u transfers of %zu bytes.",
+		stream->depth, stream->transfer_size);
+
+	return stream_fill(stream);
+}
+
+/**
+ * Resubmit a completed transfer.
+ *
+ * The transfer gets the current transfer size. When the stream grew,
+ * additional transfers get submitted as well.
+ *
+ * @param stream The stream.
+ * @param transfer The completed transfer.
+ *
+ * @retval SR_OK Success.
+ * @retval SR_ERR_NA The stream was cancelled.
+ * @retval other Submission failed. The caller still owns the transfer,
+ *   and should release it.
+ *
+ * @private
+ */
+SR_PRIV int sr_usb_stream_resubmit(struct sr_usb_stream *stream,
+		struct libusb_transfer *transfer)
+{
+	struct usb_stream_xfer *xfer;
+	int ret;
+
+	xfer = transfer->user_data;
+	if (stream->cancelled)
+		return SR_ERR_NA;
+	if (xfer->held) {
+		xfer->held = FALSE;
+		stream->held--;
+		/* It was replaced, return it to the pool unless needed. */
+		if (stream->active - stream->held - 1 >= stream->depth) {
+			xfer->active = FALSE;
+			stream->active--;
+			return SR_OK;
+		}
+	}
+	if ((ret = stream_xfer_submit(stream, xfer)) != SR_OK)
+		return ret;
+	if (stream->params.metrics)
+		sr_metric_add(&stream->params.metrics->resubmits, 1);
+	if (stream_fill(stream) != SR_OK)
+		sr_warn("Cannot add transfers to the stream.");
+
+	return SR_OK;
+}
+
+/**
+ * Release a completed transfer, it returns to the stream's pool.
+ *
+ * @param stream The stream.
+ * @param transfer The completed transfer.
+ *
+ * @return The number of transfers which remain active. The stream has
+ *   ended when this is zero.
+ *
+ * @private
+ */
+SR_PRIV unsigned int sr_usb_stream_release(struct sr_usb_stream *stream,
+		struct libusb_transfer *transfer)
+{
+	struct usb_stream_xfer *xfer;
+
+	xfer = transfer->user_data;
+	if (xfer->held) {
+		xfer->held = FALSE;
+		stream->held--;
+	}
+	if (xfer->active) {
+		xfer->active = FALSE;
+		stream->active--;
+	}
+
+	return stream->active;
+}
+
+/**
+ * Hold on to a completed transfer, to hand it back later.
+ *
+ * Drivers which keep a transfer's data for a while (like pre-trigger
+ * data) hold the transfer. It no longer counts towards the transfers
+ * in flight, and another one gets submitted in its place. The held
+ * transfer is handed back with sr_usb_stream_resubmit() (which returns
+ * it to the pool when the stream has enough transfers in flight), or
+ * sr_usb_stream_release().
+ *
+ * @param stream The stream.
+ * @param transfer The completed transfer.
+ *
+ * @private
+ */
+SR_PRIV void sr_usb_stream_hold(struct sr_usb_stream *stream,
+		struct libusb_transfer *transfer)
+{
+	struct usb_stream_xfer *xfer;
+
+	xfer = transfer->user_data;
+	if (!xfer->active || xfer->held)
+		return;
+	xfer->held = TRUE;
+	stream->held++;
+	if (!stream->cancelled && stream_fill(stream) != SR_OK)
+		sr_warn("Cannot add transfers to the stream.");
+}
+
+/**
+ * Cancel all transfers in flight.
+ *
+ * The cancelled transfers still get passed to the callback, which
+ * should release them.
+ *
+ * @param stream The stream.
+ *
+ * @private
+ */
+SR_PRIV void sr_usb_stream_cancel(struct sr_usb_stream *stream)
+{
+	struct usb_stream_xfer *xfer;
+	unsigned int i;
+
+	if (!stream)
+		return;
+
+	stream->cancelled = TRUE;
+	for (i = 0; i < stream->xfers->len; i++) {
+		xfer = g_ptr_array_index(stream->xfers, i);
+		if (xfer->in_flight)
+			libusb_cancel_transfer(xfer->transfer);
+	}
+}
+
+/**
+ * Get the timeout which covers filling all transfers in flight.
+ *
+ * @param stream The stream.
+ *
+ * @return The timeout in milliseconds.
+ *
+ * @private
+ */
+SR_PRIV unsigned int sr_usb_stream_timeout(const struct sr_usb_stream *stream)
+{
+	return stream->timeout;
+}
+
+/**
+ * Get the number of transfers which the stream keeps in flight.
+ *
+ * The number grows while the stream adapts to the host's latency.
+ *
+ * @param stream The stream.
+ *
+ * @return The current number of transfers in flight.
+ *
+ * @private
+ */
+SR_PRIV unsigned int sr_usb_stream_depth(const struct sr_usb_stream *stream)
+{
+	return stream->depth;
+}
+
+/**
+ * Get the stream's timing statistics.
+ *
+ * @param stream The stream.
+ * @param[out] stats The statistics since the stream was started.
+ *
+ * @private
+ */
+SR_PRIV void sr_usb_stream_get_stats(const struct sr_usb_stream *stream,
+		struct sr_usb_stream_stats *stats)
+{
+	*stats = stream->stats;
+	stats->transfers_in_flight = stream->depth;
+	stats->transfer_size = stream->transfer_size;
+}
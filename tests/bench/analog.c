@@ -0,0 +1,226 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 libsigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Analog conversion benchmark.
+ *
+ * Runs sr_analog_to_float() on one packet of samples in each of the
+ * encodings which drivers and input modules commonly use, and the
+ * analog to logic conversions (sr_a2l_threshold() for float and integer
+ * input, sr_a2l_schmitt_trigger()). Items are samples, bytes are the
+ * size of the input data.
+ */
+
+#include <config.h>
+#include <math.h>
+#include <string.h>
+#include <glib.h>
+#include <libsigrok/libsigrok.h>
+#include "bench.h"
+
+#define NUM_SAMPLES	(64 * 1024)
+
+struct encoding {
+	const char *name;
+	uint8_t unitsize;
+	gboolean is_signed;
+	gboolean is_float;
+	/* Byte order is the host's unless swapped. */
+	gboolean swapped;
+	int64_t scale_p, offset_p;
+	uint64_t scale_q, offset_q;
+};
+
+static const struct encoding encodings[] = {
+	{ "float32",         4, TRUE,  TRUE,  FALSE, 1, 0, 1, 1 },
+	{ "float32_scaled",  4, TRUE,  TRUE,  FALSE, 1, -5, 1000, 1 },
+	{ "float32_swapped", 4, TRUE,  TRUE,  TRUE,  1, 0, 1, 1 },
+	{ "float64",         8, TRUE,  TRUE,  FALSE, 1, 0, 1, 1 },
+	{ "int8",            1, TRUE,  FALSE, FALSE, 1, 0, 1, 1 },
+	{ "uint8",           1, FALSE, FALSE, FALSE, 5, 0, 256, 1 },
+	{ "int16",           2, TRUE,  FALSE, FALSE, 1, 0, 1, 1 },
+	{ "int16_swapped",   2, TRUE,  FALSE, TRUE,  1, 0, 1, 1 },
+	{ "uint16",          2, FALSE, FALSE, FALSE, 1, 0, 1, 1 },
+	{ "int32",           4, TRUE,  FALSE, FALSE, 1, 0, 1, 1 },
+	{ "uint32_scaled",   4, FALSE, FALSE, FALSE, 1, -5, 1000, 1 },
+};
+
+struct conv {
+	struct sr_datafeed_analog analog;
+	struct sr_analog_encoding encoding;
+	struct sr_analog_meaning meaning;
+	struct sr_analog_spec spec;
+	struct sr_channel channel;
+	uint8_t *data;
+	float *floats;
+	uint8_t *logic;
+	uint8_t state;
+};
+
+/*
+ * Fill the sample data. Float data holds a sine, to keep NaNs and
+ * denormals out. Integer data is random.
+ */
+static void fill_data(struct conv *c, const struct encoding *enc)
+{
+	GRand *rand;
+	size_t i, j;
+	float f;
+	double d;
+	uint8_t *p, tmp;
+
+	rand = g_rand_new_with_seed(1);
+	for (i = 0; i < NUM_SAMPLES; i++) {
+		p = &c->data[i * enc->unitsize];
+		if (enc->is_float && enc->unitsize == sizeof(float)) {
+			f = 3.3 * sin(i * 0.01);
+			memcpy(p, &f, sizeof(f));
+		} else if (enc->is_float) {
+			d = 3.3 * sin(i * 0.01);
+			memcpy(p, &d, sizeof(d));
+		} else {
+			for (j = 0; j < enc->unitsize; j++)
+				p[j] = g_rand_int(rand);
+		}
+		if (enc->swapped) {
+			for (j = 0; j < enc->unitsize / 2; j++) {
+				tmp = p[j];
+				p[j] = p[enc->unitsize - 1 - j];
+				p[enc->unitsize - 1 - j] = tmp;
+			}
+		}
+	}
+	g_rand_free(rand);
+}
+
+static void setup(struct conv *c, const struct encoding *enc)
+{
+	gboolean host_bigendian;
+
+	host_bigendian = G_BYTE_ORDER == G_BIG_ENDIAN;
+
+	memset(&c->encoding, 0, sizeof(c->encoding));
+	c->encoding.unitsize = enc->unitsize;
+	c->encoding.is_signed = enc->is_signed;
+	c->encoding.is_float = enc->is_float;
+	c->encoding.is_bigendian = enc->swapped ?
+		!host_bigendian : host_bigendian;
+	c->encoding.digits = 3;
+	c->encoding.is_digits_decimal = TRUE;
+	sr_rational_set(&c->encoding.scale, enc->scale_p, enc->scale_q);
+	sr_rational_set(&c->encoding.offset, enc->offset_p, enc->offset_q);
+
+	fill_data(c, enc);
+	c->analog.data = c->data;
+	c->analog.num_samples = NUM_SAMPLES;
+	c->analog.encoding = &c->encoding;
+}
+
+static size_t to_float(void *data, size_t *bytes)
+{
+	struct conv *c;
+
+	c = data;
+	if (sr_analog_to_float(&c->analog, c->floats) != SR_OK)
+		return 0;
+	*bytes = NUM_SAMPLES * c->encoding.unitsize;
+
+	return NUM_SAMPLES;
+}
+
+static size_t a2l_threshold(void *data, size_t *bytes)
+{
+	struct conv *c;
+
+	c = data;
+	if (sr_a2l_threshold(&c->analog, 1.5, c->logic, NUM_SAMPLES) != SR_OK)
+		return 0;
+	*bytes = NUM_SAMPLES * c->encoding.unitsize;
+
+	return NUM_SAMPLES;
+}
+
+static size_t a2l_schmitt(void *data, size_t *bytes)
+{
+	struct conv *c;
+
+	c = data;
+	if (sr_a2l_schmitt_trigger(&c->analog, 0.8, 2.0, &c->state,
+			c->logic, NUM_SAMPLES) != SR_OK)
+		return 0;
+	*bytes = NUM_SAMPLES * c->encoding.unitsize;
+
+	return NUM_SAMPLES;
+}
+
+static const struct encoding *find_encoding(const char *name)
+{
+	size_t i;
+
+	for (i = 0; i < G_N_ELEMENTS(encodings); i++) {
+		if (strcmp(encodings[i].name, name) == 0)
+			return &encodings[i];
+	}
+
+	return NULL;
+}
+
+int main(void)
+{
+	struct conv c;
+	char name[64];
+	size_t i;
+
+	memset(&c, 0, sizeof(c));
+	c.data = g_malloc0(NUM_SAMPLES * sizeof(double));
+	c.floats = g_malloc0(NUM_SAMPLES * sizeof(float));
+	c.logic = g_malloc0(NUM_SAMPLES);
+
+	/* A single channel, sr_analog_to_float() counts the channels. */
+	c.channel.name = "A0";
+	c.channel.type = SR_CHANNEL_ANALOG;
+	c.channel.enabled = TRUE;
+	c.meaning.mq = SR_MQ_VOLTAGE;
+	c.meaning.unit = SR_UNIT_VOLT;
+	c.meaning.channels = g_slist_append(NULL, &c.channel);
+	c.spec.spec_digits = 3;
+	c.analog.meaning = &c.meaning;
+	c.analog.spec = &c.spec;
+
+	for (i = 0; i < G_N_ELEMENTS(encodings); i++) {
+		setup(&c, &encodings[i]);
+		g_snprintf(name, sizeof(name), "analog_to_float_%s",
+			encodings[i].name);
+		bench_run(name, to_float, &c);
+	}
+
+	setup(&c, find_encoding("float32"));
+	bench_run("a2l_threshold_float32", a2l_threshold, &c);
+	bench_run("a2l_schmitt_trigger_float32", a2l_schmitt, &c);
+	setup(&c, find_encoding("int16"));
+	bench_run("a2l_threshold_int16", a2l_threshold, &c);
+	bench_run("a2l_schmitt_trigger_int16", a2l_schmitt, &c);
+
+	g_slist_free(c.meaning.channels);
+	g_free(c.data);
+	g_free(c.floats);
+	g_free(c.logic);
+
+	return 0;
+}
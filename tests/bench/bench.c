@@ -0,0 +1,85 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 libsigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <glib.h>
+#include "bench.h"
+
+/* Default minimum run time per benchmark, see SIGROK_BENCH_MIN_MS. */
+#define BENCH_DEFAULT_MIN_MS	500
+
+uint64_t bench_min_time_ms(void)
+{
+	const char *env;
+	uint64_t ms;
+
+	env = g_getenv("SIGROK_BENCH_MIN_MS");
+	if (!env || !*env)
+		return BENCH_DEFAULT_MIN_MS;
+	ms = g_ascii_strtoull(env, NULL, 10);
+
+	return ms ? ms : BENCH_DEFAULT_MIN_MS;
+}
+
+void bench_report(const struct bench_result *res)
+{
+	double ns_per_item, mb_per_s;
+
+	ns_per_item = res->items ?
+		(double)res->elapsed_ns / res->items : 0.0;
+	mb_per_s = res->elapsed_ns ?
+		(double)res->bytes * 1e3 / res->elapsed_ns : 0.0;
+	printf("bench=%s iter=%" PRIu64 " items=%" PRIu64
+		" bytes=%" PRIu64 " ns_per_item=%.3f mb_per_s=%.3f\n",
+		res->name, res->iterations, res->items, res->bytes,
+		ns_per_item, mb_per_s);
+	fflush(stdout);
+}
+
+void bench_run(const char *name, bench_func func, void *data)
+{
+	struct bench_result res;
+	int64_t start, now, min_us;
+	size_t bytes;
+
+	res.name = name;
+	res.iterations = 0;
+	res.items = 0;
+	res.bytes = 0;
+
+	/* Warm up caches and lazily initialized state. */
+	bytes = 0;
+	(void)func(data, &bytes);
+
+	min_us = bench_min_time_ms() * 1000;
+	start = g_get_monotonic_time();
+	do {
+		bytes = 0;
+		res.items += func(data, &bytes);
+		res.bytes += bytes;
+		res.iterations++;
+		now = g_get_monotonic_time();
+	} while (now - start < min_us);
+	res.elapsed_ns = (uint64_t)(now - start) * 1000;
+
+	bench_report(&res);
+}
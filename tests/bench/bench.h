@@ -0,0 +1,51 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 libsigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBSIGROK_TESTS_BENCH_BENCH_H
+#define LIBSIGROK_TESTS_BENCH_BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Minimal support for microbenchmarks. Each benchmark runs a routine
+ * repeatedly until a minimum run time has passed, and reports the
+ * result as a single line of whitespace separated key=value pairs:
+ *
+ *   bench=<name> iter=<n> items=<n> bytes=<n> ns_per_item=<t> mb_per_s=<r>
+ *
+ * Items are whatever the benchmark processes (samples, packets, etc).
+ */
+
+struct bench_result {
+	const char *name;
+	uint64_t iterations;
+	uint64_t items;
+	uint64_t bytes;
+	uint64_t elapsed_ns;
+};
+
+/* A benchmark routine processes one batch, and returns the batch size. */
+typedef size_t (*bench_func)(void *data, size_t *bytes);
+
+void bench_run(const char *name, bench_func func, void *data);
+void bench_report(const struct bench_result *res);
+uint64_t bench_min_time_ms(void);
+
+#endif
@@ -0,0 +1,220 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 libsigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Session datafeed benchmark, with different logging setups.
+ *
+ * The demo driver sends small logic packets as fast as it can, which
+ * pass the session's datafeed to a callback. Each packet runs through
+ * a few log message checks on the way, so the packet rate shows what
+ * disabled (and enabled) log messages cost:
+ *
+ *  - quiet: The default loglevel, debug messages are disabled.
+ *  - filter: The default loglevel, with debug output enabled for an
+ *    unrelated subsystem.
+ *  - spew: All messages enabled, and discarded by the log callback.
+ *  - dispatch: The default loglevel, the packets pass a transform
+ *    module, and go to several datafeed callbacks.
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
+#include <libsigrok/libsigrok.h>
+#include "bench.h"
+
+/* Samples per packet, small packets make the per packet cost visible. */
+#define PACKET_SAMPLES	256
+#define RUN_SAMPLES	(PACKET_SAMPLES * 4096)
+
+struct feed {
+	struct sr_context *ctx;
+	struct sr_session *session;
+	struct sr_dev_inst *sdi;
+	uint64_t packets;
+	uint64_t bytes;
+};
+
+static int log_discard(void *cb_data, int loglevel, const char *format,
+	va_list args)
+{
+	char buf[256];
+
+	(void)cb_data;
+	(void)loglevel;
+
+	/* Format the message, like any real log callback would. */
+	g_vsnprintf(buf, sizeof(buf), format, args);
+
+	return SR_OK;
+}
+
+static void datafeed_in(const struct sr_dev_inst *sdi,
+	const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	const struct sr_datafeed_logic *logic;
+	struct feed *f;
+
+	(void)sdi;
+
+	f = cb_data;
+	if (packet->type != SR_DF_LOGIC)
+		return;
+	logic = packet->payload;
+	f->packets++;
+	f->bytes += logic->length;
+}
+
+static size_t run_feed(void *data, size_t *bytes)
+{
+	struct feed *f;
+
+	f = data;
+	f->packets = 0;
+	f->bytes = 0;
+	if (sr_session_start(f->session) != SR_OK ||
+			sr_session_run(f->session) != SR_OK)
+		return 0;
+	*bytes = f->bytes;
+
+	return f->packets;
+}
+
+static struct sr_dev_driver *find_driver(struct sr_context *ctx,
+	const char *name)
+{
+	struct sr_dev_driver **drivers;
+	size_t i;
+
+	drivers = sr_driver_list(ctx);
+	for (i = 0; drivers && drivers[i]; i++) {
+		if (strcmp(drivers[i]->name, name) == 0)
+			return drivers[i];
+	}
+
+	return NULL;
+}
+
+static int setup(struct feed *f)
+{
+	struct sr_dev_driver *driver;
+	struct sr_config analog;
+	GSList *options, *devices;
+
+	driver = find_driver(f->ctx, "demo");
+	if (!driver) {
+		fprintf(stderr, "Demo driver not available, skipping.\n");
+		return 1;
+	}
+	if (sr_driver_init(f->ctx, driver) != SR_OK)
+		return -1;
+
+	analog.key = SR_CONF_NUM_ANALOG_CHANNELS;
+	analog.data = g_variant_new_int32(0);
+	options = g_slist_append(NULL, &analog);
+	devices = sr_driver_scan(driver, options);
+	g_slist_free(options);
+	g_variant_unref(analog.data);
+	if (!devices)
+		return -1;
+	f->sdi = devices->data;
+	g_slist_free(devices);
+
+	if (sr_dev_open(f->sdi) != SR_OK)
+		return -1;
+	if (sr_config_set(f->sdi, NULL, SR_CONF_DEVICE_MODE,
+			g_variant_new_string("max-throughput")) != SR_OK ||
+			sr_config_set(f->sdi, NULL, SR_CONF_BUFFERSIZE,
+			g_variant_new_uint64(PACKET_SAMPLES)) != SR_OK ||
+			sr_config_set(f->sdi, NULL, SR_CONF_LIMIT_SAMPLES,
+			g_variant_new_uint64(RUN_SAMPLES)) != SR_OK)
+		return -1;
+
+	if (sr_session_new(f->ctx, &f->session) != SR_OK)
+		return -1;
+	if (sr_session_dev_add(f->session, f->sdi) != SR_OK)
+		return -1;
+	sr_session_datafeed_callback_add(f->session, datafeed_in, f);
+
+	return 0;
+}
+
+static void datafeed_other(const struct sr_dev_inst *sdi,
+	const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	(void)sdi;
+	(void)packet;
+	(void)cb_data;
+}
+
+static int setup_dispatch(struct feed *f)
+{
+	const struct sr_transform_module *tmod;
+	unsigned int i;
+
+	if (!(tmod = sr_transform_find("nop")))
+		return -1;
+	if (!sr_transform_new(tmod, NULL, f->sdi))
+		return -1;
+	for (i = 0; i < 3; i++)
+		sr_session_datafeed_callback_add(f->session, datafeed_other, f);
+
+	return 0;
+}
+
+int main(void)
+{
+	struct feed f;
+	int ret;
+
+	memset(&f, 0, sizeof(f));
+	if (sr_init(&f.ctx) != SR_OK)
+		return 1;
+
+	ret = setup(&f);
+	if (ret == 0) {
+		sr_log_loglevel_set(SR_LOG_WARN);
+		bench_run("datafeed_quiet", run_feed, &f);
+
+		sr_log_filter_set("fx2lafw", SR_LOG_SPEW);
+		bench_run("datafeed_filter", run_feed, &f);
+		sr_log_filter_clear(NULL);
+
+		sr_log_callback_set(log_discard, NULL);
+		sr_log_loglevel_set(SR_LOG_SPEW);
+		bench_run("datafeed_spew", run_feed, &f);
+		sr_log_loglevel_set(SR_LOG_WARN);
+		sr_log_callback_set_default();
+
+		/* Transforms stay with the session, this comes last. */
+		ret = setup_dispatch(&f);
+		if (ret == 0)
+			bench_run("datafeed_dispatch", run_feed, &f);
+	}
+
+	if (f.session)
+		sr_session_destroy(f.session);
+	if (f.sdi)
+		sr_dev_close(f.sdi);
+	sr_exit(f.ctx);
+
+	/* A missing demo driver is not an error. */
+	return ret < 0 ? 1 : 0;
+}
@@ -0,0 +1,224 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 libsigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * DMM packet parsing benchmark.
+ *
+ * Runs the FS9721 packet validity check and parser over a stream of RX
+ * data, like the serial-dmm driver does. Resynchronization is done both
+ * by checking every byte offset (the naive approach), and by means of
+ * the chipset's sync pattern.
+ *
+ * Usage: bench_dmm [capture-file]
+ *
+ * The optional capture file holds raw RX data of an FS9721 based meter.
+ * Without a capture file, a stream of valid packets which are separated
+ * by random garbage is synthesized.
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+#include "bench.h"
+
+#define SYNTH_PACKETS	4096
+#define SYNTH_GARBAGE	32
+
+struct stream {
+	uint8_t *data;
+	size_t len;
+};
+
+/* Segment patterns of the digits 0-9, bit 7 is the decimal point. */
+static const uint8_t fs9721_segs[] = {
+	0x7d, 0x05, 0x5b, 0x1f, 0x27, 0x3e, 0x7e, 0x15, 0x7f, 0x3f,
+};
+
+static void synth_fs9721_packet(uint8_t *buf, GRand *rand)
+{
+	size_t i;
+	uint8_t seg;
+
+	/* DC, auto range, RS232, Volt. */
+	buf[0] = 0x07;
+	for (i = 0; i < 4; i++) {
+		seg = fs9721_segs[g_rand_int_range(rand, 0, 10)];
+		buf[1 + 2 * i] = (seg >> 4) & 0x07;
+		buf[2 + 2 * i] = seg & 0x0f;
+	}
+	memset(&buf[9], 0, 5);
+	buf[12] = 1 << 2;
+	for (i = 0; i < FS9721_PACKET_SIZE; i++)
+		buf[i] |= (i + 1) << 4;
+}
+
+static void synth_stream(struct stream *s)
+{
+	GRand *rand;
+	GByteArray *arr;
+	uint8_t pkt[FS9721_PACKET_SIZE], junk;
+	size_t i, j, count;
+
+	rand = g_rand_new_with_seed(1);
+	arr = g_byte_array_new();
+	for (i = 0; i < SYNTH_PACKETS; i++) {
+		synth_fs9721_packet(pkt, rand);
+		g_byte_array_append(arr, pkt, sizeof(pkt));
+		count = g_rand_int_range(rand, 0, SYNTH_GARBAGE + 1);
+		for (j = 0; j < count; j++) {
+			junk = g_rand_int_range(rand, 0, 256);
+			g_byte_array_append(arr, &junk, 1);
+		}
+	}
+	g_rand_free(rand);
+
+	s->len = arr->len;
+	s->data = g_byte_array_free(arr, FALSE);
+}
+
+static int load_stream(struct stream *s, const char *fn)
+{
+	gchar *data;
+	gsize len;
+	GError *error;
+
+	error = NULL;
+	if (!g_file_get_contents(fn, &data, &len, &error)) {
+		fprintf(stderr, "Cannot read %s: %s\n", fn, error->message);
+		g_error_free(error);
+		return -1;
+	}
+	s->data = (uint8_t *)data;
+	s->len = len;
+
+	return 0;
+}
+
+static size_t resync_naive(void *data, size_t *bytes)
+{
+	const struct stream *s;
+	size_t pos, packets;
+
+	s = data;
+	packets = 0;
+	pos = 0;
+	while (pos + FS9721_PACKET_SIZE <= s->len) {
+		if (!sr_fs9721_packet_valid(&s->data[pos])) {
+			pos++;
+			continue;
+		}
+		packets++;
+		pos += FS9721_PACKET_SIZE;
+	}
+	*bytes = s->len;
+
+	return packets;
+}
+
+static size_t resync_sync(void *data, size_t *bytes)
+{
+	const struct stream *s;
+	size_t pos, packets;
+
+	s = data;
+	packets = 0;
+	pos = 0;
+	while (pos + FS9721_PACKET_SIZE <= s->len) {
+		if (!sr_fs9721_packet_valid(&s->data[pos])) {
+			pos++;
+			pos += sr_dmm_sync_find(&sr_fs9721_sync,
+				&s->data[pos], s->len - pos);
+			continue;
+		}
+		packets++;
+		pos += FS9721_PACKET_SIZE;
+	}
+	*bytes = s->len;
+
+	return packets;
+}
+
+static size_t parse(void *data, size_t *bytes)
+{
+	const struct stream *s;
+	struct sr_datafeed_analog analog;
+	struct sr_analog_encoding encoding;
+	struct sr_analog_meaning meaning;
+	struct sr_analog_spec spec;
+	struct fs9721_info info;
+	size_t pos, packets;
+	float value;
+
+	s = data;
+	memset(&analog, 0, sizeof(analog));
+	analog.encoding = &encoding;
+	analog.meaning = &meaning;
+	analog.spec = &spec;
+	packets = 0;
+	pos = 0;
+	while (pos + FS9721_PACKET_SIZE <= s->len) {
+		if (!sr_fs9721_packet_valid(&s->data[pos])) {
+			pos++;
+			pos += sr_dmm_sync_find(&sr_fs9721_sync,
+				&s->data[pos], s->len - pos);
+			continue;
+		}
+		memset(&meaning, 0, sizeof(meaning));
+		memset(&info, 0, sizeof(info));
+		if (sr_fs9721_parse(&s->data[pos], &value,
+				&analog, &info) == SR_OK)
+			packets++;
+		pos += FS9721_PACKET_SIZE;
+	}
+	*bytes = s->len;
+
+	return packets;
+}
+
+int main(int argc, char **argv)
+{
+	struct stream s;
+	size_t bytes;
+
+	if (argc > 1) {
+		if (load_stream(&s, argv[1]) < 0)
+			return 1;
+	} else {
+		synth_stream(&s);
+	}
+
+	/* Both resync strategies must find the same packets. */
+	if (resync_naive(&s, &bytes) != resync_sync(&s, &bytes)) {
+		fprintf(stderr, "Resync results differ.\n");
+		g_free(s.data);
+		return 1;
+	}
+
+	bench_run("dmm_fs9721_resync_naive", resync_naive, &s);
+	bench_run("dmm_fs9721_resync_sync", resync_sync, &s);
+	bench_run("dmm_fs9721_parse", parse, &s);
+
+	g_free(s.data);
+
+	return 0;
+}
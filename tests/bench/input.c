@@ -0,0 +1,332 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 libsigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Input module benchmark.
+ *
+ * Each run creates an input module instance, and feeds it a complete
+ * file in chunks, like frontends do. The device instance joins a
+ * session as soon as the module has set it up, the session's datafeed
+ * callback counts the samples. Items are samples (per channel for
+ * analog data), bytes are the size of the input file.
+ *
+ * Usage: bench_input [module file]
+ *
+ * Without arguments, synthetic files for the binary, vcd, csv, wav and
+ * raw_analog modules get generated, with 8 logic or 2 analog channels.
+ * Otherwise the given file is fed to the given module, with the
+ * module's default options.
+ */
+
+#include <config.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
+#include <libsigrok/libsigrok.h>
+#include "bench.h"
+
+#define NUM_SAMPLES	(256 * 1024)
+#define CHUNK_SIZE	(64 * 1024)
+#define WAV_CHANNELS	2
+
+struct feed {
+	struct sr_context *ctx;
+	const struct sr_input_module *imod;
+	GString *file;
+	uint64_t samples;
+};
+
+/* Logic data where each of 8 channels changes in about one of 16 samples. */
+static uint8_t *logic_data(void)
+{
+	GRand *rand;
+	uint8_t *data, sample;
+	unsigned int bit;
+	size_t i;
+
+	data = g_malloc(NUM_SAMPLES);
+	rand = g_rand_new_with_seed(1);
+	sample = 0;
+	for (i = 0; i < NUM_SAMPLES; i++) {
+		for (bit = 0; bit < 8; bit++) {
+			if (g_rand_int_range(rand, 0, 16) == 0)
+				sample ^= 1 << bit;
+		}
+		data[i] = sample;
+	}
+	g_rand_free(rand);
+
+	return data;
+}
+
+static GString *gen_binary(const uint8_t *data)
+{
+	return g_string_new_len((const char *)data, NUM_SAMPLES);
+}
+
+static GString *gen_vcd(const uint8_t *data)
+{
+	GString *s;
+	unsigned int bit;
+	size_t i;
+	uint8_t prev, diff;
+
+	s = g_string_sized_new(NUM_SAMPLES * 4);
+	g_string_append(s, "$timescale 1 us $end\n$scope module bench $end\n");
+	for (bit = 0; bit < 8; bit++)
+		g_string_append_printf(s, "$var wire 1 %c D%u $end\n",
+			'!' + bit, bit);
+	g_string_append(s, "$upscope $end\n$enddefinitions $end\n#0\n");
+	for (bit = 0; bit < 8; bit++)
+		g_string_append_printf(s, "%u%c\n", (data[0] >> bit) & 1,
+			'!' + bit);
+	prev = data[0];
+	for (i = 1; i < NUM_SAMPLES; i++) {
+		diff = data[i] ^ prev;
+		if (!diff)
+			continue;
+		g_string_append_printf(s, "#%zu\n", i);
+		for (bit = 0; bit < 8; bit++) {
+			if (diff & (1 << bit))
+				g_string_append_printf(s, "%u%c\n",
+					(data[i] >> bit) & 1, '!' + bit);
+		}
+		prev = data[i];
+	}
+	g_string_append_printf(s, "#%u\n", NUM_SAMPLES);
+
+	return s;
+}
+
+static GString *gen_csv(const uint8_t *data)
+{
+	GString *s;
+	unsigned int bit;
+	size_t i;
+
+	s = g_string_sized_new(NUM_SAMPLES * 16 + 64);
+	g_string_append(s, "D0,D1,D2,D3,D4,D5,D6,D7\n");
+	for (i = 0; i < NUM_SAMPLES; i++) {
+		for (bit = 0; bit < 8; bit++) {
+			g_string_append_c(s, (data[i] >> bit) & 1 ? '1' : '0');
+			g_string_append_c(s, bit < 7 ? ',' : '\n');
+		}
+	}
+
+	return s;
+}
+
+static void append_le(GString *s, uint32_t value, size_t len)
+{
+	while (len--) {
+		g_string_append_c(s, value & 0xff);
+		value >>= 8;
+	}
+}
+
+/* 16-bit PCM, interleaved channels. */
+static GString *gen_wav(const uint8_t *data)
+{
+	GString *s;
+	size_t i, size;
+	int16_t value;
+
+	(void)data;
+
+	size = NUM_SAMPLES * WAV_CHANNELS * sizeof(int16_t);
+	s = g_string_sized_new(size + 44);
+	g_string_append(s, "RIFF");
+	append_le(s, size + 36, 4);
+	g_string_append(s, "WAVEfmt ");
+	append_le(s, 16, 4);
+	append_le(s, 1, 2);
+	append_le(s, WAV_CHANNELS, 2);
+	append_le(s, 48000, 4);
+	append_le(s, 48000 * WAV_CHANNELS * sizeof(int16_t), 4);
+	append_le(s, WAV_CHANNELS * sizeof(int16_t), 2);
+	append_le(s, 16, 2);
+	g_string_append(s, "data");
+	append_le(s, size, 4);
+	for (i = 0; i < NUM_SAMPLES; i++) {
+		value = 30000 * sin(i * 0.01);
+		append_le(s, (uint16_t)value, 2);
+		value = 20000 * cos(i * 0.003);
+		append_le(s, (uint16_t)value, 2);
+	}
+
+	return s;
+}
+
+/* The module's default format, a single channel of signed 8-bit samples. */
+static GString *gen_raw_analog(const uint8_t *data)
+{
+	return g_string_new_len((const char *)data, NUM_SAMPLES);
+}
+
+static const struct {
+	const char *id;
+	GString *(*gen)(const uint8_t *data);
+} generators[] = {
+	{ "binary", gen_binary },
+	{ "vcd", gen_vcd },
+	{ "csv", gen_csv },
+	{ "wav", gen_wav },
+	{ "raw_analog", gen_raw_analog },
+};
+
+static void datafeed_in(const struct sr_dev_inst *sdi,
+	const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	const struct sr_datafeed_logic *logic;
+	const struct sr_datafeed_analog *analog;
+	struct feed *f;
+
+	(void)sdi;
+
+	f = cb_data;
+	switch (packet->type) {
+	case SR_DF_LOGIC:
+		logic = packet->payload;
+		if (logic->unitsize)
+			f->samples += logic->length / logic->unitsize;
+		break;
+	case SR_DF_ANALOG:
+		analog = packet->payload;
+		f->samples += analog->num_samples *
+			g_slist_length(analog->meaning->channels);
+		break;
+	}
+}
+
+static size_t run_input(void *data, size_t *bytes)
+{
+	struct feed *f;
+	struct sr_input *in;
+	struct sr_session *session;
+	struct sr_dev_inst *sdi;
+	GString *chunk;
+	size_t offset, len;
+	int ret;
+
+	f = data;
+	f->samples = 0;
+	if (!(in = sr_input_new(f->imod, NULL)))
+		return 0;
+	if (sr_session_new(f->ctx, &session) != SR_OK) {
+		sr_input_free(in);
+		return 0;
+	}
+	sr_session_datafeed_callback_add(session, datafeed_in, f);
+
+	/* Frontends add the device as soon as the module has set it up. */
+	chunk = g_string_sized_new(CHUNK_SIZE);
+	ret = SR_OK;
+	sdi = NULL;
+	for (offset = 0; ret == SR_OK && offset < f->file->len; offset += len) {
+		len = MIN(CHUNK_SIZE, f->file->len - offset);
+		g_string_truncate(chunk, 0);
+		g_string_append_len(chunk, f->file->str + offset, len);
+		ret = sr_input_send(in, chunk);
+		if (!sdi && (sdi = sr_input_dev_inst_get(in)))
+			sr_session_dev_add(session, sdi);
+	}
+	if (ret == SR_OK)
+		ret = sr_input_end(in);
+	g_string_free(chunk, TRUE);
+
+	sr_session_destroy(session);
+	sr_input_free(in);
+	if (ret != SR_OK)
+		return 0;
+	*bytes = f->file->len;
+
+	return f->samples;
+}
+
+static int bench_module(struct feed *f, const char *id, GString *file)
+{
+	char name[64];
+	size_t bytes;
+
+	f->imod = sr_input_find((char *)id);
+	if (!f->imod) {
+		fprintf(stderr, "Input module %s not available, skipping.\n", id);
+		return 0;
+	}
+	f->file = file;
+
+	/* Check once, a failing module would report bogus rates. */
+	if (!run_input(f, &bytes)) {
+		fprintf(stderr, "Input module %s failed.\n", id);
+		return -1;
+	}
+	g_snprintf(name, sizeof(name), "input_%s", id);
+	bench_run(name, run_input, f);
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	struct feed f;
+	GString *file;
+	uint8_t *data;
+	gchar *contents;
+	gsize len;
+	size_t i;
+	int ret;
+
+	if (argc != 1 && argc != 3) {
+		fprintf(stderr, "Usage: %s [module file]\n", argv[0]);
+		return 1;
+	}
+
+	memset(&f, 0, sizeof(f));
+	if (sr_init(&f.ctx) != SR_OK)
+		return 1;
+	sr_log_loglevel_set(SR_LOG_WARN);
+
+	ret = 0;
+	if (argc == 3) {
+		if (!g_file_get_contents(argv[2], &contents, &len, NULL)) {
+			fprintf(stderr, "Cannot read %s.\n", argv[2]);
+			ret = 1;
+		} else {
+			file = g_string_new_len(contents, len);
+			g_free(contents);
+			if (bench_module(&f, argv[1], file) < 0)
+				ret = 1;
+			g_string_free(file, TRUE);
+		}
+	} else {
+		data = logic_data();
+		for (i = 0; i < G_N_ELEMENTS(generators); i++) {
+			file = generators[i].gen(data);
+			if (bench_module(&f, generators[i].id, file) < 0)
+				ret = 1;
+			g_string_free(file, TRUE);
+		}
+		g_free(data);
+	}
+
+	sr_exit(f.ctx);
+
+	return ret;
+}
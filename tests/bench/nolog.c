@@ -0,0 +1,56 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 libsigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Logging stubs for benchmarks which link library sources directly,
+ * instead of the library. Logging is not of interest there, all
+ * messages are disabled.
+ */
+
+#include <config.h>
+#include <glib.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+
+SR_PRIV gint sr_log_threshold = SR_LOG_NONE;
+SR_PRIV gint sr_log_filtered = 0;
+
+SR_PRIV gboolean sr_log_prefix_enabled(int loglevel, const char *prefix)
+{
+	(void)loglevel;
+	(void)prefix;
+
+	return FALSE;
+}
+
+SR_PRIV int sr_log_msg(int loglevel, const char *format, ...)
+{
+	(void)loglevel;
+	(void)format;
+
+	return SR_OK;
+}
+
+SR_PRIV int sr_log(int loglevel, const char *format, ...)
+{
+	(void)loglevel;
+	(void)format;
+
+	return SR_OK;
+}
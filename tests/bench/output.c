@@ -0,0 +1,322 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 libsigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Output module benchmark.
+ *
+ * Each run creates an output module instance, and sends it a complete
+ * datafeed: The header, the samplerate, a number of logic or analog
+ * packets, and the end. The text which the module returns is dropped,
+ * file based modules (srzip) write to a temporary file. Items are
+ * samples (per channel for analog data), bytes are the size of the
+ * sample data in the packets.
+ *
+ * Logic data holds 8 channels, where each channel changes in about one
+ * of 16 samples. Analog data holds 2 channels of sines.
+ */
+
+#include <config.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <libsigrok/libsigrok.h>
+#include "bench.h"
+
+#define PACKET_SAMPLES	4096
+#define PACKETS		64
+#define ANALOG_CHANNELS	2
+
+struct feed {
+	const struct sr_output_module *omod;
+	const struct sr_dev_inst *sdi;
+	char *filename;
+	uint8_t *logic;
+	float *analog[ANALOG_CHANNELS];
+	struct sr_analog_encoding encoding;
+	struct sr_analog_meaning meaning[ANALOG_CHANNELS];
+	struct sr_analog_spec spec;
+	gboolean is_analog;
+};
+
+static const struct {
+	const char *id;
+	gboolean is_analog;
+} modules[] = {
+	{ "vcd", FALSE },
+	{ "csv", FALSE },
+	{ "srzip", FALSE },
+	{ "bits", FALSE },
+	{ "hex", FALSE },
+	{ "ascii", FALSE },
+	{ "binary", FALSE },
+	{ "ols", FALSE },
+	{ "arrow", FALSE },
+	{ "wav", TRUE },
+	{ "csv", TRUE },
+	{ "analog", TRUE },
+	{ "srzip", TRUE },
+	{ "arrow", TRUE },
+};
+
+static void fill_data(struct feed *f)
+{
+	GRand *rand;
+	size_t i, count;
+	unsigned int bit;
+	uint8_t sample;
+
+	count = PACKET_SAMPLES * PACKETS;
+	rand = g_rand_new_with_seed(1);
+	sample = 0;
+	for (i = 0; i < count; i++) {
+		for (bit = 0; bit < 8; bit++) {
+			if (g_rand_int_range(rand, 0, 16) == 0)
+				sample ^= 1 << bit;
+		}
+		f->logic[i] = sample;
+	}
+	g_rand_free(rand);
+
+	for (i = 0; i < count; i++) {
+		f->analog[0][i] = 3.3 * sin(i * 0.01);
+		f->analog[1][i] = 1.5 * cos(i * 0.003);
+	}
+}
+
+static struct sr_dev_inst *create_dev(gboolean is_analog)
+{
+	struct sr_dev_inst *sdi;
+	char name[8];
+	unsigned int i;
+
+	sdi = sr_dev_inst_user_new("sigrok", "bench", NULL);
+	if (is_analog) {
+		for (i = 0; i < ANALOG_CHANNELS; i++) {
+			g_snprintf(name, sizeof(name), "A%u", i);
+			sr_dev_inst_channel_add(sdi, i, SR_CHANNEL_ANALOG, name);
+		}
+	} else {
+		for (i = 0; i < 8; i++) {
+			g_snprintf(name, sizeof(name), "D%u", i);
+			sr_dev_inst_channel_add(sdi, i, SR_CHANNEL_LOGIC, name);
+		}
+	}
+
+	return sdi;
+}
+
+static int send_packet(const struct sr_output *o,
+	const struct sr_datafeed_packet *packet)
+{
+	GString *out;
+	int ret;
+
+	out = NULL;
+	ret = sr_output_send(o, packet, &out);
+	if (out)
+		g_string_free(out, TRUE);
+
+	return ret;
+}
+
+static int send_meta(const struct sr_output *o)
+{
+	struct sr_datafeed_packet packet;
+	struct sr_datafeed_meta meta;
+	struct sr_config src;
+	int ret;
+
+	src.key = SR_CONF_SAMPLERATE;
+	src.data = g_variant_new_uint64(SR_MHZ(1));
+	meta.config = g_slist_append(NULL, &src);
+	packet.type = SR_DF_META;
+	packet.payload = &meta;
+	ret = send_packet(o, &packet);
+	g_slist_free(meta.config);
+	g_variant_unref(src.data);
+
+	return ret;
+}
+
+static int send_data(struct feed *f, const struct sr_output *o, size_t index)
+{
+	struct sr_datafeed_packet packet;
+	struct sr_datafeed_logic logic;
+	struct sr_datafeed_analog analog;
+	unsigned int i;
+	int ret;
+
+	if (!f->is_analog) {
+		logic.length = PACKET_SAMPLES;
+		logic.unitsize = 1;
+		logic.data = &f->logic[index * PACKET_SAMPLES];
+		packet.type = SR_DF_LOGIC;
+		packet.payload = &logic;
+		return send_packet(o, &packet);
+	}
+
+	/* One packet per channel, like most drivers send them. */
+	for (i = 0; i < ANALOG_CHANNELS; i++) {
+		memset(&analog, 0, sizeof(analog));
+		analog.data = &f->analog[i][index * PACKET_SAMPLES];
+		analog.num_samples = PACKET_SAMPLES;
+		analog.encoding = &f->encoding;
+		analog.meaning = &f->meaning[i];
+		analog.spec = &f->spec;
+		packet.type = SR_DF_ANALOG;
+		packet.payload = &analog;
+		if ((ret = send_packet(o, &packet)) != SR_OK)
+			return ret;
+	}
+
+	return SR_OK;
+}
+
+static size_t run_output(void *data, size_t *bytes)
+{
+	struct feed *f;
+	const struct sr_output *o;
+	struct sr_datafeed_packet packet;
+	struct sr_datafeed_header header;
+	size_t i;
+	int ret;
+
+	f = data;
+	/* File based modules expect a new file. */
+	g_unlink(f->filename);
+	o = sr_output_new(f->omod, NULL, f->sdi, f->filename);
+	if (!o)
+		return 0;
+
+	header.feed_version = 1;
+	header.starttime.tv_sec = 0;
+	header.starttime.tv_usec = 0;
+	packet.type = SR_DF_HEADER;
+	packet.payload = &header;
+	ret = send_packet(o, &packet);
+	if (ret == SR_OK)
+		ret = send_meta(o);
+	for (i = 0; ret == SR_OK && i < PACKETS; i++)
+		ret = send_data(f, o, i);
+	packet.type = SR_DF_END;
+	packet.payload = NULL;
+	if (ret == SR_OK)
+		ret = send_packet(o, &packet);
+	sr_output_free(o);
+	if (ret != SR_OK)
+		return 0;
+
+	if (f->is_analog) {
+		*bytes = PACKETS * PACKET_SAMPLES * ANALOG_CHANNELS * sizeof(float);
+		return PACKETS * PACKET_SAMPLES * ANALOG_CHANNELS;
+	}
+	*bytes = PACKETS * PACKET_SAMPLES;
+
+	return PACKETS * PACKET_SAMPLES;
+}
+
+static void setup_analog(struct feed *f, const struct sr_dev_inst *sdi)
+{
+	GSList *l;
+	unsigned int i;
+
+	memset(&f->encoding, 0, sizeof(f->encoding));
+	f->encoding.unitsize = sizeof(float);
+	f->encoding.is_signed = TRUE;
+	f->encoding.is_float = TRUE;
+	f->encoding.is_bigendian = G_BYTE_ORDER == G_BIG_ENDIAN;
+	f->encoding.digits = 3;
+	f->encoding.is_digits_decimal = TRUE;
+	sr_rational_set(&f->encoding.scale, 1, 1);
+	sr_rational_set(&f->encoding.offset, 0, 1);
+	f->spec.spec_digits = 3;
+
+	l = sr_dev_inst_channels_get((struct sr_dev_inst *)sdi);
+	for (i = 0; i < ANALOG_CHANNELS; i++, l = l->next) {
+		f->meaning[i].mq = SR_MQ_VOLTAGE;
+		f->meaning[i].unit = SR_UNIT_VOLT;
+		f->meaning[i].channels = g_slist_append(NULL, l->data);
+	}
+}
+
+int main(void)
+{
+	struct sr_context *ctx;
+	struct sr_dev_inst *logic_sdi, *analog_sdi;
+	struct feed f;
+	char name[64];
+	size_t i, bytes;
+	int fd, ret;
+
+	memset(&f, 0, sizeof(f));
+	if (sr_init(&ctx) != SR_OK)
+		return 1;
+	sr_log_loglevel_set(SR_LOG_WARN);
+
+	fd = g_file_open_tmp("bench-output-XXXXXX", &f.filename, NULL);
+	if (fd < 0) {
+		fprintf(stderr, "Cannot create a temporary file.\n");
+		sr_exit(ctx);
+		return 1;
+	}
+	close(fd);
+
+	f.logic = g_malloc(PACKET_SAMPLES * PACKETS);
+	for (i = 0; i < ANALOG_CHANNELS; i++)
+		f.analog[i] = g_malloc(PACKET_SAMPLES * PACKETS * sizeof(float));
+	fill_data(&f);
+	logic_sdi = create_dev(FALSE);
+	analog_sdi = create_dev(TRUE);
+	setup_analog(&f, analog_sdi);
+
+	ret = 0;
+	for (i = 0; i < G_N_ELEMENTS(modules); i++) {
+		f.omod = sr_output_find((char *)modules[i].id);
+		if (!f.omod) {
+			fprintf(stderr, "Output module %s not available, "
+				"skipping.\n", modules[i].id);
+			continue;
+		}
+		f.is_analog = modules[i].is_analog;
+		f.sdi = f.is_analog ? analog_sdi : logic_sdi;
+		g_snprintf(name, sizeof(name), "output_%s_%s", modules[i].id,
+			f.is_analog ? "analog" : "logic");
+		/* Check once, a failing module would report bogus rates. */
+		if (!run_output(&f, &bytes)) {
+			fprintf(stderr, "Output module %s failed.\n", name);
+			ret = 1;
+			continue;
+		}
+		bench_run(name, run_output, &f);
+	}
+
+	g_unlink(f.filename);
+	g_free(f.filename);
+	for (i = 0; i < ANALOG_CHANNELS; i++) {
+		g_slist_free(f.meaning[i].channels);
+		g_free(f.analog[i]);
+	}
+	g_free(f.logic);
+	sr_exit(ctx);
+
+	return ret;
+}
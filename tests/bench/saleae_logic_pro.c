@@ -0,0 +1,244 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 libsigrok contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Saleae Logic Pro sample conversion benchmark.
+ *
+ * Feeds a stream of USB packets through the driver's sample conversion,
+ * like the driver's USB transfer callback does. The previous bit by bit
+ * conversion is run for comparison, and serves as a reference for the
+ * results.
+ *
+ * Usage: bench_saleae_logic_pro [capture-file [channels]]
+ *
+ * The optional capture file holds the raw USB packets of an acquisition
+ * with the given number of channels (default 16), which are assumed to
+ * be the first channels. Without a capture file, random sample data is
+ * used, with 16, 8 and 3 channels.
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include "hardware/saleae-logic-pro/protocol.h"
+#include "bench.h"
+
+#define PACKET_SIZE	(16 * 1024)
+#define SYNTH_PACKETS	256
+
+struct stream {
+	uint32_t *data;
+	size_t packets;
+	struct dev_context devc;
+};
+
+/* The conversion as it used to be done, one bit at a time. */
+static void convert_naive(struct dev_context *devc,
+	const uint32_t *src, size_t srccnt)
+{
+	uint8_t *dst = devc->conv_buffer;
+	uint32_t samples;
+	uint16_t channel_mask;
+	unsigned int sample_index, batch_index;
+	uint16_t *dst_batch;
+
+	memcpy(dst, dst + devc->conv_size, CONV_BATCH_SIZE);
+	devc->conv_size = 0;
+
+	batch_index = devc->batch_index;
+	while (srccnt--) {
+		samples = *src++;
+		dst_batch = (uint16_t *)dst;
+		if (batch_index == 0)
+			memset(dst, 0, CONV_BATCH_SIZE);
+		channel_mask = devc->dig_channel_masks[batch_index];
+		for (sample_index = 0; sample_index <= 31; sample_index++)
+			if ((samples >> (31 - sample_index)) & 1)
+				dst_batch[sample_index] |= channel_mask;
+		if (++batch_index == devc->dig_channel_cnt) {
+			devc->conv_size += CONV_BATCH_SIZE;
+			batch_index = 0;
+			dst += CONV_BATCH_SIZE;
+		}
+	}
+	devc->batch_index = batch_index;
+}
+
+static void setup_channels(struct dev_context *devc, unsigned int cnt)
+{
+	unsigned int i;
+
+	devc->dig_channel_cnt = cnt;
+	for (i = 0; i < cnt; i++) {
+		devc->dig_channel_bits[i] = i;
+		devc->dig_channel_masks[i] = 1 << i;
+	}
+	devc->conv_size = 0;
+	devc->batch_index = 0;
+}
+
+static void synth_stream(struct stream *s)
+{
+	GRand *rand;
+	size_t i, count;
+
+	count = SYNTH_PACKETS * PACKET_SIZE / sizeof(uint32_t);
+	s->data = g_malloc(count * sizeof(uint32_t));
+	s->packets = SYNTH_PACKETS;
+	rand = g_rand_new_with_seed(1);
+	for (i = 0; i < count; i++)
+		s->data[i] = g_rand_int(rand);
+	g_rand_free(rand);
+}
+
+static int load_stream(struct stream *s, const char *fn)
+{
+	gchar *data;
+	gsize len;
+	GError *error;
+
+	error = NULL;
+	if (!g_file_get_contents(fn, &data, &len, &error)) {
+		fprintf(stderr, "Cannot read %s: %s\n", fn, error->message);
+		g_error_free(error);
+		return -1;
+	}
+	if (len < PACKET_SIZE) {
+		fprintf(stderr, "%s holds no complete packet.\n", fn);
+		g_free(data);
+		return -1;
+	}
+	s->data = (uint32_t *)data;
+	s->packets = len / PACKET_SIZE;
+
+	return 0;
+}
+
+static size_t run(struct stream *s, void (*convert)(struct dev_context *,
+	const uint32_t *, size_t), size_t *bytes)
+{
+	size_t i, samples;
+	const uint32_t *src;
+
+	samples = 0;
+	src = s->data;
+	for (i = 0; i < s->packets; i++) {
+		convert(&s->devc, src, PACKET_SIZE / sizeof(uint32_t));
+		samples += s->devc.conv_size / 2;
+		src += PACKET_SIZE / sizeof(uint32_t);
+	}
+	*bytes = s->packets * PACKET_SIZE;
+
+	return samples;
+}
+
+static size_t convert_bitwise(void *data, size_t *bytes)
+{
+	return run(data, convert_naive, bytes);
+}
+
+static size_t convert_transpose(void *data, size_t *bytes)
+{
+	return run(data, saleae_logic_pro_convert_data, bytes);
+}
+
+/* Both conversions must yield the same samples, packet by packet. */
+static int check(struct stream *s)
+{
+	struct dev_context ref;
+	const uint32_t *src;
+	size_t i;
+	int ret;
+
+	ref = s->devc;
+	ref.conv_buffer = g_malloc0(CONV_BUFFER_SIZE);
+	ret = 0;
+	src = s->data;
+	for (i = 0; i < s->packets; i++) {
+		convert_naive(&ref, src, PACKET_SIZE / sizeof(uint32_t));
+		saleae_logic_pro_convert_data(&s->devc, src,
+			PACKET_SIZE / sizeof(uint32_t));
+		if (ref.conv_size != s->devc.conv_size ||
+				memcmp(ref.conv_buffer, s->devc.conv_buffer,
+				ref.conv_size) != 0) {
+			fprintf(stderr, "Conversion results differ.\n");
+			ret = -1;
+			break;
+		}
+		src += PACKET_SIZE / sizeof(uint32_t);
+	}
+	g_free(ref.conv_buffer);
+
+	return ret;
+}
+
+static int bench_channels(struct stream *s, unsigned int cnt)
+{
+	char name[64];
+
+	setup_channels(&s->devc, cnt);
+	if (check(s) < 0)
+		return -1;
+
+	g_snprintf(name, sizeof(name), "saleae_logic_pro_convert_bitwise_%uch", cnt);
+	bench_run(name, convert_bitwise, s);
+	g_snprintf(name, sizeof(name), "saleae_logic_pro_convert_transpose_%uch", cnt);
+	bench_run(name, convert_transpose, s);
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	static const unsigned int synth_channels[] = { 16, 8, 3 };
+	struct stream s;
+	unsigned int i, cnt;
+	int ret;
+
+	memset(&s, 0, sizeof(s));
+	s.devc.conv_buffer = g_malloc0(CONV_BUFFER_SIZE);
+
+	ret = 0;
+	if (argc > 1) {
+		cnt = argc > 2 ? strtoul(argv[2], NULL, 10) : 16;
+		if (cnt < 1 || cnt > 16) {
+			fprintf(stderr, "Invalid number of channels.\n");
+			ret = 1;
+		} else if (load_stream(&s, argv[1]) < 0) {
+			ret = 1;
+		} else if (bench_channels(&s, cnt) < 0) {
+			ret = 1;
+		}
+	} else {
+		synth_stream(&s);
+		for (i = 0; i < G_N_ELEMENTS(synth_channels); i++) {
+			if (bench_channels(&s, synth_channels[i]) < 0) {
+				ret = 1;
+				break;
+			}
+		}
+	}
+
+	g_free(s.data);
+	g_free(s.devc.conv_buffer);
+
+	return ret;
+}
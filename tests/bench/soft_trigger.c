@@ -0,0 +1,209 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 libsigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Software trigger benchmark.
+ *
+ * Runs soft_trigger_logic_check() on random logic data which never
+ * satisfies the trigger, which is what a driver's soft trigger spends
+ * most of its time on before the trigger fires:
+ *
+ *  - rising: A rising edge on one of 8 channels.
+ *  - pattern: A level pattern on 4 of 16 channels.
+ *  - stages: Two stages on 16 channels. The first stage matches half
+ *    of the samples, the second never, so the search backs up a lot.
+ *  - pretrigger: Like rising, while keeping pre-trigger samples.
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+#include "bench.h"
+
+#define PACKET_SAMPLES		(64 * 1024)
+#define PRE_TRIGGER_SAMPLES	(16 * 1024)
+
+struct search {
+	struct sr_dev_inst sdi;
+	struct sr_channel channels[16];
+	struct sr_trigger *trigger;
+	struct soft_trigger_logic *stl;
+	uint8_t *data;
+	size_t length;
+};
+
+/*
+ * The soft trigger sends pre-trigger data and the trigger marker to the
+ * session when the trigger fires. That never happens here.
+ */
+SR_PRIV int sr_session_send(const struct sr_dev_inst *sdi,
+	const struct sr_datafeed_packet *packet)
+{
+	(void)sdi;
+	(void)packet;
+
+	return SR_OK;
+}
+
+SR_PRIV int std_session_send_df_trigger(const struct sr_dev_inst *sdi)
+{
+	(void)sdi;
+
+	fprintf(stderr, "Trigger fired unexpectedly.\n");
+
+	return SR_OK;
+}
+
+static void setup_channels(struct search *s, unsigned int cnt)
+{
+	struct sr_channel *ch;
+	unsigned int i;
+
+	g_slist_free(s->sdi.channels);
+	s->sdi.channels = NULL;
+	for (i = 0; i < cnt; i++) {
+		ch = &s->channels[i];
+		ch->sdi = &s->sdi;
+		ch->index = i;
+		ch->type = SR_CHANNEL_LOGIC;
+		ch->enabled = TRUE;
+		ch->name = "";
+		s->sdi.channels = g_slist_append(s->sdi.channels, ch);
+	}
+}
+
+/* Random samples, with the given channels held low. */
+static void fill_data(struct search *s, unsigned int unitsize,
+	uint16_t low_mask)
+{
+	GRand *rand;
+	size_t i;
+	uint16_t sample;
+
+	rand = g_rand_new_with_seed(1);
+	s->length = PACKET_SAMPLES * unitsize;
+	for (i = 0; i < PACKET_SAMPLES; i++) {
+		sample = g_rand_int(rand) & ~low_mask;
+		s->data[i * unitsize] = sample & 0xff;
+		if (unitsize > 1)
+			s->data[i * unitsize + 1] = sample >> 8;
+	}
+	g_rand_free(rand);
+}
+
+static void add_match(struct sr_trigger_stage *stage, struct search *s,
+	unsigned int channel, int match)
+{
+	sr_trigger_match_add(stage, &s->channels[channel], match, 0);
+}
+
+static int setup(struct search *s, const char *name)
+{
+	struct sr_trigger_stage *stage;
+	int pre_trigger;
+
+	s->trigger = sr_trigger_new(name);
+	pre_trigger = 0;
+	if (strcmp(name, "rising") == 0 || strcmp(name, "pretrigger") == 0) {
+		setup_channels(s, 8);
+		fill_data(s, 1, 1 << 0);
+		stage = sr_trigger_stage_add(s->trigger);
+		add_match(stage, s, 0, SR_TRIGGER_RISING);
+		if (strcmp(name, "pretrigger") == 0)
+			pre_trigger = PRE_TRIGGER_SAMPLES;
+	} else if (strcmp(name, "pattern") == 0) {
+		setup_channels(s, 16);
+		fill_data(s, 2, 1 << 11);
+		stage = sr_trigger_stage_add(s->trigger);
+		add_match(stage, s, 0, SR_TRIGGER_ONE);
+		add_match(stage, s, 1, SR_TRIGGER_ONE);
+		add_match(stage, s, 2, SR_TRIGGER_ZERO);
+		add_match(stage, s, 11, SR_TRIGGER_ONE);
+	} else {
+		setup_channels(s, 16);
+		fill_data(s, 2, 1 << 9);
+		stage = sr_trigger_stage_add(s->trigger);
+		add_match(stage, s, 0, SR_TRIGGER_ONE);
+		stage = sr_trigger_stage_add(s->trigger);
+		add_match(stage, s, 1, SR_TRIGGER_ONE);
+		add_match(stage, s, 9, SR_TRIGGER_ONE);
+	}
+
+	s->stl = soft_trigger_logic_new(&s->sdi, s->trigger, pre_trigger);
+	if (!s->stl) {
+		fprintf(stderr, "Cannot set up the %s trigger.\n", name);
+		sr_trigger_free(s->trigger);
+		return -1;
+	}
+
+	return 0;
+}
+
+static void cleanup(struct search *s)
+{
+	soft_trigger_logic_free(s->stl);
+	sr_trigger_free(s->trigger);
+}
+
+static size_t check(void *data, size_t *bytes)
+{
+	struct search *s;
+	int pre_trigger_samples;
+
+	s = data;
+	if (soft_trigger_logic_check(s->stl, s->data, s->length,
+			&pre_trigger_samples) >= 0)
+		return 0;
+	*bytes = s->length;
+
+	return PACKET_SAMPLES;
+}
+
+int main(void)
+{
+	static const char *triggers[] = {
+		"rising", "pattern", "stages", "pretrigger",
+	};
+	struct search s;
+	char name[64];
+	size_t i;
+	int ret;
+
+	memset(&s, 0, sizeof(s));
+	s.data = g_malloc0(PACKET_SAMPLES * 2);
+
+	ret = 0;
+	for (i = 0; i < G_N_ELEMENTS(triggers); i++) {
+		if (setup(&s, triggers[i]) < 0) {
+			ret = 1;
+			break;
+		}
+		g_snprintf(name, sizeof(name), "soft_trigger_%s", triggers[i]);
+		bench_run(name, check, &s);
+		cleanup(&s);
+	}
+
+	g_slist_free(s.sdi.channels);
+	g_free(s.data);
+
+	return ret;
+}
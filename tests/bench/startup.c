@@ -0,0 +1,89 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 libsigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Library startup benchmark: The latency of an sr_init()/sr_exit() pair,
+ * which frontends pay on every launch.
+ *
+ *  - init_exit: Plain startup, as with the default log level.
+ *  - init_exit_checks: Startup with the internal sanity checks.
+ *  - init_exit_driver: Startup, and the initialization of one driver
+ *    (which initializes the USB and HID transports, too).
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
+#include <libsigrok/libsigrok.h>
+#include "bench.h"
+
+static size_t init_exit(void *data, size_t *bytes)
+{
+	struct sr_context *ctx;
+
+	(void)data;
+	(void)bytes;
+
+	if (sr_init(&ctx) != SR_OK)
+		return 0;
+	sr_exit(ctx);
+
+	return 1;
+}
+
+static size_t init_exit_driver(void *data, size_t *bytes)
+{
+	struct sr_context *ctx;
+	struct sr_dev_driver **drivers;
+	const char *name;
+	size_t i;
+
+	(void)bytes;
+
+	name = data;
+	if (sr_init(&ctx) != SR_OK)
+		return 0;
+	drivers = sr_driver_list(ctx);
+	for (i = 0; drivers && drivers[i]; i++) {
+		if (strcmp(drivers[i]->name, name) == 0) {
+			sr_driver_init(ctx, drivers[i]);
+			break;
+		}
+	}
+	sr_exit(ctx);
+
+	return 1;
+}
+
+int main(void)
+{
+	sr_log_loglevel_set(SR_LOG_WARN);
+
+	g_unsetenv("SIGROK_SANITY_CHECKS");
+	bench_run("init_exit", init_exit, NULL);
+
+	g_setenv("SIGROK_SANITY_CHECKS", "1", TRUE);
+	bench_run("init_exit_checks", init_exit, NULL);
+	g_unsetenv("SIGROK_SANITY_CHECKS");
+
+	bench_run("init_exit_driver", init_exit_driver, "demo");
+
+	return 0;
+}
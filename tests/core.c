@@ -29,7 +29,8 @@
  *  - Check whether an sr_init() call with a proper sr_ctx works.
  *    If it returns != SR_OK (or segfaults) this test will fail.
  *    The sr_init() call (among other things) also runs sanity checks on
- *    all libsigrok hardware drivers and errors out upon issues.
+ *    all libsigrok hardware drivers and errors out upon issues (the
+ *    test suite enables them, see main()).
  *
  *  - Check whether a subsequent sr_exit() with that sr_ctx works.
  *    If it returns != SR_OK (or segfaults) this test will fail.
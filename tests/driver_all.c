@@ -18,7 +18,9 @@
  */
 
 #include <config.h>
+#include <inttypes.h>
 #include <stdlib.h>
+#include <string.h>
 #include <check.h>
 #include <libsigrok/libsigrok.h>
 #include "lib.h"
@@ -59,6 +61,68 @@ START_TEST(test_config_get_set_samplerate)
 END_TEST
 #endif
 
+/*
+ * Check whether cached config values get updated when the config changes.
+ *
+ * Uses the demo driver, the test is skipped if it's not available.
+ */
+START_TEST(test_config_cache)
+{
+	struct sr_dev_driver **drivers, *driver;
+	struct sr_dev_inst *sdi;
+	GSList *devices;
+	GVariant *gvar;
+	uint64_t rate;
+	int i, ret;
+
+	driver = NULL;
+	drivers = sr_driver_list(srtest_ctx);
+	for (i = 0; drivers && drivers[i]; i++) {
+		if (!strcmp(drivers[i]->name, "demo"))
+			driver = drivers[i];
+	}
+	if (!driver)
+		return;
+
+	srtest_driver_init(srtest_ctx, driver);
+	devices = sr_driver_scan(driver, NULL);
+	fail_unless(devices != NULL, "No demo device found.");
+	sdi = devices->data;
+	g_slist_free(devices);
+	ret = sr_dev_open(sdi);
+	fail_unless(ret == SR_OK, "Failed to open demo device: %d.", ret);
+
+	ret = sr_config_cache_enable(sdi, TRUE);
+	fail_unless(ret == SR_OK, "Failed to enable config cache: %d.", ret);
+
+	ret = sr_config_set(sdi, NULL, SR_CONF_SAMPLERATE,
+		g_variant_new_uint64(SR_KHZ(19)));
+	fail_unless(ret == SR_OK, "Failed to set samplerate: %d.", ret);
+	for (i = 0; i < 2; i++) {
+		ret = sr_config_get(driver, sdi, NULL, SR_CONF_SAMPLERATE, &gvar);
+		fail_unless(ret == SR_OK, "Failed to get samplerate: %d.", ret);
+		rate = g_variant_get_uint64(gvar);
+		g_variant_unref(gvar);
+		fail_unless(rate == SR_KHZ(19), "Incorrect samplerate: %"
+			PRIu64 ".", rate);
+	}
+
+	/* A config change must not return the stale cached value. */
+	ret = sr_config_set(sdi, NULL, SR_CONF_SAMPLERATE,
+		g_variant_new_uint64(SR_KHZ(20)));
+	fail_unless(ret == SR_OK, "Failed to set samplerate: %d.", ret);
+	ret = sr_config_get(driver, sdi, NULL, SR_CONF_SAMPLERATE, &gvar);
+	fail_unless(ret == SR_OK, "Failed to get samplerate: %d.", ret);
+	rate = g_variant_get_uint64(gvar);
+	g_variant_unref(gvar);
+	fail_unless(rate == SR_KHZ(20), "Stale samplerate: %" PRIu64 ".", rate);
+
+	fail_unless(sr_config_cache_invalidate(sdi) == SR_OK);
+	fail_unless(sr_config_cache_enable(sdi, FALSE) == SR_OK);
+	sr_dev_close(sdi);
+}
+END_TEST
+
 Suite *suite_driver_all(void)
 {
 	Suite *s;
@@ -74,5 +138,10 @@ Suite *suite_driver_all(void)
 	// tcase_add_test(tc, test_config_get_set_samplerate);
 	suite_add_tcase(s, tc);
 
+	tc = tcase_create("config-cache");
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_config_cache);
+	suite_add_tcase(s, tc);
+
 	return s;
 }
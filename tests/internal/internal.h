@@ -0,0 +1,31 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 libsigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBSIGROK_TESTS_INTERNAL_INTERNAL_H
+#define LIBSIGROK_TESTS_INTERNAL_INTERNAL_H
+
+#include <check.h>
+
+Suite *suite_log_filter(void);
+Suite *suite_modbus_batch(void);
+Suite *suite_resource_image(void);
+Suite *suite_serial_reactor(void);
+Suite *suite_soft_trigger(void);
+
+#endif
@@ -0,0 +1,162 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 libsigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <config.h>
+#include <string.h>
+#include <check.h>
+#include <glib.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+#include "internal.h"
+
+#define LOG_PREFIX "output/srzip"
+
+/*
+ * The prefix cache is indexed by the prefix string's address. These
+ * copies of a prefix share one cache entry.
+ */
+#define CACHE_STRIDE	512
+static char shared_prefixes[2][CACHE_STRIDE];
+
+static int loglevel;
+
+static void setup(void)
+{
+	loglevel = sr_log_loglevel_get();
+	sr_log_loglevel_set(SR_LOG_WARN);
+	sr_log_filter_clear(NULL);
+}
+
+static void teardown(void)
+{
+	sr_log_filter_clear(NULL);
+	sr_log_loglevel_set(loglevel);
+}
+
+/* Check that a filter applies to the subsystems below its prefix. */
+START_TEST(test_inherit)
+{
+	fail_unless(sr_log_filter_set("output", SR_LOG_DBG) == SR_OK);
+	fail_unless(g_atomic_int_get(&sr_log_threshold) == SR_LOG_DBG);
+	fail_unless(g_atomic_int_get(&sr_log_filtered));
+
+	fail_unless(sr_log_prefix_enabled(SR_LOG_DBG, "output"));
+	fail_unless(sr_log_prefix_enabled(SR_LOG_DBG, "output/srzip"));
+	fail_unless(!sr_log_prefix_enabled(SR_LOG_SPEW, "output/srzip"));
+	fail_unless(sr_log_enabled(SR_LOG_DBG));
+	/* Only whole path components match. */
+	fail_unless(!sr_log_prefix_enabled(SR_LOG_DBG, "outputs"));
+	fail_unless(!sr_log_prefix_enabled(SR_LOG_DBG, "input/wav"));
+	fail_unless(sr_log_prefix_enabled(SR_LOG_WARN, "input/wav"));
+
+	/* The longest prefix wins. */
+	fail_unless(sr_log_filter_set("output/srzip", SR_LOG_ERR) == SR_OK);
+	fail_unless(!sr_log_enabled(SR_LOG_WARN));
+	fail_unless(sr_log_enabled(SR_LOG_ERR));
+	fail_unless(sr_log_prefix_enabled(SR_LOG_DBG, "output/wav"));
+
+	fail_unless(sr_log_filter_set(NULL, SR_LOG_DBG) == SR_ERR_ARG);
+	fail_unless(sr_log_filter_set("output", SR_LOG_SPEW + 1) == SR_ERR_ARG);
+}
+END_TEST
+
+/* Check that clearing filters restores the global loglevel. */
+START_TEST(test_clear)
+{
+	sr_log_filter_set("output", SR_LOG_DBG);
+	sr_log_filter_set("output/srzip", SR_LOG_ERR);
+
+	fail_unless(sr_log_filter_clear("output") == SR_OK);
+	fail_unless(!sr_log_prefix_enabled(SR_LOG_INFO, "output/wav"));
+	fail_unless(sr_log_prefix_enabled(SR_LOG_WARN, "output/wav"));
+	fail_unless(!sr_log_enabled(SR_LOG_WARN));
+	fail_unless(g_atomic_int_get(&sr_log_threshold) == SR_LOG_WARN);
+
+	/* Clearing an unknown prefix changes nothing. */
+	fail_unless(sr_log_filter_clear("input") == SR_OK);
+	fail_unless(!sr_log_enabled(SR_LOG_WARN));
+
+	fail_unless(sr_log_filter_clear(NULL) == SR_OK);
+	fail_unless(!g_atomic_int_get(&sr_log_filtered));
+	fail_unless(sr_log_enabled(SR_LOG_WARN));
+	fail_unless(!sr_log_enabled(SR_LOG_INFO));
+
+	/* The global loglevel still raises the threshold. */
+	sr_log_filter_set("output", SR_LOG_ERR);
+	sr_log_loglevel_set(SR_LOG_INFO);
+	fail_unless(g_atomic_int_get(&sr_log_threshold) == SR_LOG_INFO);
+	fail_unless(sr_log_prefix_enabled(SR_LOG_INFO, "input/wav"));
+	fail_unless(!sr_log_prefix_enabled(SR_LOG_WARN, "output/wav"));
+}
+END_TEST
+
+/*
+ * Check that the cached levels of each prefix string follow filter
+ * changes, also when several strings share a cache entry.
+ */
+START_TEST(test_cache)
+{
+	const char *a, *b;
+
+	a = shared_prefixes[0];
+	b = shared_prefixes[1];
+	strcpy(shared_prefixes[0], "output/srzip");
+	strcpy(shared_prefixes[1], "input/wav");
+	sr_log_filter_set("output", SR_LOG_DBG);
+
+	/* Fill the entry, then check the level of the same string again. */
+	fail_unless(sr_log_prefix_enabled(SR_LOG_DBG, a));
+	fail_unless(sr_log_prefix_enabled(SR_LOG_DBG, a));
+	sr_log_filter_set("output", SR_LOG_INFO);
+	fail_unless(!sr_log_prefix_enabled(SR_LOG_DBG, a));
+	fail_unless(sr_log_prefix_enabled(SR_LOG_INFO, a));
+
+	/* Another string takes over the entry, and gets its own level. */
+	fail_unless(!sr_log_prefix_enabled(SR_LOG_INFO, b));
+	fail_unless(sr_log_prefix_enabled(SR_LOG_INFO, a));
+	fail_unless(!sr_log_prefix_enabled(SR_LOG_INFO, b));
+
+	/* A filter for the other string invalidates the entry as well. */
+	sr_log_filter_set("input", SR_LOG_SPEW);
+	fail_unless(sr_log_prefix_enabled(SR_LOG_SPEW, b));
+	fail_unless(!sr_log_prefix_enabled(SR_LOG_DBG, a));
+
+	sr_log_filter_clear("output");
+	fail_unless(!sr_log_prefix_enabled(SR_LOG_INFO, a));
+	fail_unless(sr_log_prefix_enabled(SR_LOG_WARN, a));
+}
+END_TEST
+
+Suite *suite_log_filter(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("log_filter");
+
+	tc = tcase_create("filter");
+	tcase_add_checked_fixture(tc, setup, teardown);
+	tcase_add_test(tc, test_inherit);
+	tcase_add_test(tc, test_clear);
+	tcase_add_test(tc, test_cache);
+	suite_add_tcase(s, tc);
+
+	return s;
+}
@@ -0,0 +1,50 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 libsigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Tests of internal routines. These are hidden in the shared library,
+ * so the tests link the library sources of interest directly.
+ */
+
+#include <config.h>
+#include <stdlib.h>
+#include <check.h>
+#include "internal.h"
+
+int main(void)
+{
+	int ret;
+	Suite *s;
+	SRunner *srunner;
+
+	s = suite_create("internal");
+	srunner = srunner_create(s);
+
+	srunner_add_suite(srunner, suite_log_filter());
+	srunner_add_suite(srunner, suite_modbus_batch());
+	srunner_add_suite(srunner, suite_resource_image());
+	srunner_add_suite(srunner, suite_serial_reactor());
+	srunner_add_suite(srunner, suite_soft_trigger());
+
+	srunner_run_all(srunner, CK_VERBOSE);
+	ret = srunner_ntests_failed(srunner);
+	srunner_free(srunner);
+
+	return (ret == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
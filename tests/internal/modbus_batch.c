@@ -0,0 +1,321 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 libsigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <string.h>
+#include <check.h>
+#include <glib.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+#include "internal.h"
+
+#ifdef HAVE_SERIAL_COMM
+/* The Modbus core lists the serial transport, which is not used here. */
+SR_PRIV const struct sr_modbus_dev_inst modbus_serial_rtu_dev = {
+	.name = "serial_rtu",
+	.prefix = "",
+};
+#endif
+
+/*
+ * A simulated slave, which answers "read holding registers" requests.
+ * Register values are derived from their address. Requests which
+ * include registers below "gap_start" and registers at or above
+ * "gap_end" get rejected, like with devices which refuse requests that
+ * span unimplemented registers.
+ */
+struct fake_slave {
+	int requests;
+	int requested_registers;
+	int gap_start;
+	int gap_end;
+	uint8_t reply[2 + 2 * 125];
+	int reply_len;
+	int reply_pos;
+};
+
+static struct fake_slave slave;
+static struct sr_modbus_dev_inst modbus;
+
+static uint16_t register_value(int address)
+{
+	return address ^ 0x5a00;
+}
+
+static int fake_send(void *priv, const uint8_t *buffer, int buffer_size)
+{
+	struct fake_slave *fake = priv;
+	int address, nb_registers, i;
+
+	fail_unless(buffer_size == 5);
+	fail_unless(buffer[0] == 0x03);
+	address = RB16(buffer + 1);
+	nb_registers = RB16(buffer + 3);
+	fake->requests++;
+	fake->requested_registers += nb_registers;
+
+	if (fake->gap_end > fake->gap_start && address < fake->gap_start
+	    && address + nb_registers > fake->gap_end) {
+		/* Exception 0x02: Illegal data address. */
+		W8(fake->reply + 0, 0x83);
+		W8(fake->reply + 1, 0x02);
+		fake->reply_len = 2;
+	} else {
+		W8(fake->reply + 0, 0x03);
+		W8(fake->reply + 1, 2 * nb_registers);
+		for (i = 0; i < nb_registers; i++)
+			WB16(fake->reply + 2 + 2 * i, register_value(address + i));
+		fake->reply_len = 2 + 2 * nb_registers;
+	}
+	fake->reply_pos = 0;
+
+	return SR_OK;
+}
+
+static int fake_read_begin(void *priv, uint8_t *function_code)
+{
+	struct fake_slave *fake = priv;
+
+	*function_code = fake->reply[fake->reply_pos++];
+
+	return SR_OK;
+}
+
+static int fake_read_data(void *priv, uint8_t *buf, int maxlen)
+{
+	struct fake_slave *fake = priv;
+	int len;
+
+	len = MIN(maxlen, fake->reply_len - fake->reply_pos);
+	memcpy(buf, fake->reply + fake->reply_pos, len);
+	fake->reply_pos += len;
+
+	return len;
+}
+
+static int fake_read_end(void *priv)
+{
+	(void)priv;
+
+	return SR_OK;
+}
+
+static void setup(void)
+{
+	memset(&slave, 0, sizeof(slave));
+	memset(&modbus, 0, sizeof(modbus));
+	modbus.name = "fake";
+	modbus.prefix = "";
+	modbus.send = fake_send;
+	modbus.read_begin = fake_read_begin;
+	modbus.read_data = fake_read_data;
+	modbus.read_end = fake_read_end;
+	modbus.read_timeout_ms = 1000;
+	modbus.priv = &slave;
+}
+
+/* Check that a range of the batch holds the slave's register values. */
+static void check_range(const struct sr_modbus_batch *batch,
+		int address, int nb_registers)
+{
+	uint16_t registers[125];
+	int ret, i;
+
+	ret = sr_modbus_batch_get(batch, address, nb_registers, registers);
+	fail_unless(ret == SR_OK, "Registers at 0x%04x not available.",
+		address);
+	for (i = 0; i < nb_registers; i++)
+		fail_unless(RB16(&registers[i]) == register_value(address + i),
+			"Wrong value at 0x%04x.", address + i);
+}
+
+/* Check that adjacent and overlapping ranges take a single request. */
+START_TEST(test_merge_adjacent)
+{
+	struct sr_modbus_batch *batch;
+	int ret;
+
+	batch = sr_modbus_batch_new();
+	sr_modbus_batch_add(batch, 20, 5, FALSE);
+	sr_modbus_batch_add(batch, 10, 10, FALSE);
+	sr_modbus_batch_add(batch, 12, 4, FALSE);
+	ret = sr_modbus_batch_read(&modbus, batch);
+	fail_unless(ret == SR_OK);
+	fail_unless(slave.requests == 1, "%d requests.", slave.requests);
+	fail_unless(slave.requested_registers == 15);
+	check_range(batch, 10, 10);
+	check_range(batch, 12, 4);
+	check_range(batch, 20, 5);
+	check_range(batch, 10, 15);
+	sr_modbus_batch_free(batch);
+}
+END_TEST
+
+/* Check that gaps only get bridged up to the configured size. */
+START_TEST(test_merge_gap)
+{
+	struct sr_modbus_batch *batch;
+	int ret;
+
+	batch = sr_modbus_batch_new();
+	sr_modbus_batch_add(batch, 0, 10, FALSE);
+	sr_modbus_batch_add(batch, 0x52, 2, FALSE);
+	ret = sr_modbus_batch_read(&modbus, batch);
+	fail_unless(ret == SR_OK);
+	fail_unless(slave.requests == 2, "%d requests.", slave.requests);
+
+	sr_modbus_batch_set_max_gap(batch, 0x52 - 10 - 1);
+	ret = sr_modbus_batch_read(&modbus, batch);
+	fail_unless(ret == SR_OK);
+	fail_unless(slave.requests == 4, "%d requests.", slave.requests);
+
+	sr_modbus_batch_set_max_gap(batch, 0x52 - 10);
+	ret = sr_modbus_batch_read(&modbus, batch);
+	fail_unless(ret == SR_OK);
+	fail_unless(slave.requests == 5, "%d requests.", slave.requests);
+	fail_unless(slave.requested_registers == 2 * 12 + 0x54);
+	check_range(batch, 0, 10);
+	check_range(batch, 0x52, 2);
+	sr_modbus_batch_free(batch);
+}
+END_TEST
+
+/* Check that merged requests do not exceed the Modbus limit. */
+START_TEST(test_merge_limit)
+{
+	struct sr_modbus_batch *batch;
+	uint16_t registers[10];
+	int ret;
+
+	batch = sr_modbus_batch_new();
+	sr_modbus_batch_set_max_gap(batch, 1000);
+	sr_modbus_batch_add(batch, 0, 100, FALSE);
+	sr_modbus_batch_add(batch, 100, 25, FALSE);
+	sr_modbus_batch_add(batch, 125, 1, FALSE);
+	sr_modbus_batch_add(batch, 200, 10, FALSE);
+	ret = sr_modbus_batch_read(&modbus, batch);
+	fail_unless(ret == SR_OK);
+	fail_unless(slave.requests == 2, "%d requests.", slave.requests);
+	fail_unless(slave.requested_registers == 125 + 85);
+	check_range(batch, 0, 125);
+	check_range(batch, 125, 1);
+	check_range(batch, 200, 10);
+
+	/* Ranges are not split. */
+	fail_unless(sr_modbus_batch_get(batch, 120, 10, registers) == SR_ERR_ARG);
+	fail_unless(sr_modbus_batch_add(batch, 0, 126, FALSE) == SR_ERR_ARG);
+	sr_modbus_batch_free(batch);
+}
+END_TEST
+
+/*
+ * Check that static ranges only get read once, and again after they
+ * were invalidated, and that they do not get merged with other ranges
+ * across gaps.
+ */
+START_TEST(test_static)
+{
+	struct sr_modbus_batch *batch;
+	int ret;
+
+	batch = sr_modbus_batch_new();
+	sr_modbus_batch_set_max_gap(batch, 10);
+	sr_modbus_batch_add(batch, 0, 4, TRUE);
+	sr_modbus_batch_add(batch, 8, 4, FALSE);
+	ret = sr_modbus_batch_read(&modbus, batch);
+	fail_unless(ret == SR_OK);
+	fail_unless(slave.requests == 2, "%d requests.", slave.requests);
+
+	ret = sr_modbus_batch_read(&modbus, batch);
+	fail_unless(ret == SR_OK);
+	fail_unless(slave.requests == 3, "%d requests.", slave.requests);
+	check_range(batch, 0, 4);
+
+	sr_modbus_batch_invalidate(batch, 2, 1);
+	ret = sr_modbus_batch_read(&modbus, batch);
+	fail_unless(ret == SR_OK);
+	fail_unless(slave.requests == 5, "%d requests.", slave.requests);
+
+	/*
+	 * Overlapping ranges are static only when all of them are, the
+	 * result merges with the other changing range then.
+	 */
+	sr_modbus_batch_add(batch, 3, 2, FALSE);
+	ret = sr_modbus_batch_read(&modbus, batch);
+	fail_unless(ret == SR_OK);
+	ret = sr_modbus_batch_read(&modbus, batch);
+	fail_unless(ret == SR_OK);
+	fail_unless(slave.requests == 7, "%d requests.", slave.requests);
+	check_range(batch, 0, 12);
+	sr_modbus_batch_free(batch);
+}
+END_TEST
+
+/*
+ * Check that a rejected request leaves the other ranges available, and
+ * that the ranges can be read separately then.
+ */
+START_TEST(test_rejected)
+{
+	struct sr_modbus_batch *batch;
+	uint16_t registers[2];
+	int ret;
+
+	slave.gap_start = 10;
+	slave.gap_end = 0x52;
+	batch = sr_modbus_batch_new();
+	sr_modbus_batch_add(batch, 0, 10, FALSE);
+	sr_modbus_batch_add(batch, 0x52, 2, FALSE);
+	sr_modbus_batch_add(batch, 0x100, 2, FALSE);
+	sr_modbus_batch_set_max_gap(batch, 0x52 - 10);
+	ret = sr_modbus_batch_read(&modbus, batch);
+	fail_unless(ret == SR_ERR_DATA);
+	fail_unless(slave.requests == 2, "%d requests.", slave.requests);
+	ret = sr_modbus_batch_get(batch, 0x52, 2, registers);
+	fail_unless(ret == SR_ERR_DATA);
+	check_range(batch, 0x100, 2);
+
+	sr_modbus_batch_set_max_gap(batch, 0);
+	ret = sr_modbus_batch_read(&modbus, batch);
+	fail_unless(ret == SR_OK);
+	fail_unless(slave.requests == 5, "%d requests.", slave.requests);
+	check_range(batch, 0, 10);
+	check_range(batch, 0x52, 2);
+	sr_modbus_batch_free(batch);
+}
+END_TEST
+
+Suite *suite_modbus_batch(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("modbus_batch");
+
+	tc = tcase_create("plan");
+	tcase_add_checked_fixture(tc, setup, NULL);
+	tcase_add_test(tc, test_merge_adjacent);
+	tcase_add_test(tc, test_merge_gap);
+	tcase_add_test(tc, test_merge_limit);
+	tcase_add_test(tc, test_static);
+	tcase_add_test(tc, test_rejected);
+	suite_add_tcase(s, tc);
+
+	return s;
+}
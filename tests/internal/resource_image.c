@@ -0,0 +1,185 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 libsigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <string.h>
+#include <utime.h>
+#include <check.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+#include "internal.h"
+
+#define IMAGE_NAME	"test-image.bin"
+#define MAX_SIZE	1024
+
+static struct sr_context *ctx;
+static char *dir;
+static char *filename;
+
+static void write_image(const char *contents, time_t mtime)
+{
+	struct utimbuf times;
+
+	fail_unless(g_file_set_contents(filename, contents, -1, NULL));
+	times.actime = mtime;
+	times.modtime = mtime;
+	fail_unless(g_utime(filename, &times) == 0);
+}
+
+static gboolean image_is(const struct sr_resource_image *image,
+		const char *contents)
+{
+	return image->size == strlen(contents) &&
+		memcmp(image->data, contents, image->size) == 0;
+}
+
+static void setup(void)
+{
+	dir = g_dir_make_tmp("sigrok-test-XXXXXX", NULL);
+	fail_unless(dir != NULL);
+	filename = g_build_filename(dir, IMAGE_NAME, NULL);
+	g_setenv("SIGROK_FIRMWARE_DIR", dir, TRUE);
+	g_unsetenv("SIGROK_FIRMWARE_MMAP");
+
+	ctx = g_malloc0(sizeof(*ctx));
+	sr_resource_cache_init(ctx);
+	sr_resource_set_hooks(ctx, NULL, NULL, NULL, NULL);
+}
+
+static void teardown(void)
+{
+	sr_resource_cache_free(ctx);
+	g_free(ctx);
+	g_unlink(filename);
+	g_rmdir(dir);
+	g_free(filename);
+	g_free(dir);
+	g_unsetenv("SIGROK_FIRMWARE_DIR");
+}
+
+/*
+ * Check that images are shared while cached, and that they stay valid
+ * after they were dropped from the cache, until they get released.
+ */
+START_TEST(test_refcount)
+{
+	struct sr_resource_image *image1, *image2, *image3;
+
+	write_image("first", 1000000);
+	image1 = sr_resource_image_get(ctx, SR_RESOURCE_FIRMWARE,
+		IMAGE_NAME, MAX_SIZE);
+	fail_unless(image1 != NULL);
+	fail_unless(image_is(image1, "first"));
+	image2 = sr_resource_image_get(ctx, SR_RESOURCE_FIRMWARE,
+		IMAGE_NAME, MAX_SIZE);
+	fail_unless(image2 == image1);
+	sr_resource_image_unref(image2);
+
+	sr_resource_cache_clear(ctx);
+	fail_unless(image_is(image1, "first"));
+	image3 = sr_resource_image_get(ctx, SR_RESOURCE_FIRMWARE,
+		IMAGE_NAME, MAX_SIZE);
+	fail_unless(image3 != NULL && image3 != image1);
+	fail_unless(strcmp(image3->hash, image1->hash) == 0);
+	sr_resource_image_unref(image1);
+	sr_resource_image_unref(image3);
+
+	/* Images which exceed the caller's limit are not used. */
+	image1 = sr_resource_image_get(ctx, SR_RESOURCE_FIRMWARE,
+		IMAGE_NAME, 2);
+	fail_unless(image1 == NULL);
+}
+END_TEST
+
+/* Check that files which changed on disk get loaded again. */
+START_TEST(test_mtime)
+{
+	struct sr_resource_image *image1, *image2;
+
+	write_image("first", 1000000);
+	image1 = sr_resource_image_get(ctx, SR_RESOURCE_FIRMWARE,
+		IMAGE_NAME, MAX_SIZE);
+	fail_unless(image1 != NULL);
+
+	/* Same size, only the modification time tells. */
+	write_image("other", 1000010);
+	image2 = sr_resource_image_get(ctx, SR_RESOURCE_FIRMWARE,
+		IMAGE_NAME, MAX_SIZE);
+	fail_unless(image2 != NULL && image2 != image1);
+	fail_unless(image_is(image2, "other"));
+	fail_unless(strcmp(image2->hash, image1->hash) != 0);
+	/* The previous contents stay valid for their user. */
+	fail_unless(image_is(image1, "first"));
+	sr_resource_image_unref(image1);
+	sr_resource_image_unref(image2);
+}
+END_TEST
+
+/* Check the record of the images which devices got loaded with. */
+START_TEST(test_set_loaded)
+{
+	struct sr_resource_image *image1, *image2;
+
+	write_image("first", 1000000);
+	image1 = sr_resource_image_get(ctx, SR_RESOURCE_FIRMWARE,
+		IMAGE_NAME, MAX_SIZE);
+	fail_unless(image1 != NULL);
+	fail_unless(!sr_resource_image_loaded(ctx, "1.2", image1));
+
+	sr_resource_image_set_loaded(ctx, "1.2", image1);
+	fail_unless(sr_resource_image_loaded(ctx, "1.2", image1));
+	fail_unless(!sr_resource_image_loaded(ctx, "1.3", image1));
+
+	/* A device which is loaded with other contents. */
+	write_image("other", 1000010);
+	image2 = sr_resource_image_get(ctx, SR_RESOURCE_FIRMWARE,
+		IMAGE_NAME, MAX_SIZE);
+	fail_unless(image2 != NULL);
+	fail_unless(!sr_resource_image_loaded(ctx, "1.2", image2));
+
+	/* The record survives the cache, it is by contents. */
+	sr_resource_cache_clear(ctx);
+	fail_unless(sr_resource_image_loaded(ctx, "1.2", image1));
+
+	sr_resource_image_set_loaded(ctx, "1.2", NULL);
+	fail_unless(!sr_resource_image_loaded(ctx, "1.2", image1));
+	fail_unless(!sr_resource_image_loaded(ctx, "1.2", image2));
+	sr_resource_image_unref(image1);
+	sr_resource_image_unref(image2);
+}
+END_TEST
+
+Suite *suite_resource_image(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("resource_image");
+
+	tc = tcase_create("cache");
+	tcase_add_checked_fixture(tc, setup, teardown);
+	tcase_add_test(tc, test_refcount);
+	tcase_add_test(tc, test_mtime);
+	tcase_add_test(tc, test_set_loaded);
+	suite_add_tcase(s, tc);
+
+	return s;
+}
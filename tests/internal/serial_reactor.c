@@ -0,0 +1,378 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 libsigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <config.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <check.h>
+#include <glib.h>
+#ifdef HAVE_LIBSERIALPORT
+#include <libserialport.h>
+#endif
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+#include "internal.h"
+
+#if defined HAVE_SERIAL_COMM && defined HAVE_LIBSERIALPORT && \
+	defined HAVE_SYS_EPOLL_H
+
+#define PACKET_SIZE	4
+#define PACKET_SYNC	0xaa
+/* The reactor's queue limit, see REACTOR_MAX_QUEUED. */
+#define MAX_QUEUED	256
+#define WAIT_MS		2000
+#define SLOW_READ_MS	300
+
+/*
+ * A serial port which reads from a pipe. The reactor takes its fd from
+ * sp_get_port_handle(), and reads through the port's lib_funcs.
+ */
+struct fake_port {
+	struct sr_serial_dev_inst serial;
+	struct sr_dev_inst sdi;
+	int fds[2];
+	int notify_fd;
+	/* Make the next read() take SLOW_READ_MS, and tell when it does. */
+	gint slow;
+	gint in_slow_read;
+};
+
+static struct fake_port ports[2];
+
+static int fake_read(struct sr_serial_dev_inst *serial, void *buf,
+	size_t count, int nonblocking, unsigned int timeout_ms)
+{
+	struct fake_port *fp;
+	ssize_t ret;
+
+	(void)nonblocking;
+	(void)timeout_ms;
+
+	fp = (struct fake_port *)serial->sp_data;
+	if (g_atomic_int_compare_and_exchange(&fp->slow, 1, 0)) {
+		g_atomic_int_set(&fp->in_slow_read, 1);
+		g_usleep(SLOW_READ_MS * 1000);
+		g_atomic_int_set(&fp->in_slow_read, 0);
+	}
+	ret = read(fp->fds[0], buf, count);
+	if (ret < 0)
+		return (errno == EAGAIN) ? 0 : SR_ERR_IO;
+
+	return ret;
+}
+
+static struct ser_lib_functions fake_lib_funcs = {
+	.read = fake_read,
+};
+
+SR_PRIV struct ser_lib_functions *ser_lib_funcs_libsp = &fake_lib_funcs;
+
+enum sp_return sp_get_port_handle(const struct sp_port *port,
+	void *result_ptr)
+{
+	const struct fake_port *fp;
+
+	fp = (const struct fake_port *)port;
+	*(int *)result_ptr = fp->fds[0];
+
+	return SP_OK;
+}
+
+/* The session sources of the reactor's notification pipes. */
+SR_PRIV int sr_session_fd_source_add(struct sr_session *session,
+	void *key, gintptr fd, int events, int timeout,
+	sr_receive_data_callback cb, void *cb_data)
+{
+	struct fake_port *fp;
+
+	(void)session;
+	(void)key;
+	(void)events;
+	(void)timeout;
+	(void)cb;
+
+	fp = cb_data;
+	fp->notify_fd = fd;
+
+	return SR_OK;
+}
+
+SR_PRIV int sr_session_source_remove_internal(struct sr_session *session,
+	void *key)
+{
+	(void)session;
+	(void)key;
+
+	return SR_OK;
+}
+
+static int packet_valid(const uint8_t *buf)
+{
+	return buf[0] == PACKET_SYNC;
+}
+
+static void port_setup(struct fake_port *fp, const char *name)
+{
+	int ret;
+
+	memset(fp, 0, sizeof(*fp));
+	fail_unless(pipe(fp->fds) == 0);
+	fcntl(fp->fds[0], F_SETFL, fcntl(fp->fds[0], F_GETFL) | O_NONBLOCK);
+	fp->notify_fd = -1;
+	fp->serial.port = (char *)name;
+	fp->serial.lib_funcs = ser_lib_funcs_libsp;
+	fp->serial.sp_data = (struct sp_port *)fp;
+	fp->sdi.inst_type = SR_INST_SERIAL;
+	fp->sdi.conn = &fp->serial;
+
+	ret = serial_reactor_source_add(NULL, &fp->serial, PACKET_SIZE,
+		packet_valid, NULL, NULL, -1, NULL, fp);
+	fail_unless(ret == SR_OK, "Registration failed: %d.", ret);
+	fail_unless(fp->notify_fd >= 0);
+}
+
+static void port_teardown(struct fake_port *fp)
+{
+	if (fp->serial.reactor_port)
+		serial_reactor_source_remove(NULL, &fp->serial);
+	if (fp->fds[0] >= 0)
+		close(fp->fds[0]);
+	if (fp->fds[1] >= 0)
+		close(fp->fds[1]);
+}
+
+static void setup(void)
+{
+	g_setenv("SIGROK_SERIAL_REACTOR", "1", TRUE);
+	port_setup(&ports[0], "fake0");
+	port_setup(&ports[1], "fake1");
+}
+
+static void teardown(void)
+{
+	port_teardown(&ports[0]);
+	port_teardown(&ports[1]);
+	g_unsetenv("SIGROK_SERIAL_REACTOR");
+}
+
+static void write_packet(struct fake_port *fp, uint8_t index)
+{
+	uint8_t packet[PACKET_SIZE] = { PACKET_SYNC, index, 0x55, ~index };
+
+	fail_unless(write(fp->fds[1], packet, sizeof(packet)) == PACKET_SIZE);
+}
+
+static gboolean wait_notified(struct fake_port *fp)
+{
+	struct pollfd pfd;
+
+	pfd.fd = fp->notify_fd;
+	pfd.events = POLLIN;
+
+	return poll(&pfd, 1, WAIT_MS) == 1;
+}
+
+/* Wait until the reactor has queued a number of packets of a port. */
+static void wait_rx_packets(struct fake_port *fp, uint64_t count)
+{
+	struct sr_serial_reactor_stats stats;
+	int64_t deadline;
+
+	deadline = g_get_monotonic_time() + WAIT_MS * 1000;
+	do {
+		fail_unless(sr_serial_reactor_stats_get(&fp->sdi, &stats) == SR_OK);
+		if (stats.rx_packets >= count)
+			return;
+		g_usleep(1000);
+	} while (g_get_monotonic_time() < deadline);
+	fail_unless(FALSE, "Got %" PRIu64 " of %" PRIu64 " packets.",
+		stats.rx_packets, count);
+}
+
+/* Check that the RX stream gets cut into packets, and re-synchronized. */
+START_TEST(test_packets)
+{
+	struct sr_serial_reactor_stats stats;
+	uint8_t junk[] = { 0x00, 0x11 };
+	uint8_t buf[16];
+	int i, ret;
+
+	fail_unless(write(ports[0].fds[1], junk, sizeof(junk)) == sizeof(junk));
+	for (i = 0; i < 3; i++)
+		write_packet(&ports[0], i);
+	wait_rx_packets(&ports[0], 3);
+	fail_unless(wait_notified(&ports[0]), "No notification.");
+
+	for (i = 0; i < 3; i++) {
+		ret = serial_reactor_read_packet(&ports[0].serial,
+			buf, sizeof(buf));
+		fail_unless(ret == PACKET_SIZE, "Read returned %d.", ret);
+		fail_unless(buf[0] == PACKET_SYNC && buf[1] == i);
+	}
+	ret = serial_reactor_read_packet(&ports[0].serial, buf, sizeof(buf));
+	fail_unless(ret == 0, "Read returned %d.", ret);
+
+	fail_unless(sr_serial_reactor_stats_get(&ports[0].sdi, &stats) == SR_OK);
+	fail_unless(stats.rx_bytes == sizeof(junk) + 3 * PACKET_SIZE);
+	fail_unless(stats.rx_packets == 3);
+	fail_unless(stats.dropped_bytes == sizeof(junk));
+	fail_unless(stats.dropped_packets == 0);
+	fail_unless(stats.latency_count == 3);
+	fail_unless(stats.latency_us_max <= stats.latency_us_sum);
+
+	/* The other port saw nothing. */
+	fail_unless(sr_serial_reactor_stats_get(&ports[1].sdi, &stats) == SR_OK);
+	fail_unless(stats.rx_bytes == 0 && stats.rx_packets == 0);
+}
+END_TEST
+
+/* Check that the oldest packets get dropped when the reader lags. */
+START_TEST(test_overflow)
+{
+	struct sr_serial_reactor_stats stats;
+	uint8_t buf[PACKET_SIZE];
+	int i, ret;
+
+	for (i = 0; i < MAX_QUEUED + 10; i++)
+		write_packet(&ports[0], i);
+	wait_rx_packets(&ports[0], MAX_QUEUED + 10);
+
+	for (i = 10; i < MAX_QUEUED + 10; i++) {
+		ret = serial_reactor_read_packet(&ports[0].serial,
+			buf, sizeof(buf));
+		fail_unless(ret == PACKET_SIZE, "Read returned %d.", ret);
+		fail_unless(buf[1] == (uint8_t)i, "Got packet %d, not %d.",
+			buf[1], i);
+	}
+	ret = serial_reactor_read_packet(&ports[0].serial, buf, sizeof(buf));
+	fail_unless(ret == 0, "Read returned %d.", ret);
+
+	sr_serial_reactor_stats_get(&ports[0].sdi, &stats);
+	fail_unless(stats.dropped_packets == 10);
+	fail_unless(stats.latency_count == MAX_QUEUED);
+}
+END_TEST
+
+/* Check that a hangup is reported after the remaining packets. */
+START_TEST(test_hangup)
+{
+	uint8_t buf[PACKET_SIZE];
+	int ret;
+
+	write_packet(&ports[0], 1);
+	close(ports[0].fds[1]);
+	ports[0].fds[1] = -1;
+	fail_unless(wait_notified(&ports[0]), "No notification.");
+	wait_rx_packets(&ports[0], 1);
+
+	ret = serial_reactor_read_packet(&ports[0].serial, buf, sizeof(buf));
+	fail_unless(ret == PACKET_SIZE, "Read returned %d.", ret);
+	/* The hangup might come after the packet's notification. */
+	ret = 0;
+	while (ret == 0 && wait_notified(&ports[0]))
+		ret = serial_reactor_read_packet(&ports[0].serial,
+			buf, sizeof(buf));
+	fail_unless(ret == SR_ERR_IO, "Read returned %d.", ret);
+
+	/* The other port still works. */
+	write_packet(&ports[1], 2);
+	fail_unless(wait_notified(&ports[1]), "No notification.");
+}
+END_TEST
+
+/*
+ * Check that a port which the reactor thread reads doesn't block the
+ * others' readers, and that its removal waits for the read to finish.
+ */
+START_TEST(test_busy_port)
+{
+	struct sr_serial_reactor_stats stats;
+	uint8_t buf[PACKET_SIZE];
+	int64_t start;
+	int ret;
+
+	write_packet(&ports[1], 1);
+	wait_rx_packets(&ports[1], 1);
+
+	g_atomic_int_set(&ports[0].slow, 1);
+	write_packet(&ports[0], 2);
+	while (!g_atomic_int_get(&ports[0].in_slow_read))
+		g_usleep(1000);
+
+	start = g_get_monotonic_time();
+	ret = serial_reactor_read_packet(&ports[1].serial, buf, sizeof(buf));
+	fail_unless(ret == PACKET_SIZE, "Read returned %d.", ret);
+	fail_unless(sr_serial_reactor_stats_get(&ports[1].sdi, &stats) == SR_OK);
+	fail_unless(g_atomic_int_get(&ports[0].in_slow_read));
+	fail_unless(g_get_monotonic_time() - start < SLOW_READ_MS * 1000 / 2,
+		"Reading a port waited for another port's read().");
+
+	ret = serial_reactor_source_remove(NULL, &ports[0].serial);
+	fail_unless(ret == SR_OK);
+	fail_unless(!g_atomic_int_get(&ports[0].in_slow_read),
+		"Removal didn't wait for the port's read().");
+	fail_unless(!ports[0].serial.reactor_port);
+	ret = sr_serial_reactor_stats_get(&ports[0].sdi, &stats);
+	fail_unless(ret == SR_ERR_NA);
+}
+END_TEST
+
+START_TEST(test_stats_bogus)
+{
+	struct sr_serial_reactor_stats stats;
+	struct sr_dev_inst sdi;
+
+	fail_unless(sr_serial_reactor_stats_get(NULL, &stats) == SR_ERR_ARG);
+	fail_unless(sr_serial_reactor_stats_get(&ports[0].sdi, NULL) ==
+		SR_ERR_ARG);
+	memset(&sdi, 0, sizeof(sdi));
+	sdi.inst_type = SR_INST_USB;
+	fail_unless(sr_serial_reactor_stats_get(&sdi, &stats) == SR_ERR_ARG);
+}
+END_TEST
+
+#endif
+
+Suite *suite_serial_reactor(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("serial_reactor");
+
+#if defined HAVE_SERIAL_COMM && defined HAVE_LIBSERIALPORT && \
+	defined HAVE_SYS_EPOLL_H
+	tc = tcase_create("reactor");
+	tcase_add_checked_fixture(tc, setup, teardown);
+	tcase_add_test(tc, test_packets);
+	tcase_add_test(tc, test_overflow);
+	tcase_add_test(tc, test_hangup);
+	tcase_add_test(tc, test_busy_port);
+	tcase_add_test(tc, test_stats_bogus);
+	suite_add_tcase(s, tc);
+#else
+	(void)tc;
+#endif
+
+	return s;
+}
@@ -0,0 +1,346 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 libsigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <string.h>
+#include <check.h>
+#include <glib.h>
+#include <libsigrok/libsigrok.h>
+#include "libsigrok-internal.h"
+#include "internal.h"
+
+#define NUM_CHANNELS	8
+#define PRE_TRIGGER	100
+
+/*
+ * Logic data with a rising edge on channel 0 as the trigger. The data
+ * before the trigger holds channel 0 low, and tells its position in
+ * the acquisition (modulo 128).
+ */
+#define STREAM_BYTE(pos)	((uint8_t)((pos) << 1))
+#define TRIGGER_BYTE		0x01
+
+static struct sr_dev_inst sdi;
+static struct sr_channel channels[NUM_CHANNELS];
+static struct sr_trigger *trigger;
+static struct soft_trigger_logic *stl;
+
+/* The acquisition's data, in the buffers which the driver received. */
+static uint8_t data[8][256];
+static size_t stream_pos;
+
+/* What the soft trigger sent to the session. */
+static GByteArray *sent;
+static int triggers;
+static int released;
+
+SR_PRIV int sr_session_send(const struct sr_dev_inst *sdi,
+	const struct sr_datafeed_packet *packet)
+{
+	const struct sr_datafeed_logic *logic;
+
+	(void)sdi;
+
+	fail_unless(packet->type == SR_DF_LOGIC);
+	logic = packet->payload;
+	fail_unless(logic->unitsize == 1);
+	fail_unless(logic->length > 0);
+	g_byte_array_append(sent, logic->data, logic->length);
+
+	return SR_OK;
+}
+
+SR_PRIV int std_session_send_df_trigger(const struct sr_dev_inst *sdi)
+{
+	(void)sdi;
+
+	triggers++;
+
+	return SR_OK;
+}
+
+static void release_cb(void *handle, void *cb_data)
+{
+	(void)handle;
+	(void)cb_data;
+
+	released++;
+}
+
+static void setup(void)
+{
+	struct sr_trigger_stage *stage;
+	int i;
+
+	memset(&sdi, 0, sizeof(sdi));
+	for (i = 0; i < NUM_CHANNELS; i++) {
+		channels[i].sdi = &sdi;
+		channels[i].index = i;
+		channels[i].type = SR_CHANNEL_LOGIC;
+		channels[i].enabled = TRUE;
+		channels[i].name = "";
+		sdi.channels = g_slist_append(sdi.channels, &channels[i]);
+	}
+	sr_dev_metrics_reset(&sdi.metrics);
+
+	trigger = sr_trigger_new(NULL);
+	stage = sr_trigger_stage_add(trigger);
+	sr_trigger_match_add(stage, &channels[0], SR_TRIGGER_RISING, 0);
+	stl = soft_trigger_logic_new(&sdi, trigger, PRE_TRIGGER);
+	fail_unless(stl != NULL);
+
+	sent = g_byte_array_new();
+	stream_pos = 0;
+	triggers = 0;
+	released = 0;
+}
+
+static void teardown(void)
+{
+	soft_trigger_logic_free(stl);
+	sr_trigger_free(trigger);
+	g_slist_free(sdi.channels);
+	g_byte_array_free(sent, TRUE);
+}
+
+/* Fill the next buffer, with the trigger at the given offset, or -1. */
+static uint8_t *next_buffer(int idx, size_t len, int trigger_offset)
+{
+	uint8_t *buf;
+	size_t i;
+
+	buf = data[idx];
+	for (i = 0; i < len; i++) {
+		if ((int)i == trigger_offset)
+			buf[i] = TRIGGER_BYTE;
+		else
+			buf[i] = STREAM_BYTE(stream_pos + i);
+	}
+	if (trigger_offset < 0)
+		stream_pos += len;
+	else
+		stream_pos += trigger_offset;
+
+	return buf;
+}
+
+/* Check that the data before the trigger got sent, as far as it was kept. */
+static void check_sent(size_t len)
+{
+	size_t first, i;
+
+	fail_unless(triggers == 1);
+	fail_unless(sent->len == len, "Sent %u bytes, expected %zu.",
+		sent->len, len);
+	first = stream_pos - len;
+	for (i = 0; i < len; i++)
+		fail_unless(sent->data[i] == STREAM_BYTE(first + i),
+			"Wrong pre-trigger data at %zu.", i);
+}
+
+static void check_metrics(void)
+{
+	const struct soft_trigger_stats *m;
+
+	m = &sdi.metrics.soft_trigger;
+	fail_unless(sr_metric_get(&m->bytes_copied) == stl->stats.bytes_copied);
+	fail_unless(sr_metric_get(&m->bytes_retained) ==
+		stl->stats.bytes_retained);
+	fail_unless(sr_metric_get(&m->bytes_dropped) ==
+		stl->stats.bytes_dropped);
+	fail_unless(sr_metric_get(&m->bytes_sent) == stl->stats.bytes_sent);
+	fail_unless(sr_metric_get(&m->triggers) == stl->stats.triggers);
+	fail_unless(sr_metric_get(&m->fill_bytes) == stl->stats.fill_bytes);
+}
+
+static int check_retained(int idx, size_t len, int trigger_offset,
+		int *pre_trigger_samples)
+{
+	uint8_t *buf;
+	gboolean retained;
+	int offset;
+
+	buf = next_buffer(idx, len, trigger_offset);
+	offset = soft_trigger_logic_check_buffer(stl, buf, len,
+		pre_trigger_samples, buf, &retained);
+	fail_unless(retained == (offset < 0));
+
+	return offset;
+}
+
+/*
+ * Check a pre-trigger window which spans several retained buffers, and
+ * that buffers which got older than the window are handed back.
+ */
+START_TEST(test_retained_window)
+{
+	int i, offset, pre_trigger_samples;
+
+	soft_trigger_logic_retain_buffers(stl, 8, release_cb, NULL);
+	for (i = 0; i < 5; i++) {
+		offset = check_retained(i, 30, -1, NULL);
+		fail_unless(offset == -1);
+	}
+	/* The oldest buffer is out of the window. */
+	fail_unless(released == 1);
+	fail_unless(stl->stats.bytes_dropped == 30);
+	fail_unless(sdi.metrics.soft_trigger.fill_bytes == 120);
+
+	offset = check_retained(5, 30, 10, &pre_trigger_samples);
+	fail_unless(offset == 10);
+	fail_unless(pre_trigger_samples == PRE_TRIGGER);
+	check_sent(PRE_TRIGGER);
+	fail_unless(released == 5);
+	/* The whole oldest buffer which was still kept was skipped. */
+	fail_unless(stl->stats.bytes_dropped == 60);
+	fail_unless(stl->stats.bytes_sent == PRE_TRIGGER);
+	fail_unless(stl->stats.fill_bytes == 0);
+	check_metrics();
+}
+END_TEST
+
+/*
+ * Check the data which gets skipped at the trigger: copied data which
+ * wraps around in the circular buffer, followed by retained buffers.
+ */
+START_TEST(test_send_skip)
+{
+	int i, offset, pre_trigger_samples;
+
+	/* Copied only, the circular buffer wraps around. */
+	for (i = 0; i < 2; i++) {
+		offset = soft_trigger_logic_check(stl,
+			next_buffer(i, 70, -1), 70, NULL);
+		fail_unless(offset == -1);
+	}
+	fail_unless(stl->stats.bytes_copied == 140);
+	offset = soft_trigger_logic_check(stl, next_buffer(2, 40, 25), 40,
+		&pre_trigger_samples);
+	fail_unless(offset == 25);
+	fail_unless(pre_trigger_samples == PRE_TRIGGER);
+	check_sent(PRE_TRIGGER);
+	fail_unless(stl->stats.bytes_dropped == 40 + 25);
+	check_metrics();
+}
+END_TEST
+
+START_TEST(test_send_skip_retained)
+{
+	int i, offset, pre_trigger_samples;
+
+	/* Two buffers retained, the older ones copied. */
+	soft_trigger_logic_retain_buffers(stl, 2, release_cb, NULL);
+	for (i = 0; i < 4; i++) {
+		offset = check_retained(i, 40, -1, NULL);
+		fail_unless(offset == -1);
+	}
+	fail_unless(released == 2);
+	fail_unless(stl->stats.bytes_copied == 80);
+	fail_unless(stl->stats.bytes_retained == 160);
+	fail_unless(stl->stats.bytes_dropped == 0);
+
+	/* 80 copied, 80 retained and 10 current bytes: skip 70. */
+	offset = check_retained(4, 40, 10, &pre_trigger_samples);
+	fail_unless(offset == 10);
+	fail_unless(pre_trigger_samples == PRE_TRIGGER);
+	check_sent(PRE_TRIGGER);
+	fail_unless(released == 4);
+	fail_unless(stl->stats.bytes_dropped == 70);
+	check_metrics();
+}
+END_TEST
+
+/*
+ * Check that data which exceeds the window gets dropped, with buffers
+ * which are larger than the window.
+ */
+START_TEST(test_drop_large_buffers)
+{
+	int i, offset, pre_trigger_samples;
+
+	soft_trigger_logic_retain_buffers(stl, 2, release_cb, NULL);
+	for (i = 0; i < 3; i++) {
+		offset = check_retained(i, 150, -1, NULL);
+		fail_unless(offset == -1);
+	}
+	/* Only the newest buffer is needed. */
+	fail_unless(released == 2);
+	fail_unless(stl->stats.bytes_dropped == 2 * 150);
+	fail_unless(stl->stats.fill_bytes == 150);
+
+	offset = check_retained(3, 150, 5, &pre_trigger_samples);
+	fail_unless(offset == 5);
+	fail_unless(pre_trigger_samples == PRE_TRIGGER);
+	check_sent(PRE_TRIGGER);
+	fail_unless(stl->stats.bytes_dropped == 2 * 150 + 55);
+	check_metrics();
+
+	/* Copied data, larger than the window. */
+	soft_trigger_logic_free(stl);
+	stl = soft_trigger_logic_new(&sdi, trigger, PRE_TRIGGER);
+	g_byte_array_set_size(sent, 0);
+	triggers = 0;
+	offset = soft_trigger_logic_check(stl, next_buffer(0, 150, -1), 150,
+		NULL);
+	fail_unless(offset == -1);
+	fail_unless(stl->stats.bytes_copied == PRE_TRIGGER);
+	fail_unless(stl->stats.bytes_dropped == 50);
+	offset = soft_trigger_logic_check(stl, next_buffer(1, 10, 0), 10,
+		&pre_trigger_samples);
+	fail_unless(offset == 0);
+	fail_unless(pre_trigger_samples == PRE_TRIGGER);
+	check_sent(PRE_TRIGGER);
+}
+END_TEST
+
+/* Check a trigger which fires before the window is filled. */
+START_TEST(test_short_window)
+{
+	int offset, pre_trigger_samples;
+
+	soft_trigger_logic_retain_buffers(stl, 8, release_cb, NULL);
+	offset = check_retained(0, 30, -1, NULL);
+	fail_unless(offset == -1);
+	offset = check_retained(1, 30, 5, &pre_trigger_samples);
+	fail_unless(offset == 5);
+	fail_unless(pre_trigger_samples == 35);
+	check_sent(35);
+	fail_unless(stl->stats.bytes_dropped == 0);
+	check_metrics();
+}
+END_TEST
+
+Suite *suite_soft_trigger(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("soft_trigger");
+
+	tc = tcase_create("pre_trigger");
+	tcase_add_checked_fixture(tc, setup, teardown);
+	tcase_add_test(tc, test_retained_window);
+	tcase_add_test(tc, test_send_skip);
+	tcase_add_test(tc, test_send_skip_retained);
+	tcase_add_test(tc, test_drop_large_buffers);
+	tcase_add_test(tc, test_short_window);
+	suite_add_tcase(s, tc);
+
+	return s;
+}
@@ -160,3 +160,44 @@ GArray *srtest_get_enabled_logic_channels(const struct sr_dev_inst *sdi)
 
 	return channels;
 }
+
+/*
+ * Scan for a demo device with the given number of logic and analog
+ * channels. Returns NULL when the demo driver is not available. The
+ * device belongs to the driver, sr_exit() releases it.
+ */
+struct sr_dev_inst *srtest_demo_dev_get(int num_logic, int num_analog)
+{
+	struct sr_dev_driver **drivers, *driver;
+	struct sr_config logic_cfg, analog_cfg;
+	struct sr_dev_inst *sdi;
+	GSList *options, *devices;
+	int i;
+
+	driver = NULL;
+	drivers = sr_driver_list(srtest_ctx);
+	for (i = 0; drivers && drivers[i]; i++) {
+		if (!strcmp(drivers[i]->name, "demo"))
+			driver = drivers[i];
+	}
+	if (!driver)
+		return NULL;
+	if (!driver->context)
+		srtest_driver_init(srtest_ctx, driver);
+
+	logic_cfg.key = SR_CONF_NUM_LOGIC_CHANNELS;
+	logic_cfg.data = g_variant_ref_sink(g_variant_new_int32(num_logic));
+	analog_cfg.key = SR_CONF_NUM_ANALOG_CHANNELS;
+	analog_cfg.data = g_variant_ref_sink(g_variant_new_int32(num_analog));
+	options = g_slist_append(NULL, &logic_cfg);
+	options = g_slist_append(options, &analog_cfg);
+	devices = sr_driver_scan(driver, options);
+	g_slist_free(options);
+	g_variant_unref(logic_cfg.data);
+	g_variant_unref(analog_cfg.data);
+	fail_unless(devices != NULL, "No demo device found.");
+	sdi = devices->data;
+	g_slist_free(devices);
+
+	return sdi;
+}
@@ -40,6 +40,7 @@ void srtest_check_samplerate(struct sr_context *sr_ctx, const char *drivername,
 			     uint64_t samplerate);
 
 GArray *srtest_get_enabled_logic_channels(const struct sr_dev_inst *sdi);
+struct sr_dev_inst *srtest_demo_dev_get(int num_logic, int num_analog);
 
 Suite *suite_core(void);
 Suite *suite_driver_all(void);
@@ -54,5 +55,6 @@ Suite *suite_device(void);
 Suite *suite_trigger(void);
 Suite *suite_analog(void);
 Suite *suite_conv(void);
+Suite *suite_log(void);
 
 #endif
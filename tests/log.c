@@ -0,0 +1,230 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 libsigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <stdlib.h>
+#include <string.h>
+#include <check.h>
+#include <glib.h>
+#include <libsigrok/libsigrok.h>
+#include "lib.h"
+
+#define LOG_THREADS	4
+#define LOG_MESSAGES	2000
+
+/*
+ * The tests log through public calls which log errors: Setting an
+ * invalid loglevel, and sr_exit(NULL). Each is one call site.
+ */
+#define BAD_LOGLEVEL	(SR_LOG_SPEW + 1)
+
+struct log_count {
+	gint loglevel_msgs;
+	gint exit_msgs;
+	gint other_msgs;
+	gint bad_format;
+};
+
+static int log_count_cb(void *cb_data, int loglevel, const char *format,
+		va_list args)
+{
+	struct log_count *count;
+	const char *message;
+
+	(void)loglevel;
+
+	count = cb_data;
+	if (strcmp(format, "%s") != 0) {
+		g_atomic_int_inc(&count->bad_format);
+		return SR_OK;
+	}
+	message = va_arg(args, const char *);
+	if (strstr(message, "Invalid loglevel"))
+		g_atomic_int_inc(&count->loglevel_msgs);
+	else if (strstr(message, "context was NULL"))
+		g_atomic_int_inc(&count->exit_msgs);
+	else
+		g_atomic_int_inc(&count->other_msgs);
+
+	return SR_OK;
+}
+
+static gpointer log_thread(gpointer data)
+{
+	int i;
+
+	(void)data;
+
+	for (i = 0; i < LOG_MESSAGES; i++)
+		sr_log_loglevel_set(BAD_LOGLEVEL);
+
+	return NULL;
+}
+
+static int loglevel;
+
+static void log_setup(void)
+{
+	loglevel = sr_log_loglevel_get();
+	sr_log_loglevel_set(SR_LOG_ERR);
+}
+
+static void log_teardown(void)
+{
+	sr_log_async_rate_limit_set(0);
+	sr_log_callback_set_default();
+	sr_log_loglevel_set(loglevel);
+}
+
+/*
+ * Check that messages of several threads all get passed on, or counted
+ * as dropped, and that the callback only gets complete messages.
+ */
+START_TEST(test_async_threads)
+{
+	struct log_count count;
+	GThread *threads[LOG_THREADS];
+	uint64_t logged, dropped, limited;
+	int i, ret;
+
+	memset(&count, 0, sizeof(count));
+	ret = sr_log_callback_set_async(log_count_cb, &count);
+	fail_unless(ret == SR_OK);
+	for (i = 0; i < LOG_THREADS; i++)
+		threads[i] = g_thread_new("log-test", log_thread, NULL);
+	for (i = 0; i < LOG_THREADS; i++)
+		g_thread_join(threads[i]);
+	ret = sr_log_async_flush();
+	fail_unless(ret == SR_OK);
+
+	ret = sr_log_async_stats_get(&logged, &dropped, &limited);
+	fail_unless(ret == SR_OK);
+	fail_unless(logged + dropped == LOG_THREADS * LOG_MESSAGES,
+		"%" PRIu64 " logged and %" PRIu64 " dropped messages.",
+		logged, dropped);
+	fail_unless(limited == 0);
+	fail_unless(logged > 0);
+	fail_unless(g_atomic_int_get(&count.bad_format) == 0);
+	fail_unless((uint64_t)g_atomic_int_get(&count.loglevel_msgs) == logged);
+}
+END_TEST
+
+/* Check the rate limit, for two call sites. */
+START_TEST(test_async_rate_limit)
+{
+	struct log_count count;
+	uint64_t limited;
+	int i;
+
+	memset(&count, 0, sizeof(count));
+	sr_log_callback_set_async(log_count_cb, &count);
+	sr_log_async_rate_limit_set(5);
+	for (i = 0; i < 50; i++) {
+		sr_log_loglevel_set(BAD_LOGLEVEL);
+		sr_exit(NULL);
+	}
+	sr_log_async_flush();
+	sr_log_async_stats_get(NULL, NULL, &limited);
+
+	/* Each site may pass twice its limit, when a second starts. */
+	fail_unless(count.loglevel_msgs >= 5 && count.loglevel_msgs <= 10);
+	fail_unless(count.exit_msgs >= 5 && count.exit_msgs <= 10);
+	fail_unless(limited == 100 - (uint64_t)(count.loglevel_msgs +
+		count.exit_msgs));
+}
+END_TEST
+
+/*
+ * Check that restarting the asynchronous logging while other threads
+ * log loses no queued messages, and that the statistics start over.
+ */
+START_TEST(test_async_restart)
+{
+	struct log_count count;
+	GThread *threads[LOG_THREADS];
+	uint64_t logged, dropped;
+	int i;
+
+	memset(&count, 0, sizeof(count));
+	sr_log_callback_set_async(log_count_cb, &count);
+	for (i = 0; i < LOG_THREADS; i++)
+		threads[i] = g_thread_new("log-test", log_thread, NULL);
+	for (i = 0; i < 20; i++)
+		sr_log_callback_set_async(log_count_cb, &count);
+	for (i = 0; i < LOG_THREADS; i++)
+		g_thread_join(threads[i]);
+	sr_log_async_flush();
+	fail_unless(g_atomic_int_get(&count.bad_format) == 0);
+
+	sr_log_callback_set_async(log_count_cb, &count);
+	sr_log_async_stats_get(&logged, &dropped, NULL);
+	fail_unless(logged == 0 && dropped == 0);
+	sr_log_loglevel_set(BAD_LOGLEVEL);
+	sr_log_async_flush();
+	sr_log_async_stats_get(&logged, NULL, NULL);
+	fail_unless(logged == 1);
+}
+END_TEST
+
+/* Check that sr_exit() stops the asynchronous logging. */
+START_TEST(test_async_exit)
+{
+	struct log_count count;
+	struct sr_context *ctx;
+	sr_log_callback cb, default_cb;
+	int ret;
+
+	sr_log_callback_set_default();
+	sr_log_callback_get(&default_cb, NULL);
+
+	memset(&count, 0, sizeof(count));
+	ret = sr_init(&ctx);
+	fail_unless(ret == SR_OK);
+	sr_log_callback_set_async(log_count_cb, &count);
+	sr_log_loglevel_set(BAD_LOGLEVEL);
+	ret = sr_exit(ctx);
+	fail_unless(ret == SR_OK);
+
+	sr_log_callback_get(&cb, NULL);
+	fail_unless(cb == default_cb);
+	fail_unless(count.loglevel_msgs == 1);
+
+	/* Flushing without asynchronous logging returns right away. */
+	ret = sr_log_async_flush();
+	fail_unless(ret == SR_OK);
+}
+END_TEST
+
+Suite *suite_log(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("log");
+
+	tc = tcase_create("async");
+	tcase_add_checked_fixture(tc, log_setup, log_teardown);
+	tcase_add_test(tc, test_async_threads);
+	tcase_add_test(tc, test_async_rate_limit);
+	tcase_add_test(tc, test_async_restart);
+	tcase_add_test(tc, test_async_exit);
+	suite_add_tcase(s, tc);
+
+	return s;
+}
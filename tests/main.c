@@ -20,6 +20,7 @@
 #include <config.h>
 #include <stdlib.h>
 #include <check.h>
+#include <glib.h>
 #include <libsigrok/libsigrok.h>
 #include "lib.h"
 
@@ -29,6 +30,9 @@ int main(void)
 	Suite *s;
 	SRunner *srunner;
 
+	/* Have sr_init() run its internal sanity checks. */
+	g_setenv("SIGROK_SANITY_CHECKS", "1", TRUE);
+
 	s = suite_create("mastersuite");
 	srunner = srunner_create(s);
 
@@ -46,6 +50,7 @@ int main(void)
 	srunner_add_suite(srunner, suite_trigger());
 	srunner_add_suite(srunner, suite_analog());
 	srunner_add_suite(srunner, suite_conv());
+	srunner_add_suite(srunner, suite_log());
 
 	srunner_run_all(srunner, CK_VERBOSE);
 	ret = srunner_ntests_failed(srunner);
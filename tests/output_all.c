@@ -19,6 +19,9 @@
 
 #include <config.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
 #include <check.h>
 #include <libsigrok/libsigrok.h>
 #include "lib.h"
@@ -96,6 +99,290 @@ START_TEST(test_output_options)
 }
 END_TEST
 
+static void send_packet(const struct sr_output *o, int type,
+		const void *payload, GString *stream)
+{
+	struct sr_datafeed_packet packet;
+	GString *out;
+
+	packet.type = type;
+	packet.payload = payload;
+	out = NULL;
+	fail_unless(sr_output_send(o, &packet, &out) == SR_OK);
+	if (out) {
+		if (stream)
+			g_string_append_len(stream, out->str, out->len);
+		g_string_free(out, TRUE);
+	}
+}
+
+static uint16_t read_u16le(const uint8_t *p)
+{
+	return p[0] | p[1] << 8;
+}
+
+static uint32_t read_u32le(const uint8_t *p)
+{
+	return read_u16le(p) | (uint32_t)read_u16le(p + 2) << 16;
+}
+
+/*
+ * Get the bodyLength field (the fourth) of an Arrow IPC message's
+ * flatbuffer, which follows the marker and the metadata size.
+ */
+static uint64_t arrow_body_length(const uint8_t *msg)
+{
+	const uint8_t *fb, *table, *vtable;
+	uint16_t offset;
+
+	fb = msg + 8;
+	table = fb + read_u32le(fb);
+	vtable = table - (int32_t)read_u32le(table);
+	if (read_u16le(vtable) < 4 + 2 * 4)
+		return 0;
+	offset = read_u16le(vtable + 4 + 2 * 3);
+	if (!offset)
+		return 0;
+
+	return read_u32le(table + offset) |
+		(uint64_t)read_u32le(table + offset + 4) << 32;
+}
+
+/* Check that the arrow module frames its messages, and ends the stream. */
+START_TEST(test_output_arrow)
+{
+	static const char eos[] = "\xff\xff\xff\xff\0\0\0\0";
+	struct sr_dev_inst *sdi;
+	const struct sr_output *o;
+	struct sr_datafeed_header header;
+	struct sr_datafeed_logic logic;
+	GString *stream;
+	const uint8_t *msg;
+	uint64_t body_len;
+	size_t pos;
+	uint8_t data[100];
+
+	sdi = srtest_demo_dev_get(2, 0);
+	if (!sdi)
+		return;
+	o = sr_output_new(sr_output_find("arrow"), NULL, sdi, NULL);
+	fail_unless(o != NULL, "Couldn't create an 'arrow' output.");
+
+	memset(&header, 0, sizeof(header));
+	header.feed_version = 1;
+	memset(data, 0x55, sizeof(data));
+	logic.length = sizeof(data);
+	logic.unitsize = 1;
+	logic.data = data;
+	stream = g_string_new(NULL);
+	send_packet(o, SR_DF_HEADER, &header, stream);
+	send_packet(o, SR_DF_LOGIC, &logic, stream);
+	send_packet(o, SR_DF_END, NULL, stream);
+	sr_output_free(o);
+
+	/* Schema, one record batch, end of stream, all 8-byte aligned. */
+	fail_unless(stream->len > 3 * 8 && stream->len % 8 == 0);
+	fail_unless(!memcmp(stream->str, eos, 4), "No message marker.");
+	fail_unless(!memcmp(stream->str + stream->len - 8, eos, 8),
+		"No end of stream marker.");
+
+	/* The schema has no body. */
+	msg = (const uint8_t *)stream->str;
+	body_len = arrow_body_length(msg);
+	fail_unless(body_len == 0, "Schema has a body.");
+	pos = 8 + read_u32le(msg + 4);
+
+	/* The record batch's body reaches up to the end of stream marker. */
+	fail_unless(pos + 8 < stream->len);
+	msg = (const uint8_t *)stream->str + pos;
+	fail_unless(!memcmp(msg, eos, 4), "No message marker.");
+	body_len = arrow_body_length(msg);
+	fail_unless(body_len > 0, "Record batch has no body.");
+	pos += 8 + read_u32le(msg + 4) + body_len;
+	fail_unless(pos == stream->len - 8, "Wrong record batch body length.");
+	g_string_free(stream, TRUE);
+}
+END_TEST
+
+static void send_analog(const struct sr_output *o, struct sr_channel *ch,
+		float *data, int num_samples)
+{
+	struct sr_datafeed_analog analog;
+	struct sr_analog_encoding encoding;
+	struct sr_analog_meaning meaning;
+	struct sr_analog_spec spec;
+
+	memset(&encoding, 0, sizeof(encoding));
+	encoding.unitsize = sizeof(float);
+	encoding.is_float = TRUE;
+#ifdef WORDS_BIGENDIAN
+	encoding.is_bigendian = TRUE;
+#endif
+	encoding.scale.p = encoding.scale.q = 1;
+	encoding.offset.q = 1;
+	memset(&meaning, 0, sizeof(meaning));
+	meaning.channels = g_slist_append(NULL, ch);
+	memset(&spec, 0, sizeof(spec));
+	memset(&analog, 0, sizeof(analog));
+	analog.data = data;
+	analog.num_samples = num_samples;
+	analog.encoding = &encoding;
+	analog.meaning = &meaning;
+	analog.spec = &spec;
+	send_packet(o, SR_DF_ANALOG, &analog, NULL);
+	g_slist_free(meaning.channels);
+}
+
+/*
+ * Check the wav module's header sizes and PCM conversion. The channels
+ * are sent in separate packets, samples out of range get clamped.
+ */
+START_TEST(test_output_wav)
+{
+	static float data0[] = { 0.25, -2.0, 1.5 };
+	static float data1[] = { 0.0, -0.25, 0.0 };
+	struct sr_dev_inst *sdi;
+	struct sr_channel *ch0, *ch1;
+	const struct sr_output *o;
+	struct sr_datafeed_header header;
+	struct sr_datafeed_meta meta;
+	struct sr_config src;
+	GHashTable *options;
+	gchar *path, *contents;
+	gsize len;
+	const uint8_t *p;
+	int fd;
+
+	sdi = srtest_demo_dev_get(0, 2);
+	if (!sdi)
+		return;
+	ch0 = g_slist_nth_data(sr_dev_inst_channels_get(sdi), 0);
+	ch1 = g_slist_nth_data(sr_dev_inst_channels_get(sdi), 1);
+
+	fd = g_file_open_tmp("sr-test-XXXXXX.wav", &path, NULL);
+	fail_unless(fd >= 0, "Couldn't create a temporary file.");
+	close(fd);
+	options = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+		(GDestroyNotify)g_variant_unref);
+	g_hash_table_insert(options, "format",
+		g_variant_ref_sink(g_variant_new_string("pcm16")));
+	o = sr_output_new(sr_output_find("wav"), options, sdi, path);
+	g_hash_table_destroy(options);
+	fail_unless(o != NULL, "Couldn't create a 'wav' output.");
+
+	memset(&header, 0, sizeof(header));
+	header.feed_version = 1;
+	src.key = SR_CONF_SAMPLERATE;
+	src.data = g_variant_ref_sink(g_variant_new_uint64(48000));
+	meta.config = g_slist_append(NULL, &src);
+	send_packet(o, SR_DF_HEADER, &header, NULL);
+	send_packet(o, SR_DF_META, &meta, NULL);
+	send_analog(o, ch0, data0, G_N_ELEMENTS(data0));
+	send_analog(o, ch1, data1, G_N_ELEMENTS(data1));
+	send_packet(o, SR_DF_END, NULL, NULL);
+	sr_output_free(o);
+	g_slist_free(meta.config);
+	g_variant_unref(src.data);
+
+	fail_unless(g_file_get_contents(path, &contents, &len, NULL));
+	g_unlink(path);
+	g_free(path);
+
+	/* RIFF, JUNK (room for ds64), fmt and data chunks, 3 frames. */
+	p = (const uint8_t *)contents;
+	fail_unless(len == 80 + 3 * 2 * 2, "Wrong file size %zu.", len);
+	fail_unless(!memcmp(p, "RIFF", 4) && read_u32le(p + 4) == len - 8,
+		"Wrong RIFF size.");
+	fail_unless(!memcmp(p + 8, "WAVE", 4) && !memcmp(p + 12, "JUNK", 4));
+	fail_unless(!memcmp(p + 48, "fmt ", 4) && read_u32le(p + 52) == 16);
+	fail_unless(read_u16le(p + 56) == 1, "Wrong format tag.");
+	fail_unless(read_u16le(p + 58) == 2, "Wrong number of channels.");
+	fail_unless(read_u32le(p + 60) == 48000, "Wrong samplerate.");
+	fail_unless(read_u16le(p + 68) == 4, "Wrong block alignment.");
+	fail_unless(read_u16le(p + 70) == 16, "Wrong bits per sample.");
+	fail_unless(!memcmp(p + 72, "data", 4), "No data chunk.");
+	fail_unless(read_u32le(p + 76) == 3 * 2 * 2, "Wrong data size.");
+	fail_unless((int16_t)read_u16le(p + 80) == 8192);
+	fail_unless((int16_t)read_u16le(p + 82) == 0);
+	fail_unless((int16_t)read_u16le(p + 84) == -32767, "No clamping.");
+	fail_unless((int16_t)read_u16le(p + 86) == -8192);
+	fail_unless((int16_t)read_u16le(p + 88) == 32767, "No clamping.");
+	g_free(contents);
+}
+END_TEST
+
+/*
+ * Check that channels which send large separate packets, as scopes do,
+ * stay in sync instead of getting filled up with silence.
+ */
+#define WAV_BIG_PACKET	300000
+
+START_TEST(test_output_wav_big_packets)
+{
+	struct sr_dev_inst *sdi;
+	struct sr_channel *ch0, *ch1;
+	const struct sr_output *o;
+	struct sr_datafeed_header header;
+	GHashTable *options;
+	gchar *path, *contents;
+	gsize len, bad;
+	const uint8_t *p;
+	float *data0, *data1;
+	int fd, i;
+
+	sdi = srtest_demo_dev_get(0, 2);
+	if (!sdi)
+		return;
+	ch0 = g_slist_nth_data(sr_dev_inst_channels_get(sdi), 0);
+	ch1 = g_slist_nth_data(sr_dev_inst_channels_get(sdi), 1);
+
+	fd = g_file_open_tmp("sr-test-XXXXXX.wav", &path, NULL);
+	fail_unless(fd >= 0, "Couldn't create a temporary file.");
+	close(fd);
+	options = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+		(GDestroyNotify)g_variant_unref);
+	g_hash_table_insert(options, "format",
+		g_variant_ref_sink(g_variant_new_string("pcm16")));
+	o = sr_output_new(sr_output_find("wav"), options, sdi, path);
+	g_hash_table_destroy(options);
+	fail_unless(o != NULL, "Couldn't create a 'wav' output.");
+
+	data0 = g_malloc(WAV_BIG_PACKET * sizeof(float));
+	data1 = g_malloc(WAV_BIG_PACKET * sizeof(float));
+	for (i = 0; i < WAV_BIG_PACKET; i++) {
+		data0[i] = 0.5;
+		data1[i] = -0.5;
+	}
+	memset(&header, 0, sizeof(header));
+	header.feed_version = 1;
+	send_packet(o, SR_DF_HEADER, &header, NULL);
+	for (i = 0; i < 2; i++) {
+		send_analog(o, ch0, data0, WAV_BIG_PACKET);
+		send_analog(o, ch1, data1, WAV_BIG_PACKET);
+	}
+	send_packet(o, SR_DF_END, NULL, NULL);
+	sr_output_free(o);
+	g_free(data0);
+	g_free(data1);
+
+	fail_unless(g_file_get_contents(path, &contents, &len, NULL));
+	g_unlink(path);
+	g_free(path);
+
+	p = (const uint8_t *)contents;
+	fail_unless(len == 80 + 2 * WAV_BIG_PACKET * 2 * 2,
+		"Wrong file size %zu.", len);
+	bad = 0;
+	for (p += 80; p < (const uint8_t *)contents + len; p += 4) {
+		if ((int16_t)read_u16le(p) != 16384 ||
+				(int16_t)read_u16le(p + 2) != -16384)
+			bad++;
+	}
+	fail_unless(bad == 0, "%zu frames are out of sync.", bad);
+	g_free(contents);
+}
+END_TEST
+
 Suite *suite_output_all(void)
 {
 	Suite *s;
@@ -112,5 +399,16 @@ Suite *suite_output_all(void)
 	tcase_add_test(tc, test_output_options);
 	suite_add_tcase(s, tc);
 
+	tc = tcase_create("wav");
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_output_wav);
+	tcase_add_test(tc, test_output_wav_big_packets);
+	suite_add_tcase(s, tc);
+
+	tc = tcase_create("arrow");
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_output_arrow);
+	suite_add_tcase(s, tc);
+
 	return s;
 }
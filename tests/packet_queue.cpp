@@ -0,0 +1,184 @@
+/*
+ * This file is part of the libsigrok project.
+ *
+ * Copyright (C) 2026 libsigrok contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <stdlib.h>
+#include <check.h>
+#include <libsigrokcxx/libsigrokcxx.hpp>
+
+using namespace std;
+using namespace sigrok;
+
+#define DEMO_SAMPLES 10000
+
+/* A session with a demo device, which stops after DEMO_SAMPLES. */
+static shared_ptr<Session> demo_session(shared_ptr<Context> context)
+{
+	auto drivers = context->drivers();
+	if (!drivers.count("demo"))
+		return nullptr;
+	auto devices = drivers["demo"]->scan();
+	if (devices.empty())
+		return nullptr;
+	auto device = devices.front();
+	device->open();
+	device->config_set(ConfigKey::LIMIT_SAMPLES,
+		Glib::Variant<guint64>::create(DEMO_SAMPLES));
+
+	auto session = context->create_session();
+	session->add_device(device);
+
+	return session;
+}
+
+/* Check that all packets can be pulled, until the end of the datafeed. */
+START_TEST(test_pull)
+{
+	auto context = Context::create();
+	auto session = demo_session(context);
+	if (!session)
+		return;
+	auto queue = session->create_packet_queue();
+	session->start();
+
+	unsigned int logic = 0, end = 0;
+	for (auto packet : *queue) {
+		if (packet->type() == PacketType::LOGIC)
+			logic++;
+		else if (packet->type() == PacketType::END)
+			end++;
+	}
+	fail_unless(logic > 0);
+	fail_unless(end == 1);
+	fail_unless(queue->finished());
+}
+END_TEST
+
+/*
+ * Check that a consumer on another thread than the session's can read
+ * the payload of queued packets, after the driver sent them.
+ */
+START_TEST(test_read_payload)
+{
+	auto context = Context::create();
+	auto session = demo_session(context);
+	if (!session)
+		return;
+	auto device = session->devices().front();
+	device->channel_groups()["Logic"]->config_set(ConfigKey::PATTERN_MODE,
+		Glib::Variant<Glib::ustring>::create("all-high"));
+	auto queue = session->create_packet_queue(4, PacketQueue::BLOCK);
+	session->start();
+
+	/* Once a packet is queued, the session thread runs the session. */
+	thread session_thread([session] { session->run(); });
+	while (queue->size() < 1)
+		this_thread::sleep_for(chrono::milliseconds(1));
+
+	size_t length = 0, bad = 0;
+	thread consumer([&] {
+		for (auto packet : *queue) {
+			if (packet->type() != PacketType::LOGIC)
+				continue;
+			auto logic = dynamic_pointer_cast<Logic>(packet->payload());
+			auto data = static_cast<const uint8_t *>(logic->data_pointer());
+			for (size_t i = 0; i < logic->data_length(); i++)
+				if (data[i] != 0xff)
+					bad++;
+			length += logic->data_length();
+		}
+	});
+	consumer.join();
+	session_thread.join();
+	fail_unless(length == DEMO_SAMPLES, "Got %zu bytes.", length);
+	fail_unless(bad == 0, "%zu bytes are not all high.", bad);
+}
+END_TEST
+
+/* Check that waiting for a packet fails while the session is stopped. */
+START_TEST(test_not_started)
+{
+	auto context = Context::create();
+	auto session = demo_session(context);
+	if (!session)
+		return;
+	auto queue = session->create_packet_queue();
+
+	bool thrown = false;
+	try {
+		queue->next_packet();
+	} catch (const Error &error) {
+		thrown = error.result == SR_ERR_NA;
+	}
+	fail_unless(thrown, "next_packet() didn't fail.");
+}
+END_TEST
+
+/*
+ * Check that dropping a full queue, which blocks the session thread,
+ * lets the session go on.
+ */
+START_TEST(test_drop_full_queue)
+{
+	auto context = Context::create();
+	auto session = demo_session(context);
+	if (!session)
+		return;
+	auto queue = session->create_packet_queue(1, PacketQueue::BLOCK);
+	session->start();
+
+	thread session_thread([session] { session->run(); });
+	while (queue->size() < 1)
+		this_thread::sleep_for(chrono::milliseconds(1));
+	queue.reset();
+	/* Hangs, and gets timed out, if the session thread stays blocked. */
+	session_thread.join();
+	fail_unless(!session->is_running());
+}
+END_TEST
+
+static Suite *suite_packet_queue(void)
+{
+	Suite *s;
+	TCase *tc;
+
+	s = suite_create("packet_queue");
+
+	tc = tcase_create("pull");
+	tcase_add_test(tc, test_pull);
+	tcase_add_test(tc, test_read_payload);
+	tcase_add_test(tc, test_not_started);
+	tcase_add_test(tc, test_drop_full_queue);
+	suite_add_tcase(s, tc);
+
+	return s;
+}
+
+int main(void)
+{
+	int ret;
+	SRunner *srunner;
+
+	srunner = srunner_create(suite_packet_queue());
+	srunner_run_all(srunner, CK_VERBOSE);
+	ret = srunner_ntests_failed(srunner);
+	srunner_free(srunner);
+
+	return (ret == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
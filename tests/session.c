@@ -19,6 +19,9 @@
 
 #include <config.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
 #include <check.h>
 #include <libsigrok/libsigrok.h>
 #include "lib.h"
@@ -185,6 +188,555 @@ START_TEST(test_session_trigger_get_null)
 }
 END_TEST
 
+/* Samples which the demo devices acquire in the session tests. */
+#define DEMO_SAMPLES	10000
+
+/*
+ * Run a session with demo devices until they reached their limit. The
+ * devices remain in the session.
+ */
+static void run_demo_session(struct sr_session *sess,
+	struct sr_dev_inst **devs, int num_devs)
+{
+	int i, ret;
+
+	for (i = 0; i < num_devs; i++) {
+		ret = sr_dev_open(devs[i]);
+		fail_unless(ret == SR_OK, "Failed to open demo device: %d.", ret);
+		ret = sr_config_set(devs[i], NULL, SR_CONF_LIMIT_SAMPLES,
+			g_variant_new_uint64(DEMO_SAMPLES));
+		fail_unless(ret == SR_OK, "Failed to set limit: %d.", ret);
+		ret = sr_session_dev_add(sess, devs[i]);
+		fail_unless(ret == SR_OK, "Failed to add device: %d.", ret);
+	}
+	ret = sr_session_start(sess);
+	fail_unless(ret == SR_OK, "sr_session_start() failed: %d.", ret);
+	ret = sr_session_run(sess);
+	fail_unless(ret == SR_OK, "sr_session_run() failed: %d.", ret);
+	for (i = 0; i < num_devs; i++)
+		sr_dev_close(devs[i]);
+}
+
+START_TEST(test_session_stats_get)
+{
+	int ret;
+	struct sr_session *sess;
+	struct sr_dev_inst *sdi;
+	GVariant *stats, *devices, *dev, *send_us;
+	gboolean running;
+	uint64_t value;
+
+	sr_session_new(srtest_ctx, &sess);
+
+	/* A session which never ran has no metrics yet. */
+	ret = sr_session_stats_get(sess, &stats);
+	fail_unless(ret == SR_OK, "sr_session_stats_get() failed: %d.", ret);
+	g_variant_ref_sink(stats);
+	fail_unless(g_variant_lookup(stats, "running", "b", &running));
+	fail_unless(!running);
+	devices = g_variant_lookup_value(stats, "devices",
+		G_VARIANT_TYPE("aa{sv}"));
+	fail_unless(devices != NULL);
+	fail_unless(g_variant_n_children(devices) == 0);
+	g_variant_unref(devices);
+	g_variant_unref(stats);
+
+	/* Run a demo device, its packets and the send durations count. */
+	sdi = srtest_demo_dev_get(2, 0);
+	if (!sdi) {
+		sr_session_destroy(sess);
+		return;
+	}
+	ret = sr_session_stats_timing_set(sess, TRUE);
+	fail_unless(ret == SR_OK);
+	run_demo_session(sess, &sdi, 1);
+
+	ret = sr_session_stats_get(sess, &stats);
+	fail_unless(ret == SR_OK, "sr_session_stats_get() failed: %d.", ret);
+	g_variant_ref_sink(stats);
+	fail_unless(g_variant_lookup(stats, "running", "b", &running));
+	fail_unless(!running);
+	devices = g_variant_lookup_value(stats, "devices",
+		G_VARIANT_TYPE("aa{sv}"));
+	fail_unless(devices != NULL);
+	fail_unless(g_variant_n_children(devices) == 1);
+	dev = g_variant_get_child_value(devices, 0);
+	fail_unless(g_variant_lookup(dev, "packets", "t", &value));
+	fail_unless(value > 0, "No packets counted.");
+	fail_unless(g_variant_lookup(dev, "logic_bytes", "t", &value));
+	fail_unless(value >= DEMO_SAMPLES, "Too few bytes counted: %"
+		PRIu64 ".", value);
+	send_us = g_variant_lookup_value(dev, "send_us", G_VARIANT_TYPE_VARDICT);
+	fail_unless(send_us != NULL);
+	fail_unless(g_variant_lookup(send_us, "count", "t", &value));
+	fail_unless(value > 0, "No send durations measured.");
+	g_variant_unref(send_us);
+	g_variant_unref(dev);
+	g_variant_unref(devices);
+	g_variant_unref(stats);
+
+	sr_session_destroy(sess);
+}
+END_TEST
+
+START_TEST(test_session_stats_bogus)
+{
+	int ret;
+	struct sr_session *sess;
+	GVariant *stats;
+
+	ret = sr_session_stats_get(NULL, &stats);
+	fail_unless(ret == SR_ERR_ARG);
+	ret = sr_session_stats_interval_set(NULL, 100);
+	fail_unless(ret == SR_ERR_ARG);
+	ret = sr_session_stats_timing_set(NULL, TRUE);
+	fail_unless(ret == SR_ERR_ARG);
+
+	sr_session_new(srtest_ctx, &sess);
+	ret = sr_session_stats_get(sess, NULL);
+	fail_unless(ret == SR_ERR_ARG);
+	ret = sr_session_stats_interval_set(sess, 100);
+	fail_unless(ret == SR_OK);
+	sr_session_destroy(sess);
+}
+END_TEST
+
+static void datafeed_nop(const struct sr_dev_inst *sdi,
+	const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	(void)sdi;
+	(void)packet;
+	(void)cb_data;
+}
+
+struct feed_check {
+	GMutex mutex;
+	GThread *session_thread;
+	struct sr_dev_inst *devs[2];
+	int logic[2];
+	int ends[2];
+	gboolean out_of_order;
+	gboolean other_thread;
+};
+
+/* Count each device's packets, and check that END comes last. */
+static void datafeed_check(const struct sr_dev_inst *sdi,
+	const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	struct feed_check *check;
+	int i;
+
+	check = cb_data;
+	g_mutex_lock(&check->mutex);
+	i = (sdi == check->devs[0]) ? 0 : 1;
+	if (check->ends[i])
+		check->out_of_order = TRUE;
+	if (packet->type == SR_DF_LOGIC)
+		check->logic[i]++;
+	if (packet->type == SR_DF_END)
+		check->ends[i]++;
+	if (g_thread_self() != check->session_thread)
+		check->other_thread = TRUE;
+	g_mutex_unlock(&check->mutex);
+}
+
+START_TEST(test_session_device_threads)
+{
+	int ret, i, j;
+	struct sr_session *sess;
+	struct sr_dev_inst *devs[2];
+	struct feed_check checks[2];
+
+	ret = sr_session_device_threads_set(NULL, TRUE);
+	fail_unless(ret == SR_ERR_ARG);
+	ret = sr_session_datafeed_callback_add_concurrent(NULL,
+		datafeed_nop, NULL);
+	fail_unless(ret == SR_ERR_ARG);
+
+	sr_session_new(srtest_ctx, &sess);
+	ret = sr_session_device_threads_set(sess, TRUE);
+	fail_unless(ret == SR_OK);
+	ret = sr_session_datafeed_callback_add_concurrent(sess, NULL, NULL);
+	fail_unless(ret == SR_ERR_ARG);
+	ret = sr_session_datafeed_callback_add_concurrent(sess,
+		datafeed_nop, NULL);
+	fail_unless(ret == SR_OK);
+
+	/*
+	 * Run two demo devices on dispatch threads. Both kinds of
+	 * callbacks get all packets, each device's in order.
+	 */
+	devs[0] = srtest_demo_dev_get(2, 0);
+	devs[1] = srtest_demo_dev_get(2, 0);
+	if (!devs[0] || !devs[1]) {
+		sr_session_destroy(sess);
+		return;
+	}
+	memset(checks, 0, sizeof(checks));
+	for (i = 0; i < 2; i++) {
+		g_mutex_init(&checks[i].mutex);
+		checks[i].session_thread = g_thread_self();
+		checks[i].devs[0] = devs[0];
+		checks[i].devs[1] = devs[1];
+	}
+	ret = sr_session_datafeed_callback_add(sess, datafeed_check,
+		&checks[0]);
+	fail_unless(ret == SR_OK);
+	ret = sr_session_datafeed_callback_add_concurrent(sess,
+		datafeed_check, &checks[1]);
+	fail_unless(ret == SR_OK);
+	run_demo_session(sess, devs, 2);
+
+	for (i = 0; i < 2; i++) {
+		for (j = 0; j < 2; j++) {
+			fail_unless(checks[i].logic[j] > 0,
+				"No logic packets of device %d.", j);
+			fail_unless(checks[i].ends[j] == 1,
+				"No end of device %d.", j);
+		}
+		fail_unless(!checks[i].out_of_order, "Packets after end.");
+		fail_unless(checks[i].other_thread,
+			"Callback not run from a dispatch thread.");
+		g_mutex_clear(&checks[i].mutex);
+	}
+	sr_session_destroy(sess);
+}
+END_TEST
+
+static void datafeed_timed_nop(const struct sr_dev_inst *sdi,
+	const struct sr_datafeed_packet *packet,
+	const struct sr_datafeed_timestamp *ts, void *cb_data)
+{
+	(void)sdi;
+	(void)packet;
+	(void)ts;
+	(void)cb_data;
+}
+
+struct ts_check {
+	struct sr_dev_inst *devs[2];
+	uint64_t next_sample[2];
+	int64_t last_us;
+	int logic[2];
+	gboolean time_order;
+	gboolean sample_order;
+};
+
+/*
+ * Check that merged packets come in time order, and that each device's
+ * sample index counts up by the samples of its packets.
+ */
+static void datafeed_timed_check(const struct sr_dev_inst *sdi,
+	const struct sr_datafeed_packet *packet,
+	const struct sr_datafeed_timestamp *ts, void *cb_data)
+{
+	struct ts_check *check;
+	const struct sr_datafeed_logic *logic;
+	int i;
+
+	check = cb_data;
+	if (packet->type != SR_DF_LOGIC)
+		return;
+	logic = packet->payload;
+	i = (sdi == check->devs[0]) ? 0 : 1;
+	if (ts->time_us < check->last_us)
+		check->time_order = FALSE;
+	check->last_us = ts->time_us;
+	if (ts->sample != check->next_sample[i])
+		check->sample_order = FALSE;
+	check->next_sample[i] = ts->sample + logic->length / logic->unitsize;
+	check->logic[i]++;
+}
+
+START_TEST(test_session_timestamps)
+{
+	int ret;
+	struct sr_session *sess;
+	struct sr_dev_inst *devs[2];
+	struct ts_check check;
+
+	ret = sr_session_datafeed_callback_add_timed(NULL,
+		datafeed_timed_nop, NULL);
+	fail_unless(ret == SR_ERR_ARG);
+	ret = sr_session_merge_set(NULL, 1000);
+	fail_unless(ret == SR_ERR_ARG);
+
+	sr_session_new(srtest_ctx, &sess);
+	ret = sr_session_datafeed_callback_add_timed(sess, NULL, NULL);
+	fail_unless(ret == SR_ERR_ARG);
+	ret = sr_session_datafeed_callback_add_timed(sess,
+		datafeed_timed_nop, NULL);
+	fail_unless(ret == SR_OK);
+	ret = sr_session_merge_set(sess, 1000);
+	fail_unless(ret == SR_OK);
+	ret = sr_session_datafeed_callback_remove_all(sess);
+	fail_unless(ret == SR_OK);
+
+	/* Merge the packets of two demo devices. */
+	devs[0] = srtest_demo_dev_get(2, 0);
+	devs[1] = srtest_demo_dev_get(2, 0);
+	if (!devs[0] || !devs[1]) {
+		sr_session_destroy(sess);
+		return;
+	}
+	memset(&check, 0, sizeof(check));
+	check.devs[0] = devs[0];
+	check.devs[1] = devs[1];
+	check.time_order = TRUE;
+	check.sample_order = TRUE;
+	ret = sr_session_merge_set(sess, 1000000);
+	fail_unless(ret == SR_OK);
+	ret = sr_session_datafeed_callback_add_timed(sess,
+		datafeed_timed_check, &check);
+	fail_unless(ret == SR_OK);
+	run_demo_session(sess, devs, 2);
+
+	fail_unless(check.logic[0] > 0 && check.logic[1] > 0,
+		"Missing logic packets.");
+	fail_unless(check.time_order, "Packets not in time order.");
+	fail_unless(check.sample_order, "Sample index not monotonic.");
+	fail_unless(check.next_sample[0] == DEMO_SAMPLES);
+	fail_unless(check.next_sample[1] == DEMO_SAMPLES);
+	sr_session_destroy(sess);
+}
+END_TEST
+
+#define FRAMES		3
+#define FRAME_SAMPLES	10
+#define FRAME_TRIGGER	4
+
+static void send_packet(const struct sr_output *o, int type,
+		const void *payload)
+{
+	struct sr_datafeed_packet packet;
+	GString *out;
+
+	packet.type = type;
+	packet.payload = payload;
+	out = NULL;
+	fail_unless(sr_output_send(o, &packet, &out) == SR_OK);
+	if (out)
+		g_string_free(out, TRUE);
+}
+
+/*
+ * Write a capture file of FRAMES frames. Each frame has a trigger, and
+ * its samples are filled with the frame's number (1-based).
+ */
+static gchar *write_frames(void)
+{
+	struct sr_dev_inst *sdi;
+	const struct sr_output_module *omod;
+	const struct sr_output *o;
+	struct sr_datafeed_header header;
+	struct sr_datafeed_meta meta;
+	struct sr_datafeed_logic logic;
+	struct sr_config src;
+	uint8_t data[FRAME_SAMPLES];
+	gchar *path;
+	int fd, i;
+
+	omod = sr_output_find("srzip");
+	if (!omod)
+		return NULL;
+	sdi = srtest_demo_dev_get(8, 0);
+	if (!sdi)
+		return NULL;
+
+	fd = g_file_open_tmp("sr-test-XXXXXX.sr", &path, NULL);
+	fail_unless(fd >= 0, "Couldn't create a temporary file.");
+	close(fd);
+	o = sr_output_new(omod, NULL, sdi, path);
+	fail_unless(o != NULL, "Couldn't create an 'srzip' output.");
+
+	memset(&header, 0, sizeof(header));
+	header.feed_version = 1;
+	src.key = SR_CONF_SAMPLERATE;
+	src.data = g_variant_ref_sink(g_variant_new_uint64(1000000));
+	meta.config = g_slist_append(NULL, &src);
+	send_packet(o, SR_DF_HEADER, &header);
+	send_packet(o, SR_DF_META, &meta);
+	logic.unitsize = 1;
+	logic.data = data;
+	for (i = 0; i < FRAMES; i++) {
+		memset(data, i + 1, sizeof(data));
+		send_packet(o, SR_DF_FRAME_BEGIN, NULL);
+		logic.length = FRAME_TRIGGER;
+		send_packet(o, SR_DF_LOGIC, &logic);
+		send_packet(o, SR_DF_TRIGGER, NULL);
+		logic.length = FRAME_SAMPLES - FRAME_TRIGGER;
+		send_packet(o, SR_DF_LOGIC, &logic);
+		send_packet(o, SR_DF_FRAME_END, NULL);
+	}
+	send_packet(o, SR_DF_END, NULL);
+	sr_output_free(o);
+	g_slist_free(meta.config);
+	g_variant_unref(src.data);
+
+	return path;
+}
+
+struct frames_check {
+	GString *data;
+	int begins;
+	int triggers;
+	int ends;
+	/* Bytes received before each frame's trigger. */
+	size_t trigger_pos[FRAMES];
+	gboolean outside_frame;
+};
+
+static void datafeed_frames(const struct sr_dev_inst *sdi,
+	const struct sr_datafeed_packet *packet, void *cb_data)
+{
+	struct frames_check *check;
+	const struct sr_datafeed_logic *logic;
+	gboolean in_frame;
+
+	(void)sdi;
+
+	check = cb_data;
+	in_frame = check->begins > check->ends;
+	switch (packet->type) {
+	case SR_DF_FRAME_BEGIN:
+		if (in_frame)
+			check->outside_frame = TRUE;
+		check->begins++;
+		break;
+	case SR_DF_TRIGGER:
+		if (!in_frame || check->triggers >= FRAMES)
+			check->outside_frame = TRUE;
+		else
+			check->trigger_pos[check->triggers++] = check->data->len;
+		break;
+	case SR_DF_FRAME_END:
+		if (!in_frame)
+			check->outside_frame = TRUE;
+		check->ends++;
+		break;
+	case SR_DF_LOGIC:
+		if (!in_frame)
+			check->outside_frame = TRUE;
+		logic = packet->payload;
+		g_string_append_len(check->data, logic->data, logic->length);
+		break;
+	}
+}
+
+/*
+ * Load the capture file, and stream the frames selected by first_frame
+ * and limit_frames (0 for no limit).
+ */
+static void read_frames(const char *path, uint64_t first_frame,
+	uint64_t limit_frames, struct frames_check *check)
+{
+	struct sr_session *sess;
+	struct sr_dev_inst *sdi;
+	GSList *devlist;
+	GVariant *gvar;
+	int ret;
+
+	ret = sr_session_load(srtest_ctx, path, &sess);
+	fail_unless(ret == SR_OK, "sr_session_load() failed: %d.", ret);
+	ret = sr_session_dev_list(sess, &devlist);
+	fail_unless(ret == SR_OK && devlist != NULL);
+	sdi = devlist->data;
+	g_slist_free(devlist);
+
+	ret = sr_config_get(sr_dev_inst_driver_get(sdi), sdi, NULL,
+		SR_CONF_CAPTURE_FRAMES, &gvar);
+	fail_unless(ret == SR_OK, "No frames in the capture file.");
+	fail_unless(g_variant_get_uint64(gvar) == FRAMES);
+	g_variant_unref(gvar);
+	ret = sr_config_set(sdi, NULL, SR_CONF_FIRST_FRAME,
+		g_variant_new_uint64(first_frame));
+	fail_unless(ret == SR_OK, "Failed to set the first frame: %d.", ret);
+	ret = sr_config_set(sdi, NULL, SR_CONF_LIMIT_FRAMES,
+		g_variant_new_uint64(limit_frames));
+	fail_unless(ret == SR_OK, "Failed to set the frame limit: %d.", ret);
+
+	memset(check, 0, sizeof(*check));
+	check->data = g_string_new(NULL);
+	sr_session_datafeed_callback_add(sess, datafeed_frames, check);
+	ret = sr_session_start(sess);
+	fail_unless(ret == SR_OK, "sr_session_start() failed: %d.", ret);
+	ret = sr_session_run(sess);
+	fail_unless(ret == SR_OK, "sr_session_run() failed: %d.", ret);
+	sr_dev_close(sdi);
+	sr_session_destroy(sess);
+}
+
+/* Check the received frames, which start at frame number first. */
+static void check_frames(const struct frames_check *check, int first,
+	int count)
+{
+	const uint8_t *p;
+	size_t i;
+	int frame;
+
+	fail_unless(!check->outside_frame, "Data or marker outside a frame.");
+	fail_unless(check->begins == count && check->ends == count,
+		"Got %d frame begins and %d ends, expected %d.",
+		check->begins, check->ends, count);
+	fail_unless(check->triggers == count, "Got %d triggers.",
+		check->triggers);
+	fail_unless(check->data->len == (size_t)count * FRAME_SAMPLES,
+		"Got %zu bytes.", check->data->len);
+
+	p = (const uint8_t *)check->data->str;
+	for (i = 0; i < check->data->len; i++) {
+		frame = first + i / FRAME_SAMPLES;
+		fail_unless(p[i] == frame + 1, "Byte %zu is from frame %d, "
+			"not %d.", i, p[i] - 1, frame);
+	}
+	for (frame = 0; frame < count; frame++) {
+		fail_unless(check->trigger_pos[frame] ==
+			(size_t)frame * FRAME_SAMPLES + FRAME_TRIGGER,
+			"Frame %d's trigger is at %zu.", first + frame,
+			check->trigger_pos[frame]);
+	}
+}
+
+/*
+ * Check that a segmented capture, which the srzip module writes, reads
+ * back with its frames, and that a selection of frames only streams
+ * those frames' samples and markers.
+ */
+START_TEST(test_session_frames)
+{
+	struct frames_check check;
+	gchar *path;
+
+	path = write_frames();
+	if (!path)
+		return;
+
+	read_frames(path, 0, 0, &check);
+	check_frames(&check, 0, FRAMES);
+	g_string_free(check.data, TRUE);
+
+	read_frames(path, 1, 1, &check);
+	check_frames(&check, 1, 1);
+	g_string_free(check.data, TRUE);
+
+	read_frames(path, 1, 0, &check);
+	check_frames(&check, 1, FRAMES - 1);
+	g_string_free(check.data, TRUE);
+
+	read_frames(path, 0, 2, &check);
+	check_frames(&check, 0, 2);
+	g_string_free(check.data, TRUE);
+
+	/* Nothing is left after the last frame. */
+	read_frames(path, FRAMES, 0, &check);
+	check_frames(&check, FRAMES, 0);
+	g_string_free(check.data, TRUE);
+
+	g_unlink(path);
+	g_free(path);
+}
+END_TEST
+
 Suite *suite_session(void)
 {
 	Suite *s;
@@ -209,5 +761,26 @@ Suite *suite_session(void)
 	tcase_add_test(tc, test_session_trigger_get_null);
 	suite_add_tcase(s, tc);
 
+	tc = tcase_create("stats");
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_session_stats_get);
+	tcase_add_test(tc, test_session_stats_bogus);
+	suite_add_tcase(s, tc);
+
+	tc = tcase_create("device_threads");
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_session_device_threads);
+	suite_add_tcase(s, tc);
+
+	tc = tcase_create("timestamps");
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_session_timestamps);
+	suite_add_tcase(s, tc);
+
+	tc = tcase_create("frames");
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_session_frames);
+	suite_add_tcase(s, tc);
+
 	return s;
 }
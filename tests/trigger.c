@@ -21,8 +21,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <check.h>
+#include <string.h>
 #include <libsigrok/libsigrok.h>
 #include "lib.h"
+#include "libsigrok-internal.h"
 
 /* Test lots of triggers/stages/matches/channels */
 #define NUM_TRIGGERS 70
@@ -249,6 +251,164 @@ START_TEST(test_trigger_match_add_bogus)
 }
 END_TEST
 
+/* Check a stage's matches one by one, the way triggers used to be checked. */
+static gboolean interpreted_match(const struct sr_trigger_stage *stage,
+	const uint8_t *sample, const uint8_t *prev)
+{
+	const struct sr_trigger_match *match;
+	const GSList *l;
+	int index, bit, prev_bit;
+
+	for (l = stage->matches; l; l = l->next) {
+		match = l->data;
+		if (!match->channel->enabled)
+			continue;
+		if (match->channel->type != SR_CHANNEL_LOGIC)
+			continue;
+		index = match->channel->index;
+		bit = (sample[index / 8] >> (index % 8)) & 1;
+		if (match->match == SR_TRIGGER_ZERO && bit)
+			return FALSE;
+		if (match->match == SR_TRIGGER_ONE && !bit)
+			return FALSE;
+		if (match->match == SR_TRIGGER_ZERO || match->match == SR_TRIGGER_ONE)
+			continue;
+		if (!prev)
+			return FALSE;
+		prev_bit = (prev[index / 8] >> (index % 8)) & 1;
+		if (match->match == SR_TRIGGER_RISING && !(!prev_bit && bit))
+			return FALSE;
+		if (match->match == SR_TRIGGER_FALLING && !(prev_bit && !bit))
+			return FALSE;
+		if (match->match == SR_TRIGGER_EDGE && prev_bit == bit)
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+#define COMPILE_CHANNELS 80
+#define COMPILE_UNITSIZE ((COMPILE_CHANNELS + 7) / 8)
+#define COMPILE_STAGES 4
+#define COMPILE_SAMPLES 2000
+
+/* Check compiled triggers against the match by match evaluation. */
+START_TEST(test_trigger_compile)
+{
+	struct sr_channel *ch[COMPILE_CHANNELS];
+	struct sr_trigger *t;
+	struct sr_trigger_stage *stage;
+	struct sr_trigger_compiled *tc;
+	const GSList *l;
+	uint8_t samples[COMPILE_SAMPLES][COMPILE_UNITSIZE];
+	const uint8_t *prev;
+	int i, j, k, n, round, ret;
+	size_t stage_idx;
+	gboolean compiled, interpreted;
+
+	srand(1);
+	for (i = 0; i < COMPILE_CHANNELS; i++) {
+		ch[i] = g_malloc0(sizeof(struct sr_channel));
+		ch[i]->index = i;
+		ch[i]->type = SR_CHANNEL_LOGIC;
+		ch[i]->enabled = (i % 13) != 5;
+		ch[i]->name = g_strdup_printf("L%d", i);
+	}
+
+	for (round = 0; round < 50; round++) {
+		t = sr_trigger_new("T");
+		for (j = 0; j < COMPILE_STAGES; j++) {
+			stage = sr_trigger_stage_add(t);
+			/* Few matches per stage, so that matches do happen. */
+			n = 1 + rand() % 3;
+			for (k = 0; k < n; k++) {
+				ret = sr_trigger_match_add(stage,
+					ch[rand() % COMPILE_CHANNELS],
+					SR_TRIGGER_ZERO + rand() % 5, 0);
+				fail_unless(ret == SR_OK);
+			}
+		}
+		ret = sr_trigger_compile(t, COMPILE_UNITSIZE, &tc);
+		fail_unless(ret == SR_OK);
+		fail_unless(tc != NULL);
+		fail_unless(tc->num_stages == COMPILE_STAGES);
+
+		/* Samples with few changes, so that levels and edges match. */
+		memset(samples[0], 0, COMPILE_UNITSIZE);
+		for (i = 1; i < COMPILE_SAMPLES; i++) {
+			memcpy(samples[i], samples[i - 1], COMPILE_UNITSIZE);
+			for (k = rand() % 40; k < COMPILE_CHANNELS; k += 1 + rand() % 40)
+				samples[i][k / 8] ^= 1 << (k % 8);
+		}
+
+		for (i = 0; i < COMPILE_SAMPLES; i++) {
+			prev = i ? samples[i - 1] : NULL;
+			stage_idx = 0;
+			for (l = t->stages; l; l = l->next, stage_idx++) {
+				compiled = sr_trigger_compiled_match(tc, stage_idx,
+					samples[i], prev);
+				interpreted = interpreted_match(l->data,
+					samples[i], prev);
+				fail_unless(compiled == interpreted,
+					"Round %d, sample %d, stage %zu: compiled %d, "
+					"interpreted %d.", round, i, stage_idx,
+					compiled, interpreted);
+			}
+		}
+
+		sr_trigger_compiled_free(tc);
+		sr_trigger_free(t);
+	}
+
+	for (i = 0; i < COMPILE_CHANNELS; i++) {
+		g_free(ch[i]->name);
+		g_free(ch[i]);
+	}
+}
+END_TEST
+
+/* Check whether sr_trigger_compile() rejects unusable triggers. */
+START_TEST(test_trigger_compile_bogus)
+{
+	struct sr_channel ch;
+	struct sr_trigger *t;
+	struct sr_trigger_stage *stage;
+	struct sr_trigger_compiled *tc;
+
+	memset(&ch, 0, sizeof(ch));
+	ch.index = 8;
+	ch.type = SR_CHANNEL_LOGIC;
+	ch.enabled = TRUE;
+	ch.name = "L8";
+
+	t = sr_trigger_new(NULL);
+	tc = NULL;
+
+	/* No stages. */
+	fail_unless(sr_trigger_compile(t, 1, &tc) == SR_ERR_ARG);
+	fail_unless(tc == NULL);
+
+	/* Stage without matches. */
+	stage = sr_trigger_stage_add(t);
+	fail_unless(sr_trigger_compile(t, 2, &tc) == SR_ERR_ARG);
+	fail_unless(tc == NULL);
+
+	/* Channel beyond the unit size. */
+	sr_trigger_match_add(stage, &ch, SR_TRIGGER_ONE, 0);
+	fail_unless(sr_trigger_compile(t, 1, &tc) == SR_ERR_ARG);
+	fail_unless(tc == NULL);
+	fail_unless(sr_trigger_compile(t, 2, &tc) == SR_OK);
+	fail_unless(tc != NULL);
+	sr_trigger_compiled_free(tc);
+
+	fail_unless(sr_trigger_compile(NULL, 1, &tc) == SR_ERR_ARG);
+	fail_unless(sr_trigger_compile(t, 0, &tc) == SR_ERR_ARG);
+	sr_trigger_compiled_free(NULL);
+
+	sr_trigger_free(t);
+}
+END_TEST
+
 Suite *suite_trigger(void)
 {
 	Suite *s;
@@ -276,5 +436,11 @@ Suite *suite_trigger(void)
 	tcase_add_test(tc, test_trigger_match_add_bogus);
 	suite_add_tcase(s, tc);
 
+	tc = tcase_create("compile");
+	tcase_add_checked_fixture(tc, srtest_setup, srtest_teardown);
+	tcase_add_test(tc, test_trigger_compile);
+	tcase_add_test(tc, test_trigger_compile_bogus);
+	suite_add_tcase(s, tc);
+
 	return s;
 }